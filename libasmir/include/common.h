@@ -43,6 +43,59 @@ typedef uint64_t address_t;
 #define LOG_TO_FILE
 
 
+//
+// Collect per-stage translation statistics, comment this line 
+// to compile out all of the time measurement code.
+//
+#define USE_STATS
+
+#ifdef USE_STATS
+
+#if defined(__i386__) || defined(__x86_64__)
+
+// read CPU time stamp counter
+static inline uint64_t stats_tsc(void)
+{
+    uint32_t lo = 0, hi = 0;
+
+    __asm__ __volatile__("rdtsc" : "=a"(lo), "=d"(hi));
+
+    return ((uint64_t)hi << 32) | lo;
+}
+
+#else
+
+#include <time.h>
+
+// there's no TSC, use monotonic clock in nanoseconds instead
+static inline uint64_t stats_tsc(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+#endif
+
+// remember time stamp at the beginning of measured code
+#define STATS_START(_t_) uint64_t _t_ = stats_tsc()
+
+// update cumulative time and calls count of measured code
+#define STATS_END(_time_, _count_, _t_)         \
+                                                \
+    (_time_) += stats_tsc() - (_t_);            \
+    (_count_) += 1;
+
+#else
+
+#define STATS_START(_t_)
+#define STATS_END(_time_, _count_, _t_)
+
+#endif // USE_STATS
+
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -75,6 +128,12 @@ void log_close(void);
 void log_write(uint32_t level, const char *msg, ...);
 size_t log_write_bytes(uint32_t level, const char *msg, size_t len);
 
+// number of stats_tsc() ticks per second
+uint64_t stats_tsc_freq(void);
+
+// convert stats_tsc() ticks to nanoseconds
+uint64_t stats_tsc_to_ns(uint64_t ticks);
+
 #ifdef __cplusplus
 }
 #endif
@@ -9,7 +9,7 @@
 
 extern "C" {
 
-int disasm_insn(VexArch guest, uint8_t *data, address_t addr, string &mnemonic, string &op);
+int disasm_insn(VexArch guest, uint8_t *data, address_t addr, string &mnemonic, string &op, unsigned int &id);
 
 int disasm_arg_src(VexArch guest, uint8_t *data, address_t addr, vector<Temp *> &args);
 int disasm_arg_dst(VexArch guest, uint8_t *data, address_t addr, vector<Temp *> &args);
@@ -30,6 +30,9 @@ struct bap_block_s
     string str_mnem;
     string str_op;
 
+    // capstone instruction ID
+    unsigned int inst_id;
+
     IRSB *vex_ir;
     vector<Stmt *> *bap_ir;
 }; 
@@ -42,6 +45,27 @@ typedef struct flag_thunks_s
 
 } flag_thunks_t; 
 
+
+//
+// Cumulative time (in stats_tsc() ticks) and number of calls 
+// for each translation stage, see USE_STATS in common.h
+//
+typedef struct bap_stats_s
+{
+    // capstone instruction decoding
+    uint64_t disasm_time, disasm_count;
+
+    // LibVEX_Translate()
+    uint64_t vex_time, vex_count;
+
+    // translate_irbb()
+    uint64_t irbb_time, irbb_count;
+
+    // generate_bap_ir() post-passes
+    uint64_t bap_time, bap_count;
+
+} bap_stats_t;
+
 //
 // Structure that keeps global state of translation process.
 //
@@ -62,6 +86,9 @@ struct bap_context_s
 
     // to keep current value of ITSTATE register
     uint32_t itstate;
+
+    // translation statistics
+    bap_stats_t stats;
 };
 
 //======================================================================
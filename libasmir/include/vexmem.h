@@ -11,6 +11,10 @@ extern "C"
 void *vx_Alloc(Int nbytes);
 void vx_FreeAll();
 
+// get/reset maximum number of bytes that was allocated with vx_Alloc()
+size_t vx_MaxUsed();
+void vx_ResetMaxUsed();
+
 IRSB* vx_dopyIRSB(IRSB* bb);
 
 #ifdef __cplusplus
@@ -8,6 +8,7 @@
 #include <unistd.h>
 #include <stdarg.h>
 #include <assert.h>
+#include <time.h>
 
 using namespace std;
 
@@ -166,3 +167,73 @@ void _panic(const char *msg)
 {
     panic(string(msg));
 }
+
+//----------------------------------------------------------------------
+// Time measurement helpers for translation statistics
+//----------------------------------------------------------------------
+#ifdef USE_STATS
+
+static uint64_t stats_clock_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+#endif // USE_STATS
+
+uint64_t stats_tsc_freq(void)
+{
+
+#ifdef USE_STATS
+
+#if defined(__i386__) || defined(__x86_64__)
+
+    static uint64_t freq = 0;
+
+    if (freq == 0)
+    {
+        // calibrate time stamp counter using monotonic clock
+        uint64_t ns_start = stats_clock_ns(), tsc_start = stats_tsc();
+        uint64_t ns_end = 0, tsc_end = 0;
+
+        do
+        {
+            ns_end = stats_clock_ns();
+            tsc_end = stats_tsc();
+        }
+        while (ns_end - ns_start < 10000000);
+
+        freq = (uint64_t)((double)(tsc_end - tsc_start) * 1000000000.0 / (ns_end - ns_start));
+    }
+
+    return freq;
+
+#else
+
+    // stats_tsc() returns nanoseconds
+    return 1000000000ULL;
+
+#endif
+
+#else
+
+    return 0;
+
+#endif // USE_STATS
+
+}
+
+uint64_t stats_tsc_to_ns(uint64_t ticks)
+{
+    uint64_t freq = stats_tsc_freq();
+
+    if (freq == 0)
+    {
+        return 0;
+    }
+
+    return (uint64_t)((double)ticks * 1000000000.0 / freq);
+}
@@ -388,7 +388,7 @@ void disasm_open(VexArch guest, address_t addr, csh *handle)
     }    
 }
 
-int disasm_insn(VexArch guest, uint8_t *data, address_t addr, string &mnemonic, string &op)
+int disasm_insn(VexArch guest, uint8_t *data, address_t addr, string &mnemonic, string &op, unsigned int &id)
 {
     int ret = -1;
     
@@ -407,6 +407,9 @@ int disasm_insn(VexArch guest, uint8_t *data, address_t addr, string &mnemonic,
         mnemonic = string(insn[0].mnemonic);
         op = string(insn[0].op_str);        
 
+        // get capstone instruction ID
+        id = insn[0].id;
+
         cs_free(insn, count);
     } 
     else
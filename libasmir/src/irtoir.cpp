@@ -2405,7 +2405,13 @@ bap_block_t *generate_vex_ir(bap_context_t *context, uint8_t *data, address_t in
     vblock->bap_ir = NULL;
 
     vblock->inst = inst;
-    vblock->inst_size = disasm_insn(context->guest, data, inst, vblock->str_mnem, vblock->str_op);
+    vblock->inst_id = 0;
+
+    STATS_START(disasm_start);
+
+    vblock->inst_size = disasm_insn(context->guest, data, inst, vblock->str_mnem, vblock->str_op, vblock->inst_id);
+
+    STATS_END(context->stats.disasm_time, context->stats.disasm_count, disasm_start);
     
     if (vblock->inst_size > 0)
     {
@@ -2422,7 +2428,11 @@ bap_block_t *generate_vex_ir(bap_context_t *context, uint8_t *data, address_t in
         // are also the ones that VEX does not handle
         if (!is_special(inst))
         {
+            STATS_START(vex_start);
+
             vblock->vex_ir = translate_insn(context->guest, data, inst, NULL);
+
+            STATS_END(context->stats.vex_time, context->stats.vex_count, vex_start);
         }
         else
         {
@@ -2622,11 +2632,17 @@ void generate_bap_ir(bap_context_t *context, bap_block_t *block)
     }
     else if (block->vex_ir)
     {
+        STATS_START(irbb_start);
+
         block->bap_ir = translate_irbb(context, block->vex_ir);
+
+        STATS_END(context->stats.irbb_time, context->stats.irbb_count, irbb_start);
     }
 
     if (block->bap_ir)
     {
+        STATS_START(bap_start);
+
         vector<Stmt *> *vir = block->bap_ir;
 
         // Go through block and add Special's for ret
@@ -2672,6 +2688,8 @@ void generate_bap_ir(bap_context_t *context, bap_block_t *block)
 
             vir->at(j)->ir_address = ir_addr++;
         }
+
+        STATS_END(context->stats.bap_time, context->stats.bap_count, bap_start);
     } 
     else
     {
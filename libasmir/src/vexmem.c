@@ -85,6 +85,9 @@ static IRTypeEnv *vx_dopyIRTypeEnv(IRTypeEnv *src);
 unsigned char huge_block[ HUGE_BLOCK_SIZE ];
 unsigned char *next_free = huge_block;
 
+// arena high-water mark
+unsigned char *max_free = huge_block;
+
 void *vx_Alloc(Int nbytes)
 {
     assert(nbytes > 0);
@@ -95,6 +98,11 @@ void *vx_Alloc(Int nbytes)
 
     assert(next_free < huge_block + HUGE_BLOCK_SIZE);
 
+    if (next_free > max_free)
+    {
+        max_free = next_free;
+    }
+
     return this_block;
 }
 
@@ -103,6 +111,16 @@ void vx_FreeAll()
     next_free = huge_block;
 }
 
+size_t vx_MaxUsed()
+{
+    return (size_t)(max_free - huge_block);
+}
+
+void vx_ResetMaxUsed()
+{
+    max_free = next_free;
+}
+
 //======================================================================
 //
 // Constructors
@@ -0,0 +1,222 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+#include <algorithm>
+
+using namespace std;
+
+#include "libopenreil.h"
+#include "exe-loader.h"
+
+// ELF format definitions that we need
+#define ELF_EHDR_SIZE           0x34
+#define ELF_SHDR_SIZE           0x28
+#define ELF_EI_CLASS            4
+#define ELF_EI_DATA             5
+#define ELF_CLASS32             1
+#define ELF_DATA2LSB            1
+#define ELF_MACHINE_386         3
+#define ELF_MACHINE_ARM         40
+#define ELF_SHT_PROGBITS        1
+#define ELF_SHF_EXECINSTR       4
+
+// PE format definitions that we need
+#define PE_MACHINE_I386         0x014c
+#define PE_SCN_CNT_CODE         0x00000020
+#define PE_SCN_MEM_EXECUTE      0x20000000
+
+bool exe_read_file(const char *path, vector<uint8_t> &data)
+{
+    // "-" stands for stdin
+    FILE *fd = strcmp(path, "-") ? fopen(path, "rb") : stdin;
+    if (fd == NULL)
+    {
+        return false;
+    }
+
+    uint8_t buff[0x1000];
+    size_t len = 0;
+
+    while ((len = fread(buff, 1, sizeof(buff), fd)) > 0)
+    {
+        data.insert(data.end(), buff, buff + len);
+    }
+
+    if (fd != stdin)
+    {
+        fclose(fd);
+    }
+
+    return true;
+}
+
+static bool load_elf(vector<uint8_t> &data, const char *path, vector<exe_section> &sections)
+{
+    if (data.size() < ELF_EHDR_SIZE)
+    {
+        return false;
+    }
+
+    reil_arch_t arch;
+
+    if (data[ELF_EI_CLASS] != ELF_CLASS32 || data[ELF_EI_DATA] != ELF_DATA2LSB)
+    {
+        fprintf(stderr, "ERROR: %s: only 32-bit little endian ELF files are supported\n", path);
+        return false;
+    }
+
+    // Elf32_Ehdr fields
+    uint16_t machine = *(uint16_t *)&data[0x12];
+    uint32_t sh_offset = *(uint32_t *)&data[0x20];
+    uint16_t sh_num = *(uint16_t *)&data[0x30];
+    uint16_t sh_strndx = *(uint16_t *)&data[0x32];
+
+    switch (machine)
+    {
+    case ELF_MACHINE_386: arch = ARCH_X86; break;
+    case ELF_MACHINE_ARM: arch = ARCH_ARM; break;
+
+    default:
+
+        fprintf(stderr, "ERROR: %s: unsupported ELF machine %d\n", path, machine);
+        return false;
+    }
+
+    if (sh_offset == 0 || sh_offset + sh_num * ELF_SHDR_SIZE > data.size() || sh_strndx >= sh_num)
+    {
+        fprintf(stderr, "ERROR: %s: bad section headers\n", path);
+        return false;
+    }
+
+    uint32_t str_offset = *(uint32_t *)&data[sh_offset + sh_strndx * ELF_SHDR_SIZE + 0x10];
+
+    for (int i = 0; i < sh_num; i += 1)
+    {
+        // Elf32_Shdr fields
+        uint8_t *shdr = &data[sh_offset + i * ELF_SHDR_SIZE];
+        uint32_t name = *(uint32_t *)(shdr + 0x00);
+        uint32_t type = *(uint32_t *)(shdr + 0x04);
+        uint32_t flags = *(uint32_t *)(shdr + 0x08);
+        uint32_t addr = *(uint32_t *)(shdr + 0x0c);
+        uint32_t offset = *(uint32_t *)(shdr + 0x10);
+        uint32_t size = *(uint32_t *)(shdr + 0x14);
+
+        if (type != ELF_SHT_PROGBITS || !(flags & ELF_SHF_EXECINSTR) || offset + size > data.size())
+        {
+            continue;
+        }
+
+        exe_section section;
+
+        if (str_offset + name < data.size())
+        {
+            section.name = string((char *)&data[str_offset + name]);
+        }
+
+        section.arch = arch;
+        section.addr = addr;
+        section.data.assign(data.begin() + offset, data.begin() + offset + size);
+
+        sections.push_back(section);
+    }
+
+    return true;
+}
+
+static bool load_pe(vector<uint8_t> &data, const char *path, vector<exe_section> &sections)
+{
+    if (data.size() < 0x40)
+    {
+        return false;
+    }
+
+    uint32_t pe_offset = *(uint32_t *)&data[0x3c];
+
+    if (pe_offset + 0x18 > data.size() || memcmp(&data[pe_offset], "PE\0\0", 4))
+    {
+        fprintf(stderr, "ERROR: %s: bad PE header\n", path);
+        return false;
+    }
+
+    // IMAGE_FILE_HEADER fields
+    uint16_t machine = *(uint16_t *)&data[pe_offset + 0x04];
+    uint16_t sections_num = *(uint16_t *)&data[pe_offset + 0x06];
+    uint16_t opt_header_size = *(uint16_t *)&data[pe_offset + 0x14];
+
+    if (machine != PE_MACHINE_I386)
+    {
+        fprintf(stderr, "ERROR: %s: unsupported PE machine 0x%x\n", path, machine);
+        return false;
+    }
+
+    // IMAGE_OPTIONAL_HEADER32.ImageBase
+    uint32_t image_base = *(uint32_t *)&data[pe_offset + 0x18 + 0x1c];
+    uint32_t scn_offset = pe_offset + 0x18 + opt_header_size;
+
+    for (int i = 0; i < sections_num; i += 1)
+    {
+        // IMAGE_SECTION_HEADER is 40 bytes long
+        if (scn_offset + (i + 1) * 40 > data.size())
+        {
+            break;
+        }
+
+        uint8_t *scn = &data[scn_offset + i * 40];
+
+        uint32_t virtual_size = *(uint32_t *)(scn + 0x08);
+        uint32_t virtual_addr = *(uint32_t *)(scn + 0x0c);
+        uint32_t raw_size = *(uint32_t *)(scn + 0x10);
+        uint32_t raw_offset = *(uint32_t *)(scn + 0x14);
+        uint32_t characteristics = *(uint32_t *)(scn + 0x24);
+
+        if (!(characteristics & (PE_SCN_CNT_CODE | PE_SCN_MEM_EXECUTE)))
+        {
+            continue;
+        }
+
+        uint32_t size = virtual_size > 0 ? min(virtual_size, raw_size) : raw_size;
+
+        if (size == 0 || raw_offset + size > data.size())
+        {
+            continue;
+        }
+
+        exe_section section;
+
+        section.name = string((char *)scn, strnlen((char *)scn, 8));
+        section.arch = ARCH_X86;
+        section.addr = image_base + virtual_addr;
+        section.data.assign(data.begin() + raw_offset, data.begin() + raw_offset + size);
+
+        sections.push_back(section);
+    }
+
+    return true;
+}
+
+bool exe_load(const char *path, vector<exe_section> &sections)
+{
+    vector<uint8_t> data;
+
+    if (!exe_read_file(path, data))
+    {
+        fprintf(stderr, "ERROR: Unable to read %s\n", path);
+        return false;
+    }
+
+    if (data.size() >= 4 && !memcmp(&data[0], "\x7f" "ELF", 4))
+    {
+        return load_elf(data, path, sections);
+    }
+    else if (data.size() >= 2 && !memcmp(&data[0], "MZ", 2))
+    {
+        return load_pe(data, path, sections);
+    }
+
+    fprintf(stderr, "ERROR: %s: unknown file format\n", path);
+    return false;
+}
@@ -0,0 +1,27 @@
+#ifndef EXE_LOADER_H
+#define EXE_LOADER_H
+
+/*
+    Minimal loader of executable sections from 32-bit ELF (x86, ARM)
+    and PE (x86) files that is used by OpenREIL command line tools.
+*/
+typedef struct _exe_section
+{
+    string name;
+    reil_arch_t arch;
+    reil_addr_t addr;
+    vector<uint8_t> data;
+
+} exe_section;
+
+/*
+    Read whole file contents, "-" path stands for stdin.
+*/
+bool exe_read_file(const char *path, vector<uint8_t> &data);
+
+/*
+    Load executable sections of the file, returns false on error.
+*/
+bool exe_load(const char *path, vector<exe_section> &sections);
+
+#endif // EXE_LOADER_H
@@ -0,0 +1,832 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <assert.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/types.h>
+
+#ifndef _WIN32
+
+#include <sys/wait.h>
+
+#endif
+
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+
+using namespace std;
+
+#include "libopenreil.h"
+#include "exe-loader.h"
+
+// number of passes over the code in cached mode
+#define CACHE_PASSES 4
+
+// number of mnemonics to print in text mode by default
+#define MNEM_TOP 20
+
+// benchmark modes
+#define MODE_SINGLE     0x01    // new translator for each instruction
+#define MODE_BATCH      0x02    // single translator for whole section
+#define MODE_CACHED     0x04    // address keyed translation cache
+#define MODE_PARALLEL   0x08    // several worker processes
+
+#define MODE_ALL (MODE_SINGLE | MODE_BATCH | MODE_CACHED | MODE_PARALLEL)
+
+typedef struct _bench_section
+{
+    string name;
+    reil_arch_t arch;
+    reil_addr_t addr;
+    vector<uint8_t> data;
+
+    // offsets of instructions that was successfully translated during linear sweep
+    vector<int> insn_list;
+
+} bench_section;
+
+typedef struct _bench_file
+{
+    string path;
+    vector<bench_section> sections;
+
+} bench_file;
+
+typedef struct _bench_result
+{
+    unsigned long long insn;
+    unsigned long long reil;
+    unsigned long long bytes;
+    unsigned long long failed;
+    unsigned long long time;
+
+    // cached mode only
+    unsigned long long hits;
+    unsigned long long misses;
+
+} bench_result;
+
+typedef struct _bench_mnem
+{
+    unsigned long long count;
+    unsigned long long reil;
+    unsigned long long time;
+
+} bench_mnem;
+
+typedef struct _bench_context
+{
+    unsigned long long reil;
+
+    // mnemonic of the last translated instruction
+    char mnem[0x20];
+
+    // translated instructions for cached mode
+    vector<reil_inst_t> *insts;
+
+} bench_context;
+
+typedef map<reil_addr_t, vector<reil_inst_t> > bench_cache;
+
+// key is architecture name and mnemonic
+typedef map<pair<string, string>, bench_mnem> bench_mnem_map;
+
+static const char *arch_name(reil_arch_t arch)
+{
+    switch (arch)
+    {
+    case ARCH_X86: return "x86";
+    case ARCH_ARM: return "arm";
+    }
+
+    return "?";
+}
+
+static unsigned long long time_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static string json_escape(const string &str)
+{
+    string ret;
+
+    for (size_t i = 0; i < str.size(); i += 1)
+    {
+        if (str[i] == '"' || str[i] == '\\') ret += '\\';
+
+        ret += str[i];
+    }
+
+    return ret;
+}
+
+static double per_sec(unsigned long long val, unsigned long long time)
+{
+    return time > 0 ? (double)val * 1000000000.0 / (double)time : 0.0;
+}
+
+int bench_inst_handler(reil_inst_t *inst, void *context)
+{
+    bench_context *c = (bench_context *)context;
+
+    if (inst->inum == 0)
+    {
+        const char *mnem = inst->raw_info.str_mnem;
+
+        strncpy(c->mnem, mnem ? mnem : "?", sizeof(c->mnem) - 1);
+    }
+
+    if (c->insts)
+    {
+        reil_inst_t copy = *inst;
+
+        // these pointers are valid only during handler call
+        copy.raw_info.data = NULL;
+        copy.raw_info.str_mnem = NULL;
+        copy.raw_info.str_op = NULL;
+
+        c->insts->push_back(copy);
+    }
+
+    c->reil += 1;
+
+    return 0;
+}
+
+static bool load_file(const char *path, bench_file &file)
+{
+    vector<exe_section> sections;
+
+    file.path = string(path);
+
+    if (!exe_load(path, sections))
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < sections.size(); i += 1)
+    {
+        bench_section section;
+
+        section.name = sections[i].name;
+        section.arch = sections[i].arch;
+        section.addr = sections[i].addr;
+        section.data.swap(sections[i].data);
+
+        file.sections.push_back(section);
+    }
+
+    return true;
+}
+
+//----------------------------------------------------------------------
+// Benchmark modes
+//----------------------------------------------------------------------
+static int translate_one(reil_t reil, bench_section &section, int offset)
+{
+    uint8_t inst_buff[MAX_INST_LEN];
+    int copy_len = min(MAX_INST_LEN, (int)section.data.size() - offset);
+
+    // copy one instruction into the buffer, just like reil_translate() does
+    memset(inst_buff, 0, sizeof(inst_buff));
+    memcpy(inst_buff, &section.data[offset], copy_len);
+
+    return reil_translate_insn(reil, section.addr + offset, inst_buff, MAX_INST_LEN);
+}
+
+/*
+    Linear sweep over the section to collect instruction offsets,
+    undecodable bytes (alignment, ARM literal pools, etc.) are skipped.
+*/
+static void bench_sweep(reil_t reil, bench_section &section, bench_result &result)
+{
+    int offset = 0, size = (int)section.data.size();
+    int skip = section.arch == ARCH_ARM ? 4 : 1;
+
+    section.insn_list.clear();
+
+    while (offset < size)
+    {
+        int inst_len = translate_one(reil, section, offset);
+        if (inst_len == REIL_ERROR)
+        {
+            result.failed += 1;
+            offset += skip;
+            continue;
+        }
+
+        section.insn_list.push_back(offset);
+        offset += inst_len;
+    }
+}
+
+static void bench_single(bench_section &section, bench_result &result)
+{
+    bench_context context;
+    memset(&context, 0, sizeof(context));
+
+    unsigned long long start = time_ns();
+
+    for (size_t i = 0; i < section.insn_list.size(); i += 1)
+    {
+        reil_t reil = reil_init(section.arch, bench_inst_handler, &context);
+        assert(reil);
+
+        int inst_len = translate_one(reil, section, section.insn_list[i]);
+        if (inst_len != REIL_ERROR)
+        {
+            result.insn += 1;
+            result.bytes += inst_len;
+        }
+
+        reil_close(reil);
+    }
+
+    result.time += time_ns() - start;
+    result.reil += context.reil;
+}
+
+static void bench_batch(bench_section &section, bench_result &result, bench_mnem_map *mnem_map)
+{
+    bench_context context;
+    memset(&context, 0, sizeof(context));
+
+    reil_t reil = reil_init(section.arch, bench_inst_handler, &context);
+    assert(reil);
+
+    unsigned long long start = time_ns();
+
+    for (size_t i = 0; i < section.insn_list.size(); i += 1)
+    {
+        unsigned long long inst_start = mnem_map ? time_ns() : 0;
+        unsigned long long reil_count = context.reil;
+
+        int inst_len = translate_one(reil, section, section.insn_list[i]);
+        if (inst_len == REIL_ERROR)
+        {
+            continue;
+        }
+
+        result.insn += 1;
+        result.bytes += inst_len;
+
+        if (mnem_map)
+        {
+            // update per-mnemonic counters
+            bench_mnem &mnem = (*mnem_map)[make_pair(string(arch_name(section.arch)),
+                                                     string(context.mnem))];
+            mnem.count += 1;
+            mnem.reil += context.reil - reil_count;
+            mnem.time += time_ns() - inst_start;
+        }
+    }
+
+    result.time += time_ns() - start;
+    result.reil += context.reil;
+
+    reil_close(reil);
+}
+
+static void bench_cached(bench_section &section, bench_result &result)
+{
+    bench_cache cache;
+    bench_context context;
+    memset(&context, 0, sizeof(context));
+
+    reil_t reil = reil_init(section.arch, bench_inst_handler, &context);
+    assert(reil);
+
+    unsigned long long start = time_ns();
+
+    for (int pass = 0; pass < CACHE_PASSES; pass += 1)
+    {
+        for (size_t i = 0; i < section.insn_list.size(); i += 1)
+        {
+            reil_addr_t addr = section.addr + section.insn_list[i];
+            bench_cache::iterator it = cache.find(addr);
+
+            if (it != cache.end())
+            {
+                vector<reil_inst_t> &insts = it->second;
+
+                // use previously translated instruction
+                result.hits += 1;
+                result.insn += 1;
+                result.reil += insts.size();
+                result.bytes += insts.empty() ? 0 : insts[0].raw_info.size;
+                continue;
+            }
+
+            vector<reil_inst_t> &insts = cache[addr];
+
+            context.insts = &insts;
+            context.reil = 0;
+
+            int inst_len = translate_one(reil, section, section.insn_list[i]);
+
+            context.insts = NULL;
+
+            if (inst_len == REIL_ERROR)
+            {
+                cache.erase(addr);
+                continue;
+            }
+
+            result.misses += 1;
+            result.insn += 1;
+            result.reil += context.reil;
+            result.bytes += inst_len;
+        }
+    }
+
+    result.time += time_ns() - start;
+
+    reil_close(reil);
+}
+
+#ifndef _WIN32
+
+/*
+    VEX keeps its state in global variables, so worker processes are
+    used instead of threads.
+*/
+static void bench_parallel(vector<bench_file> &files, int jobs, bench_result &result)
+{
+    vector<pid_t> workers;
+    vector<int> pipes;
+
+    unsigned long long start = time_ns();
+
+    for (int n = 0; n < jobs; n += 1)
+    {
+        int fd[2];
+
+        if (pipe(fd) != 0)
+        {
+            printf("ERROR: pipe() fails\n");
+            exit(-1);
+        }
+
+        pid_t pid = fork();
+        if (pid < 0)
+        {
+            printf("ERROR: fork() fails\n");
+            exit(-1);
+        }
+        else if (pid == 0)
+        {
+            bench_result worker_result;
+            memset(&worker_result, 0, sizeof(worker_result));
+
+            close(fd[0]);
+
+            for (size_t f = 0; f < files.size(); f += 1)
+            {
+                for (size_t s = 0; s < files[f].sections.size(); s += 1)
+                {
+                    bench_section &section = files[f].sections[s];
+                    bench_section part = section;
+
+                    // each worker translates its own chunk of instructions list
+                    size_t chunk = (section.insn_list.size() + jobs - 1) / jobs;
+                    size_t first = min(section.insn_list.size(), chunk * n);
+                    size_t last = min(section.insn_list.size(), first + chunk);
+
+                    part.insn_list.assign(section.insn_list.begin() + first,
+                                          section.insn_list.begin() + last);
+
+                    bench_batch(part, worker_result, NULL);
+                }
+            }
+
+            if (write(fd[1], &worker_result, sizeof(worker_result)) != sizeof(worker_result))
+            {
+                _exit(-1);
+            }
+
+            close(fd[1]);
+            _exit(0);
+        }
+
+        close(fd[1]);
+
+        workers.push_back(pid);
+        pipes.push_back(fd[0]);
+    }
+
+    for (int n = 0; n < jobs; n += 1)
+    {
+        bench_result worker_result;
+        int status = 0;
+
+        if (read(pipes[n], &worker_result, sizeof(worker_result)) == sizeof(worker_result))
+        {
+            result.insn += worker_result.insn;
+            result.reil += worker_result.reil;
+            result.bytes += worker_result.bytes;
+        }
+        else
+        {
+            printf("ERROR: Worker %d fails\n", n);
+        }
+
+        close(pipes[n]);
+        waitpid(workers[n], &status, 0);
+    }
+
+    // wall clock time for all of the workers
+    result.time += time_ns() - start;
+}
+
+#endif // _WIN32
+
+//----------------------------------------------------------------------
+// Results output
+//----------------------------------------------------------------------
+static void print_result_text(const char *name, const char *mode, bench_result &result)
+{
+    printf("%-24s %-8s %8llu insn %9llu reil %8.2f ms %12.0f insn/s %12.0f reil/s",
+           name, mode, result.insn, result.reil, (double)result.time / 1000000.0,
+           per_sec(result.insn, result.time), per_sec(result.reil, result.time));
+
+    if (result.hits + result.misses > 0)
+    {
+        printf(" (%llu hits)", result.hits);
+    }
+
+    printf("\n");
+}
+
+static void print_result_json(bool &first, const string &name, const char *arch, const char *mode,
+                              bench_result &result)
+{
+    printf("%s\n    {\"file\": \"%s\", \"arch\": \"%s\", \"mode\": \"%s\", "
+           "\"insn\": %llu, \"reil\": %llu, \"bytes\": %llu, \"failed\": %llu, "
+           "\"hits\": %llu, \"misses\": %llu, \"time_ns\": %llu, "
+           "\"insn_per_sec\": %.0f, \"reil_per_sec\": %.0f}",
+           first ? "" : ",", json_escape(name).c_str(), arch, mode,
+           result.insn, result.reil, result.bytes, result.failed,
+           result.hits, result.misses, result.time,
+           per_sec(result.insn, result.time), per_sec(result.reil, result.time));
+
+    first = false;
+}
+
+static bool compare_mnem(const pair<pair<string, string>, bench_mnem> &a,
+                         const pair<pair<string, string>, bench_mnem> &b)
+{
+    return a.second.time > b.second.time;
+}
+
+static void print_mnem(bench_mnem_map &mnem_map, bool json, int top)
+{
+    vector<pair<pair<string, string>, bench_mnem> > mnem_list(mnem_map.begin(), mnem_map.end());
+
+    // most expensive mnemonics goes first
+    sort(mnem_list.begin(), mnem_list.end(), compare_mnem);
+
+    if (!json)
+    {
+        printf("\n%-4s %-12s %10s %10s %12s %10s %10s\n",
+               "arch", "mnemonic", "count", "reil", "time (ms)", "ns/insn", "reil/insn");
+    }
+
+    for (size_t i = 0; i < mnem_list.size(); i += 1)
+    {
+        const string &arch = mnem_list[i].first.first;
+        const string &name = mnem_list[i].first.second;
+        bench_mnem &mnem = mnem_list[i].second;
+
+        if (json)
+        {
+            printf("%s\n    {\"arch\": \"%s\", \"mnem\": \"%s\", \"count\": %llu, "
+                   "\"reil\": %llu, \"time_ns\": %llu}",
+                   i == 0 ? "" : ",", arch.c_str(), json_escape(name).c_str(),
+                   mnem.count, mnem.reil, mnem.time);
+        }
+        else if (top <= 0 || (int)i < top)
+        {
+            printf("%-4s %-12s %10llu %10llu %12.2f %10.0f %10.2f\n",
+                   arch.c_str(), name.c_str(), mnem.count, mnem.reil,
+                   (double)mnem.time / 1000000.0,
+                   (double)mnem.time / mnem.count, (double)mnem.reil / mnem.count);
+        }
+    }
+}
+
+//----------------------------------------------------------------------
+static int parse_modes(const char *str)
+{
+    int modes = 0;
+    string list(str);
+
+    while (!list.empty())
+    {
+        size_t pos = list.find(',');
+        string mode = list.substr(0, pos);
+
+        if (mode == "single") modes |= MODE_SINGLE;
+        else if (mode == "batch") modes |= MODE_BATCH;
+        else if (mode == "cached") modes |= MODE_CACHED;
+        else if (mode == "parallel") modes |= MODE_PARALLEL;
+        else if (mode == "all") modes |= MODE_ALL;
+        else return -1;
+
+        list = pos == string::npos ? string() : list.substr(pos + 1);
+    }
+
+    return modes;
+}
+
+static void usage(void)
+{
+    printf("USAGE: reil-bench [options] file ...\n\n");
+    printf("Options:\n");
+    printf("  -m, --mode <list>     comma separated list of single, batch, cached, parallel or all\n");
+    printf("  -n, --iterations <n>  number of iterations, best time is reported\n");
+    printf("  -j, --jobs <n>        number of worker processes for parallel mode\n");
+    printf("  -t, --top <n>         number of mnemonics to print, 0 for all\n");
+    printf("  -p, --profile <name>  save translation profile into the <name>_<arch>.csv file\n");
+    printf("  --json                print results and profile in JSON format\n\n");
+    printf("Executable sections of 32-bit ELF (x86, ARM) and PE (x86) files are used.\n");
+}
+
+int main(int argc, char *argv[])
+{
+    int modes = MODE_ALL, iterations = 1, top = MNEM_TOP;
+    int jobs = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    bool json = false;
+    char *profile = NULL;
+
+    vector<bench_file> files;
+
+    for (int i = 1; i < argc; i++)
+    {
+        char *arg = argv[i];
+
+        if ((!strcmp(arg, "--mode") || !strcmp(arg, "-m")) && i < argc - 1)
+        {
+            if ((modes = parse_modes(argv[++i])) <= 0)
+            {
+                printf("ERROR: Bad mode\n");
+                return -1;
+            }
+        }
+        else if ((!strcmp(arg, "--iterations") || !strcmp(arg, "-n")) && i < argc - 1)
+        {
+            iterations = max(1, atoi(argv[++i]));
+        }
+        else if ((!strcmp(arg, "--jobs") || !strcmp(arg, "-j")) && i < argc - 1)
+        {
+            jobs = atoi(argv[++i]);
+        }
+        else if ((!strcmp(arg, "--top") || !strcmp(arg, "-t")) && i < argc - 1)
+        {
+            top = atoi(argv[++i]);
+        }
+        else if ((!strcmp(arg, "--profile") || !strcmp(arg, "-p")) && i < argc - 1)
+        {
+            profile = argv[++i];
+        }
+        else if (!strcmp(arg, "--json"))
+        {
+            json = true;
+        }
+        else if (arg[0] == '-')
+        {
+            usage();
+            return -1;
+        }
+        else
+        {
+            bench_file file;
+
+            if (!load_file(arg, file))
+            {
+                return -1;
+            }
+
+            files.push_back(file);
+        }
+    }
+
+    if (files.empty())
+    {
+        usage();
+        return 0;
+    }
+
+    jobs = max(1, jobs);
+
+#ifdef _WIN32
+
+    // fork() is not available
+    modes &= ~MODE_PARALLEL;
+
+#endif
+
+    // translation errors are expected during linear sweep
+    reil_log_init(REIL_LOG_NONE, NULL);
+
+    bench_result total[4];
+    memset(total, 0, sizeof(total));
+
+    const char *mode_names[] = { "single", "batch", "cached", "parallel" };
+
+    bench_mnem_map mnem_map;
+    bool first = true;
+
+    // linear sweep translator for each architecture, also used for profiling
+    bench_context sweep_context;
+    reil_t sweep_reil[2] = { NULL, NULL };
+
+    memset(&sweep_context, 0, sizeof(sweep_context));
+
+    if (json)
+    {
+        printf("{\n  \"jobs\": %d, \"iterations\": %d,\n  \"results\": [", jobs, iterations);
+    }
+
+    for (size_t f = 0; f < files.size(); f += 1)
+    {
+        bench_file &file = files[f];
+        bench_result file_result[4];
+        bench_result sweep;
+
+        memset(file_result, 0, sizeof(file_result));
+        memset(&sweep, 0, sizeof(sweep));
+
+        for (size_t s = 0; s < file.sections.size(); s += 1)
+        {
+            bench_section &section = file.sections[s];
+
+            if (sweep_reil[section.arch] == NULL)
+            {
+                sweep_reil[section.arch] = reil_init(section.arch, bench_inst_handler, &sweep_context);
+                assert(sweep_reil[section.arch]);
+
+                reil_profile_enable(sweep_reil[section.arch], profile != NULL);
+            }
+
+            bench_sweep(sweep_reil[section.arch], section, sweep);
+        }
+
+        for (int m = 0; m < 3; m += 1)
+        {
+            if (!(modes & (1 << m)))
+            {
+                continue;
+            }
+
+            for (int n = 0; n < iterations; n += 1)
+            {
+                bench_result result;
+                memset(&result, 0, sizeof(result));
+
+                for (size_t s = 0; s < file.sections.size(); s += 1)
+                {
+                    bench_section &section = file.sections[s];
+
+                    switch (1 << m)
+                    {
+                    case MODE_SINGLE:
+
+                        bench_single(section, result);
+                        break;
+
+                    case MODE_BATCH:
+
+                        // collect per-mnemonic statistics only once
+                        bench_batch(section, result, n == 0 ? &mnem_map : NULL);
+                        break;
+
+                    case MODE_CACHED:
+
+                        bench_cached(section, result);
+                        break;
+                    }
+                }
+
+                // keep the best time
+                if (n == 0 || result.time < file_result[m].time)
+                {
+                    file_result[m] = result;
+                }
+            }
+
+            file_result[m].failed = sweep.failed;
+
+            total[m].insn += file_result[m].insn;
+            total[m].reil += file_result[m].reil;
+            total[m].bytes += file_result[m].bytes;
+            total[m].failed += file_result[m].failed;
+            total[m].hits += file_result[m].hits;
+            total[m].misses += file_result[m].misses;
+            total[m].time += file_result[m].time;
+
+            if (json)
+            {
+                print_result_json(first, file.path, arch_name(file.sections.empty() ? ARCH_X86 :
+                                                              file.sections[0].arch),
+                                  mode_names[m], file_result[m]);
+            }
+            else
+            {
+                const char *name = strrchr(file.path.c_str(), '/');
+
+                print_result_text(name ? name + 1 : file.path.c_str(), mode_names[m], file_result[m]);
+            }
+        }
+    }
+
+#ifndef _WIN32
+
+    if (modes & MODE_PARALLEL)
+    {
+        for (int n = 0; n < iterations; n += 1)
+        {
+            bench_result result;
+            memset(&result, 0, sizeof(result));
+
+            bench_parallel(files, jobs, result);
+
+            if (n == 0 || result.time < total[3].time)
+            {
+                total[3] = result;
+            }
+        }
+    }
+
+#endif // _WIN32
+
+    if (json)
+    {
+        printf("\n  ],\n  \"total\": [");
+
+        first = true;
+
+        for (int m = 0; m < 4; m += 1)
+        {
+            if (modes & (1 << m))
+            {
+                print_result_json(first, string("*"), "*", mode_names[m], total[m]);
+            }
+        }
+
+        printf("\n  ],\n  \"mnemonics\": [");
+
+        print_mnem(mnem_map, true, 0);
+
+        printf("\n  ]\n}\n");
+    }
+    else
+    {
+        printf("\n");
+
+        for (int m = 0; m < 4; m += 1)
+        {
+            if (modes & (1 << m))
+            {
+                print_result_text("total", mode_names[m], total[m]);
+            }
+        }
+
+        if (modes & MODE_BATCH)
+        {
+            print_mnem(mnem_map, false, top);
+        }
+    }
+
+    for (int a = ARCH_X86; a <= ARCH_ARM; a += 1)
+    {
+        if (sweep_reil[a] == NULL)
+        {
+            continue;
+        }
+
+        if (profile)
+        {
+            string path = string(profile) + "_" + arch_name((reil_arch_t)a) + (json ? ".json" : ".csv");
+
+            if (reil_profile_dump(sweep_reil[a], path.c_str(), 
+                                  json ? REIL_PROFILE_JSON : REIL_PROFILE_CSV) == REIL_ERROR)
+            {
+                fprintf(stderr, "ERROR: Unable to save profile into the %s\n", path.c_str());
+            }
+        }
+
+        reil_close(sweep_reil[a]);
+    }
+
+    return 0;
+}
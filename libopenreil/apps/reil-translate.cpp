@@ -0,0 +1,770 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <assert.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/types.h>
+
+#ifndef _WIN32
+
+#include <sys/wait.h>
+
+#endif
+
+#include <string>
+#include <vector>
+#include <algorithm>
+
+using namespace std;
+
+#include "libopenreil.h"
+#include "exe-loader.h"
+
+#define LOG_NAME "reil-translate.log"
+
+// size of the output buffer
+#define OUT_BUFF_SIZE 0x100000
+
+// number of bytes to translate before chunk start to find instruction boundary
+#define PREROLL_LEN 0x40
+
+// max. length of input record line
+#define RECORD_MAX_LEN 0x1000
+
+#define OUT_TEXT    0
+#define OUT_BINARY  1
+#define OUT_JSON    2
+
+/*
+    Fixed-width little endian record of binary output format,
+    one record for each IR instruction.
+*/
+typedef struct _reil_rec_arg_t
+{
+    uint8_t type;       // reil_type_t
+    uint8_t size;       // reil_size_t
+    uint16_t inum;      // IR instruction number for A_LOC
+    uint32_t reserved;
+    uint64_t val;       // A_CONST value or A_LOC address
+    char name[16];      // A_REG or A_TEMP name
+
+} reil_rec_arg_t;
+
+typedef struct _reil_rec_t
+{
+    uint64_t addr;      // address of the machine instruction
+    uint32_t size;      // .. and it's size
+    uint16_t inum;      // IR instruction number
+    uint8_t op;         // reil_op_t
+    uint8_t reserved;
+    uint64_t flags;     // IOPT_* flags
+    reil_rec_arg_t a, b, c;
+
+} reil_rec_t;
+
+// make sure that compiler doesn't change record layout
+typedef char reil_rec_size_check[sizeof(reil_rec_t) == 120 ? 1 : -1];
+
+typedef struct _input_chunk
+{
+    reil_arch_t arch;
+    reil_addr_t addr;
+    vector<uint8_t> data;
+
+} input_chunk;
+
+/*
+    Part of the input chunk that is translated by one worker.
+*/
+typedef struct _work_piece
+{
+    size_t chunk;
+    int start, end;
+
+    // translation starts at (start - preroll) but IR is emitted only from start
+    int preroll;
+
+} work_piece;
+
+typedef struct _translate_result
+{
+    unsigned long long insn;
+    unsigned long long reil;
+    unsigned long long bytes;
+    unsigned long long failed;
+    unsigned long long out_bytes;
+
+} translate_result;
+
+typedef struct _translate_context
+{
+    FILE *fd;
+    int format;
+    bool emit;
+
+    // architecture of the chunk that is being translated
+    reil_arch_t arch;
+
+    translate_result *result;
+
+} translate_context;
+
+static unsigned long long time_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+//----------------------------------------------------------------------
+// Output formats
+//----------------------------------------------------------------------
+static size_t write_text(FILE *fd, reil_arch_t arch, reil_inst_t *inst, bool json)
+{
+    char buff[REIL_INST_JSON_MAX_LEN];
+
+    int len = json ? reil_inst_to_json(arch, inst, buff, sizeof(buff) - 1) :
+                     reil_inst_to_str(inst, buff, sizeof(buff) - 1);
+    if (len == REIL_ERROR)
+    {
+        return 0;
+    }
+
+    buff[len] = '\n';
+
+    return fwrite(buff, 1, len + 1, fd);
+}
+
+static void convert_arg(reil_rec_arg_t *rec, reil_arg_t *arg)
+{
+    rec->type = (uint8_t)arg->type;
+    rec->size = (uint8_t)arg->size;
+    rec->inum = (uint16_t)arg->inum;
+    rec->val = arg->val;
+
+    if (arg->type == A_REG || arg->type == A_TEMP)
+    {
+        strncpy(rec->name, arg->name, sizeof(rec->name) - 1);
+    }
+}
+
+static size_t write_binary(FILE *fd, reil_inst_t *inst)
+{
+    reil_rec_t rec;
+    memset(&rec, 0, sizeof(rec));
+
+    rec.addr = inst->raw_info.addr;
+    rec.size = (uint32_t)inst->raw_info.size;
+    rec.inum = (uint16_t)inst->inum;
+    rec.op = (uint8_t)inst->op;
+    rec.flags = inst->flags;
+
+    convert_arg(&rec.a, &inst->a);
+    convert_arg(&rec.b, &inst->b);
+    convert_arg(&rec.c, &inst->c);
+
+    return fwrite(&rec, sizeof(rec), 1, fd) * sizeof(rec);
+}
+
+int reil_inst_handler(reil_inst_t *inst, void *context)
+{
+    translate_context *c = (translate_context *)context;
+
+    if (c->emit)
+    {
+        c->result->out_bytes += c->format == OUT_BINARY ? write_binary(c->fd, inst) :
+                                write_text(c->fd, c->arch, inst, c->format == OUT_JSON);
+        c->result->reil += 1;
+    }
+
+    return 0;
+}
+
+//----------------------------------------------------------------------
+// Input parsing
+//----------------------------------------------------------------------
+static int hex_digit(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+
+    return -1;
+}
+
+/*
+    Read "<address> <hex bytes>" records from the stream, one record per line.
+*/
+static bool read_records(FILE *fd, reil_arch_t arch, vector<input_chunk> &chunks)
+{
+    char line[RECORD_MAX_LEN];
+    int line_num = 0;
+
+    while (fgets(line, sizeof(line), fd))
+    {
+        char *ptr = line, *end = NULL;
+
+        line_num += 1;
+
+        while (*ptr == ' ' || *ptr == '\t') ptr += 1;
+
+        // skip empty lines and comments
+        if (*ptr == '\0' || *ptr == '\r' || *ptr == '\n' || *ptr == '#')
+        {
+            continue;
+        }
+
+        input_chunk chunk;
+
+        chunk.arch = arch;
+        chunk.addr = strtoull(ptr, &end, 16);
+
+        if (end == ptr)
+        {
+            fprintf(stderr, "ERROR: Bad address at line %d\n", line_num);
+            return false;
+        }
+
+        if (*end == ':') end += 1;
+
+        for (ptr = end; *ptr != '\0';)
+        {
+            if (*ptr == ' ' || *ptr == '\t' || *ptr == '\r' || *ptr == '\n')
+            {
+                ptr += 1;
+                continue;
+            }
+
+            int hi = hex_digit(ptr[0]), lo = hex_digit(ptr[1]);
+            if (hi == -1 || lo == -1)
+            {
+                fprintf(stderr, "ERROR: Bad instruction bytes at line %d\n", line_num);
+                return false;
+            }
+
+            chunk.data.push_back((uint8_t)((hi << 4) | lo));
+            ptr += 2;
+        }
+
+        if (!chunk.data.empty())
+        {
+            chunks.push_back(input_chunk());
+            chunks.back().arch = chunk.arch;
+            chunks.back().addr = chunk.addr;
+            chunks.back().data.swap(chunk.data);
+        }
+    }
+
+    return true;
+}
+
+/*
+    Split input chunks into pieces and distribute them between workers,
+    each worker gets contiguous range of pieces to keep output ordered.
+*/
+static void split_work(vector<input_chunk> &chunks, int jobs, bool thumb,
+                       vector<vector<work_piece> > &work)
+{
+    unsigned long long total = 0, done = 0;
+
+    for (size_t i = 0; i < chunks.size(); i += 1)
+    {
+        total += chunks[i].data.size();
+    }
+
+    work.assign(jobs, vector<work_piece>());
+
+    int piece_len = (int)max(1ULL, (total + jobs - 1) / jobs);
+
+    for (size_t i = 0; i < chunks.size(); i += 1)
+    {
+        input_chunk &chunk = chunks[i];
+        int size = (int)chunk.data.size();
+
+        // ARM instructions are aligned and have fixed length
+        int align = chunk.arch == ARCH_ARM ? (thumb ? 2 : 4) : 1;
+        int preroll = chunk.arch == ARCH_ARM && !thumb ? 0 : PREROLL_LEN;
+
+        for (int start = 0; start < size;)
+        {
+            work_piece piece;
+            int end = min(size, start + piece_len);
+
+            end = end < size ? end - end % align : end;
+            end = end <= start ? min(size, start + piece_len) : end;
+
+            piece.chunk = i;
+            piece.start = start;
+            piece.end = end;
+            piece.preroll = min(start, preroll);
+
+            int worker = (int)min((unsigned long long)jobs - 1, done * jobs / max(1ULL, total));
+
+            work[worker].push_back(piece);
+
+            done += end - start;
+            start = end;
+        }
+    }
+}
+
+//----------------------------------------------------------------------
+// Translation
+//----------------------------------------------------------------------
+static void translate_pieces(vector<input_chunk> &chunks, vector<work_piece> &pieces,
+                             bool thumb, FILE *fd, int format, translate_result &result)
+{
+    translate_context context;
+    reil_t reil[2] = { NULL, NULL };
+
+    context.fd = fd;
+    context.format = format;
+    context.emit = false;
+    context.result = &result;
+
+    for (size_t i = 0; i < pieces.size(); i += 1)
+    {
+        input_chunk &chunk = chunks[pieces[i].chunk];
+        int offset = pieces[i].start - pieces[i].preroll, size = (int)chunk.data.size();
+        int skip = chunk.arch == ARCH_ARM ? (thumb ? 2 : 4) : 1;
+
+        if (reil[chunk.arch] == NULL)
+        {
+            reil[chunk.arch] = reil_init(chunk.arch, reil_inst_handler, &context);
+            assert(reil[chunk.arch]);
+        }
+
+        context.arch = chunk.arch;
+
+        while (offset < pieces[i].end)
+        {
+            uint8_t inst_buff[MAX_INST_LEN];
+            int copy_len = min(MAX_INST_LEN, size - offset);
+            reil_addr_t addr = chunk.addr + offset;
+
+            // instruction bytes at the end of the chunk are padded with zeros
+            memset(inst_buff, 0, sizeof(inst_buff));
+            memcpy(inst_buff, &chunk.data[offset], copy_len);
+
+            // preroll instructions are translated only to find instruction boundary
+            context.emit = offset >= pieces[i].start;
+
+            if (thumb && chunk.arch == ARCH_ARM)
+            {
+                addr = REIL_ARM_THUMB(addr);
+            }
+
+            int inst_len = reil_translate_insn(reil[chunk.arch], addr, inst_buff, MAX_INST_LEN);
+            if (inst_len == REIL_ERROR)
+            {
+                if (context.emit) result.failed += 1;
+
+                offset += skip;
+                continue;
+            }
+
+            if (context.emit)
+            {
+                result.insn += 1;
+                result.bytes += inst_len;
+            }
+
+            offset += inst_len;
+        }
+    }
+
+    for (int i = 0; i < 2; i += 1)
+    {
+        if (reil[i]) reil_close(reil[i]);
+    }
+}
+
+static void add_result(translate_result &dst, translate_result &src)
+{
+    dst.insn += src.insn;
+    dst.reil += src.reil;
+    dst.bytes += src.bytes;
+    dst.failed += src.failed;
+    dst.out_bytes += src.out_bytes;
+}
+
+#ifndef _WIN32
+
+/*
+    VEX keeps its state in global variables, so worker processes are used
+    instead of threads. Each worker writes its output into the temporary
+    file that are copied into the output file in order.
+*/
+static bool translate_parallel(vector<input_chunk> &chunks, vector<vector<work_piece> > &work,
+                               bool thumb, FILE *out, int format, translate_result &result)
+{
+    vector<pid_t> workers;
+    vector<int> pipes;
+    vector<FILE *> files;
+    bool ret = true;
+
+    for (size_t n = 0; n < work.size(); n += 1)
+    {
+        int fd[2];
+        FILE *tmp = tmpfile();
+
+        if (tmp == NULL || pipe(fd) != 0)
+        {
+            fprintf(stderr, "ERROR: Unable to create worker output\n");
+            exit(-1);
+        }
+
+        pid_t pid = fork();
+        if (pid < 0)
+        {
+            fprintf(stderr, "ERROR: fork() fails\n");
+            exit(-1);
+        }
+        else if (pid == 0)
+        {
+            translate_result worker_result;
+            memset(&worker_result, 0, sizeof(worker_result));
+
+            close(fd[0]);
+
+            setvbuf(tmp, NULL, _IOFBF, OUT_BUFF_SIZE);
+            translate_pieces(chunks, work[n], thumb, tmp, format, worker_result);
+            fflush(tmp);
+
+            if (write(fd[1], &worker_result, sizeof(worker_result)) != sizeof(worker_result))
+            {
+                _exit(-1);
+            }
+
+            close(fd[1]);
+            _exit(0);
+        }
+
+        close(fd[1]);
+
+        workers.push_back(pid);
+        pipes.push_back(fd[0]);
+        files.push_back(tmp);
+    }
+
+    for (size_t n = 0; n < work.size(); n += 1)
+    {
+        translate_result worker_result;
+        int status = 0;
+
+        if (read(pipes[n], &worker_result, sizeof(worker_result)) == sizeof(worker_result))
+        {
+            add_result(result, worker_result);
+        }
+        else
+        {
+            fprintf(stderr, "ERROR: Worker %d fails\n", (int)n);
+            ret = false;
+        }
+
+        close(pipes[n]);
+        waitpid(workers[n], &status, 0);
+
+        // copy worker output
+        char buff[0x10000];
+        size_t len = 0;
+
+        rewind(files[n]);
+
+        while ((len = fread(buff, 1, sizeof(buff), files[n])) > 0)
+        {
+            fwrite(buff, 1, len, out);
+        }
+
+        fclose(files[n]);
+    }
+
+    return ret;
+}
+
+#endif // _WIN32
+
+//----------------------------------------------------------------------
+static bool parse_arch(const char *name, reil_arch_t *arch)
+{
+    if (!strcmp(name, "i386") || !strcmp(name, "x86"))
+    {
+        *arch = ARCH_X86;
+        return true;
+    }
+    else if (!strcmp(name, "arm"))
+    {
+        *arch = ARCH_ARM;
+        return true;
+    }
+
+    return false;
+}
+
+static void usage(void)
+{
+    printf("USAGE: reil-translate [options] <input>\n\n");
+    printf("Input options (raw file by default, \"-\" stands for stdin):\n");
+    printf("  -a, --arch <arch>     architecture of raw input: x86 or arm\n");
+    printf("  -e, --exe             input is ELF or PE file, translate executable sections\n");
+    printf("  -s, --section <name>  translate only specified section of ELF or PE file\n");
+    printf("  -r, --records         input is a stream of \"<address> <hex bytes>\" lines\n");
+    printf("  --addr <address>      address of raw input, default is 0\n");
+    printf("  --offset <n>          offset of the code inside raw input or section\n");
+    printf("  --size <n>            size of the code\n");
+    printf("  -t, --thumb           disassemble ARM code in Thumb mode\n\n");
+    printf("Output options:\n");
+    printf("  -o, --output <path>   output file, default is stdout\n");
+    printf("  -b, --binary          write fixed-width binary records instead of text\n");
+    printf("  --json                write JSON lines compatible with pyopenreil InsnJson\n");
+    printf("  -j, --jobs <n>        number of worker processes\n");
+    printf("  -q, --quiet           don't print throughput report to stderr\n");
+    printf("  -d, --debug           write debug log into the %s\n", LOG_NAME);
+}
+
+int main(int argc, char *argv[])
+{
+    reil_arch_t arch = ARCH_X86;
+    bool arch_set = false, exe = false, records = false, thumb = false, quiet = false, debug = false;
+    int format = OUT_TEXT, jobs = 1;
+    char *input = NULL, *output = NULL, *section_name = NULL;
+    unsigned long long base = 0, offset = 0, size = 0;
+
+    vector<input_chunk> chunks;
+
+    for (int i = 1; i < argc; i++)
+    {
+        char *arg = argv[i];
+        bool has_val = i < argc - 1;
+
+        if ((!strcmp(arg, "--arch") || !strcmp(arg, "-a")) && has_val)
+        {
+            if (!parse_arch(argv[++i], &arch))
+            {
+                fprintf(stderr, "ERROR: Bad architecture\n");
+                return -1;
+            }
+
+            arch_set = true;
+        }
+        else if (!strcmp(arg, "--exe") || !strcmp(arg, "-e"))
+        {
+            exe = true;
+        }
+        else if ((!strcmp(arg, "--section") || !strcmp(arg, "-s")) && has_val)
+        {
+            exe = true;
+            section_name = argv[++i];
+        }
+        else if (!strcmp(arg, "--records") || !strcmp(arg, "-r"))
+        {
+            records = true;
+        }
+        else if (!strcmp(arg, "--addr") && has_val)
+        {
+            base = strtoull(argv[++i], NULL, 16);
+        }
+        else if (!strcmp(arg, "--offset") && has_val)
+        {
+            offset = strtoull(argv[++i], NULL, 0);
+        }
+        else if (!strcmp(arg, "--size") && has_val)
+        {
+            size = strtoull(argv[++i], NULL, 0);
+        }
+        else if (!strcmp(arg, "--thumb") || !strcmp(arg, "-t"))
+        {
+            thumb = true;
+        }
+        else if ((!strcmp(arg, "--output") || !strcmp(arg, "-o")) && has_val)
+        {
+            output = argv[++i];
+        }
+        else if (!strcmp(arg, "--binary") || !strcmp(arg, "-b"))
+        {
+            format = OUT_BINARY;
+        }
+        else if (!strcmp(arg, "--json"))
+        {
+            format = OUT_JSON;
+        }
+        else if ((!strcmp(arg, "--jobs") || !strcmp(arg, "-j")) && has_val)
+        {
+            jobs = max(1, atoi(argv[++i]));
+        }
+        else if (!strcmp(arg, "--quiet") || !strcmp(arg, "-q"))
+        {
+            quiet = true;
+        }
+        else if (!strcmp(arg, "--debug") || !strcmp(arg, "-d"))
+        {
+            debug = true;
+        }
+        else if (arg[0] == '-' && arg[1] != '\0')
+        {
+            usage();
+            return -1;
+        }
+        else
+        {
+            input = arg;
+        }
+    }
+
+    if (input == NULL && !records)
+    {
+        usage();
+        return 0;
+    }
+
+    if (exe)
+    {
+        vector<exe_section> sections;
+
+        if (!exe_load(input, sections))
+        {
+            return -1;
+        }
+
+        for (size_t i = 0; i < sections.size(); i += 1)
+        {
+            if (section_name && sections[i].name != section_name)
+            {
+                continue;
+            }
+
+            input_chunk chunk;
+            vector<uint8_t> &data = sections[i].data;
+
+            unsigned long long start = min(offset, (unsigned long long)data.size());
+            unsigned long long end = size > 0 ? min(start + size, (unsigned long long)data.size()) : data.size();
+
+            chunks.push_back(chunk);
+            chunks.back().arch = sections[i].arch;
+            chunks.back().addr = sections[i].addr + start;
+            chunks.back().data.assign(data.begin() + start, data.begin() + end);
+        }
+
+        if (chunks.empty())
+        {
+            fprintf(stderr, "ERROR: There's no executable sections to translate\n");
+            return -1;
+        }
+    }
+    else if (records)
+    {
+        FILE *fd = input == NULL || !strcmp(input, "-") ? stdin : fopen(input, "r");
+        if (fd == NULL)
+        {
+            fprintf(stderr, "ERROR: Unable to open %s\n", input);
+            return -1;
+        }
+
+        bool ok = read_records(fd, arch, chunks);
+
+        if (fd != stdin) fclose(fd);
+        if (!ok) return -1;
+    }
+    else
+    {
+        vector<uint8_t> data;
+        input_chunk chunk;
+
+        if (!arch_set)
+        {
+            fprintf(stderr, "ERROR: Architecture of raw input must be specified\n");
+            return -1;
+        }
+
+        if (!exe_read_file(input, data))
+        {
+            fprintf(stderr, "ERROR: Unable to read %s\n", input);
+            return -1;
+        }
+
+        unsigned long long start = min(offset, (unsigned long long)data.size());
+        unsigned long long end = size > 0 ? min(start + size, (unsigned long long)data.size()) : data.size();
+
+        chunks.push_back(chunk);
+        chunks.back().arch = arch;
+        chunks.back().addr = base;
+        chunks.back().data.assign(data.begin() + start, data.begin() + end);
+    }
+
+    FILE *out = output ? fopen(output, "wb") : stdout;
+    if (out == NULL)
+    {
+        fprintf(stderr, "ERROR: Unable to create %s\n", output);
+        return -1;
+    }
+
+    setvbuf(out, NULL, _IOFBF, OUT_BUFF_SIZE);
+
+#ifdef _WIN32
+
+    // fork() is not available
+    jobs = 1;
+
+#endif
+
+    if (debug)
+    {
+        reil_log_init(REIL_LOG_ALL, LOG_NAME);
+    }
+    else
+    {
+        // translation errors are expected for data inside code sections
+        reil_log_init(REIL_LOG_NONE, NULL);
+    }
+
+    vector<vector<work_piece> > work;
+    translate_result result;
+    bool ok = true;
+
+    memset(&result, 0, sizeof(result));
+    split_work(chunks, jobs, thumb, work);
+
+    unsigned long long start = time_ns();
+
+    if (jobs == 1)
+    {
+        translate_pieces(chunks, work[0], thumb, out, format, result);
+    }
+
+#ifndef _WIN32
+
+    else
+    {
+        ok = translate_parallel(chunks, work, thumb, out, format, result);
+    }
+
+#endif
+
+    fflush(out);
+
+    unsigned long long time = max(1ULL, time_ns() - start);
+
+    if (output)
+    {
+        fclose(out);
+    }
+
+    if (!quiet)
+    {
+        double sec = (double)time / 1000000000.0;
+
+        fprintf(stderr, "[+] %llu instructions (%llu bytes, %llu failed) translated into "
+                        "%llu IR instructions in %.3f sec\n",
+                result.insn, result.bytes, result.failed, result.reil, sec);
+
+        fprintf(stderr, "[+] %.0f insn/s, %.0f IR insn/s, %.2f MB/s of output\n",
+                result.insn / sec, result.reil / sec, result.out_bytes / sec / 1048576.0);
+    }
+
+    return ok ? 0 : -1;
+}
@@ -9,6 +9,22 @@
 // max. size of one machine instruction (all arhitectures)
 #define MAX_INST_LEN 24
 
+// max. length of instruction mnemonic in profile entry
+#define REIL_MAX_MNEM_LEN 32
+
+// buffer sizes that are enough for reil_inst_to_str() and reil_inst_to_json()
+#define REIL_INST_STR_MAX_LEN   0x100
+#define REIL_INST_JSON_MAX_LEN  0x800
+
+/*
+    Instruction attributes keys of JSON representation, 
+    see IATTR_* constants in pyopenreil.
+*/
+#define REIL_IATTR_ASM      0   // assembly instruction mnemonic and operands
+#define REIL_IATTR_BIN      1   // instruction bytes
+#define REIL_IATTR_FLAGS    2   // IOPT_* flags
+#define REIL_IATTR_REP      6   // rep-prefixed string instruction information
+
 // return value that indicates initialization/translation error
 #define REIL_ERROR -1
 
@@ -45,6 +61,60 @@
 
 typedef void * reil_t;
 
+/*
+    Cumulative time (in nanoseconds) and number of calls of single translation stage.
+*/
+typedef struct _reil_stats_stage_t
+{
+    unsigned long long time;
+    unsigned long long count;
+
+} reil_stats_stage_t;
+
+/*
+    Translator statistics, see reil_get_stats().
+*/
+typedef struct _reil_stats_t
+{
+    reil_stats_stage_t disasm;      // capstone instruction decoding
+    reil_stats_stage_t vex;         // LibVEX_Translate()
+    reil_stats_stage_t irbb;        // translate_irbb()
+    reil_stats_stage_t bap;         // generate_bap_ir() post-passes
+    reil_stats_stage_t bil;         // process_bil() excluding handler time
+    reil_stats_stage_t handler;     // user-specified instruction handler
+
+    unsigned long long insn_translated;     // translated machine instructions
+    unsigned long long insn_unknown;        // instructions that wasn't translated by VEX
+    unsigned long long insn_failed;         // instructions that caused translation error
+    unsigned long long reil_emitted;        // generated IR instructions
+    unsigned long long temp_allocated;      // allocated temp registers
+    unsigned long long vex_mem_max;         // VEX memory arena high-water mark
+
+} reil_stats_t;
+
+/*
+    Translation profile of the machine instructions with the same
+    mnemonic and capstone ID, see reil_profile_get().
+*/
+typedef struct _reil_profile_entry_t
+{
+    unsigned int id;                    // capstone instruction ID
+    char mnem[REIL_MAX_MNEM_LEN];       // instruction mnemonic
+
+    unsigned long long count;           // number of translated instructions
+    unsigned long long reil_emitted;    // generated IR instructions
+    unsigned long long temp_allocated;  // allocated temp registers
+    unsigned long long time;            // translation time in nanoseconds excluding handler time
+
+} reil_profile_entry_t;
+
+typedef enum _reil_profile_format_t
+{
+    REIL_PROFILE_CSV,
+    REIL_PROFILE_JSON
+
+} reil_profile_format_t;
+
 typedef enum _reil_arch_t 
 { 
     ARCH_X86, 
@@ -52,6 +122,377 @@ typedef enum _reil_arch_t
 
 } reil_arch_t;
 
+typedef void * reil_vm_t;
+typedef void * reil_mem_t;
+
+typedef void * reil_vm_snapshot_t;
+typedef void * reil_mem_snapshot_t;
+typedef void * reil_vm_batch_t;
+typedef void * reil_cfg_t;
+typedef void * reil_ssa_t;
+typedef void * reil_sym_t;
+
+// guest memory page size, see reil_mem_init()
+#define REIL_MEM_PAGE_SIZE 0x1000
+
+// default lowest accessible address (NULL pointers detection)
+#define REIL_MEM_LOWEST_ADDR 0x1000
+
+// start address for reil_mem_alloc_addr() allocations
+#define REIL_MEM_ALLOC_BASE 0x11000000
+
+/*
+    Guest memory access errors, see reil_mem_get_error().
+*/
+typedef enum _reil_mem_error_t
+{
+    REIL_MEM_OK,
+    REIL_MEM_ERR_READ,      // memory at given address is not accessible
+    REIL_MEM_ERR_WRITE,     
+    REIL_MEM_ERR_NULL       // NULL pointer access
+
+} reil_mem_error_t;
+
+/*
+    Return codes of reil_vm_run().
+*/
+typedef enum _reil_vm_status_t
+{
+    REIL_VM_STOP,       // stop point was reached
+    REIL_VM_ERR_FETCH,  // instruction to execute is not available
+    REIL_VM_ERR_INSN,   // invalid or unknown instruction
+    REIL_VM_ERR_MEM,    // memory access error
+    REIL_VM_ERR_HOOK    // hook handler returned error
+
+} reil_vm_status_t;
+
+// inum value of reil_vm_stop_add() to stop at any IR instruction of given address
+#define REIL_VM_ANY_INUM -1
+
+/*
+    Location of the current instruction and number of executed IR
+    instructions since reil_vm_init() call, see reil_vm_get_state().
+*/
+typedef struct _reil_vm_state_t
+{
+    reil_addr_t addr;
+    reil_inum_t inum;
+    unsigned long long executed;
+
+} reil_vm_state_t;
+
+/*
+    Interpreter register information, see reil_vm_reg_list().
+*/
+typedef struct _reil_vm_reg_t
+{
+    char name[REIL_MAX_NAME_LEN];
+    reil_size_t size;
+    reil_const_t val;
+    int temp;
+
+} reil_vm_reg_t;
+
+/*
+    Rep-prefixed string instruction information, see reil_vm_rep_add().
+*/
+typedef enum _reil_vm_rep_op_t
+{
+    REIL_VM_REP_MOVS,
+    REIL_VM_REP_STOS,
+    REIL_VM_REP_CMPS,
+    REIL_VM_REP_SCAS
+
+} reil_vm_rep_op_t;
+
+typedef enum _reil_vm_rep_cond_t
+{
+    REIL_VM_REP_ALWAYS, // rep
+    REIL_VM_REP_EQ,     // repe, repz
+    REIL_VM_REP_NE      // repne, repnz
+
+} reil_vm_rep_cond_t;
+
+typedef struct _reil_vm_rep_t
+{
+    reil_vm_rep_op_t op;
+    reil_vm_rep_cond_t cond;
+
+    // element size in bytes
+    int size;
+
+    // names of counter, source and destination pointers, value (for STOS and SCAS)
+    // and direction registers, NULL for registers that are not used by operation
+    const char *count, *src, *dst, *val, *dir;
+
+} reil_vm_rep_t;
+
+/*
+    Event types of the execution hooks, see reil_vm_hook_set().
+*/
+#define REIL_VM_HOOK_INSN       0x01    // machine instruction execution
+#define REIL_VM_HOOK_BB         0x02    // basic block entry
+#define REIL_VM_HOOK_MEM_READ   0x04    // memory read
+#define REIL_VM_HOOK_MEM_WRITE  0x08    // memory write
+#define REIL_VM_HOOK_UNK        0x10    // unknown instruction
+#define REIL_VM_HOOK_TAINT_JUMP 0x20    // jump to tainted address
+#define REIL_VM_HOOK_TAINT_COND 0x40    // conditional jump with tainted condition
+#define REIL_VM_HOOK_TAINT_MEM  0x80    // memory access at tainted address
+#define REIL_VM_HOOK_TAINT_SINK 0x100   // tainted register at sink address
+
+typedef struct _reil_vm_event_t
+{
+    int type;
+
+    // location of the IR instruction that caused an event
+    reil_addr_t addr;
+    reil_inum_t inum;
+
+    // accessed memory and value for REIL_VM_HOOK_MEM_READ and REIL_VM_HOOK_MEM_WRITE
+    reil_addr_t mem_addr;
+    reil_size_t mem_size;
+    reil_const_t val;
+
+} reil_vm_event_t;
+
+/*
+    Taint tracking options, see reil_vm_taint_enable(). Taint events are reported
+    with taint bits of the operand in val field of reil_vm_event_t, mem_addr field
+    holds accessed address for REIL_VM_HOOK_TAINT_MEM, jump target for 
+    REIL_VM_HOOK_TAINT_JUMP, condition value for REIL_VM_HOOK_TAINT_COND and
+    sink ID for REIL_VM_HOOK_TAINT_SINK.
+*/
+#define REIL_TAINT_BYTES        0x01    // track taint of whole bytes instead of bits
+#define REIL_TAINT_ADDR         0x02    // memory access at tainted address taints the value
+
+/*
+    Basic block hit counter, see reil_vm_cov_list().
+*/
+typedef struct _reil_vm_cov_t
+{
+    reil_addr_t addr;
+    reil_inum_t inum;
+    unsigned long long hits;
+
+} reil_vm_cov_t;
+
+// size of the edge coverage bitmap, see reil_vm_cov_map()
+#define REIL_VM_COV_MAP_SIZE 0x10000
+
+/*
+    Called by interpreter when IR instruction at given address is not loaded yet, 
+    callback must load it using reil_vm_load() or reil_vm_load_next(). Callback
+    also can load the rest of basic block at once, loaded instructions are linked
+    together on their first execution, so the callback is never called for them.
+*/
+typedef int (* reil_vm_fetch_t)(reil_vm_t vm, reil_addr_t addr, reil_inum_t inum, void *context);
+
+/*
+    Memory access callbacks, must return REIL_ERROR when memory at given 
+    address is not accessible.
+*/
+typedef int (* reil_vm_mem_read_t)(reil_addr_t addr, reil_size_t size, reil_const_t *val, void *context);
+typedef int (* reil_vm_mem_write_t)(reil_addr_t addr, reil_size_t size, reil_const_t val, void *context);
+
+/*
+    Called by interpreter with queued execution events, must return REIL_ERROR 
+    to stop the execution with REIL_VM_ERR_HOOK status.
+*/
+typedef int (* reil_vm_hook_t)(reil_vm_t vm, reil_vm_event_t *events, int count, void *context);
+
+/*
+    Called by guest memory when accessed range is not available, callback may make 
+    it accessible with reil_mem_alloc() (for example, by reading executable image 
+    contents) or return REIL_ERROR.
+*/
+typedef int (* reil_mem_fault_t)(reil_mem_t mem, reil_addr_t addr, int size, void *context);
+
+/*
+    Called by CFG builder to read code at given address into the buffer, must 
+    return number of bytes that were read (it can be less than size) or REIL_ERROR
+    when memory at given address is not accessible. Address never has ARM Thumb 
+    bit set.
+*/
+typedef int (* reil_reader_t)(reil_addr_t addr, unsigned char *buff, int size, void *context);
+
+// flags of reil_cfg_bb_t
+#define REIL_CFG_BB_RET     0x01    // basic block ends with return from function
+#define REIL_CFG_BB_ERROR   0x02    // code at block address can't be read or translated
+#define REIL_CFG_BB_INDIRECT 0x04   // basic block ends with indirect jump that was resolved
+
+/*
+    Basic block information, see reil_cfg_bb_list(). Block that has 
+    REIL_CFG_BB_ERROR flag set has no instructions and zero size.
+*/
+typedef struct _reil_cfg_bb_t
+{
+    reil_addr_t addr;       // IR address of the first instruction
+    reil_inum_t inum;
+    reil_addr_t last_addr;  // IR address of the last instruction
+    reil_inum_t last_inum;
+    int size;               // size of machine code
+    int flags;
+
+} reil_cfg_bb_t;
+
+/*
+    Control flow graph edge, see reil_cfg_edge_list().
+*/
+typedef struct _reil_cfg_edge_t
+{
+    int from, to;           // indexes of basic blocks
+
+} reil_cfg_edge_t;
+
+/*
+    Function information, see reil_cfg_func_list().
+*/
+typedef struct _reil_cfg_func_t
+{
+    reil_addr_t addr;           // entry point address
+    int bb_first, bb_count;     // range of reil_cfg_bb_list() items
+    int edge_first, edge_count; // range of reil_cfg_edge_list() items
+
+} reil_cfg_func_t;
+
+// reil_dfg_optimize() options
+#define REIL_DFG_FOLD_CONST     0x01    // constant folding and propagation
+#define REIL_DFG_ELIM_SUBEXP    0x02    // common subexpression elimination and copy propagation
+#define REIL_DFG_ELIM_DEAD      0x04    // dead code elimination
+#define REIL_DFG_KEEP_FLAGS     0x08    // flags are live at the end of the function
+
+#define REIL_DFG_OPTIMIZE_ALL (REIL_DFG_FOLD_CONST | REIL_DFG_ELIM_SUBEXP | REIL_DFG_ELIM_DEAD)
+
+// reil_ssa_slice() options
+#define REIL_SLICE_FORWARD      0x01    // forward slice instead of backward one
+#define REIL_SLICE_MEM          0x02    // follow memory dependencies of I_LDM and I_STM
+#define REIL_SLICE_LOCAL        0x04    // don't leave basic block of the instruction
+
+// operands of reil_ssa_slice()
+#define REIL_SLICE_ARG_A        0
+#define REIL_SLICE_ARG_B        1
+#define REIL_SLICE_ARG_C        2
+
+// number of reil_ssa_slice() bitmap items for given number of instructions
+#define REIL_SLICE_WORDS(_count_) (((_count_) + 63) / 64)
+
+/*
+    Basic block of the function in SSA form, see reil_ssa_bb_list(). Blocks and
+    instructions are sorted by IR address, blocks that are not reachable from
+    the entry point have no dominator and their operands are not renamed.
+*/
+typedef struct _reil_ssa_bb_t
+{
+    int first, last;            // range of reil_ssa_insn_list() items
+    int idom;                   // immediate dominator or -1 for entry point
+    int phi_first, phi_count;   // range of reil_ssa_phi_list() items
+    int reachable;
+
+} reil_ssa_bb_t;
+
+/*
+    IR instruction of the function in SSA form, see reil_ssa_insn_list().
+*/
+typedef struct _reil_ssa_insn_t
+{
+    reil_addr_t addr;           // IR address of the instruction
+    reil_inum_t inum;
+    int bb;                     // index of basic block
+    int a, b, c;                // SSA variables of the operands or -1
+
+} reil_ssa_insn_t;
+
+/*
+    Version of register or temporary register, see reil_ssa_var_list().
+    Version 0 holds the value that variable has at the function entry,
+    other versions are defined by instruction or by phi function.
+*/
+typedef struct _reil_ssa_var_t
+{
+    reil_type_t type;
+    char name[REIL_MAX_NAME_LEN];
+    int version;
+    int insn;                   // defining instruction or -1
+    int phi;                    // defining phi function or -1
+    int use_first, use_count;   // range of reil_ssa_use_list() items
+
+} reil_ssa_var_t;
+
+/*
+    Use of SSA variable by instruction or by phi function, see reil_ssa_use_list().
+    Function call also uses general purpose registers and defines them and flags,
+    unknown instruction uses and defines all of the registers.
+*/
+typedef struct _reil_ssa_use_t
+{
+    int insn;                   // index of instruction or -1
+    int phi;                    // index of phi function or -1
+
+} reil_ssa_use_t;
+
+/*
+    Phi function, see reil_ssa_phi_list().
+*/
+typedef struct _reil_ssa_phi_t
+{
+    int bb;                     // basic block
+    int var;                    // defined SSA variable
+    int arg_first, arg_count;   // range of reil_ssa_phi_arg_list() items
+
+} reil_ssa_phi_t;
+
+/*
+    Phi function argument, function entry is a predecessor of the entry block.
+*/
+typedef struct _reil_ssa_phi_arg_t
+{
+    int bb;                     // predecessor block or -1 for function entry
+    int var;                    // SSA variable
+
+} reil_ssa_phi_arg_t;
+
+// kinds of reil_sym_node_t
+#define REIL_SYM_CONST      0   // constant value
+#define REIL_SYM_VAL        1   // initial value of register or temporary register
+#define REIL_SYM_PTR        2   // memory contents at address a
+#define REIL_SYM_EXP        3   // operation over a and b, I_STR converts a to the node size
+#define REIL_SYM_COND       4   // a ? b : c
+#define REIL_SYM_LOC        5   // IR address
+#define REIL_SYM_IP         6   // instruction pointer
+
+// reil_sym_smt2() and reil_sym_z3() options
+#define REIL_SMT_ASSERT     0x00000001  // assert that expressions are not zero
+#define REIL_SMT_MEM_BYTES  0x00000002  // separate value for each byte of memory
+
+/*
+    Node of symbolic expression, see reil_sym_node(). Temporary registers of 
+    different machine instructions are different values, val holds address 
+    of the machine instruction for them.
+*/
+typedef struct _reil_sym_node_t
+{
+    int kind;
+    reil_op_t op;               // operation of REIL_SYM_EXP
+    reil_size_t size;           // not used by REIL_SYM_LOC and REIL_SYM_IP
+    int a, b, c;                // operand nodes or -1
+    reil_const_t val;           // constant value or IR address
+    reil_inum_t inum;
+    reil_type_t type;           // A_REG or A_TEMP for REIL_SYM_VAL
+    char name[REIL_MAX_NAME_LEN];
+
+} reil_sym_node_t;
+
+/*
+    Symbolic state item: register, memory (REIL_SYM_PTR) or instruction
+    pointer (REIL_SYM_IP) node and the expression of its value.
+*/
+typedef struct _reil_sym_item_t
+{
+    int val;
+    int exp;
+
+} reil_sym_item_t;
+
 
 #ifdef __cplusplus
 extern "C" {
@@ -62,6 +503,29 @@ extern "C" {
 */
 void reil_inst_print(reil_inst_t *inst);
 
+/*
+    Write text representation of REIL instruction (the same as reil_inst_print()
+    prints, without new line) into the caller specified buffer. Returns length 
+    of the string or REIL_ERROR when buffer is too small.
+*/
+int reil_inst_to_str(reil_inst_t *inst, char *buff, int len);
+
+/*
+    Write JSON representation of REIL instruction that is compatible with 
+    pyopenreil InsnJson class into the caller specified buffer. Returns length 
+    of the string or REIL_ERROR when buffer is too small. Architecture is
+    needed for register names of IATTR_REP attribute.
+*/
+int reil_inst_to_json(reil_arch_t arch, reil_inst_t *inst, char *buff, int len);
+
+/*
+    Convert IOPT_REP_* fields of instruction flags into rep-prefixed string 
+    instruction information with register names of given architecture, it
+    can be passed to reil_vm_rep_add(). Returns REIL_ERROR when IOPT_REP is 
+    not set or architecture has no such instructions.
+*/
+int reil_rep_info(reil_arch_t arch, unsigned long long flags, reil_vm_rep_t *rep);
+
 
 typedef int (* reil_inst_handler_t)(reil_inst_t *inst, void *context);
 
@@ -92,6 +556,548 @@ void reil_log_close(void);
 int reil_translate(reil_t reil, reil_addr_t addr, unsigned char *buff, int len);
 int reil_translate_insn(reil_t reil, reil_addr_t addr, unsigned char *buff, int len);
 
+/*
+    Query translator statistics collected since reil_init() or last 
+    reil_reset_stats() call. Time and calls count of translation stages 
+    are available only when libasmir was compiled with USE_STATS option.
+*/
+int reil_get_stats(reil_t reil, reil_stats_t *stats);
+
+/*
+    Reset translator statistics.
+*/
+void reil_reset_stats(reil_t reil);
+
+/*
+    Enable or disable collecting of per-mnemonic translation profile,
+    it's disabled by default.
+*/
+void reil_profile_enable(reil_t reil, int enable);
+
+/*
+    Copy up to count profile entries into the entries array, most expensive 
+    instructions goes first. Returns total number of profile entries, 
+    entries argument can be NULL.
+*/
+int reil_profile_get(reil_t reil, reil_profile_entry_t *entries, int count);
+
+/*
+    Write translation profile into the file in CSV or JSON format,
+    NULL path value indicates that we need to write it to stdout.
+    Returns number of profile entries or REIL_ERROR.
+*/
+int reil_profile_dump(reil_t reil, const char *path, reil_profile_format_t format);
+
+/*
+    Clear collected translation profile.
+*/
+void reil_profile_reset(reil_t reil);
+
+/*
+    Initialize CFG builder that reads machine code with specified callback,
+    it has it's own translator instance.
+*/
+reil_cfg_t reil_cfg_init(reil_arch_t arch, reil_reader_t reader, void *context);
+
+/*
+    Close CFG builder.
+*/
+void reil_cfg_close(reil_cfg_t cfg);
+
+/*
+    Set callback that reads constant data of the image (read-only sections), 
+    it's used to resolve targets of indirect jumps that are loaded from jump
+    tables. Targets of indirect jumps are not resolved when callback is NULL.
+*/
+void reil_cfg_set_data_reader(reil_cfg_t cfg, reil_reader_t reader, void *context);
+
+/*
+    Discover basic blocks that are reachable from specified address without 
+    following function calls and indirect jumps. Basic blocks are split at 
+    IOPT_BB_END instructions and at branch targets, so they never overlap.
+    When data reader is set, targets of indirect jumps are resolved by value 
+    set analysis of the IR code (bounds checked index of constant jump table)
+    and traversal continues from them, blocks of such jumps are marked with 
+    REIL_CFG_BB_INDIRECT flag and have edges to all of the resolved targets.
+    Results of the previous traversal are discarded but translated code is 
+    kept by builder, so functions that are sharing code are translated once.
+    Returns number of found basic blocks or REIL_ERROR for inconsistent code.
+*/
+int reil_cfg_traverse(reil_cfg_t cfg, reil_addr_t addr, reil_inum_t inum);
+
+/*
+    Discover functions that are reachable from the specified entry points by 
+    following direct calls, each function is traversed as reil_cfg_traverse() 
+    does. Functions are distributed between the specified number of worker 
+    processes (VEX keeps its state in global variables, so threads can't be used) 
+    that are taking them from work-stealing queues and sharing the set of already 
+    claimed function addresses, so each function is traversed only once. Code 
+    translated by workers is copied into the builder, code that is shared by
+    functions of different workers is translated by each of them. With a single
+    job discovery runs in the calling process. Results of the previous traversal
+    are discarded, returns number of found functions or REIL_ERROR.
+*/
+int reil_cfg_discover(reil_cfg_t cfg, reil_addr_t *entries, int count, int jobs);
+
+/*
+    Copy up to count functions found by the last discovery into the caller 
+    specified array and return their total number, array argument can be NULL.
+    Functions are sorted by address.
+*/
+int reil_cfg_func_list(reil_cfg_t cfg, reil_cfg_func_t *funcs, int count);
+
+/*
+    Copy up to count basic blocks or edges found by the last traversal or 
+    discovery into the caller specified array and return their total number, 
+    array argument can be NULL. Blocks of the function are sorted by address, 
+    edges are sorted by indexes of blocks.
+*/
+int reil_cfg_bb_list(reil_cfg_t cfg, reil_cfg_bb_t *bbs, int count);
+int reil_cfg_edge_list(reil_cfg_t cfg, reil_cfg_edge_t *edges, int count);
+
+/*
+    Copy up to count IR instructions of machine instruction at given address that 
+    was translated by CFG builder and return their total number or REIL_ERROR when
+    it wasn't translated. raw_info fields are valid until reil_cfg_close() call.
+*/
+int reil_cfg_insn_list(reil_cfg_t cfg, reil_addr_t addr, reil_inst_t *insts, int count);
+
+/*
+    Optimize IR code of the function that starts at given IR address, array 
+    must contain IR instructions of all of it's basic blocks in any order.
+    Instructions are modified in place: optimized operands are replaced and
+    eliminated instructions are turned into I_NONE with IOPT_ELIMINATED flag, 
+    just like pyopenreil DFGraph.optimize_all() does. Temporary registers and 
+    flags (unless REIL_DFG_KEEP_FLAGS is set) are not live at the end of the
+    function, function calls are reading and writing general purpose registers.
+    Returns number of eliminated instructions or REIL_ERROR.
+*/
+int reil_dfg_optimize(reil_arch_t arch, reil_inst_t *insts, int count, 
+                      reil_addr_t addr, reil_inum_t inum, int options);
+
+/*
+    Build SSA form of the function that starts at given IR address, array 
+    must contain IR instructions of all of it's basic blocks in any order.
+    Dominator tree is computed with Cooper-Harvey-Kennedy algorithm, pruned
+    SSA has phi functions only at dominance frontiers where variable is live,
+    registers are live at the end of the function. Returns NULL on error.
+*/
+reil_ssa_t reil_ssa_init(reil_arch_t arch, reil_inst_t *insts, int count, 
+                         reil_addr_t addr, reil_inum_t inum);
+
+/*
+    Free SSA form of the function.
+*/
+void reil_ssa_close(reil_ssa_t ssa);
+
+/*
+    Copy up to count items into the caller specified array and return their
+    total number, array argument can be NULL.
+*/
+int reil_ssa_bb_list(reil_ssa_t ssa, reil_ssa_bb_t *bbs, int count);
+int reil_ssa_insn_list(reil_ssa_t ssa, reil_ssa_insn_t *insns, int count);
+int reil_ssa_var_list(reil_ssa_t ssa, reil_ssa_var_t *vars, int count);
+int reil_ssa_use_list(reil_ssa_t ssa, reil_ssa_use_t *uses, int count);
+int reil_ssa_phi_list(reil_ssa_t ssa, reil_ssa_phi_t *phis, int count);
+int reil_ssa_phi_arg_list(reil_ssa_t ssa, reil_ssa_phi_arg_t *args, int count);
+
+/*
+    Copy up to count blocks of the dominance frontier of given basic block 
+    and return their total number or REIL_ERROR for invalid block index.
+*/
+int reil_ssa_df_list(reil_ssa_t ssa, int bb, int *bbs, int count);
+
+/*
+    Check if basic block a dominates basic block b.
+*/
+int reil_ssa_dominates(reil_ssa_t ssa, int a, int b);
+
+/*
+    Compute backward (instructions that the operand value depends on) or forward 
+    (instructions that depend on the operand value) slice for the operand of IR 
+    instruction at given address. Slice follows SSA def-use chains through phi 
+    functions, so it's inter-block unless REIL_SLICE_LOCAL is set. With REIL_SLICE_MEM 
+    memory reads are depending on all of the memory writes that can reach them 
+    (function calls and unknown instructions are reading and writing memory as well).
+    Slice includes the instruction itself, bit n % 64 of bitmap[n / 64] is set for 
+    n-th item of reil_ssa_insn_list(). Up to count items of the bitmap are copied 
+    into the caller specified array (it can be NULL), REIL_SLICE_WORDS() of the 
+    number of instructions is enough. Returns number of instructions in the slice 
+    or REIL_ERROR when instruction is not found or operand is not used by it.
+*/
+int reil_ssa_slice(reil_ssa_t ssa, reil_addr_t addr, reil_inum_t inum, int arg, int options,
+                   unsigned long long *bitmap, int count);
+
+/*
+    Create symbolic expression engine. Expressions are hash-consed DAG nodes
+    that are identified by their indexes: the same expression always gets the
+    same node, so expressions are equal only when their nodes are equal.
+*/
+reil_sym_t reil_sym_init(void);
+
+/*
+    Free the engine with all of its nodes.
+*/
+void reil_sym_close(reil_sym_t sym);
+
+/*
+    Get node of the expression, functions are returning REIL_ERROR for invalid
+    operands. reil_sym_exp() simplifies expression before creating its node: 
+    constants are folded, masking with I_AND and zero extension with I_OR are 
+    turned into I_STR conversions and identities like x ^ x, x & x, x + 0 and 
+    ~~x are eliminated. Operand b is -1 for unary operations, size is the 
+    size of result.
+*/
+int reil_sym_const(reil_sym_t sym, reil_const_t val, reil_size_t size);
+int reil_sym_val(reil_sym_t sym, const char *name, reil_type_t type, reil_size_t size, reil_addr_t addr);
+int reil_sym_ptr(reil_sym_t sym, int addr, reil_size_t size);
+int reil_sym_exp(reil_sym_t sym, reil_op_t op, int a, int b, reil_size_t size);
+int reil_sym_cond(reil_sym_t sym, int cond, int a, int b);
+int reil_sym_loc(reil_sym_t sym, reil_addr_t addr, reil_inum_t inum);
+int reil_sym_ip(reil_sym_t sym);
+
+/*
+    Query information about the node.
+*/
+int reil_sym_node(reil_sym_t sym, int node, reil_sym_node_t *info);
+
+/*
+    Get total number of nodes.
+*/
+int reil_sym_count(reil_sym_t sym);
+
+/*
+    Execute IR instructions symbolically starting from the given state (it can
+    be empty), registers that are not in the state have their initial values.
+    Memory reads are giving REIL_SYM_PTR of the address, memory writes are
+    adding REIL_SYM_PTR items and jumps are setting REIL_SYM_IP item. Up to
+    out_count items of the resulting state are copied into out array (it can be
+    the same array as state) and their total number is returned, state_count + 
+    count items are always enough. Returns REIL_ERROR for invalid state or 
+    instruction operands.
+*/
+int reil_sym_exec(reil_sym_t sym, reil_inst_t *insts, int count, 
+                  reil_sym_item_t *state, int state_count, reil_sym_item_t *out, int out_count);
+
+/*
+    Update state with summary of IR code, summary is the state that reil_sym_exec()
+    returned for this code and empty input state. Expressions of summary items
+    are getting values of registers from the given state, so the result is the
+    same as executing the code from this state. Arrays and return value are the
+    same as reil_sym_exec() has, state_count + summary_count items are always
+    enough. Returns REIL_ERROR for invalid items or when memory writes of the
+    summary are aliased in given state, code must be executed in this case.
+*/
+int reil_sym_apply(reil_sym_t sym, reil_sym_item_t *summary, int summary_count,
+                   reil_sym_item_t *state, int state_count, reil_sym_item_t *out, int out_count);
+
+/*
+    Export expressions into SMT-LIB2 bit-vector script: declarations of registers
+    and memory followed by (define-fun E_n ...) of n-th expression or assertion
+    that it's not zero when REIL_SMT_ASSERT option is set. Subexpressions that are
+    used more than once are shared with let. Registers are named as in REIL,
+    temporary registers have address of machine instruction appended to their
+    names. Memory is MEM array of bytes with 64-bit index, with REIL_SMT_MEM_BYTES
+    option each byte is MEM_<address> value and REIL_SYM_PTR addresses must be
+    constants. REIL_SYM_LOC is 64-bit address of machine instruction (it must
+    have zero inum) and REIL_SYM_IP can't be exported. Up to size - 1 characters
+    of the text with terminating zero are copied into the caller specified buffer
+    (it can be NULL), returns length of the text or REIL_ERROR for unsupported
+    expressions.
+*/
+int reil_sym_smt2(reil_sym_t sym, int *nodes, int count, int options, char *buff, int size);
+
+/*
+    Build Z3 AST of expressions in the given Z3_context with the same names and
+    semantics as reil_sym_smt2() has, out receives Z3_ast of n-th expression.
+    Contexts that were created with Z3_mk_context_rc() are giving one reference
+    of each AST to the caller. Returns REIL_ERROR for unsupported expressions or
+    when library was built without Z3.
+*/
+int reil_sym_z3(reil_sym_t sym, void *ctx, int *nodes, int count, int options, void **out);
+
+/*
+    Initialize native REIL interpreter.
+*/
+reil_vm_t reil_vm_init(reil_arch_t arch, reil_vm_fetch_t fetch, 
+                       reil_vm_mem_read_t mem_read, reil_vm_mem_write_t mem_write, void *context);
+
+/*
+    Close interpreter.
+*/
+void reil_vm_close(reil_vm_t vm);
+
+/*
+    Load IR instruction into the interpreter. Address of the next instruction 
+    is determined by IOPT_ASM_END flag, reil_vm_load_next() allows to specify 
+    it explicitly.
+*/
+int reil_vm_load(reil_vm_t vm, reil_inst_t *inst);
+int reil_vm_load_next(reil_vm_t vm, reil_inst_t *inst, reil_addr_t next_addr, reil_inum_t next_inum);
+
+/*
+    Tell the interpreter that machine instruction at given address is rep-prefixed
+    string instruction, it should be called before loading of it's IR code. When
+    native guest memory is used the interpreter executes such instructions as bulk
+    memory operations and IR code runs only the last iteration of CMPS or SCAS
+    to set the flags, or the rest of iterations when bulk operation was not able to
+    access some memory. Value of direction register is 1 for incrementing and
+    all bits set for decrementing of pointers. Information is discarded by
+    reil_vm_flush().
+*/
+int reil_vm_rep_add(reil_vm_t vm, reil_addr_t addr, reil_vm_rep_t *rep);
+
+/*
+    Unload all of the previously loaded instructions. Interpreter also does it
+    when STM instruction writes into the memory page with loaded machine code.
+*/
+void reil_vm_flush(reil_vm_t vm);
+
+/*
+    Get or set register value. reil_vm_reg_set() creates register with specified 
+    size if it doesn't exist, reil_vm_reg_get() returns REIL_ERROR in this case.
+*/
+int reil_vm_reg_get(reil_vm_t vm, const char *name, reil_size_t *size, reil_const_t *val);
+int reil_vm_reg_set(reil_vm_t vm, const char *name, reil_size_t size, reil_const_t val);
+
+/*
+    Copy up to count registers information into the regs array. Returns total 
+    number of registers, regs argument can be NULL.
+*/
+int reil_vm_reg_list(reil_vm_t vm, reil_vm_reg_t *regs, int count);
+
+/*
+    Set all of the registers or only temp registers values to zero.
+*/
+void reil_vm_reset(reil_vm_t vm);
+void reil_vm_reset_temp(reil_vm_t vm);
+
+/*
+    Add or remove stop points, reil_vm_run() returns REIL_VM_STOP before
+    executing instruction at stop point address.
+*/
+int reil_vm_stop_add(reil_vm_t vm, reil_addr_t addr, int inum);
+void reil_vm_stop_clear(reil_vm_t vm);
+
+/*
+    Execute instructions starting from specified address untill stop point
+    or error. Returns one of REIL_VM_* status codes.
+*/
+int reil_vm_run(reil_vm_t vm, reil_addr_t addr, reil_inum_t inum);
+
+/*
+    Query location of the current instruction, in case of error it
+    points to the instruction that caused it.
+*/
+void reil_vm_get_state(reil_vm_t vm, reil_vm_state_t *state);
+
+/*
+    Save values of all registers or restore them. Snapshot can be restored
+    into any interpreter instance, registers that are not present in the 
+    snapshot are set to zero. 
+*/
+reil_vm_snapshot_t reil_vm_snapshot(reil_vm_t vm);
+void reil_vm_restore(reil_vm_t vm, reil_vm_snapshot_t snap);
+void reil_vm_snapshot_close(reil_vm_snapshot_t snap);
+
+/*
+    Use native guest memory instead of memory access callbacks, NULL
+    value of mem argument switches interpreter back to the callbacks.
+*/
+void reil_vm_set_mem(reil_vm_t vm, reil_mem_t mem);
+
+/*
+    Enable or disable JIT compiler that translates frequently executed IR code
+    into the native code, returns REIL_ERROR when it's not supported by the 
+    host (only x86_64 is supported). JIT is disabled by default.
+*/
+int reil_vm_jit_enable(reil_vm_t vm, int enable);
+
+/*
+    Set execution hook for the mask of REIL_VM_HOOK_* event types. Events are 
+    queued by interpreter and handler gets them in batches, the rest of queued 
+    events is delivered before reil_vm_run() returns. Memory hooks are disabling
+    bulk execution of rep-prefixed string instructions.
+*/
+int reil_vm_hook_set(reil_vm_t vm, int mask, reil_vm_hook_t handler, void *context);
+
+/*
+    Report only events of given instruction addresses and memory ranges, by 
+    default all of the events are reported. reil_vm_hook_clear() removes the 
+    hook and it's filters.
+*/
+int reil_vm_hook_addr_add(reil_vm_t vm, reil_addr_t addr);
+int reil_vm_hook_mem_add(reil_vm_t vm, reil_addr_t addr, int size);
+void reil_vm_hook_clear(reil_vm_t vm);
+
+/*
+    Interpreter always counts hits of basic blocks and updates AFL-style edge 
+    coverage bitmap of REIL_VM_COV_MAP_SIZE bytes that is owned by interpreter.
+    Basic blocks are found at run time as targets of the executed branches.
+    reil_vm_cov_list() copies up to count hit counters into the items array and
+    returns total number of executed basic blocks, items argument can be NULL.
+*/
+int reil_vm_cov_list(reil_vm_t vm, reil_vm_cov_t *items, int count);
+unsigned char *reil_vm_cov_map(reil_vm_t vm);
+void reil_vm_cov_reset(reil_vm_t vm);
+
+/*
+    Enable or disable taint tracking with REIL_TAINT_* options. Interpreter keeps 
+    shadow state with taint bits of each register and memory byte, it's updated
+    by each executed instruction. Disabling frees the shadow state. JIT compiler
+    and bulk execution of rep-prefixed string instructions are not used while 
+    taint tracking is enabled, shadow state is not saved by snapshots.
+*/
+int reil_vm_taint_enable(reil_vm_t vm, int enable, int options);
+
+/*
+    Remove taint from all of the registers and memory.
+*/
+int reil_vm_taint_clear(reil_vm_t vm);
+
+/*
+    Get or set taint bits of existing register, reil_vm_taint_reg_set() is 
+    used to register taint sources.
+*/
+int reil_vm_taint_reg_get(reil_vm_t vm, const char *name, reil_const_t *mask);
+int reil_vm_taint_reg_set(reil_vm_t vm, const char *name, reil_const_t mask);
+
+/*
+    Copy taint bits of memory range into the buffer or set taint bits of each
+    byte of the memory range, 0xff marks the whole byte as tainted.
+*/
+int reil_vm_taint_mem_get(reil_vm_t vm, reil_addr_t addr, unsigned char *buff, int size);
+int reil_vm_taint_mem_set(reil_vm_t vm, reil_addr_t addr, int size, unsigned char mask);
+
+/*
+    Add taint sink: REIL_VM_HOOK_TAINT_SINK event is reported when machine
+    instruction at given address is about to execute and specified register
+    is tainted. Returns sink ID or REIL_ERROR, reil_vm_taint_sink_clear()
+    removes all of the sinks.
+*/
+int reil_vm_taint_sink_add(reil_vm_t vm, reil_addr_t addr, const char *name);
+int reil_vm_taint_sink_clear(reil_vm_t vm);
+
+/*
+    Create batch executor that runs the same IR code over specified number of
+    lanes at once. Each lane has it's own registers and copy-on-write clone of 
+    the interpreter memory, lanes are starting from the current state of the
+    interpreter. Interpreter must use native guest memory, instructions are 
+    loaded with it's fetch callback and it must be alive while batch is used.
+*/
+reil_vm_batch_t reil_vm_batch_init(reil_vm_t vm, int lanes);
+void reil_vm_batch_close(reil_vm_batch_t batch);
+
+/*
+    The same as reil_vm_batch_init() but lanes are distributed between the
+    specified number of worker threads that reil_vm_batch_run() executes in
+    parallel. Loaded instructions of the interpreter are shared by workers,
+    fetch and memory fault callbacks are never called concurrently but they
+    might be called from any of the worker threads. While the batch is running
+    reil_vm_load() keeps instructions that were already loaded unchanged.
+*/
+reil_vm_batch_t reil_vm_batch_init_mt(reil_vm_t vm, int lanes, int threads);
+
+/*
+    Arithmetic instructions of batch executors are using the best SIMD kernels
+    that host CPU supports (it's checked at runtime). reil_vm_batch_simd()
+    limits them to the specified REIL_VM_BATCH_SIMD_* level for the next
+    reil_vm_batch_run() calls, returns the level that will be used. It must 
+    not be called concurrently with reil_vm_batch_run().
+*/
+#define REIL_VM_BATCH_SIMD_NONE 0   // plain loops
+#define REIL_VM_BATCH_SIMD_SSE2 1   // 2 lanes per operation
+#define REIL_VM_BATCH_SIMD_AVX2 2   // 4 lanes per operation
+
+int reil_vm_batch_simd(int level);
+
+/*
+    Get or set register value of the lane.
+*/
+int reil_vm_batch_reg_get(reil_vm_batch_t batch, int lane, const char *name, reil_size_t *size, reil_const_t *val);
+int reil_vm_batch_reg_set(reil_vm_batch_t batch, int lane, const char *name, reil_size_t size, reil_const_t val);
+
+/*
+    Get guest memory of the lane, it's owned by the batch.
+*/
+reil_mem_t reil_vm_batch_mem(reil_vm_batch_t batch, int lane);
+
+/*
+    Execute instructions of all lanes starting from specified address untill
+    each lane reaches stop point or error. Lanes that are following the same
+    path are executed together. Writes into the executed code are not detected.
+*/
+void reil_vm_batch_run(reil_vm_batch_t batch, reil_addr_t addr, reil_inum_t inum);
+
+/*
+    Query location of the lane after reil_vm_batch_run(), returns one of 
+    REIL_VM_* status codes.
+*/
+int reil_vm_batch_get_state(reil_vm_batch_t batch, int lane, reil_vm_state_t *state);
+
+/*
+    Initialize guest memory. In strict mode writes to the memory that wasn't 
+    allocated are causing REIL_MEM_ERR_WRITE error, in non-strict mode such 
+    writes are allocating the memory. Access to addresses below lowest_addr
+    causes REIL_MEM_ERR_NULL error.
+*/
+reil_mem_t reil_mem_init(int strict, reil_addr_t lowest_addr, reil_mem_fault_t fault, void *context);
+
+/*
+    Free guest memory.
+*/
+void reil_mem_close(reil_mem_t mem);
+
+/*
+    Change strict mode of guest memory.
+*/
+void reil_mem_set_strict(reil_mem_t mem, int strict);
+
+/*
+    Copy data from or into the guest memory.
+*/
+int reil_mem_read(reil_mem_t mem, reil_addr_t addr, unsigned char *buff, int size);
+int reil_mem_write(reil_mem_t mem, reil_addr_t addr, unsigned char *buff, int size);
+
+/*
+    Load or store little endian value of given size.
+*/
+int reil_mem_load(reil_mem_t mem, reil_addr_t addr, reil_size_t size, reil_const_t *val);
+int reil_mem_store(reil_mem_t mem, reil_addr_t addr, reil_size_t size, reil_const_t val);
+
+/*
+    Make memory range accessible and fill it with specified data or zeros
+    when data is NULL or shorter than size.
+*/
+int reil_mem_alloc(reil_mem_t mem, reil_addr_t addr, unsigned char *data, int data_size, int size);
+
+/*
+    Reserve address range for allocation, works as simple bump allocator
+    that starts from REIL_MEM_ALLOC_BASE.
+*/
+reil_addr_t reil_mem_alloc_addr(reil_mem_t mem, int size);
+
+/*
+    Free all of the allocated memory, allocator state is not changed.
+*/
+void reil_mem_clear(reil_mem_t mem);
+
+/*
+    Save guest memory contents and allocator state. Pages are shared between
+    the memory and it's snapshots and copied on write, so taking a snapshot 
+    costs O(allocated pages) and restoring of the last taken or restored 
+    snapshot costs O(pages modified since then). Snapshot can be restored 
+    into any memory instance, so it allows to fork independent executions.
+*/
+reil_mem_snapshot_t reil_mem_snapshot(reil_mem_t mem);
+void reil_mem_restore(reil_mem_t mem, reil_mem_snapshot_t snap);
+void reil_mem_snapshot_close(reil_mem_snapshot_t snap);
+
+/*
+    Query type and address of last memory access error.
+*/
+int reil_mem_get_error(reil_mem_t mem, reil_addr_t *addr);
+
 #ifdef __cplusplus
 }
 #endif
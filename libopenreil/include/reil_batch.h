@@ -0,0 +1,166 @@
+#ifndef REIL_BATCH_H
+#define REIL_BATCH_H
+
+// SIMD kernels are available only for x86 hosts and GCC compatible compilers
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BATCH_SIMD_SUPPORTED
+#endif
+
+typedef struct _batch_insn batch_insn;
+
+typedef void (* batch_kernel_t)(batch_insn *insn, int lo, int hi);
+
+/*
+    IR instruction decoded for batch execution, operands are pointing to the
+    columns of register values or constants.
+*/
+struct _batch_insn
+{
+    vm_insn *insn;
+
+    // operation over the range of lanes, NULL for non-arithmetic instructions
+    batch_kernel_t kernel;
+
+    reil_const_t *a, *b, *c;
+
+    // next and JCC target instructions, loaded instructions are never modified by batch
+    vm_insn *next, *jump;
+};
+
+/*
+    State of the single lane.
+*/
+typedef struct _batch_lane
+{
+    // lane number that was used by caller
+    int id;
+
+    CReilMem *mem;
+
+    // location and status of the finished lane
+    reil_vm_status_t status;
+    VM_LOC loc;
+
+    unsigned long long executed;
+
+} batch_lane;
+
+/*
+    Range of lanes that are executing the same code.
+*/
+typedef struct _batch_group
+{
+    VM_LOC loc;
+    int lo, hi;
+
+} batch_group;
+
+/*
+    Mutex that serializes access to the interpreter from worker threads.
+*/
+class CReilBatchLock
+{
+public:
+
+    CReilBatchLock();
+    ~CReilBatchLock();
+
+    void acquire(void);
+    void release(void);
+
+private:
+
+#ifndef _WIN32
+
+    pthread_mutex_t mutex;
+
+#endif
+};
+
+class CReilBatch
+{
+public:
+
+    CReilBatch(CReilVM *vm, int count, int threads = 1, CReilBatchLock *lock = NULL);
+    ~CReilBatch();
+
+    bool reg_get(int lane, string name, reil_size_t *size, reil_const_t *val);
+    void reg_set(int lane, string name, reil_size_t size, reil_const_t val);
+
+    CReilMem *get_mem(int lane);
+
+    // SIMD level is a REIL_VM_BATCH_SIMD_* value, -1 to use the current one
+    void run(VM_LOC loc, int simd = -1);
+
+    reil_vm_status_t get_state(int lane, reil_vm_state_t *state);
+
+    bool mem_read(reil_addr_t addr, uint8_t *buff, int size);
+    bool mem_read_shared(reil_addr_t addr, uint8_t *buff, int size);
+
+private:
+
+    CReilBatch *worker(int *lane);
+    vm_insn *fetch(VM_LOC loc);
+
+    reil_const_t *column(reil_const_t *val);
+    reil_const_t *constant(reil_const_t val);
+
+    batch_insn *decode(vm_insn *insn);
+
+    void swap(int i, int j);
+    int partition(int lo, int hi);
+
+    void fill_ip(int lo, int hi, reil_addr_t addr);
+    void account(int lo, int hi, unsigned long long executed);
+    void finish(int lo, int hi, reil_vm_status_t status, VM_LOC loc, unsigned long long executed);
+
+    bool pick(batch_group *group);
+    void suspend(VM_LOC loc, int lo, int hi);
+    void run_group(batch_group group);
+
+    CReilVM *vm;
+    CReilMem *mem;
+
+    int count;
+
+    // register values stored by columns, deque keeps pointers to them valid
+    deque<vector<reil_const_t> > cols;
+    map<reil_const_t *, reil_const_t *> cols_map;
+
+    // immediate values of operands and destinations of invalid instructions
+    deque<vector<reil_const_t> > consts;
+    map<reil_const_t, reil_const_t *> consts_map;
+
+    // decoded instructions of the current run and SIMD level of their kernels
+    map<vm_insn *, batch_insn> insns;
+    int simd;
+
+    vector<batch_lane> lanes;
+
+    // current position of the lane in columns and lanes vectors
+    vector<int> pos;
+
+    // per lane flags for partitioning
+    vector<uint8_t> flags;
+
+    // groups that are waiting for execution
+    vector<batch_group> pending;
+
+    reil_const_t *ip;
+    reil_const_t ip_mask;
+
+    // batches with lanes ranges that are executed by worker threads
+    vector<CReilBatch *> workers;
+    vector<int> workers_start;
+
+    // lock that is shared by the workers, NULL for single threaded batch
+    CReilBatchLock *lock;
+
+    // interpreter memory contents that lanes of the worker have read, NULL for single threaded batch
+    CReilMem *cache;
+
+    // instructions that were fetched by the worker
+    map<VM_LOC, vm_insn *> code;
+};
+
+#endif // REIL_BATCH_H
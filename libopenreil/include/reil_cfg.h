@@ -0,0 +1,192 @@
+#ifndef REIL_CFG_H
+#define REIL_CFG_H
+
+typedef pair<reil_addr_t, reil_inum_t> CFG_LOC;
+
+// size of code chunks that are requested from the reader callback
+#define CFG_READ_CHUNK 0x1000
+
+// max. number of functions that can be found by reil_cfg_discover()
+#define CFG_FUNCS_MAX 0x100000
+
+// initial size of the claimed set when discovery runs in the calling process
+#define CFG_FUNCS_INIT 0x1000
+
+// max. number of times that traversal is continued from resolved indirect jump targets
+#define CFG_RESOLVE_PASSES 8
+
+// interval of worker processes status polling in microseconds
+#define CFG_WAIT_TIME 1000
+
+class CReilCFGException
+{
+public:
+
+    CReilCFGException(string s) : reason(s) {};
+    string reason;
+};
+
+/*
+    Translated machine instruction, raw_info of IR instructions points to
+    the strings that are owned by this structure.
+*/
+typedef struct _cfg_insn
+{
+    reil_addr_t addr;
+    int size;
+
+    vector<reil_inst_t> insts;
+
+    string data, str_mnem, str_op;
+
+    // number of the last traversal that visited each IR instruction
+    vector<unsigned int> visited;
+
+} cfg_insn;
+
+/*
+    Basic blocks and edges of the function that was found by discovery,
+    edges are using local indexes of basic blocks.
+*/
+typedef struct _cfg_func
+{
+    vector<reil_cfg_bb_t> bbs;
+    vector<reil_cfg_edge_t> edges;
+
+} cfg_func;
+
+/*
+    Claimed function, tasks are allocated in order of claims and linked
+    into the deque of worker that has claimed them.
+*/
+typedef struct _cfg_task
+{
+    reil_addr_t addr;
+    int prev, next;
+
+} cfg_task;
+
+/*
+    Work-stealing deque of the worker, owner pushes and pops functions
+    at the tail while other workers are stealing them from the head.
+*/
+typedef struct _cfg_deque
+{
+    int lock;
+    int head, tail;
+
+} cfg_deque;
+
+/*
+    Discovery state that is shared between workers, claimed set is open 
+    addressing hash table of function addresses plus one with two slots
+    for each task.
+*/
+typedef struct _cfg_shared
+{
+    size_t size;
+    bool fork;      // state is mapped into the shared memory and can't grow
+    int workers;
+    int capacity;   // max. number of tasks
+    int pending;    // number of functions that are queued or processed
+    int claims;     // number of claimed functions
+    int overflow;   // claimed set is full
+    int failed;     // one of the workers has died, others must exit
+
+    cfg_deque *deques;
+    cfg_task *tasks;
+    reil_addr_t *claimed;
+
+} cfg_shared;
+
+class CReilCFG
+{
+public:
+
+    CReilCFG(reil_arch_t arch, reil_reader_t reader, void *context);
+    ~CReilCFG();
+
+    void set_data_reader(reil_reader_t reader, void *context);
+
+    int traverse(CFG_LOC loc);
+    int discover(reil_addr_t *entries, int count, int jobs);
+
+    int func_list(reil_cfg_func_t *funcs, int count);
+    int bb_list(reil_cfg_bb_t *bbs, int count);
+    int edge_list(reil_cfg_edge_t *edges, int count);
+    int insn_list(reil_addr_t addr, reil_inst_t *insts, int count);
+
+    // called by translator for each generated IR instruction
+    void handler(reil_inst_t *inst);
+
+private:
+
+    bool is_thumb(reil_addr_t addr) { return arch == ARCH_ARM && (addr & 1) != 0; }
+
+    int read_chunk(reil_addr_t addr, const string **data);
+    int read_code(reil_addr_t addr, unsigned char *buff);
+
+    cfg_insn *translate(reil_addr_t addr);
+    reil_inst_t *get_inst(CFG_LOC loc, cfg_insn **insn = NULL);
+
+    bool is_bb_end(reil_inst_t *inst);
+    CFG_LOC get_next(reil_inst_t *inst);
+    int get_successors(reil_inst_t *inst, CFG_LOC *succ);
+
+    bool add_leader(CFG_LOC loc);
+    void add_bb(CFG_LOC loc);
+
+    bool resolve(vector<CFG_LOC> &entries, vector<cfg_insn *> &walked, vector<CFG_LOC> &worklist);
+
+    cfg_shared *shared_alloc(int workers, int capacity, bool fork);
+    bool shared_grow(cfg_shared *shared);
+    void shared_free(cfg_shared *shared);
+
+    int claim(cfg_shared *shared, reil_addr_t addr);
+    void task_push(cfg_shared *shared, int worker, int task);
+    bool task_pop(cfg_shared *shared, int worker, reil_addr_t *addr);
+
+    void discover_worker(cfg_shared *shared, int worker);
+    bool discover_fork(cfg_shared *shared, int jobs);
+
+    void save_results(FILE *fd);
+    bool load_results(FILE *fd);
+
+    reil_arch_t arch;
+    reil_t reil;
+    reil_reader_t reader;
+    void *reader_context;
+
+    // optional callback that reads constant data for indirect jumps resolving
+    reil_reader_t data_reader;
+    void *data_context;
+
+    // instruction that is currently translated
+    cfg_insn *current;
+
+    // translated instructions and code chunks, they are kept between traversals
+    map<reil_addr_t, cfg_insn *> insns;
+    map<reil_addr_t, string> chunks;
+
+    unsigned int traversal;
+
+    // instructions that were translated since the start of discovery
+    vector<cfg_insn *> translated;
+
+    // leaders of the basic blocks and results of the last traversal
+    map<CFG_LOC, int> leaders;
+    vector<reil_cfg_bb_t> bbs;
+    vector<reil_cfg_edge_t> edges;
+
+    // direct call targets of the last traversal
+    vector<reil_addr_t> calls;
+
+    // resolved targets of indirect jumps of the last traversal
+    map<CFG_LOC, vector<reil_addr_t> > targets;
+
+    // functions found by discovery
+    map<reil_addr_t, cfg_func> found;
+    vector<reil_cfg_func_t> funcs;
+};
+
+#endif // REIL_CFG_H
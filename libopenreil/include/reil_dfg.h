@@ -0,0 +1,145 @@
+#ifndef REIL_DFG_H
+#define REIL_DFG_H
+
+typedef pair<reil_addr_t, reil_inum_t> DFG_LOC;
+
+// bit set of variables
+typedef vector<uint64_t> dfg_set;
+
+static inline void dfg_set_add(dfg_set &set, int n) { set[n >> 6] |= 1ULL << (n & 63); }
+static inline void dfg_set_del(dfg_set &set, int n) { set[n >> 6] &= ~(1ULL << (n & 63)); }
+static inline bool dfg_set_test(dfg_set &set, int n) { return (set[n >> 6] & (1ULL << (n & 63))) != 0; }
+
+static inline void dfg_set_union(dfg_set &dst, dfg_set &src)
+{
+    for (size_t i = 0; i < dst.size(); i++) dst[i] |= src[i];
+}
+
+// evaluate expression with constant operands, returns false for unsupported operations
+bool dfg_eval(reil_inst_t *inst, reil_const_t a, reil_const_t b, reil_const_t *val);
+
+class CReilDFGException
+{
+public:
+
+    CReilDFGException(string s) : reason(s) {};
+    string reason;
+};
+
+// max. number of optimization passes
+#define DFG_MAX_PASSES 8
+
+// states of constant propagation lattice, unreached blocks have no state at all
+enum { DFG_CONST, DFG_NAC };
+
+typedef struct _dfg_val
+{
+    int state;
+    reil_const_t val;
+
+} dfg_val;
+
+/*
+    IR instruction of the function, a, b and c are IDs of variable
+    operands or -1 for other operand types.
+*/
+typedef struct _dfg_insn
+{
+    reil_inst_t *inst;
+    DFG_LOC loc;
+
+    int a, b, c;
+
+    // indexes of successor instructions, exit is set when function might return
+    int succ[2], succ_count;
+    bool exit;
+
+    int bb;
+
+} dfg_insn;
+
+typedef struct _dfg_bb
+{
+    int first, last;
+    vector<int> succ, pred;
+    bool exit;
+
+} dfg_bb;
+
+/*
+    Key of the expression for value numbering, operands are value numbers.
+*/
+typedef struct _dfg_expr
+{
+    int op, a, b, size_a, size_b, size_c;
+    int mem;
+
+    bool operator < (const struct _dfg_expr &other) const
+    {
+        return memcmp(this, &other, sizeof(*this)) < 0;
+    }
+
+} dfg_expr;
+
+class CReilDFG
+{
+public:
+
+    CReilDFG(reil_arch_t arch, reil_inst_t *insts, int count);
+
+    int optimize(DFG_LOC entry, int options);
+
+protected:
+
+    int var_id(reil_arg_t *arg);
+    int find(DFG_LOC loc);
+
+    bool is_pure(reil_inst_t *inst);
+    bool is_read(dfg_insn *insn, int var);
+    bool is_written(dfg_insn *insn, int var);
+
+    void update(dfg_insn *insn);
+    void eliminate(dfg_insn *insn);
+
+    void set_arg(reil_arg_t *arg, int var, reil_size_t size);
+    void set_const(reil_arg_t *arg, reil_const_t val, reil_size_t size);
+
+    void build(DFG_LOC entry);
+
+    int constant_folding();
+    int fold_insn(dfg_insn *insn, vector<dfg_val> &vals);
+    void fold_transfer(dfg_insn *insn, vector<dfg_val> &vals);
+    bool fold_meet(vector<dfg_val> &dst, vector<dfg_val> &src);
+
+    int eliminate_subexpressions();
+    int coalesce_temps(dfg_bb *bb);
+
+    void liveness();
+    bool live_transfer(dfg_insn *insn, dfg_set &live, bool eliminate);
+
+    int eliminate_dead_code();
+
+    reil_arch_t arch;
+    bool keep_flags;
+    int eliminated;
+
+    // instructions sorted by IR address
+    vector<dfg_insn> insns;
+    vector<dfg_bb> bbs;
+    int entry;
+
+    // variables of the function
+    map<string, int> vars_map;
+    vector<reil_arg_t> vars;
+
+    // general purpose registers and flags of the architecture
+    dfg_set general, flags;
+
+    // variables that might be changed by function call
+    vector<int> clobbered;
+
+    // live variables at the end of each basic block
+    vector<dfg_set> live_out;
+};
+
+#endif // REIL_DFG_H
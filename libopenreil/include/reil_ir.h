@@ -8,6 +8,22 @@
 #define IOPT_RET        0x00000002
 #define IOPT_BB_END     0x00000004
 #define IOPT_ASM_END    0x00000008
+#define IOPT_ELIMINATED 0x00000010
+#define IOPT_REP        0x00000020
+
+/*
+    Fields of x86 rep-prefixed string instruction information that is encoded 
+    into the flags of the first IR instruction when IOPT_REP is set: operation 
+    and repeat condition (see reil_vm_rep_op_t and reil_vm_rep_cond_t) and 
+    element size in bytes.
+*/
+#define IOPT_REP_OP(_flags_)    (((_flags_) >> 8) & 0x3)
+#define IOPT_REP_SIZE(_flags_)  (((_flags_) >> 10) & 0x7)
+#define IOPT_REP_COND(_flags_)  (((_flags_) >> 13) & 0x3)
+
+#define IOPT_REP_INFO(_op_, _size_, _cond_) (IOPT_REP | ((_op_) << 8) | ((_size_) << 10) | ((_cond_) << 13))
+
+#define IOPT_REP_MASK   (IOPT_REP | 0x7f00)
 
 typedef enum _reil_op_t 
 { 
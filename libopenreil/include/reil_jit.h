@@ -0,0 +1,63 @@
+#ifndef REIL_JIT_H
+#define REIL_JIT_H
+
+// JIT compiler is available only for x86_64 hosts with System V ABI
+#if defined(__x86_64__) && !defined(_WIN32)
+#define VM_JIT_SUPPORTED
+#endif
+
+// number of executions before instruction gets compiled
+#define VM_JIT_THRESHOLD 0x40
+
+// maximum number of IR instructions in compiled block
+#define VM_JIT_MAX_INSNS 0x100
+
+// size of executable memory for compiled code
+#define VM_JIT_CODE_SIZE 0x200000
+
+class CReilJIT
+{
+public:
+
+    CReilJIT(reil_const_t *ip, reil_const_t ip_mask, unsigned long long *executed, vm_insn **exit);
+    ~CReilJIT();
+
+    bool is_available(void) { return code != NULL; }
+
+    bool compile(vm_insn *insn);
+    void flush(void);
+
+private:
+
+    void emit_u8(uint8_t val) { buff.push_back(val); }
+    void emit_u32(uint32_t val);
+    void emit_u64(uint64_t val);
+    void emit_bytes(const char *data, int size);
+
+    void emit_mov_imm(reil_const_t val);
+    void emit_mask(reil_const_t mask);
+    void emit_load(vm_insn *insn, reil_const_t *val, reil_const_t mask);
+    void emit_store(reil_const_t *val);
+    void emit_ip(reil_addr_t addr);
+    void emit_executed(int count);
+    void emit_call(vm_insn *insn);
+
+    bool emit_insn(vm_insn *insn);
+
+    reil_const_t *ip;
+    reil_const_t ip_mask;
+    unsigned long long *executed;
+    vm_insn **exit;
+
+    // executable memory
+    uint8_t *code;
+    size_t code_used;
+
+    // currently compiled block
+    vector<uint8_t> buff;
+
+    // instructions with handlers that were replaced with compiled code
+    vector<vm_insn *> entries;
+};
+
+#endif // REIL_JIT_H
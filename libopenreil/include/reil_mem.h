@@ -0,0 +1,215 @@
+#ifndef REIL_MEM_H
+#define REIL_MEM_H
+
+#define MEM_PAGE_BITS 12
+#define MEM_PAGE_SIZE REIL_MEM_PAGE_SIZE
+#define MEM_PAGE_MASK (MEM_PAGE_SIZE - 1)
+
+// number of entries in direct-mapped translation cache
+#define MEM_TLB_SIZE 0x100
+
+// initial number of page table slots, must be a power of 2
+#define MEM_TABLE_SIZE 0x100
+
+#define MEM_PAGE_NUM(_addr_) ((_addr_) >> MEM_PAGE_BITS)
+#define MEM_PAGE_OFFS(_addr_) ((_addr_) & MEM_PAGE_MASK)
+
+typedef struct _mem_page
+{
+    reil_addr_t num;
+
+    // number of memory and snapshot references, shared page is copied on write
+    int refs;
+
+    // accessible bytes bitmap and it's population count
+    int valid_count;
+    uint8_t valid[MEM_PAGE_SIZE / 8];
+
+    uint8_t data[MEM_PAGE_SIZE];
+
+} mem_page;
+
+typedef struct _mem_tlb_entry
+{
+    reil_addr_t num;
+    mem_page *page;
+
+} mem_tlb_entry;
+
+// pages and snapshots might be shared by memories that are used from different threads
+static inline int mem_ref(int *refs, int val)
+{
+    return __atomic_add_fetch(refs, val, __ATOMIC_ACQ_REL);
+}
+
+static inline int mem_refs(int *refs)
+{
+    return __atomic_load_n(refs, __ATOMIC_ACQUIRE);
+}
+
+static inline reil_const_t mem_get_le(uint8_t *data, int len)
+{
+    reil_const_t val = 0;
+
+    for (int i = len - 1; i >= 0; i--)
+    {
+        val = (val << 8) | data[i];
+    }
+
+    return val;
+}
+
+static inline void mem_put_le(uint8_t *data, int len, reil_const_t val)
+{
+    for (int i = 0; i < len; i++)
+    {
+        data[i] = (uint8_t)(val >> (i * 8));
+    }
+}
+
+/*
+    Saved memory state, pages are shared with the memory until they're modified.
+*/
+class CReilMemSnapshot
+{
+public:
+
+    CReilMemSnapshot(reil_addr_t alloc_last) : refs(1), alloc_last(alloc_last) {};
+    ~CReilMemSnapshot();
+
+    void ref(void) { mem_ref(&refs, 1); }
+    void release(void) { if (mem_ref(&refs, -1) == 0) delete this; }
+
+    int refs;
+
+    map<reil_addr_t, mem_page *> pages;
+    reil_addr_t alloc_last;
+};
+
+class CReilMem
+{
+public:
+
+    CReilMem(bool strict, reil_addr_t lowest_addr, reil_mem_fault_t fault, void *context);
+    ~CReilMem();
+
+    void set_strict(bool strict) { this->strict = strict; }
+
+    bool get_strict(void) { return strict; }
+    reil_addr_t get_lowest_addr(void) { return lowest_addr; }
+
+    bool read(reil_addr_t addr, uint8_t *buff, int size);
+    bool write(reil_addr_t addr, uint8_t *buff, int size);
+
+    bool alloc(reil_addr_t addr, uint8_t *data, int data_size, int size);
+    reil_addr_t alloc_addr(int size);
+
+    void clear(void);
+
+    CReilMemSnapshot *snapshot(void);
+    void restore(CReilMemSnapshot *snap);
+
+    reil_mem_error_t get_error(reil_addr_t *addr);
+
+    // fast path for the value that is located at fully accessible page
+    inline bool load(reil_addr_t addr, int len, reil_const_t *val)
+    {
+        mem_page *page = NULL;
+
+        if (MEM_PAGE_OFFS(addr) + len <= MEM_PAGE_SIZE && addr >= lowest_addr &&
+            (page = page_lookup(MEM_PAGE_NUM(addr))) != NULL && page->valid_count == MEM_PAGE_SIZE)
+        {
+            *val = mem_get_le(page->data + MEM_PAGE_OFFS(addr), len);
+            return true;
+        }
+
+        return load_slow(addr, len, val);
+    }
+
+    inline bool store(reil_addr_t addr, int len, reil_const_t val)
+    {
+        mem_page *page = NULL;
+
+        if (MEM_PAGE_OFFS(addr) + len <= MEM_PAGE_SIZE && addr >= lowest_addr &&
+            (page = page_lookup(MEM_PAGE_NUM(addr))) != NULL && page->valid_count == MEM_PAGE_SIZE &&
+            mem_refs(&page->refs) == 1)
+        {
+            mem_put_le(page->data + MEM_PAGE_OFFS(addr), len, val);
+            return true;
+        }
+
+        return store_slow(addr, len, val);
+    }
+
+private:
+
+    bool load_slow(reil_addr_t addr, int len, reil_const_t *val);
+    bool store_slow(reil_addr_t addr, int len, reil_const_t val);
+
+    bool check_addr(reil_addr_t addr);
+    bool set_error(reil_mem_error_t error, reil_addr_t addr);
+
+    bool read_raw(reil_addr_t addr, uint8_t *buff, int size);
+    bool write_raw(reil_addr_t addr, uint8_t *buff, int size);
+
+    inline mem_page *page_lookup(reil_addr_t num)
+    {
+        mem_tlb_entry *entry = &tlb[num & (MEM_TLB_SIZE - 1)];
+
+        if (entry->page == NULL || entry->num != num)
+        {
+            if ((entry->page = page_find(num)) == NULL)
+            {
+                return NULL;
+            }
+
+            entry->num = num;
+        }
+
+        return entry->page;
+    }
+
+    // returns writable page, shared one is copied
+    inline mem_page *page_lookup_write(reil_addr_t num)
+    {
+        mem_page *page = page_lookup(num);
+
+        return (page && mem_refs(&page->refs) > 1) ? page_copy(page) : page;
+    }
+
+    mem_page *page_find(reil_addr_t num);
+    mem_page *page_get(reil_addr_t num);
+    mem_page *page_copy(mem_page *page);
+
+    int table_slot(reil_addr_t num);
+    void table_insert(mem_page *page);
+    void table_remove(int slot);
+    void table_grow(void);
+    void table_reset(int count);
+
+    void tlb_flush(void);
+    void tlb_flush(reil_addr_t num);
+
+    bool strict;
+    reil_addr_t lowest_addr;
+
+    reil_mem_fault_t fault;
+    void *context;
+
+    reil_mem_error_t error;
+    reil_addr_t error_addr;
+
+    reil_addr_t alloc_last;
+
+    // page table with open addressing
+    vector<mem_page *> table;
+    int table_count;
+
+    // last taken or restored snapshot and pages that were changed since
+    CReilMemSnapshot *base;
+    vector<reil_addr_t> dirty;
+
+    mem_tlb_entry tlb[MEM_TLB_SIZE];
+};
+
+#endif // REIL_MEM_H
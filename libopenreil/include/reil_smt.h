@@ -0,0 +1,65 @@
+#ifndef REIL_SMT_H
+#define REIL_SMT_H
+
+// SMT-LIB2 name of memory array
+#define SMT_MEM_NAME "MEM"
+
+/*
+    Text of SMT-LIB2 term is built from the list of items: item is either
+    a text or a node that must be printed in its place (node is -1 for text).
+*/
+typedef struct _smt_item
+{
+    int node;
+    string text;
+
+} smt_item;
+
+/*
+    Export of symbolic expressions into bit-vector formulas: SMT-LIB2 text or
+    Z3 AST built with its C API. Each export is independent, so expressions
+    can be exported from the engine any number of times.
+*/
+class CReilSmt
+{
+public:
+
+    CReilSmt(CReilSym *sym, int options);
+
+    bool smt2(int *nodes, int count, string &text);
+
+    // returns false when libopenreil was built without Z3
+    bool z3(void *ctx, int *nodes, int count, void **out);
+
+private:
+
+    int bits(int n);
+    int width(sym_node *node);
+    int uses(sym_node *node, int arg);
+
+    // walk expression DAG in postorder and count uses of the nodes
+    bool order(int root, vector<int> &list);
+    bool shared(int n);
+
+    string name(int n);
+    string mem(reil_const_t addr);
+    bool declare(vector<int> &list, string &text);
+
+    bool atom(int n, string &text);
+    bool expand(int n, vector<smt_item> &items);
+    bool print(int n, string &text);
+
+    CReilSym *sym;
+    int options;
+
+    // nodes that were visited by current walk and their number of uses
+    vector<int> marks, touched, refs;
+    int mark;
+
+    // names of declared values
+    map<int, string> val_names;
+    set<string> val_taken;
+    set<reil_const_t> mem_bytes;
+};
+
+#endif // REIL_SMT_H
@@ -0,0 +1,105 @@
+#ifndef REIL_SSA_H
+#define REIL_SSA_H
+
+/*
+    State of the slice query, sets are indexed by instruction, SSA variable
+    and basic block.
+*/
+typedef struct _ssa_slice
+{
+    int options, bb, count;
+
+    dfg_set insns, vars, mem_bbs;
+
+    // SSA variables to process
+    vector<int> work;
+
+} ssa_slice;
+
+/*
+    SSA form of the function, CFG and variables are the same as data flow
+    optimizer has, results are stored in the arrays of C API structures.
+*/
+class CReilSSA : public CReilDFG
+{
+public:
+
+    CReilSSA(reil_arch_t arch, reil_inst_t *insts, int count, DFG_LOC entry);
+
+    int bb_list(reil_ssa_bb_t *bbs, int count);
+    int insn_list(reil_ssa_insn_t *insns, int count);
+    int var_list(reil_ssa_var_t *vars, int count);
+    int use_list(reil_ssa_use_t *uses, int count);
+    int phi_list(reil_ssa_phi_t *phis, int count);
+    int phi_arg_list(reil_ssa_phi_arg_t *args, int count);
+
+    int df_list(int bb, int *bbs, int count);
+    bool dominates(int a, int b);
+
+    int slice(DFG_LOC loc, int arg, int options, unsigned long long *bitmap, int count);
+
+protected:
+
+    void insn_uses(dfg_insn *insn, vector<int> &uses);
+    void insn_defs(dfg_insn *insn, vector<int> &defs);
+
+    void dominators();
+    void frontiers();
+    void place_phis();
+    void rename();
+    void rename_bb(int n, vector<int> &pushed);
+    void link_uses();
+
+    int new_var(int var, int insn, int phi);
+    int top_var(int var);
+    void add_use(int var, int insn, int phi);
+
+    bool is_mem_read(reil_inst_t *inst);
+    bool is_mem_write(reil_inst_t *inst);
+
+    void slice_index();
+    void slice_add(ssa_slice &s, int n);
+    void slice_var(ssa_slice &s, int var);
+    void slice_mem(ssa_slice &s, int n);
+
+    // registers and general purpose registers of the function
+    vector<int> regs, general_regs;
+
+    // reverse postorder of reachable blocks and postorder numbers
+    vector<int> order, post_num;
+
+    vector<int> idom;
+
+    // children in dominator tree and dominance frontiers (CSR arrays)
+    vector<int> dom_first, dom_children;
+    vector<int> df_first, df_bbs;
+
+    // dominator tree preorder and postorder numbers for dominates()
+    vector<int> dom_pre, dom_post;
+
+    // phi functions of each block
+    vector<vector<int> > bb_phis;
+
+    // renaming stacks and version counters of each variable
+    vector<vector<int> > stacks;
+    vector<int> versions, entry_vars;
+
+    // uses that are collected during renaming
+    vector<pair<int, reil_ssa_use_t> > var_uses;
+
+    vector<reil_ssa_bb_t> ssa_bbs;
+    vector<reil_ssa_insn_t> ssa_insns;
+    vector<reil_ssa_var_t> ssa_vars;
+    vector<reil_ssa_use_t> ssa_uses;
+    vector<reil_ssa_phi_t> ssa_phis;
+    vector<reil_ssa_phi_arg_t> ssa_phi_args;
+
+    // copy of the instructions, caller can free them after initialization
+    vector<reil_inst_t> ssa_insts;
+
+    // used and defined SSA variables of each instruction for slicing (CSR arrays)
+    vector<int> use_first, use_vars;
+    vector<int> def_first, def_vars;
+};
+
+#endif // REIL_SSA_H
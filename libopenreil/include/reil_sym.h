@@ -0,0 +1,91 @@
+#ifndef REIL_SYM_H
+#define REIL_SYM_H
+
+// initial number of hash table slots, table is doubled when it's half full
+#define SYM_TABLE_SIZE 0x1000
+
+/*
+    Node of expression DAG, operands are indexes of other nodes or -1,
+    name is index of interned register name.
+*/
+typedef struct _sym_node
+{
+    int kind;
+    reil_op_t op;
+    reil_size_t size;
+    int a, b, c;
+    reil_const_t val;
+    reil_inum_t inum;
+    reil_type_t type;
+    int name;
+
+} sym_node;
+
+/*
+    Hash-consed expressions: each distinct expression exists only once, so
+    expressions are equal only when their node indexes are equal. Nodes are
+    simplified when they are created and never changed or freed until the
+    end of the engine lifetime.
+*/
+class CReilSym
+{
+    friend class CReilSmt;
+
+public:
+
+    CReilSym();
+
+    int constant(reil_const_t val, reil_size_t size);
+    int val(const char *name, reil_type_t type, reil_size_t size, reil_addr_t addr);
+    int ptr(int addr, reil_size_t size);
+    int exp(reil_op_t op, int a, int b, reil_size_t size);
+    int cond(int cond, int a, int b);
+    int loc(reil_addr_t addr, reil_inum_t inum);
+    int ip();
+
+    bool node(int n, reil_sym_node_t *info);
+
+    // number of created nodes
+    int count() { return (int)nodes.size(); }
+
+    // update state with IR instructions, state items are kept in order of their creation
+    bool exec(reil_inst_t *insts, int count, vector<reil_sym_item_t> &state);
+
+    /*
+        Update state with summary of IR code: state that exec() gave for this code
+        from the empty state. Returns false when two memory writes of summary are
+        going to the same address in given state.
+    */
+    bool apply(vector<reil_sym_item_t> &summary, vector<reil_sym_item_t> &state);
+
+private:
+
+    bool valid(int n) { return n >= 0 && n < (int)nodes.size(); }
+
+    unsigned int hash(sym_node &node);
+    bool same(sym_node &a, sym_node &b);
+    int add(sym_node &node);
+    void grow();
+
+    bool is_const(int n, reil_const_t val);
+    int cast(int a, reil_size_t size);
+    int simplify(reil_op_t op, int a, int b, reil_size_t size);
+
+    int arg(reil_inst_t *inst, reil_arg_t *arg, vector<reil_sym_item_t> &state, map<int, int> &index);
+    int arg_val(reil_inst_t *inst, reil_arg_t *arg);
+    void update(vector<reil_sym_item_t> &state, map<int, int> &index, int val, int exp);
+    bool index_build(vector<reil_sym_item_t> &state, map<int, int> &index);
+
+    // replace initial values of registers in expression with their values from state
+    int subst(int n, vector<reil_sym_item_t> &state, map<int, int> &index, map<int, int> &done);
+
+    vector<sym_node> nodes;
+
+    // open addressing hash table of node indexes, -1 for empty slot
+    vector<int> table;
+
+    vector<string> names;
+    map<string, int> name_ids;
+};
+
+#endif // REIL_SYM_H
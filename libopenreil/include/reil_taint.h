@@ -0,0 +1,284 @@
+#ifndef REIL_TAINT_H
+#define REIL_TAINT_H
+
+/*
+    Shadow page of the guest memory, each byte holds taint bits of the
+    corresponding guest memory byte.
+*/
+typedef struct _taint_page
+{
+    uint8_t data[MEM_PAGE_SIZE];
+
+} taint_page;
+
+typedef struct _taint_tlb_entry
+{
+    reil_addr_t num;
+
+    // NULL when page has no tainted bytes
+    taint_page *page;
+
+} taint_tlb_entry;
+
+/*
+    Register that is checked when machine instruction at given address
+    is executed, see reil_vm_taint_sink_add().
+*/
+typedef struct _taint_sink
+{
+    reil_addr_t addr;
+    string name;
+
+} taint_sink;
+
+// rounds taint bits to the whole bytes
+static inline reil_const_t vm_taint_bytes(reil_const_t t)
+{
+    reil_const_t low = 0x7f7f7f7f7f7f7f7fULL, high = 0x8080808080808080ULL;
+
+    // high bit of each byte that has any bit set
+    t = (((t & low) + low) | t) & high;
+
+    return (t >> 7) * 0xff;
+}
+
+// all bits starting from the lowest tainted one
+static inline reil_const_t vm_taint_smear(reil_const_t t)
+{
+    return t | (0 - t);
+}
+
+//======================================================================
+// Propagation rules
+//======================================================================
+
+/*
+    Taint bits of the operation result for given operand values and their
+    taint bits, values of tainted bits are not known. Rules are precise for
+    bitwise operations and shifts by untainted amount, additions are using
+    the lowest and the highest possible operand values to find bits that
+    can be changed by carry.
+*/
+struct vm_taint_str
+{
+    static inline reil_const_t prop(reil_const_t, reil_const_t, reil_const_t ta, reil_const_t) { return ta; }
+};
+
+struct vm_taint_not
+{
+    static inline reil_const_t prop(reil_const_t, reil_const_t, reil_const_t ta, reil_const_t) { return ta; }
+};
+
+struct vm_taint_xor
+{
+    static inline reil_const_t prop(reil_const_t, reil_const_t, reil_const_t ta, reil_const_t tb) { return ta | tb; }
+};
+
+struct vm_taint_and
+{
+    // untainted zero bit of the other operand clears the result bit
+    static inline reil_const_t prop(reil_const_t a, reil_const_t b, reil_const_t ta, reil_const_t tb)
+    {
+        return (ta & (tb | b)) | (tb & a);
+    }
+};
+
+struct vm_taint_or
+{
+    // untainted one bit of the other operand sets the result bit
+    static inline reil_const_t prop(reil_const_t a, reil_const_t b, reil_const_t ta, reil_const_t tb)
+    {
+        return (ta & (tb | ~b)) | (tb & ~a);
+    }
+};
+
+struct vm_taint_add
+{
+    static inline reil_const_t prop(reil_const_t a, reil_const_t b, reil_const_t ta, reil_const_t tb)
+    {
+        return ta | tb | (((a & ~ta) + (b & ~tb)) ^ ((a | ta) + (b | tb)));
+    }
+};
+
+struct vm_taint_sub
+{
+    static inline reil_const_t prop(reil_const_t a, reil_const_t b, reil_const_t ta, reil_const_t tb)
+    {
+        return ta | tb | (((a & ~ta) - (b | tb)) ^ ((a | ta) - (b & ~tb)));
+    }
+};
+
+struct vm_taint_neg
+{
+    static inline reil_const_t prop(reil_const_t a, reil_const_t, reil_const_t ta, reil_const_t)
+    {
+        return ta | ((0 - (a & ~ta)) ^ (0 - (a | ta)));
+    }
+};
+
+struct vm_taint_mul
+{
+    static inline reil_const_t prop(reil_const_t a, reil_const_t b, reil_const_t ta, reil_const_t tb)
+    {
+        // multiplication by untainted zero
+        if ((ta == 0 && a == 0) || (tb == 0 && b == 0)) return 0;
+
+        // result bit depends only on the same and lower operand bits
+        return vm_taint_smear(ta | tb);
+    }
+};
+
+struct vm_taint_div
+{
+    static inline reil_const_t prop(reil_const_t, reil_const_t, reil_const_t ta, reil_const_t tb)
+    {
+        return (ta | tb) ? ~0ULL : 0;
+    }
+};
+
+struct vm_taint_shl
+{
+    static inline reil_const_t prop(reil_const_t, reil_const_t b, reil_const_t ta, reil_const_t tb)
+    {
+        if (tb) return ~0ULL;
+
+        return b >= 64 ? 0 : ta << b;
+    }
+};
+
+struct vm_taint_shr
+{
+    static inline reil_const_t prop(reil_const_t, reil_const_t b, reil_const_t ta, reil_const_t tb)
+    {
+        if (tb) return ~0ULL;
+
+        return b >= 64 ? 0 : ta >> b;
+    }
+};
+
+struct vm_taint_eq
+{
+    static inline reil_const_t prop(reil_const_t a, reil_const_t b, reil_const_t ta, reil_const_t tb)
+    {
+        // untainted bits are already different
+        return ((a ^ b) & ~(ta | tb)) ? 0 : 1;
+    }
+};
+
+struct vm_taint_lt
+{
+    static inline reil_const_t prop(reil_const_t a, reil_const_t b, reil_const_t ta, reil_const_t tb)
+    {
+        // result is known when ranges of possible operand values are not overlapped
+        reil_const_t a_min = a & ~ta, a_max = a | ta, b_min = b & ~tb, b_max = b | tb;
+
+        return (a_max < b_min || a_min >= b_max) ? 0 : 1;
+    }
+};
+
+//======================================================================
+// Shadow state
+//======================================================================
+
+class CReilTaint
+{
+public:
+
+    CReilTaint(int options);
+    ~CReilTaint();
+
+    void set_options(int options);
+    int get_options(void) { return options; }
+
+    // make shadow registers available for register IDs below count
+    void reserve(int count);
+
+    void clear(void);
+
+    inline reil_const_t reg(int id)
+    {
+        return id < 0 ? 0 : regs[id];
+    }
+
+    inline void reg_set(int id, reil_const_t t, reil_const_t mask)
+    {
+        regs[id] = (bytes ? vm_taint_bytes(t) : t) & mask;
+    }
+
+    inline reil_const_t load(reil_addr_t addr, int len)
+    {
+        if (MEM_PAGE_OFFS(addr) + len <= MEM_PAGE_SIZE)
+        {
+            taint_page *page = page_lookup(MEM_PAGE_NUM(addr));
+
+            return page ? mem_get_le(page->data + MEM_PAGE_OFFS(addr), len) : 0;
+        }
+
+        return load_slow(addr, len);
+    }
+
+    inline void store(reil_addr_t addr, int len, reil_const_t t)
+    {
+        if (MEM_PAGE_OFFS(addr) + len <= MEM_PAGE_SIZE)
+        {
+            taint_page *page = page_lookup(MEM_PAGE_NUM(addr));
+
+            // untainted value doesn't need a shadow page
+            if (page == NULL && t == 0) return;
+            if (page == NULL) page = page_get(MEM_PAGE_NUM(addr));
+
+            mem_put_le(page->data + MEM_PAGE_OFFS(addr), len, t);
+            return;
+        }
+
+        store_slow(addr, len, t);
+    }
+
+    void read(reil_addr_t addr, uint8_t *buff, int size);
+    void fill(reil_addr_t addr, int size, uint8_t t);
+
+    int sink_add(reil_addr_t addr, string name);
+    void sink_clear(void);
+
+    bool is_sink(reil_addr_t addr) { return sink_addrs.find(addr) != sink_addrs.end(); }
+
+    vector<taint_sink> sinks;
+
+private:
+
+    reil_const_t load_slow(reil_addr_t addr, int len);
+    void store_slow(reil_addr_t addr, int len, reil_const_t t);
+
+    inline taint_page *page_lookup(reil_addr_t num)
+    {
+        taint_tlb_entry *entry = &tlb[num & (MEM_TLB_SIZE - 1)];
+
+        if (entry->num != num)
+        {
+            // pages without taint are cached as well
+            map<reil_addr_t, taint_page *>::iterator it = pages.find(num);
+
+            entry->num = num;
+            entry->page = it == pages.end() ? NULL : it->second;
+        }
+
+        return entry->page;
+    }
+
+    taint_page *page_get(reil_addr_t num);
+
+    void tlb_flush(void);
+
+    int options;
+    bool bytes;
+
+    // shadow registers by register ID
+    vector<reil_const_t> regs;
+
+    map<reil_addr_t, taint_page *> pages;
+    taint_tlb_entry tlb[MEM_TLB_SIZE];
+
+    set<reil_addr_t> sink_addrs;
+};
+
+#endif // REIL_TAINT_H
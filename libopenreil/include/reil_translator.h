@@ -6,11 +6,6 @@
 
 #define MAX_REG_NAME_LEN 20
 
-string to_string_constant(reil_const_t val, reil_size_t size);
-string to_string_size(reil_size_t size);
-string to_string_operand(reil_arg_t *a);
-string to_string_inst_code(reil_op_t inst_code);
-
 typedef pair<int32_t, string> TEMPREG_BAP;
 
 typedef pair<reil_const_t, reil_inum_t> BAP_LOC;
@@ -28,7 +23,7 @@ class CReilFromBilTranslator
 {
 public:
     
-    CReilFromBilTranslator(VexArch arch, reil_inst_handler_t handler, void *context); 
+    CReilFromBilTranslator(VexArch arch, reil_inst_handler_t handler, void *context, reil_stats_t *stats); 
     ~CReilFromBilTranslator();
 
     void reset_state(bap_block_t *block);    
@@ -43,6 +38,7 @@ private:
     string tempreg_get(string name);
     
     uint64_t convert_special(Special *special);
+    uint64_t convert_rep(reil_raw_t *raw_info);
 
     void convert_operand(Exp *exp, reil_arg_t *reil_arg);  
     reg_t convert_operand_size(reil_size_t size);
@@ -88,6 +84,9 @@ private:
     reil_inst_handler_t inst_handler;
     void *inst_handler_context;
 
+    // translation statistics, time values are in stats_tsc() ticks
+    reil_stats_t *stats;
+
     vector<reil_inst_t *> translated_insts;
     vector<BAP_LABEL *> translated_labels;
 };
@@ -101,10 +100,26 @@ public:
 
     int process_inst(address_t addr, uint8_t *data, int size);
 
+    void get_stats(reil_stats_t *stats);
+    void reset_stats(void);
+    void failed_inst(void);
+
+    void profile_enable(bool enable);
+    int profile_get(reil_profile_entry_t *entries, int count);
+    void profile_reset(void);
+
 private:
 
+    reil_profile_entry_t *profile_entry(bap_block_t *block);
+
     bap_context_t *context;
     CReilFromBilTranslator *translator;
+
+    reil_stats_t stats;
+
+    // per-mnemonic translation profile, time values are in stats_tsc() ticks
+    bool profile_enabled;
+    map<pair<unsigned int, string>, reil_profile_entry_t> profile;
 };
 
 #endif // REIL_TRANSLATOR_H
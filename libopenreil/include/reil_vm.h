@@ -0,0 +1,310 @@
+#ifndef REIL_VM_H
+#define REIL_VM_H
+
+typedef pair<reil_addr_t, reil_inum_t> VM_LOC;
+
+// max. number of bytes that is processed by single bulk memory operation
+#define VM_REP_CHUNK 0x1000
+
+// indexes of vm_rep registers
+enum { VM_REP_COUNT, VM_REP_SRC, VM_REP_DST, VM_REP_VAL, VM_REP_DIR, VM_REP_REGS };
+
+// max. number of queued events before they are delivered to the hook handler
+#define VM_HOOK_BATCH 0x400
+
+// flags of vm_insn events field
+#define VM_EVENT_BB     0x01    // basic block entry
+#define VM_EVENT_INSN   0x02    // hooked machine instruction
+#define VM_EVENT_SINK   0x04    // taint sink
+
+typedef struct _vm_reg
+{
+    // index of the register, it's used as shadow register index by taint tracking
+    int id;
+
+    string name;
+    reil_size_t size;
+    reil_const_t val;
+    bool temp;
+
+} vm_reg;
+
+typedef struct _vm_insn vm_insn;
+
+class CReilTaint;
+
+/*
+    Rep-prefixed string instruction, see reil_vm_rep_add().
+*/
+typedef struct _vm_rep
+{
+    reil_vm_rep_op_t op;
+    reil_vm_rep_cond_t cond;
+    int size;
+
+    // register names and registers that were found on the first execution
+    string names[VM_REP_REGS];
+    vm_reg *regs[VM_REP_REGS];
+
+} vm_rep;
+
+/*
+    Execution hook and queued events, see reil_vm_hook_set().
+*/
+typedef struct _vm_hooks
+{
+    int mask;
+    reil_vm_hook_t handler;
+    void *context;
+    reil_vm_t vm;
+
+    // instruction addresses and memory ranges filters, empty filter matches everything
+    set<reil_addr_t> addrs;
+    vector<pair<reil_addr_t, reil_addr_t> > ranges;
+
+    vector<reil_vm_event_t> events;
+
+} vm_hooks;
+
+/*
+    Interpreter state that is visible for instruction handlers.
+*/
+typedef struct _vm_state
+{
+    // native guest memory, memory access callbacks are used when it's NULL
+    CReilMem *mem;
+
+    reil_vm_mem_read_t mem_read;
+    reil_vm_mem_write_t mem_write;
+    void *context;
+
+    // set by handler that returned NULL because of error
+    bool error;
+    reil_vm_status_t status;
+
+    // set by handler that returned NULL because of unresolved next instruction
+    VM_LOC next;
+    vm_insn **link;
+
+    // address range and pages of loaded code to detect it's modifications
+    reil_addr_t code_start, code_end;
+    set<reil_addr_t> code_pages;
+
+    // set by STM handler that modified loaded code
+    bool code_written;
+
+    // set by compiled code to the instruction that returned NULL
+    vm_insn *exit;
+
+    vm_hooks hooks;
+
+    // shadow state, NULL when taint tracking is disabled
+    CReilTaint *taint;
+
+} vm_state;
+
+typedef vm_insn *(* vm_handler_t)(vm_state *state, vm_insn *insn);
+
+/*
+    Pre-decoded IR instruction.
+*/
+struct _vm_insn
+{
+    // opcode and operand size specific handler, or compiled code of the block
+    vm_handler_t handler;
+
+    // interpreter handler
+    vm_handler_t exec;
+
+    // number of executions, used by JIT compiler
+    unsigned int hits;
+
+    // set for instructions in the middle of compiled block
+    bool compiled;
+
+    // VM_EVENT_* flags that must be handled by interpreter before execution
+    int events;
+
+    // number of basic block executions and it's edge coverage identifier
+    unsigned long long bb_hits;
+    unsigned int cov_id;
+
+    reil_addr_t addr;
+    reil_inum_t inum;
+    reil_op_t op;
+
+    // pointers to registers values or to the immediate values below
+    reil_const_t *a, *b, *c;
+    reil_const_t imm_a, imm_b, imm_c;
+
+    // IDs of register operands or -1
+    int reg_a, reg_b, reg_c;
+
+    // masks for operands and result values
+    reil_const_t mask_a, mask_b, mask_c;
+
+    // sign extension shifts for operands and result values of signed operations
+    int sext_a, sext_b, sext_r;
+
+    // memory access size for LDM and STM
+    reil_size_t mem_size;
+    int mem_len;
+
+    bool stop;
+
+    // rep-prefixed string instruction information, set only for the first IR instruction
+    vm_rep *rep;
+
+    // next instruction, NULL when it wasn't resolved yet
+    vm_insn *next;
+    VM_LOC next_loc;
+
+    // JCC target instruction, for register target it keeps last taken one
+    vm_insn *jump;
+    VM_LOC jump_loc;
+};
+
+/*
+    Saved registers state.
+*/
+typedef struct _vm_snapshot
+{
+    vector<vm_reg> regs;
+
+} vm_snapshot;
+
+class CReilJIT;
+class CReilBatch;
+
+class CReilVMException
+{
+public:
+
+    CReilVMException(string s) : reason(s) {};
+    string reason;
+};
+
+class CReilVM
+{
+public:
+
+    CReilVM(reil_arch_t arch, reil_vm_fetch_t fetch,
+            reil_vm_mem_read_t mem_read, reil_vm_mem_write_t mem_write, void *context);
+    ~CReilVM();
+
+    void load(reil_inst_t *inst, VM_LOC next);
+    void flush(void);
+
+    void rep_add(reil_addr_t addr, reil_vm_rep_t *rep);
+
+    bool reg_get(string name, reil_size_t *size, reil_const_t *val);
+    void reg_set(string name, reil_size_t size, reil_const_t val);
+    int reg_list(reil_vm_reg_t *regs, int count);
+
+    void reset(void);
+    void reset_temp(void);
+
+    void stop_add(reil_addr_t addr, int inum);
+    void stop_clear(void);
+
+    vm_snapshot *snapshot(void);
+    void restore(vm_snapshot *snap);
+
+    void set_mem(CReilMem *mem);
+
+    bool jit_enable(bool enable);
+
+    void taint_enable(bool enable, int options);
+    bool taint_clear(void);
+
+    bool taint_reg_get(string name, reil_const_t *mask);
+    bool taint_reg_set(string name, reil_const_t mask);
+
+    bool taint_mem_get(reil_addr_t addr, uint8_t *buff, int size);
+    bool taint_mem_set(reil_addr_t addr, int size, uint8_t mask);
+
+    int taint_sink_add(reil_addr_t addr, string name);
+    bool taint_sink_clear(void);
+
+    void hook_set(int mask, reil_vm_hook_t handler, void *context);
+    void hook_addr_add(reil_addr_t addr);
+    void hook_mem_add(reil_addr_t addr, int size);
+    void hook_clear(void);
+
+    int cov_list(reil_vm_cov_t *items, int count);
+    uint8_t *cov_map(void) { return cov_bitmap; }
+    void cov_reset(void);
+
+    reil_vm_status_t run(VM_LOC loc);
+
+    void get_state(reil_vm_state_t *state);
+
+private:
+
+    // batch executor shares registers and loaded instructions of the interpreter
+    friend class CReilBatch;
+
+    vm_reg *reg_find(string name);
+    vm_reg *reg_create(string name, reil_size_t size, bool temp);
+
+    void decode_arg(reil_arg_t *arg, reil_const_t **val, reil_const_t *imm, reil_size_t *size, int *reg);
+    vm_handler_t decode_handler(reil_op_t op, reil_size_t size_a, reil_size_t size_b, reil_size_t size_c);
+
+    bool is_stop(reil_addr_t addr, reil_inum_t inum);
+
+    bool rep_range(reil_const_t ptr, reil_const_t mask, bool back, int len, int size, reil_addr_t *addr);
+    void rep_execute(vm_rep *rep);
+    vm_insn *fetch_insn(VM_LOC loc);
+
+    void jit_compile(vm_insn *insn);
+    void jit_flush(void);
+
+    int hook_events(vm_insn *insn);
+    void hook_update(void);
+
+    vm_handler_t insn_handler(vm_insn *insn);
+    bool taint_sink(vm_insn *insn);
+
+    void bb_mark(vm_insn *insn);
+    bool on_events(vm_insn *insn);
+
+    reil_vm_status_t execute(VM_LOC loc);
+
+    reil_vm_fetch_t fetch;
+    void *context;
+
+    vm_state state;
+
+    // registers file, deque keeps pointers to its items valid
+    deque<vm_reg> regs;
+    map<string, vm_reg *> regs_map;
+    vm_reg *reg_ip;
+
+    // loaded instructions
+    deque<vm_insn> insns;
+    map<VM_LOC, vm_insn *> insns_map;
+
+    // rep-prefixed string instructions by address
+    map<reil_addr_t, vm_rep> reps;
+
+    set<VM_LOC> stop_points;
+    set<reil_addr_t> stop_addrs;
+
+    VM_LOC current;
+    unsigned long long executed;
+
+    // JIT compiler, NULL when it's disabled
+    CReilJIT *jit;
+
+    // loaded instructions are used by batch worker threads and can't be replaced
+    bool shared;
+
+    // AFL-style edge coverage bitmap and identifier of the previous basic block
+    uint8_t cov_bitmap[REIL_VM_COV_MAP_SIZE];
+    unsigned int cov_prev;
+
+    // hits of basic blocks that were flushed
+    map<VM_LOC, unsigned long long> cov_hits;
+};
+
+#endif // REIL_VM_H
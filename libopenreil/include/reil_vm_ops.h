@@ -0,0 +1,115 @@
+#ifndef REIL_VM_OPS_H
+#define REIL_VM_OPS_H
+
+/*
+    Operand sizes and semantics of IR operations that are shared by native
+    interpreter and batch executor.
+*/
+
+static inline reil_const_t vm_mask(reil_size_t size)
+{
+    switch (size)
+    {
+    case U1: return 0x1;
+    case U8: return 0xff;
+    case U16: return 0xffff;
+    case U32: return 0xffffffff;
+    case U64: return 0xffffffffffffffffULL;
+    }
+
+    throw CReilVMException("Invalid operand size");
+}
+
+// width of the numpy type that pyopenreil uses for values of given size
+static inline int vm_width(reil_size_t size)
+{
+    switch (size)
+    {
+    case U1:
+    case U8: return 8;
+    case U16: return 16;
+    case U32: return 32;
+    case U64: return 64;
+    }
+
+    throw CReilVMException("Invalid operand size");
+}
+
+static inline reil_const_t vm_width_mask(int width)
+{
+    return width == 64 ? 0xffffffffffffffffULL : ((1ULL << width) - 1);
+}
+
+//======================================================================
+// Operations
+//======================================================================
+
+struct vm_op_str { static inline reil_const_t eval(reil_const_t a, reil_const_t) { return a; } };
+struct vm_op_add { static inline reil_const_t eval(reil_const_t a, reil_const_t b) { return a + b; } };
+struct vm_op_sub { static inline reil_const_t eval(reil_const_t a, reil_const_t b) { return a - b; } };
+struct vm_op_neg { static inline reil_const_t eval(reil_const_t a, reil_const_t) { return 0 - a; } };
+struct vm_op_mul { static inline reil_const_t eval(reil_const_t a, reil_const_t b) { return a * b; } };
+struct vm_op_and { static inline reil_const_t eval(reil_const_t a, reil_const_t b) { return a & b; } };
+struct vm_op_or  { static inline reil_const_t eval(reil_const_t a, reil_const_t b) { return a | b; } };
+struct vm_op_xor { static inline reil_const_t eval(reil_const_t a, reil_const_t b) { return a ^ b; } };
+struct vm_op_not { static inline reil_const_t eval(reil_const_t a, reil_const_t) { return ~a; } };
+struct vm_op_eq  { static inline reil_const_t eval(reil_const_t a, reil_const_t b) { return a == b ? 1 : 0; } };
+struct vm_op_lt  { static inline reil_const_t eval(reil_const_t a, reil_const_t b) { return a < b ? 1 : 0; } };
+
+struct vm_op_div
+{
+    // numpy returns zero on division by zero
+    static inline reil_const_t eval(reil_const_t a, reil_const_t b) { return b == 0 ? 0 : a / b; }
+};
+
+struct vm_op_mod
+{
+    static inline reil_const_t eval(reil_const_t a, reil_const_t b) { return b == 0 ? 0 : a % b; }
+};
+
+struct vm_op_shl
+{
+    static inline reil_const_t eval(reil_const_t a, reil_const_t b) { return b >= 64 ? 0 : a << b; }
+};
+
+struct vm_op_shr
+{
+    static inline reil_const_t eval(reil_const_t a, reil_const_t b) { return b >= 64 ? 0 : a >> b; }
+};
+
+struct vm_op_smul
+{
+    static inline int64_t eval(int64_t a, int64_t b)
+    {
+        return (int64_t)((reil_const_t)a * (reil_const_t)b);
+    }
+};
+
+// quotient is rounded towards zero and remainder has the sign of dividend
+struct vm_op_sdiv
+{
+    static inline int64_t eval(int64_t a, int64_t b)
+    {
+        if (b == 0) return 0;
+
+        // avoid overflow trap on INT64_MIN / -1
+        if (b == -1) return (int64_t)(0 - (reil_const_t)a);
+
+        return a / b;
+    }
+};
+
+struct vm_op_smod
+{
+    static inline int64_t eval(int64_t a, int64_t b)
+    {
+        return (b == 0 || b == -1) ? 0 : a % b;
+    }
+};
+
+static inline int64_t vm_sext(reil_const_t val, int shift)
+{
+    return (int64_t)(val << shift) >> shift;
+}
+
+#endif // REIL_VM_OPS_H
@@ -0,0 +1,89 @@
+#ifndef REIL_VSA_H
+#define REIL_VSA_H
+
+// max. number of values in the set, bigger sets are turned into any value
+#define VSA_MAX_VALS 0x200
+
+// max. number of operations to evaluate expression over two sets
+#define VSA_MAX_OPS 0x1000
+
+// number of changes of variable value after which it's widened to any value
+#define VSA_MAX_CHANGES 8
+
+// max. number of definitions to follow while refining branch condition
+#define VSA_MAX_DEPTH 8
+
+// max. number of passes, analysis gives no results when it's not converged
+#define VSA_MAX_PASSES 0x100
+
+// states of value set lattice
+enum { VSA_TOP, VSA_SET, VSA_ANY };
+
+typedef struct _vsa_val
+{
+    int state;
+    vector<reil_const_t> vals;  // sorted values for VSA_SET
+
+} vsa_val;
+
+/*
+    Values of SSA variables that are known on the path to the block from 
+    the branch conditions, SSA variables are never changed, so constraints 
+    of dominating branches are valid for the whole path.
+*/
+typedef map<int, vector<reil_const_t> > vsa_env;
+
+/*
+    Sparse conditional constant propagation over the bounded value sets of 
+    SSA variables, I_LDM from constant memory that is read with callback is
+    evaluated as well.
+*/
+class CReilVSA : public CReilSSA
+{
+public:
+
+    CReilVSA(reil_arch_t arch, reil_inst_t *insts, int count, DFG_LOC entry,
+             reil_reader_t reader, void *context);
+
+    // get targets of indirect jumps that were resolved
+    int jump_list(map<DFG_LOC, vector<reil_addr_t> > &jumps);
+
+private:
+
+    bool get(int var, vsa_env &env, vsa_val &val);
+    bool get_arg(reil_arg_t *arg, int var, vsa_env &env, vsa_val &val);
+    bool get_single(reil_arg_t *arg, int var, vsa_env &env, reil_const_t *ret);
+
+    bool load(reil_addr_t addr, reil_size_t size, reil_const_t *val);
+
+    void eval(reil_inst_t *inst, vsa_val &a, vsa_val &b, vsa_val &ret);
+    void transfer(int n, vsa_env &env);
+    void update(int var, vsa_val &val);
+
+    bool refine_bool(int var, reil_const_t bit, vsa_env &env, int depth, vsa_env &ret);
+    bool refine_value(int var, vector<reil_const_t> &vals, vsa_env &env, int depth, vsa_env &ret);
+
+    void jump_succ(int n, int *target, int *next);
+    bool edge_env(int from, int to, vsa_env &ret);
+
+    bool solve();
+
+    reil_reader_t reader;
+    void *reader_context;
+
+    // values of SSA variables and number of their changes
+    vector<vsa_val> vals;
+    vector<int> changes;
+    bool changed;
+
+    // executable blocks and constraints at the beginning of each block
+    vector<bool> executable;
+    vector<vsa_env> envs;
+
+    // values that were read by I_LDM, not readable memory is cached as well
+    map<pair<reil_addr_t, int>, pair<bool, reil_const_t> > loads;
+
+    bool converged;
+};
+
+#endif // REIL_VSA_H
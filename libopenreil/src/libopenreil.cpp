@@ -5,6 +5,8 @@
 #include <assert.h>
 #include <iostream>
 #include <string>
+#include <vector>
+#include <algorithm>
 
 using namespace std;
 
@@ -16,11 +18,6 @@ using namespace std;
 #include "libopenreil.h"
 #include "reil_translator.h"
 
-#define STR_ARG_EMPTY " "
-#define STR_VAR(_name_, _t_) "(" + (_name_) + ", " + to_string_size((_t_)) + ")"
-#define STR_CONST(_val_, _t_) "(" + to_string_constant((_val_), (_t_)) + ", " + to_string_size((_t_)) + ")"
-#define STR_LOC(_addr_, _inum_) to_string_constant((_addr_), U32) + "." + to_string_constant((_inum_), U8)
-
 // number of zero bytes reserved for VEX at beginning of the code buffer 
 #define VEX_BYTES 18
 
@@ -31,71 +28,14 @@ typedef struct _reil_context
 
 } reil_context;
 
-string to_string_constant(reil_const_t val, reil_size_t size)
+extern "C" void reil_inst_print(reil_inst_t *inst)
 {
-    stringstream s;
-    uint8_t u8 = 0;
-    uint16_t u16 = 0;
-    uint32_t u32 = 0;
-    uint64_t u64 = 0;
+    char buff[REIL_INST_STR_MAX_LEN];
 
-    switch (size)
+    if (reil_inst_to_str(inst, buff, sizeof(buff)) != REIL_ERROR)
     {
-    case U1: if (val == 0) s << "0"; else s << "1"; break;
-    case U8: u8 = (uint8_t)val; s << dec << (int)u8; break;
-    case U16: u16 = (uint16_t)val; s << u16; break;
-    case U32: u32 = (uint32_t)val; s << u32; break;
-    case U64: u64 = (uint64_t)val; s << u64; break;
-    default: assert(0);
+        printf("%s\n", buff);
     }
-    
-    return s.str();
-}
-
-string to_string_size(reil_size_t size)
-{
-    switch (size)
-    {
-    case U1: return string("1");
-    case U8: return string("8");
-    case U16: return string("16");
-    case U32: return string("32");
-    case U64: return string("64");
-    }
-
-    assert(0);
-}
-
-string to_string_operand(reil_arg_t *a)
-{
-    switch (a->type)
-    {
-    case A_NONE: return string(STR_ARG_EMPTY);
-    case A_REG: return STR_VAR(string(a->name), a->size);
-    case A_TEMP: return STR_VAR(string(a->name), a->size);
-    case A_CONST: return STR_CONST(a->val, a->size);
-    case A_LOC: return STR_LOC(a->val, a->inum);
-    }    
-
-    assert(0);
-}
-
-// defined in reil_translator.cpp
-extern const char *reil_inst_name[];
-
-string to_string_inst_code(reil_op_t inst_code)
-{
-    return string(reil_inst_name[inst_code]);
-}
-
-extern "C" void reil_inst_print(reil_inst_t *inst)
-{
-    printf("%.8llx.%.2x ", inst->raw_info.addr, inst->inum);  
-    printf("%7s ", to_string_inst_code(inst->op).c_str());
-    printf("%16s, ", to_string_operand(&inst->a).c_str());
-    printf("%16s, ", to_string_operand(&inst->b).c_str());
-    printf("%16s  ", to_string_operand(&inst->c).c_str());
-    printf("\n");
 }
 
 extern "C" reil_t reil_init(reil_arch_t arch, reil_inst_handler_t handler, void *context)
@@ -204,15 +144,18 @@ extern "C" int reil_translate_insn(reil_t reil, reil_addr_t addr, unsigned char
     catch (BapException e)
     {        
         // libasmir exception
+        c->translator->failed_inst();
         return reil_translate_report_error(addr, e.reason.c_str());
     }
     catch (CReilTranslatorException e)
     {
         // libopenreil exception
+        c->translator->failed_inst();
         return reil_translate_report_error(addr, e.reason.c_str());
     }
     catch (...)
     {
+        c->translator->failed_inst();
         return reil_translate_report_error(addr, NULL);
     }
 
@@ -241,3 +184,113 @@ extern "C" int reil_translate(reil_t reil, reil_addr_t addr, unsigned char *buff
 
     return translated;
 }
+
+extern "C" int reil_get_stats(reil_t reil, reil_stats_t *stats)
+{
+    reil_context *c = (reil_context *)reil;
+    assert(c);
+
+    if (stats == NULL)
+    {
+        return REIL_ERROR;
+    }
+
+    c->translator->get_stats(stats);
+
+    return 0;
+}
+
+extern "C" void reil_reset_stats(reil_t reil)
+{
+    reil_context *c = (reil_context *)reil;
+    assert(c);
+
+    c->translator->reset_stats();
+}
+
+extern "C" void reil_profile_enable(reil_t reil, int enable)
+{
+    reil_context *c = (reil_context *)reil;
+    assert(c);
+
+    c->translator->profile_enable(enable != 0);
+}
+
+extern "C" int reil_profile_get(reil_t reil, reil_profile_entry_t *entries, int count)
+{
+    reil_context *c = (reil_context *)reil;
+    assert(c);
+
+    return c->translator->profile_get(entries, count);
+}
+
+extern "C" int reil_profile_dump(reil_t reil, const char *path, reil_profile_format_t format)
+{
+    reil_context *c = (reil_context *)reil;
+    assert(c);
+
+    int count = c->translator->profile_get(NULL, 0);
+    vector<reil_profile_entry_t> entries(max(count, 1));
+
+    c->translator->profile_get(&entries[0], count);
+
+    FILE *fd = stdout;
+
+    if (path && (fd = fopen(path, "wb")) == NULL)
+    {
+        log_write(LOG_ERR, "Unable to create profile file \"%s\"", path);
+        return REIL_ERROR;
+    }
+
+    if (format == REIL_PROFILE_CSV)
+    {
+        fprintf(fd, "id,mnem,count,reil_emitted,temp_allocated,time\n");
+    }
+    else
+    {
+        fprintf(fd, "[");
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        reil_profile_entry_t *entry = &entries[i];
+
+        if (format == REIL_PROFILE_CSV)
+        {
+            fprintf(
+                fd, "%u,%s,%llu,%llu,%llu,%llu\n", 
+                entry->id, entry->mnem, entry->count, 
+                entry->reil_emitted, entry->temp_allocated, entry->time
+            );
+        }
+        else
+        {
+            fprintf(
+                fd, "%s\n  {\"id\": %u, \"mnem\": \"%s\", \"count\": %llu, "
+                "\"reil_emitted\": %llu, \"temp_allocated\": %llu, \"time\": %llu}", 
+                i == 0 ? "" : ",", entry->id, entry->mnem, entry->count, 
+                entry->reil_emitted, entry->temp_allocated, entry->time
+            );
+        }
+    }
+
+    if (format == REIL_PROFILE_JSON)
+    {
+        fprintf(fd, "\n]\n");
+    }
+
+    if (path)
+    {
+        fclose(fd);
+    }
+
+    return count;
+}
+
+extern "C" void reil_profile_reset(reil_t reil)
+{
+    reil_context *c = (reil_context *)reil;
+    assert(c);
+
+    c->translator->profile_reset();
+}
@@ -0,0 +1,1266 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <string>
+#include <deque>
+#include <vector>
+#include <map>
+#include <set>
+#include <algorithm>
+
+#ifndef _WIN32
+
+#include <pthread.h>
+
+#endif
+
+using namespace std;
+
+// OpenREIL includes
+#include "libopenreil.h"
+#include "reil_mem.h"
+#include "reil_vm.h"
+#include "reil_vm_ops.h"
+#include "reil_batch.h"
+
+#ifdef BATCH_SIMD_SUPPORTED
+
+#include <immintrin.h>
+
+#endif
+
+/*
+    Batch executor runs the same IR code over many independent states (lanes)
+    of the native interpreter at once. Register values are stored by columns,
+    so each arithmetic instruction is a simple loop over the range of lanes
+    that compiler can vectorize, common operations have explicit SSE2 and AVX2
+    kernels that are chosen at runtime. Lanes that are executing the same code
+    are kept together in the contiguous range, when they diverge at JCC range is
+    split by moving lanes around. Ranges that were split are merged back when
+    they reach the same location: groups of lanes are scheduled by the lowest
+    location first, so lanes that are waiting for others after the end of
+    if-else or loop are joined with them.
+
+    Instructions are loaded and decoded by the interpreter that owns the batch,
+    each lane has it's own copy-on-write clone of the interpreter memory. Worker
+    threads are reading missing memory contents through their own cache, so
+    the lock that protects the interpreter is taken by each worker only once
+    for the same data.
+
+    Batch that was created with multiple threads distributes it's lanes
+    between the worker batches that are running in parallel. Instructions
+    that were loaded by the interpreter are shared by all of the workers as
+    read-only code cache: interpreter doesn't replace them while workers are
+    running, workers are keeping links between instructions and decoded 
+    operands in their own state and only fetching of missing instructions
+    and memory contents from the interpreter is serialized.
+*/
+
+#ifndef _WIN32
+
+typedef struct _batch_job
+{
+    CReilBatch *batch;
+    VM_LOC loc;
+    int simd;
+
+    pthread_t thread;
+    bool started;
+
+} batch_job;
+
+static void *batch_thread(void *arg)
+{
+    batch_job *job = (batch_job *)arg;
+
+    job->batch->run(job->loc, job->simd);
+
+    return NULL;
+}
+
+#endif
+
+// reads missing memory contents of the lane from the interpreter memory
+static int batch_mem_fault(reil_mem_t mem, reil_addr_t addr, int size, void *context)
+{
+    vector<uint8_t> buff(size);
+
+    if (!((CReilBatch *)context)->mem_read(addr, &buff[0], size))
+    {
+        return REIL_ERROR;
+    }
+
+    return ((CReilMem *)mem)->alloc(addr, &buff[0], size, size) ? 0 : REIL_ERROR;
+}
+
+// reads missing contents of the worker cache from the interpreter memory
+static int batch_cache_fault(reil_mem_t mem, reil_addr_t addr, int size, void *context)
+{
+    vector<uint8_t> buff(size);
+
+    if (!((CReilBatch *)context)->mem_read_shared(addr, &buff[0], size))
+    {
+        return REIL_ERROR;
+    }
+
+    return ((CReilMem *)mem)->alloc(addr, &buff[0], size, size) ? 0 : REIL_ERROR;
+}
+
+//======================================================================
+// Kernels
+//======================================================================
+
+template <class OP>
+static void batch_binop(batch_insn *insn, int lo, int hi)
+{
+    reil_const_t *a = insn->a, *b = insn->b, *c = insn->c;
+    reil_const_t mask_a = insn->insn->mask_a, mask_b = insn->insn->mask_b, mask_c = insn->insn->mask_c;
+
+    for (int i = lo; i < hi; i++)
+    {
+        c[i] = OP::eval(a[i] & mask_a, b[i] & mask_b) & mask_c;
+    }
+}
+
+template <class OP>
+static void batch_sbinop(batch_insn *insn, int lo, int hi)
+{
+    reil_const_t *a = insn->a, *b = insn->b, *c = insn->c;
+    reil_const_t mask_c = insn->insn->mask_c;
+    int sext_a = insn->insn->sext_a, sext_b = insn->insn->sext_b, sext_r = insn->insn->sext_r;
+
+    for (int i = lo; i < hi; i++)
+    {
+        int64_t ret = OP::eval(vm_sext(a[i], sext_a), vm_sext(b[i], sext_b));
+
+        c[i] = (reil_const_t)vm_sext((reil_const_t)ret, sext_r) & mask_c;
+    }
+}
+
+#ifdef BATCH_SIMD_SUPPORTED
+
+#define BATCH_SSE2 __attribute__((target("sse2")))
+#define BATCH_AVX2 __attribute__((target("avx2")))
+
+/*
+    SIMD versions of the operations, values are always 64-bit wide. Shifts
+    by 64 or more bits are giving zero as vm_op_shl and vm_op_shr do,
+    comparisons are giving 0 or 1.
+*/
+struct batch_op_add : vm_op_add
+{
+    BATCH_SSE2 static inline __m128i sse2(__m128i a, __m128i b) { return _mm_add_epi64(a, b); }
+    BATCH_AVX2 static inline __m256i avx2(__m256i a, __m256i b) { return _mm256_add_epi64(a, b); }
+};
+
+struct batch_op_sub : vm_op_sub
+{
+    BATCH_SSE2 static inline __m128i sse2(__m128i a, __m128i b) { return _mm_sub_epi64(a, b); }
+    BATCH_AVX2 static inline __m256i avx2(__m256i a, __m256i b) { return _mm256_sub_epi64(a, b); }
+};
+
+struct batch_op_and : vm_op_and
+{
+    BATCH_SSE2 static inline __m128i sse2(__m128i a, __m128i b) { return _mm_and_si128(a, b); }
+    BATCH_AVX2 static inline __m256i avx2(__m256i a, __m256i b) { return _mm256_and_si256(a, b); }
+};
+
+struct batch_op_or : vm_op_or
+{
+    BATCH_SSE2 static inline __m128i sse2(__m128i a, __m128i b) { return _mm_or_si128(a, b); }
+    BATCH_AVX2 static inline __m256i avx2(__m256i a, __m256i b) { return _mm256_or_si256(a, b); }
+};
+
+struct batch_op_xor : vm_op_xor
+{
+    BATCH_SSE2 static inline __m128i sse2(__m128i a, __m128i b) { return _mm_xor_si128(a, b); }
+    BATCH_AVX2 static inline __m256i avx2(__m256i a, __m256i b) { return _mm256_xor_si256(a, b); }
+};
+
+struct batch_op_shl : vm_op_shl
+{
+    BATCH_SSE2 static inline __m128i sse2(__m128i a, __m128i b) 
+    {
+        // SSE2 shifts both values by the same count
+        __m128i lo = _mm_sll_epi64(a, b), hi = _mm_sll_epi64(a, _mm_unpackhi_epi64(b, b));
+
+        return _mm_unpacklo_epi64(lo, _mm_unpackhi_epi64(hi, hi));
+    }
+
+    BATCH_AVX2 static inline __m256i avx2(__m256i a, __m256i b) { return _mm256_sllv_epi64(a, b); }
+};
+
+struct batch_op_shr : vm_op_shr
+{
+    BATCH_SSE2 static inline __m128i sse2(__m128i a, __m128i b) 
+    {
+        __m128i lo = _mm_srl_epi64(a, b), hi = _mm_srl_epi64(a, _mm_unpackhi_epi64(b, b));
+
+        return _mm_unpacklo_epi64(lo, _mm_unpackhi_epi64(hi, hi));
+    }
+
+    BATCH_AVX2 static inline __m256i avx2(__m256i a, __m256i b) { return _mm256_srlv_epi64(a, b); }
+};
+
+struct batch_op_eq : vm_op_eq
+{
+    BATCH_SSE2 static inline __m128i sse2(__m128i a, __m128i b) 
+    {
+        // both halves of 64-bit value must be equal
+        __m128i eq = _mm_cmpeq_epi32(a, b);
+
+        eq = _mm_and_si128(eq, _mm_shuffle_epi32(eq, _MM_SHUFFLE(2, 3, 0, 1)));
+
+        return _mm_srli_epi64(eq, 63);
+    }
+
+    BATCH_AVX2 static inline __m256i avx2(__m256i a, __m256i b) 
+    {
+        return _mm256_srli_epi64(_mm256_cmpeq_epi64(a, b), 63);
+    }
+};
+
+struct batch_op_lt : vm_op_lt
+{
+    BATCH_SSE2 static inline __m128i sse2(__m128i a, __m128i b) 
+    {
+        // borrow of a - b: (~a & b) | (~(a ^ b) & (a - b))
+        __m128i eq = _mm_andnot_si128(_mm_xor_si128(a, b), _mm_sub_epi64(a, b));
+
+        return _mm_srli_epi64(_mm_or_si128(_mm_andnot_si128(a, b), eq), 63);
+    }
+
+    BATCH_AVX2 static inline __m256i avx2(__m256i a, __m256i b) 
+    {
+        // unsigned comparison with signed instruction
+        __m256i sign = _mm256_set1_epi64x((long long)0x8000000000000000ULL);
+
+        return _mm256_srli_epi64(_mm256_cmpgt_epi64(_mm256_xor_si256(b, sign), 
+                                                    _mm256_xor_si256(a, sign)), 63);
+    }
+};
+
+struct batch_op_str : vm_op_str
+{
+    BATCH_SSE2 static inline __m128i sse2(__m128i a, __m128i) { return a; }
+    BATCH_AVX2 static inline __m256i avx2(__m256i a, __m256i) { return a; }
+};
+
+struct batch_op_not : vm_op_not
+{
+    BATCH_SSE2 static inline __m128i sse2(__m128i a, __m128i) 
+    { 
+        return _mm_xor_si128(a, _mm_set1_epi32(-1)); 
+    }
+
+    BATCH_AVX2 static inline __m256i avx2(__m256i a, __m256i) 
+    { 
+        return _mm256_xor_si256(a, _mm256_set1_epi32(-1)); 
+    }
+};
+
+struct batch_op_neg : vm_op_neg
+{
+    BATCH_SSE2 static inline __m128i sse2(__m128i a, __m128i) { return _mm_sub_epi64(_mm_setzero_si128(), a); }
+    BATCH_AVX2 static inline __m256i avx2(__m256i a, __m256i) { return _mm256_sub_epi64(_mm256_setzero_si256(), a); }
+};
+
+struct batch_op_mul : vm_op_mul
+{
+    BATCH_SSE2 static inline __m128i sse2(__m128i a, __m128i b) 
+    {
+        // there's no 64-bit multiplication, sum of 32-bit partial products
+        __m128i lo = _mm_mul_epu32(a, b);
+        __m128i hi = _mm_add_epi64(_mm_mul_epu32(_mm_srli_epi64(a, 32), b), 
+                                   _mm_mul_epu32(a, _mm_srli_epi64(b, 32)));
+
+        return _mm_add_epi64(lo, _mm_slli_epi64(hi, 32));
+    }
+
+    BATCH_AVX2 static inline __m256i avx2(__m256i a, __m256i b) 
+    {
+        __m256i lo = _mm256_mul_epu32(a, b);
+        __m256i hi = _mm256_add_epi64(_mm256_mul_epu32(_mm256_srli_epi64(a, 32), b), 
+                                      _mm256_mul_epu32(a, _mm256_srli_epi64(b, 32)));
+
+        return _mm256_add_epi64(lo, _mm256_slli_epi64(hi, 32));
+    }
+};
+
+// multiplication of operands that are not wider than 32 bits
+struct batch_op_mul32 : vm_op_mul
+{
+    BATCH_SSE2 static inline __m128i sse2(__m128i a, __m128i b) { return _mm_mul_epu32(a, b); }
+    BATCH_AVX2 static inline __m256i avx2(__m256i a, __m256i b) { return _mm256_mul_epu32(a, b); }
+};
+
+template <class OP>
+BATCH_SSE2 static void batch_binop_sse2(batch_insn *insn, int lo, int hi)
+{
+    reil_const_t *a = insn->a, *b = insn->b, *c = insn->c;
+    reil_const_t mask_a = insn->insn->mask_a, mask_b = insn->insn->mask_b, mask_c = insn->insn->mask_c;
+
+    __m128i va_mask = _mm_set1_epi64x((long long)mask_a);
+    __m128i vb_mask = _mm_set1_epi64x((long long)mask_b);
+    __m128i vc_mask = _mm_set1_epi64x((long long)mask_c);
+
+    int i = lo;
+
+    for (; i + 2 <= hi; i += 2)
+    {
+        __m128i va = _mm_and_si128(_mm_loadu_si128((__m128i *)(a + i)), va_mask);
+        __m128i vb = _mm_and_si128(_mm_loadu_si128((__m128i *)(b + i)), vb_mask);
+
+        _mm_storeu_si128((__m128i *)(c + i), _mm_and_si128(OP::sse2(va, vb), vc_mask));
+    }
+
+    for (; i < hi; i++)
+    {
+        c[i] = OP::eval(a[i] & mask_a, b[i] & mask_b) & mask_c;
+    }
+}
+
+template <class OP>
+BATCH_AVX2 static void batch_binop_avx2(batch_insn *insn, int lo, int hi)
+{
+    reil_const_t *a = insn->a, *b = insn->b, *c = insn->c;
+    reil_const_t mask_a = insn->insn->mask_a, mask_b = insn->insn->mask_b, mask_c = insn->insn->mask_c;
+
+    __m256i va_mask = _mm256_set1_epi64x((long long)mask_a);
+    __m256i vb_mask = _mm256_set1_epi64x((long long)mask_b);
+    __m256i vc_mask = _mm256_set1_epi64x((long long)mask_c);
+
+    int i = lo;
+
+    for (; i + 4 <= hi; i += 4)
+    {
+        __m256i va = _mm256_and_si256(_mm256_loadu_si256((__m256i *)(a + i)), va_mask);
+        __m256i vb = _mm256_and_si256(_mm256_loadu_si256((__m256i *)(b + i)), vb_mask);
+
+        _mm256_storeu_si256((__m256i *)(c + i), _mm256_and_si256(OP::avx2(va, vb), vc_mask));
+    }
+
+    for (; i < hi; i++)
+    {
+        c[i] = OP::eval(a[i] & mask_a, b[i] & mask_b) & mask_c;
+    }
+}
+
+static int batch_simd_host(void)
+{
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx2")) return REIL_VM_BATCH_SIMD_AVX2;
+    if (__builtin_cpu_supports("sse2")) return REIL_VM_BATCH_SIMD_SSE2;
+
+    return REIL_VM_BATCH_SIMD_NONE;
+}
+
+#define BATCH_SIMD_SELECT(_simd_, _name_)                                       \
+                                                                                \
+    if (simd == REIL_VM_BATCH_SIMD_AVX2) return batch_binop_avx2<_simd_>;      \
+    if (simd == REIL_VM_BATCH_SIMD_SSE2) return batch_binop_sse2<_simd_>;      \
+                                                                                \
+    return batch_binop<_name_>;
+
+#else
+
+static int batch_simd_host(void)
+{
+    return REIL_VM_BATCH_SIMD_NONE;
+}
+
+#define BATCH_SIMD_SELECT(_simd_, _name_) return batch_binop<_name_>;
+
+#endif // BATCH_SIMD_SUPPORTED
+
+#define BATCH_SIMD_KERNEL(_op_, _simd_, _name_) case _op_: BATCH_SIMD_SELECT(_simd_, _name_)
+
+/*
+    SIMD level of kernels for the next runs, it's detected once when library 
+    is loaded and reil_vm_batch_simd() is the only function that changes it.
+*/
+static int batch_simd_level = batch_simd_host();
+
+static int batch_simd(int level)
+{
+    int host = batch_simd_host();
+
+    batch_simd_level = level < 0 ? host : min(level, host);
+
+    return batch_simd_level;
+}
+
+static batch_kernel_t batch_kernel(vm_insn *insn, int simd)
+{
+    switch (insn->op)
+    {
+    BATCH_SIMD_KERNEL(I_ADD, batch_op_add, vm_op_add)
+    BATCH_SIMD_KERNEL(I_SUB, batch_op_sub, vm_op_sub)
+    BATCH_SIMD_KERNEL(I_SHL, batch_op_shl, vm_op_shl)
+    BATCH_SIMD_KERNEL(I_SHR, batch_op_shr, vm_op_shr)
+    BATCH_SIMD_KERNEL(I_AND, batch_op_and, vm_op_and)
+    BATCH_SIMD_KERNEL(I_OR,  batch_op_or,  vm_op_or)
+    BATCH_SIMD_KERNEL(I_XOR, batch_op_xor, vm_op_xor)
+    BATCH_SIMD_KERNEL(I_EQ,  batch_op_eq,  vm_op_eq)
+    BATCH_SIMD_KERNEL(I_LT,  batch_op_lt,  vm_op_lt)
+    BATCH_SIMD_KERNEL(I_STR, batch_op_str, vm_op_str)
+    BATCH_SIMD_KERNEL(I_NEG, batch_op_neg, vm_op_neg)
+    BATCH_SIMD_KERNEL(I_NOT, batch_op_not, vm_op_not)
+
+    case I_MUL:
+
+        if ((insn->mask_a | insn->mask_b) <= 0xffffffff)
+        {
+            // product of masked operands fits into 64 bits
+            BATCH_SIMD_SELECT(batch_op_mul32, vm_op_mul)
+        }
+
+        BATCH_SIMD_SELECT(batch_op_mul, vm_op_mul)
+
+    // there's no SIMD integer division on x86
+    case I_DIV: return batch_binop<vm_op_div>;
+    case I_MOD: return batch_binop<vm_op_mod>;
+
+    case I_SMUL: return batch_sbinop<vm_op_smul>;
+    case I_SDIV: return batch_sbinop<vm_op_sdiv>;
+    case I_SMOD: return batch_sbinop<vm_op_smod>;
+
+    default: break;
+    }
+
+    (void)simd;
+
+    return NULL;
+}
+
+//======================================================================
+// Batch executor
+//======================================================================
+
+CReilBatchLock::CReilBatchLock()
+{
+#ifndef _WIN32
+
+    pthread_mutex_init(&mutex, NULL);
+
+#endif
+}
+
+CReilBatchLock::~CReilBatchLock()
+{
+#ifndef _WIN32
+
+    pthread_mutex_destroy(&mutex);
+
+#endif
+}
+
+void CReilBatchLock::acquire(void)
+{
+#ifndef _WIN32
+
+    pthread_mutex_lock(&mutex);
+
+#endif
+}
+
+void CReilBatchLock::release(void)
+{
+#ifndef _WIN32
+
+    pthread_mutex_unlock(&mutex);
+
+#endif
+}
+
+CReilBatch::CReilBatch(CReilVM *vm, int count, int threads, CReilBatchLock *lock)
+{
+    if (vm->state.mem == NULL)
+    {
+        throw CReilVMException("Native memory is required");
+    }
+
+    if (count <= 0)
+    {
+        throw CReilVMException("Invalid number of lanes");
+    }
+
+    if (threads <= 0)
+    {
+        throw CReilVMException("Invalid number of threads");
+    }
+
+    this->vm = vm;
+    this->mem = vm->state.mem;
+    this->count = count;
+    this->lock = lock;
+    this->cache = NULL;
+    this->simd = REIL_VM_BATCH_SIMD_NONE;
+
+    if (threads > 1 && count > 1)
+    {
+        threads = min(threads, count);
+
+        // the same lock is shared by all of the workers
+        this->lock = new CReilBatchLock();
+
+        for (int i = 0, start = 0; i < threads; i++)
+        {
+            // distribute lanes between the workers evenly
+            int size = count / threads + (i < count % threads ? 1 : 0);
+
+            workers_start.push_back(start);
+            workers.push_back(new CReilBatch(vm, size, 1, this->lock));
+
+            start += size;
+        }
+
+        ip = NULL;
+        ip_mask = 0;
+
+        return;
+    }
+
+    // lanes are starting from the current state of the interpreter
+    for (deque<vm_reg>::iterator it = vm->regs.begin(); it != vm->regs.end(); ++it)
+    {
+        column(&it->val);
+    }
+
+    ip = column(&vm->reg_ip->val);
+    ip_mask = vm_mask(vm->reg_ip->size);
+
+    if (lock)
+    {
+        // lanes of the worker are reading missing memory contents through it's own cache
+        cache = new CReilMem(mem->get_strict(), mem->get_lowest_addr(), batch_cache_fault, this);
+    }
+
+    CReilMemSnapshot *snap = mem->snapshot();
+
+    lanes.resize(count);
+    pos.resize(count);
+    flags.resize(count);
+
+    for (int i = 0; i < count; i++)
+    {
+        batch_lane *lane = &lanes[i];
+
+        // memory pages are shared with the interpreter memory until they're modified
+        lane->mem = new CReilMem(mem->get_strict(), mem->get_lowest_addr(), batch_mem_fault, this);
+        lane->mem->restore(snap);
+
+        lane->id = pos[i] = i;
+        lane->status = REIL_VM_ERR_FETCH;
+        lane->loc = VM_LOC(0, 0);
+        lane->executed = 0;
+    }
+
+    snap->release();
+}
+
+CReilBatch::~CReilBatch()
+{
+    for (vector<batch_lane>::iterator it = lanes.begin(); it != lanes.end(); ++it)
+    {
+        delete it->mem;
+    }
+
+    for (vector<CReilBatch *>::iterator it = workers.begin(); it != workers.end(); ++it)
+    {
+        delete *it;
+    }
+
+    if (!workers.empty())
+    {
+        delete lock;
+    }
+
+    if (cache)
+    {
+        delete cache;
+    }
+}
+
+CReilBatch *CReilBatch::worker(int *lane)
+{
+    if (workers.empty())
+    {
+        return this;
+    }
+
+    // find the worker that owns the lane and convert lane number
+    int num = upper_bound(workers_start.begin(), workers_start.end(), *lane) - workers_start.begin() - 1;
+
+    *lane -= workers_start[num];
+
+    return workers[num];
+}
+
+CReilMem *CReilBatch::get_mem(int lane)
+{
+    CReilBatch *batch = worker(&lane);
+
+    return batch != this ? batch->get_mem(lane) : lanes[pos[lane]].mem;
+}
+
+bool CReilBatch::mem_read(reil_addr_t addr, uint8_t *buff, int size)
+{
+    if (cache)
+    {
+        // lock is taken only when none of the worker lanes has read this data yet
+        return cache->read(addr, buff, size);
+    }
+
+    return mem->read(addr, buff, size);
+}
+
+bool CReilBatch::mem_read_shared(reil_addr_t addr, uint8_t *buff, int size)
+{
+    // interpreter memory might call it's fault callback
+    lock->acquire();
+
+    bool ret = mem->read(addr, buff, size);
+
+    lock->release();
+
+    return ret;
+}
+
+vm_insn *CReilBatch::fetch(VM_LOC loc)
+{
+    if (lock == NULL)
+    {
+        return vm->fetch_insn(loc);
+    }
+
+    map<VM_LOC, vm_insn *>::iterator it = code.find(loc);
+    if (it != code.end())
+    {
+        return it->second;
+    }
+
+    lock->acquire();
+
+    // interpreter loads missing instruction with it's fetch callback
+    vm_insn *insn = vm->fetch_insn(loc);
+
+    lock->release();
+
+    if (insn)
+    {
+        code[loc] = insn;
+    }
+
+    return insn;
+}
+
+reil_const_t *CReilBatch::column(reil_const_t *val)
+{
+    map<reil_const_t *, reil_const_t *>::iterator it = cols_map.find(val);
+    if (it != cols_map.end())
+    {
+        return it->second;
+    }
+
+    // register that was created after the batch gets it's current value
+    cols.push_back(vector<reil_const_t>(count, *val));
+
+    return cols_map[val] = &cols.back()[0];
+}
+
+reil_const_t *CReilBatch::constant(reil_const_t val)
+{
+    map<reil_const_t, reil_const_t *>::iterator it = consts_map.find(val);
+    if (it != consts_map.end())
+    {
+        return it->second;
+    }
+
+    consts.push_back(vector<reil_const_t>(count, val));
+
+    return consts_map[val] = &consts.back()[0];
+}
+
+batch_insn *CReilBatch::decode(vm_insn *insn)
+{
+    map<vm_insn *, batch_insn>::iterator it = insns.find(insn);
+    if (it != insns.end())
+    {
+        return &it->second;
+    }
+
+    batch_insn *ret = &insns[insn];
+
+    ret->insn = insn;
+    ret->kernel = batch_kernel(insn, simd);
+
+    // start from the links that were made by interpreter
+    ret->next = insn->next;
+    ret->jump = insn->jump;
+
+    ret->a = insn->a == &insn->imm_a ? constant(insn->imm_a) : column(insn->a);
+    ret->b = insn->b == &insn->imm_b ? constant(insn->imm_b) : column(insn->b);
+
+    if (insn->c == &insn->imm_c)
+    {
+        if (ret->kernel)
+        {
+            // invalid instruction, let the executor to report an error
+            ret->kernel = NULL;
+        }
+
+        if (insn->op == I_LDM)
+        {
+            // interpreter writes loaded value into the immediate operand
+            consts.push_back(vector<reil_const_t>(count, 0));
+            ret->c = &consts.back()[0];
+        }
+        else
+        {
+            ret->c = constant(insn->imm_c);
+        }
+    }
+    else
+    {
+        ret->c = column(insn->c);
+    }
+
+    return ret;
+}
+
+void CReilBatch::swap(int i, int j)
+{
+    for (deque<vector<reil_const_t> >::iterator it = cols.begin(); it != cols.end(); ++it)
+    {
+        std::swap((*it)[i], (*it)[j]);
+    }
+
+    std::swap(lanes[i], lanes[j]);
+    std::swap(flags[i], flags[j]);
+
+    pos[lanes[i].id] = i;
+    pos[lanes[j].id] = j;
+}
+
+int CReilBatch::partition(int lo, int hi)
+{
+    // move lanes with non-zero flag to the end of the range
+    while (true)
+    {
+        while (lo < hi && flags[lo] == 0) lo += 1;
+        while (lo < hi && flags[hi - 1] != 0) hi -= 1;
+
+        if (lo >= hi)
+        {
+            break;
+        }
+
+        swap(lo, hi - 1);
+    }
+
+    return lo;
+}
+
+void CReilBatch::fill_ip(int lo, int hi, reil_addr_t addr)
+{
+    fill(ip + lo, ip + hi, addr & ip_mask);
+}
+
+void CReilBatch::account(int lo, int hi, unsigned long long executed)
+{
+    for (int i = lo; i < hi; i++)
+    {
+        lanes[i].executed += executed;
+    }
+}
+
+void CReilBatch::finish(int lo, int hi, reil_vm_status_t status, VM_LOC loc, unsigned long long executed)
+{
+    account(lo, hi, executed);
+
+    for (int i = lo; i < hi; i++)
+    {
+        lanes[i].status = status;
+        lanes[i].loc = loc;
+    }
+}
+
+bool CReilBatch::pick(batch_group *group)
+{
+    if (pending.empty())
+    {
+        return false;
+    }
+
+    int num = 0;
+
+    for (size_t i = 1; i < pending.size(); i++)
+    {
+        if (pending[i].loc < pending[num].loc)
+        {
+            num = i;
+        }
+    }
+
+    *group = pending[num];
+    pending.erase(pending.begin() + num);
+
+    // join adjacent ranges that are waiting at the same location
+    for (size_t i = 0; i < pending.size(); )
+    {
+        batch_group *other = &pending[i];
+
+        if (other->loc == group->loc && (other->hi == group->lo || other->lo == group->hi))
+        {
+            group->lo = min(group->lo, other->lo);
+            group->hi = max(group->hi, other->hi);
+
+            pending.erase(pending.begin() + i);
+            i = 0;
+        }
+        else
+        {
+            i += 1;
+        }
+    }
+
+    return true;
+}
+
+void CReilBatch::suspend(VM_LOC loc, int lo, int hi)
+{
+    batch_group group;
+
+    group.loc = loc;
+    group.lo = lo;
+    group.hi = hi;
+
+    pending.push_back(group);
+}
+
+void CReilBatch::run_group(batch_group group)
+{
+    int lo = group.lo, hi = group.hi;
+    unsigned long long executed = 0;
+    vm_insn *insn = NULL;
+
+    // IP register is updated before fetching of each instruction
+    fill_ip(lo, hi, group.loc.first);
+
+    if ((insn = fetch(group.loc)) == NULL)
+    {
+        finish(lo, hi, REIL_VM_ERR_FETCH, group.loc, 0);
+        return;
+    }
+
+    reil_addr_t addr = insn->addr;
+
+    while (true)
+    {
+        VM_LOC loc(insn->addr, insn->inum);
+
+        if (insn->addr != addr)
+        {
+            fill_ip(lo, hi, insn->addr);
+            addr = insn->addr;
+        }
+
+        if (insn->stop)
+        {
+            finish(lo, hi, REIL_VM_STOP, loc, executed);
+            return;
+        }
+
+        batch_insn *binsn = decode(insn);
+        vm_insn *next = NULL;
+
+        executed += 1;
+
+        if (binsn->kernel)
+        {
+            binsn->kernel(binsn, lo, hi);
+        }
+        else if (insn->op == I_LDM || insn->op == I_STM)
+        {
+            reil_const_t *a = binsn->a, *c = binsn->c;
+
+            for (int i = lo; i < hi; )
+            {
+                CReilMem *mem = lanes[i].mem;
+                bool ok = false;
+
+                if (insn->op == I_LDM)
+                {
+                    reil_const_t val = 0;
+
+                    if ((ok = mem->load(a[i] & insn->mask_a, insn->mem_len, &val)))
+                    {
+                        c[i] = val & insn->mask_c;
+                    }
+                }
+                else
+                {
+                    ok = mem->store(c[i] & insn->mask_c, insn->mem_len, a[i] & insn->mask_a);
+                }
+
+                if (ok)
+                {
+                    i += 1;
+                    continue;
+                }
+
+                // remove failed lane from the group
+                finish(i, i + 1, REIL_VM_ERR_MEM, loc, executed);
+                swap(i, hi - 1);
+                hi -= 1;
+            }
+
+            if (lo == hi)
+            {
+                return;
+            }
+        }
+        else if (insn->op == I_JCC)
+        {
+            reil_const_t *a = binsn->a, *c = binsn->c;
+            // jump_loc is set for constant targets, see CReilVM::load()
+            bool is_loc = insn->c == &insn->imm_c;
+
+            for (int i = lo; i < hi; i++)
+            {
+                flags[i] = (a[i] & insn->mask_a) != 0;
+            }
+
+            int taken = partition(lo, hi);
+
+            if (taken == lo && !is_loc)
+            {
+                reil_const_t target = c[lo] & insn->mask_c;
+
+                for (int i = lo; i < hi && taken == lo; i++)
+                {
+                    // check if all of the lanes are jumping to the same address
+                    if ((c[i] & insn->mask_c) != target) taken = i;
+                }
+
+                if (taken == lo)
+                {
+                    VM_LOC target_loc(target, 0);
+
+                    if (binsn->jump && binsn->jump->addr == target && binsn->jump->inum == 0)
+                    {
+                        next = binsn->jump;
+                    }
+                    else if ((next = fetch(target_loc)) == NULL)
+                    {
+                        fill_ip(lo, hi, target);
+                        finish(lo, hi, REIL_VM_ERR_FETCH, target_loc, executed);
+                        return;
+                    }
+
+                    binsn->jump = next;
+                }
+
+                // lanes are split by jump target below
+                taken = lo;
+            }
+            else if (taken == lo)
+            {
+                if ((next = binsn->jump) == NULL)
+                {
+                    if ((next = fetch(insn->jump_loc)) == NULL)
+                    {
+                        fill_ip(lo, hi, insn->jump_loc.first);
+                        finish(lo, hi, REIL_VM_ERR_FETCH, insn->jump_loc, executed);
+                        return;
+                    }
+
+                    binsn->jump = next;
+                }
+            }
+
+            if (next == NULL && taken < hi)
+            {
+                // lanes are going to be split, so counter is not shared anymore
+                account(lo, hi, executed);
+                executed = 0;
+
+                for (int start = taken; start < hi; )
+                {
+                    VM_LOC target_loc = insn->jump_loc;
+                    int end = hi;
+
+                    if (!is_loc)
+                    {
+                        reil_const_t target = c[start] & insn->mask_c;
+
+                        for (int i = start; i < hi; i++)
+                        {
+                            flags[i] = (c[i] & insn->mask_c) != target;
+                        }
+
+                        // group lanes by jump target
+                        end = partition(start, hi);
+                        target_loc = VM_LOC(target, 0);
+                    }
+
+                    suspend(target_loc, start, end);
+                    start = end;
+                }
+
+                if (lo == taken)
+                {
+                    // all of the lanes have jumped
+                    return;
+                }
+
+                hi = taken;
+            }
+        }
+        else if (insn->op != I_NONE)
+        {
+            finish(lo, hi, REIL_VM_ERR_INSN, loc, executed);
+            return;
+        }
+
+        if (next == NULL && (next = binsn->next) == NULL)
+        {
+            if ((next = fetch(insn->next_loc)) == NULL)
+            {
+                fill_ip(lo, hi, insn->next_loc.first);
+                finish(lo, hi, REIL_VM_ERR_FETCH, insn->next_loc, executed);
+                return;
+            }
+
+            // link it with the current one as interpreter does
+            binsn->next = next;
+        }
+
+        if (insn->op == I_JCC && !pending.empty())
+        {
+            VM_LOC next_loc(next->addr, next->inum);
+
+            for (vector<batch_group>::iterator it = pending.begin(); it != pending.end(); ++it)
+            {
+                if (it->loc <= next_loc)
+                {
+                    // let the other lanes to catch up
+                    account(lo, hi, executed);
+                    suspend(next_loc, lo, hi);
+                    return;
+                }
+            }
+        }
+
+        insn = next;
+    }
+}
+
+void CReilBatch::run(VM_LOC loc, int simd)
+{
+    batch_group group;
+
+    if (simd < 0)
+    {
+        // all of the workers are using the same kernels during the run
+        simd = batch_simd_level;
+    }
+
+    if (!workers.empty())
+    {
+#ifndef _WIN32
+
+        vector<batch_job> jobs(workers.size());
+
+        // workers are reading loaded instructions without the lock
+        vm->shared = true;
+
+        for (size_t i = 1; i < workers.size(); i++)
+        {
+            jobs[i].batch = workers[i];
+            jobs[i].loc = loc;
+            jobs[i].simd = simd;
+            jobs[i].started = pthread_create(&jobs[i].thread, NULL, batch_thread, &jobs[i]) == 0;
+        }
+
+        // the first worker is executed by the current thread
+        workers[0]->run(loc, simd);
+
+        for (size_t i = 1; i < workers.size(); i++)
+        {
+            if (jobs[i].started)
+            {
+                pthread_join(jobs[i].thread, NULL);
+            }
+            else
+            {
+                // thread wasn't created, execute the worker here
+                workers[i]->run(loc, simd);
+            }
+        }
+
+        vm->shared = false;
+#else
+        for (size_t i = 0; i < workers.size(); i++)
+        {
+            workers[i]->run(loc, simd);
+        }
+#endif
+        return;
+    }
+
+    // loaded instructions and interpreter memory might be changed since the last run
+    insns.clear();
+
+    this->simd = simd;
+    pending.clear();
+
+    if (cache)
+    {
+        cache->clear();
+    }
+
+    for (vector<batch_lane>::iterator it = lanes.begin(); it != lanes.end(); ++it)
+    {
+        it->executed = 0;
+    }
+
+    suspend(loc, 0, count);
+
+    while (pick(&group))
+    {
+        run_group(group);
+    }
+}
+
+bool CReilBatch::reg_get(int lane, string name, reil_size_t *size, reil_const_t *val)
+{
+    CReilBatch *batch = worker(&lane);
+
+    if (batch != this)
+    {
+        return batch->reg_get(lane, name, size, val);
+    }
+
+    vm_reg *reg = vm->reg_find(name);
+
+    if (reg == NULL)
+    {
+        return false;
+    }
+
+    if (size) *size = reg->size;
+    if (val) *val = column(&reg->val)[pos[lane]] & vm_mask(reg->size);
+
+    return true;
+}
+
+void CReilBatch::reg_set(int lane, string name, reil_size_t size, reil_const_t val)
+{
+    CReilBatch *batch = worker(&lane);
+
+    if (batch != this)
+    {
+        batch->reg_set(lane, name, size, val);
+        return;
+    }
+
+    vm_reg *reg = vm->reg_find(name);
+
+    if (reg == NULL)
+    {
+        // the same register is used by interpreter when code gets loaded
+        reg = vm->reg_create(name, size, false);
+    }
+
+    column(&reg->val)[pos[lane]] = val & vm_mask(reg->size);
+}
+
+reil_vm_status_t CReilBatch::get_state(int lane, reil_vm_state_t *state)
+{
+    CReilBatch *batch = worker(&lane);
+
+    if (batch != this)
+    {
+        return batch->get_state(lane, state);
+    }
+
+    batch_lane *info = &lanes[pos[lane]];
+
+    state->addr = info->loc.first;
+    state->inum = info->loc.second;
+    state->executed = info->executed;
+
+    return info->status;
+}
+
+//======================================================================
+// C API
+//======================================================================
+
+extern "C" reil_vm_batch_t reil_vm_batch_init(reil_vm_t vm, int lanes)
+{
+    return reil_vm_batch_init_mt(vm, lanes, 1);
+}
+
+extern "C" reil_vm_batch_t reil_vm_batch_init_mt(reil_vm_t vm, int lanes, int threads)
+{
+    try
+    {
+        return (reil_vm_batch_t)new CReilBatch((CReilVM *)vm, lanes, threads);
+    }
+    catch (CReilVMException e)
+    {
+        fprintf(stderr, "reil_vm_batch_init_mt() ERROR: %s\n", e.reason.c_str());
+    }
+
+    return NULL;
+}
+
+extern "C" void reil_vm_batch_close(reil_vm_batch_t batch)
+{
+    delete (CReilBatch *)batch;
+}
+
+extern "C" int reil_vm_batch_simd(int level)
+{
+    return batch_simd(level);
+}
+
+extern "C" int reil_vm_batch_reg_get(reil_vm_batch_t batch, int lane, const char *name, reil_size_t *size, reil_const_t *val)
+{
+    return ((CReilBatch *)batch)->reg_get(lane, name, size, val) ? 0 : REIL_ERROR;
+}
+
+extern "C" int reil_vm_batch_reg_set(reil_vm_batch_t batch, int lane, const char *name, reil_size_t size, reil_const_t val)
+{
+    try
+    {
+        ((CReilBatch *)batch)->reg_set(lane, name, size, val);
+        return 0;
+    }
+    catch (CReilVMException e)
+    {
+        fprintf(stderr, "reil_vm_batch_reg_set() ERROR: %s\n", e.reason.c_str());
+    }
+
+    return REIL_ERROR;
+}
+
+extern "C" reil_mem_t reil_vm_batch_mem(reil_vm_batch_t batch, int lane)
+{
+    return (reil_mem_t)((CReilBatch *)batch)->get_mem(lane);
+}
+
+extern "C" void reil_vm_batch_run(reil_vm_batch_t batch, reil_addr_t addr, reil_inum_t inum)
+{
+    ((CReilBatch *)batch)->run(VM_LOC(addr, inum));
+}
+
+extern "C" int reil_vm_batch_get_state(reil_vm_batch_t batch, int lane, reil_vm_state_t *state)
+{
+    return ((CReilBatch *)batch)->get_state(lane, state);
+}
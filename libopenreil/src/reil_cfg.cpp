@@ -0,0 +1,1380 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+
+#ifndef _WIN32
+
+#include <errno.h>
+#include <unistd.h>
+#include <sched.h>
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#endif
+
+using namespace std;
+
+// OpenREIL includes
+#include "libopenreil.h"
+#include "reil_cfg.h"
+#include "reil_dfg.h"
+#include "reil_ssa.h"
+#include "reil_vsa.h"
+
+/*
+    CFG builder discovers basic blocks of the function without any calls to
+    the caller code except of the reader callback that is used to fetch code
+    chunks of CFG_READ_CHUNK bytes. Translated machine instructions are cached
+    by builder. Traversal works in two passes: the first one walks IR code from
+    the worklist of block leaders (entry point, branch targets and locations
+    where two different paths are joining) untill IOPT_BB_END instruction, the
+    second one builds non-overlapping blocks that are starting from the leaders
+    and resolves their successors into the edges.
+
+    Discovery runs traversal for each function and follows direct calls into
+    the new functions. VEX keeps its state in global variables, so workers are
+    forked processes that are sharing the discovery state in anonymous shared 
+    memory: each worker has it's own deque of functions to traverse and steals
+    them from other workers when it's own deque is empty. Called function is 
+    queued only by worker that has claimed it's address in the shared set, 
+    so each function is traversed once. Claims are made by function address,
+    not by block: translated code is cached only by the worker process, so
+    blocks that are shared by functions of different workers are translated 
+    by each of them. Workers are saving found functions and instructions they
+    have translated into temporary files that are loaded by the parent process.
+    Shared memory of forked workers can't be reallocated, so it reserves room
+    for CFG_FUNCS_MAX functions with the pages committed on the first access,
+    while discovery with a single job runs in the calling process and grows
+    it's claimed set on demand.
+
+    When data reader callback is set, traversal that has found indirect jumps
+    runs value set analysis over the visited IR code to resolve their targets
+    (jump tables in constant data) and continues from the new targets.
+*/
+
+static int cfg_inst_handler(reil_inst_t *inst, void *context)
+{
+    ((CReilCFG *)context)->handler(inst);
+
+    return 0;
+}
+
+static void cfg_insn_init(cfg_insn *insn)
+{
+    for (vector<reil_inst_t>::iterator it = insn->insts.begin(); it != insn->insts.end(); ++it)
+    {
+        it->raw_info.data = insn->data.empty() ? NULL : (unsigned char *)insn->data.data();
+        it->raw_info.str_mnem = insn->str_mnem.empty() ? NULL : (char *)insn->str_mnem.c_str();
+        it->raw_info.str_op = insn->str_mnem.empty() ? NULL : (char *)insn->str_op.c_str();
+    }
+
+    insn->visited.resize(insn->insts.size(), 0);
+}
+
+static bool cfg_lock(int *lock, int *failed)
+{
+    while (__atomic_exchange_n(lock, 1, __ATOMIC_ACQUIRE))
+    {
+        // lock might be held by the worker that has died
+        if (__atomic_load_n(failed, __ATOMIC_ACQUIRE)) return false;
+
+#ifndef _WIN32
+        sched_yield();
+#endif
+    }
+
+    return true;
+}
+
+static void cfg_unlock(int *lock)
+{
+    __atomic_store_n(lock, 0, __ATOMIC_RELEASE);
+}
+
+static void cfg_write(FILE *fd, const void *data, size_t size)
+{
+    if (size > 0) fwrite(data, size, 1, fd);
+}
+
+static bool cfg_read(FILE *fd, void *data, size_t size)
+{
+    return size == 0 || fread(data, size, 1, fd) == 1;
+}
+
+static void cfg_write_str(FILE *fd, const string &str)
+{
+    int len = (int)str.size();
+
+    cfg_write(fd, &len, sizeof(len));
+    cfg_write(fd, str.data(), len);
+}
+
+static bool cfg_read_str(FILE *fd, string &str)
+{
+    int len = 0;
+
+    if (!cfg_read(fd, &len, sizeof(len)) || len < 0 || len > CFG_READ_CHUNK)
+    {
+        return false;
+    }
+
+    str.resize(len);
+
+    return cfg_read(fd, &str[0], len);
+}
+
+CReilCFG::CReilCFG(reil_arch_t arch, reil_reader_t reader, void *context)
+{
+    this->arch = arch;
+    this->reader = reader;
+    this->reader_context = context;
+
+    data_reader = NULL;
+    data_context = NULL;
+
+    current = NULL;
+    traversal = 0;
+
+    if ((reil = reil_init(arch, cfg_inst_handler, this)) == NULL)
+    {
+        throw CReilCFGException("Unable to initialize translator");
+    }
+}
+
+CReilCFG::~CReilCFG()
+{
+    for (map<reil_addr_t, cfg_insn *>::iterator it = insns.begin(); it != insns.end(); ++it)
+    {
+        if (it->second) delete it->second;
+    }
+
+    reil_close(reil);
+}
+
+void CReilCFG::set_data_reader(reil_reader_t reader, void *context)
+{
+    data_reader = reader;
+    data_context = context;
+}
+
+void CReilCFG::handler(reil_inst_t *inst)
+{
+    if (current == NULL)
+    {
+        return;
+    }
+
+    if (inst->inum == 0)
+    {
+        // copy instruction bytes and assembly code, they are valid only inside the handler
+        if (inst->raw_info.data)
+        {
+            current->data.assign((char *)inst->raw_info.data, inst->raw_info.size);
+        }
+
+        if (inst->raw_info.str_mnem && inst->raw_info.str_op)
+        {
+            current->str_mnem = inst->raw_info.str_mnem;
+            current->str_op = inst->raw_info.str_op;
+        }
+    }
+
+    current->insts.push_back(*inst);
+}
+
+int CReilCFG::read_chunk(reil_addr_t addr, const string **data)
+{
+    map<reil_addr_t, string>::iterator it = chunks.find(addr);
+
+    if (it == chunks.end())
+    {
+        unsigned char buff[CFG_READ_CHUNK];
+        int len = reader(addr, buff, CFG_READ_CHUNK, reader_context);
+
+        // not accessible chunks are cached as well
+        len = min(max(len, 0), CFG_READ_CHUNK);
+
+        it = chunks.insert(make_pair(addr, string((char *)buff, len))).first;
+    }
+
+    *data = &it->second;
+
+    return it->second.size();
+}
+
+int CReilCFG::read_code(reil_addr_t addr, unsigned char *buff)
+{
+    int len = 0;
+
+    while (len < MAX_INST_LEN)
+    {
+        reil_addr_t ptr = addr + len, base = ptr & ~((reil_addr_t)CFG_READ_CHUNK - 1);
+        const string *data = NULL;
+
+        int offs = (int)(ptr - base);
+
+        if (read_chunk(base, &data) <= offs)
+        {
+            // end of the readable memory
+            break;
+        }
+
+        int copy_len = min(MAX_INST_LEN - len, (int)data->size() - offs);
+
+        memcpy(buff + len, data->data() + offs, copy_len);
+        len += copy_len;
+    }
+
+    if (len == 0)
+    {
+        // readable memory might start in the middle of the chunk
+        len = min(max(reader(addr, buff, MAX_INST_LEN, reader_context), 0), MAX_INST_LEN);
+    }
+
+    return len;
+}
+
+cfg_insn *CReilCFG::translate(reil_addr_t addr)
+{
+    map<reil_addr_t, cfg_insn *>::iterator it = insns.find(addr);
+
+    if (it != insns.end())
+    {
+        return it->second;
+    }
+
+    unsigned char buff[MAX_INST_LEN];
+    cfg_insn *insn = NULL;
+
+    memset(buff, 0, sizeof(buff));
+
+    // reader gets the address without Thumb bit but translator needs it to determinate the mode
+    int len = read_code(arch == ARCH_ARM ? addr & ~(reil_addr_t)1 : addr, buff);
+
+    if (len > 0)
+    {
+        insn = new cfg_insn;
+        insn->addr = addr;
+
+        current = insn;
+        insn->size = reil_translate_insn(reil, addr, buff, len);
+        current = NULL;
+
+        if (insn->size == REIL_ERROR || insn->insts.empty())
+        {
+            delete insn;
+            insn = NULL;
+        }
+        else
+        {
+            cfg_insn_init(insn);
+            translated.push_back(insn);
+        }
+    }
+
+    // failed instructions are cached as well
+    insns[addr] = insn;
+
+    return insn;
+}
+
+reil_inst_t *CReilCFG::get_inst(CFG_LOC loc, cfg_insn **insn)
+{
+    cfg_insn *ret = translate(loc.first);
+
+    if (ret == NULL || loc.second >= ret->insts.size())
+    {
+        return NULL;
+    }
+
+    if (insn) *insn = ret;
+
+    return &ret->insts[loc.second];
+}
+
+bool CReilCFG::is_bb_end(reil_inst_t *inst)
+{
+    if (!(inst->flags & IOPT_BB_END))
+    {
+        return false;
+    }
+
+    reil_addr_t next = inst->raw_info.addr + inst->raw_info.size;
+
+    if (is_thumb(inst->raw_info.addr) && is_thumb(next) &&
+        inst->op == I_JCC && (inst->flags & IOPT_ASM_END) &&
+        inst->a.type == A_CONST && inst->a.val != 0 &&
+        inst->c.type == A_LOC && inst->c.val == next && inst->c.inum == 0)
+    {
+        // JCC that is used to propagate Thumb bit doesn't split the code on basic blocks
+        return false;
+    }
+
+    return true;
+}
+
+CFG_LOC CReilCFG::get_next(reil_inst_t *inst)
+{
+    if (inst->flags & IOPT_ASM_END)
+    {
+        // first IR instruction of the next machine instruction
+        return CFG_LOC(inst->raw_info.addr + inst->raw_info.size, 0);
+    }
+
+    return CFG_LOC(inst->raw_info.addr, inst->inum + 1);
+}
+
+int CReilCFG::get_successors(reil_inst_t *inst, CFG_LOC *succ)
+{
+    int count = 0;
+
+    if (inst->op == I_JCC)
+    {
+        // jump target, indirect jumps are not followed
+        if (inst->c.type == A_CONST) succ[count++] = CFG_LOC(inst->c.val, 0);
+        else if (inst->c.type == A_LOC) succ[count++] = CFG_LOC(inst->c.val, inst->c.inum);
+    }
+
+    if (inst->flags & IOPT_RET)
+    {
+        // end of the function
+        return count;
+    }
+
+    if (inst->op == I_JCC && inst->a.type == A_CONST && inst->a.val != 0 &&
+        !(inst->flags & IOPT_CALL))
+    {
+        // unconditional jump
+        return count;
+    }
+
+    succ[count++] = get_next(inst);
+
+    return count;
+}
+
+bool CReilCFG::add_leader(CFG_LOC loc)
+{
+    return leaders.insert(make_pair(loc, 0)).second;
+}
+
+void CReilCFG::add_bb(CFG_LOC loc)
+{
+    reil_cfg_bb_t bb;
+    int from = bbs.size();
+
+    vector<int> succ_list;
+    CFG_LOC succ[2];
+    int count = 0;
+
+    bb.addr = bb.last_addr = loc.first;
+    bb.inum = bb.last_inum = loc.second;
+    bb.size = bb.flags = 0;
+
+    reil_inst_t *inst = get_inst(loc);
+
+    if (inst == NULL)
+    {
+        // code at the leader address is not available
+        bb.flags |= REIL_CFG_BB_ERROR;
+        bbs.push_back(bb);
+
+        return;
+    }
+
+    while (true)
+    {
+        bb.last_addr = loc.first;
+        bb.last_inum = loc.second;
+
+        if (is_bb_end(inst))
+        {
+            if (inst->flags & IOPT_RET) bb.flags |= REIL_CFG_BB_RET;
+
+            count = get_successors(inst, succ);
+            break;
+        }
+
+        loc = get_next(inst);
+
+        if (leaders.find(loc) != leaders.end())
+        {
+            // next instruction belongs to another block
+            succ[count++] = loc;
+            break;
+        }
+
+        // first pass makes a leader from any location that is not available
+        if ((inst = get_inst(loc)) == NULL)
+        {
+            throw CReilCFGException("Unexpected end of basic block");
+        }
+    }
+
+    bb.size = (int)(inst->raw_info.addr + inst->raw_info.size - bb.addr);
+    bbs.push_back(bb);
+
+    for (int i = 0; i < count; i++)
+    {
+        map<CFG_LOC, int>::iterator it = leaders.find(succ[i]);
+
+        if (it == leaders.end())
+        {
+            throw CReilCFGException("Successor is not a leader");
+        }
+
+        succ_list.push_back(it->second);
+    }
+
+    map<CFG_LOC, vector<reil_addr_t> >::iterator jump = targets.find(CFG_LOC(inst->raw_info.addr, inst->inum));
+
+    if (jump != targets.end())
+    {
+        // indirect jump with resolved targets
+        bbs.back().flags |= REIL_CFG_BB_INDIRECT;
+
+        for (vector<reil_addr_t>::iterator it = jump->second.begin(); it != jump->second.end(); ++it)
+        {
+            map<CFG_LOC, int>::iterator target = leaders.find(CFG_LOC(*it, 0));
+
+            if (target == leaders.end())
+            {
+                throw CReilCFGException("Jump target is not a leader");
+            }
+
+            succ_list.push_back(target->second);
+        }
+    }
+
+    // conditional jump to the next instruction has the same successors
+    sort(succ_list.begin(), succ_list.end());
+    succ_list.erase(unique(succ_list.begin(), succ_list.end()), succ_list.end());
+
+    for (vector<int>::iterator it = succ_list.begin(); it != succ_list.end(); ++it)
+    {
+        reil_cfg_edge_t edge;
+
+        edge.from = from;
+        edge.to = *it;
+
+        edges.push_back(edge);
+    }
+}
+
+bool CReilCFG::resolve(vector<CFG_LOC> &entries, vector<cfg_insn *> &walked, vector<CFG_LOC> &worklist)
+{
+    vector<reil_inst_t> insts;
+    vector<CFG_LOC> found;
+
+    sort(walked.begin(), walked.end());
+    walked.erase(unique(walked.begin(), walked.end()), walked.end());
+
+    for (vector<cfg_insn *>::iterator it = walked.begin(); it != walked.end(); ++it)
+    {
+        for (size_t i = 0; i < (*it)->insts.size(); i++)
+        {
+            // IR code of the function that was found so far
+            if ((*it)->visited[i] == traversal) insts.push_back((*it)->insts[i]);
+        }
+    }
+
+    if (insts.empty())
+    {
+        return false;
+    }
+
+    /*
+        Resolved jumps are not known by data flow analysis, so code at their targets
+        is analyzed separately with unknown values of the variables at the entry.
+    */
+    for (vector<CFG_LOC>::iterator entry = entries.begin(); entry != entries.end(); ++entry)
+    {
+        map<DFG_LOC, vector<reil_addr_t> > jumps;
+
+        try
+        {
+            CReilVSA vsa(arch, &insts[0], (int)insts.size(), *entry, data_reader, data_context);
+
+            vsa.jump_list(jumps);
+        }
+        catch (CReilDFGException e)
+        {
+            continue;
+        }
+
+        for (map<DFG_LOC, vector<reil_addr_t> >::iterator it = jumps.begin(); it != jumps.end(); ++it)
+        {
+            vector<reil_addr_t> &known = targets[it->first];
+
+            for (vector<reil_addr_t>::iterator addr = it->second.begin(); addr != it->second.end(); ++addr)
+            {
+                if (find(known.begin(), known.end(), *addr) != known.end())
+                {
+                    continue;
+                }
+
+                known.push_back(*addr);
+
+                // continue traversal from the new jump target
+                if (add_leader(CFG_LOC(*addr, 0))) worklist.push_back(CFG_LOC(*addr, 0));
+
+                found.push_back(CFG_LOC(*addr, 0));
+            }
+        }
+    }
+
+    sort(found.begin(), found.end());
+    found.erase(unique(found.begin(), found.end()), found.end());
+
+    entries.swap(found);
+
+    return !entries.empty();
+}
+
+int CReilCFG::traverse(CFG_LOC loc)
+{
+    vector<CFG_LOC> worklist;
+
+    // machine instructions that were walked and presence of indirect jumps
+    vector<cfg_insn *> walked;
+    bool indirect = false;
+
+    // locations to analyze for indirect jumps resolving
+    vector<CFG_LOC> entries(1, loc);
+
+    leaders.clear();
+    bbs.clear();
+    edges.clear();
+    calls.clear();
+    funcs.clear();
+    targets.clear();
+
+    // visited instructions are marked with the number of the current traversal
+    traversal += 1;
+
+    add_leader(loc);
+    worklist.push_back(loc);
+
+    for (int pass = 0; ; pass++)
+    {
+        while (!worklist.empty())
+        {
+            CFG_LOC cur = worklist.back();
+            bool first = true;
+
+            worklist.pop_back();
+
+            while (true)
+            {
+                cfg_insn *insn = NULL;
+                reil_inst_t *inst = get_inst(cur, &insn);
+
+                if (inst == NULL || insn->visited[cur.second] == traversal)
+                {
+                    /*
+                        Location is reachable from two different paths or not available,
+                        in both cases it has to be a start of the new basic block.
+                    */
+                    if (!first) add_leader(cur);
+                    break;
+                }
+
+                insn->visited[cur.second] = traversal;
+
+                walked.push_back(insn);
+
+                if (inst->op == I_JCC && (inst->flags & IOPT_CALL) &&
+                    (inst->c.type == A_CONST || inst->c.type == A_LOC))
+                {
+                    // direct function call
+                    calls.push_back(inst->c.val);
+                }
+
+                if (is_bb_end(inst))
+                {
+                    CFG_LOC succ[2];
+                    int count = get_successors(inst, succ);
+
+                    for (int i = 0; i < count; i++)
+                    {
+                        if (add_leader(succ[i])) worklist.push_back(succ[i]);
+                    }
+
+                    if (inst->op == I_JCC && !(inst->flags & (IOPT_CALL | IOPT_RET)) &&
+                        inst->c.type != A_CONST && inst->c.type != A_LOC)
+                    {
+                        indirect = true;
+                    }
+
+                    break;
+                }
+
+                cur = get_next(inst);
+                first = false;
+            }
+        }
+
+        if (data_reader == NULL || !indirect || pass >= CFG_RESOLVE_PASSES ||
+            !resolve(entries, walked, worklist))
+        {
+            // there's no new jump targets
+            break;
+        }
+    }
+
+    int num = 0;
+
+    // leaders are sorted by address, so as basic blocks
+    for (map<CFG_LOC, int>::iterator it = leaders.begin(); it != leaders.end(); ++it)
+    {
+        it->second = num++;
+    }
+
+    try
+    {
+        for (map<CFG_LOC, int>::iterator it = leaders.begin(); it != leaders.end(); ++it)
+        {
+            add_bb(it->first);
+        }
+    }
+    catch (CReilCFGException e)
+    {
+        fprintf(stderr, "CFG traversal ERROR: %s\n", e.reason.c_str());
+
+        bbs.clear();
+        edges.clear();
+        calls.clear();
+
+        return REIL_ERROR;
+    }
+
+    sort(calls.begin(), calls.end());
+    calls.erase(unique(calls.begin(), calls.end()), calls.end());
+
+    return bbs.size();
+}
+
+static size_t cfg_hash(reil_addr_t addr, size_t size)
+{
+    return (size_t)((addr * 0x9e3779b97f4a7c15ULL) >> 32) & (size - 1);
+}
+
+cfg_shared *CReilCFG::shared_alloc(int workers, int capacity, bool fork)
+{
+    size_t head_size = (sizeof(cfg_shared) + sizeof(cfg_deque) * workers + 0xf) & ~0xf;
+    size_t tasks_size = sizeof(cfg_task) * capacity;
+    size_t claimed_size = sizeof(reil_addr_t) * capacity * 2;
+
+    cfg_shared *shared = NULL;
+
+#ifndef _WIN32
+
+    if (fork)
+    {
+        size_t size = head_size + tasks_size + claimed_size;
+
+        // pages of anonymous mapping are zero filled on the first access
+        void *ptr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANON | MAP_NORESERVE, -1, 0);
+
+        if (ptr == MAP_FAILED)
+        {
+            return NULL;
+        }
+
+        uint8_t *mem = (uint8_t *)ptr;
+
+        shared = (cfg_shared *)mem;
+        shared->size = size;
+        shared->tasks = (cfg_task *)(mem + head_size);
+        shared->claimed = (reil_addr_t *)(mem + head_size + tasks_size);
+    }
+    else
+
+#endif
+
+    {
+        // tasks and claimed set are allocated separately to grow them on demand
+        if ((shared = (cfg_shared *)calloc(1, head_size)) == NULL)
+        {
+            return NULL;
+        }
+
+        shared->size = head_size;
+        shared->tasks = (cfg_task *)malloc(tasks_size);
+        shared->claimed = (reil_addr_t *)calloc(1, claimed_size);
+
+        if (shared->tasks == NULL || shared->claimed == NULL)
+        {
+            shared_free(shared);
+            return NULL;
+        }
+    }
+
+    shared->fork = fork;
+    shared->workers = workers;
+    shared->capacity = capacity;
+    shared->deques = (cfg_deque *)((uint8_t *)shared + sizeof(cfg_shared));
+
+    for (int i = 0; i < workers; i++)
+    {
+        shared->deques[i].head = shared->deques[i].tail = -1;
+    }
+
+    return shared;
+}
+
+bool CReilCFG::shared_grow(cfg_shared *shared)
+{
+    size_t size = (size_t)shared->capacity * 2;
+    int capacity = shared->capacity * 2;
+
+    if (shared->fork || capacity > CFG_FUNCS_MAX)
+    {
+        return false;
+    }
+
+    cfg_task *tasks = (cfg_task *)realloc(shared->tasks, sizeof(cfg_task) * capacity);
+
+    if (tasks == NULL)
+    {
+        return false;
+    }
+
+    shared->tasks = tasks;
+
+    reil_addr_t *claimed = (reil_addr_t *)calloc(capacity * 2, sizeof(reil_addr_t));
+
+    if (claimed == NULL)
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < size; i++)
+    {
+        reil_addr_t key = shared->claimed[i];
+
+        if (key != 0)
+        {
+            size_t pos = cfg_hash(key - 1, capacity * 2);
+
+            while (claimed[pos] != 0) pos = (pos + 1) & (capacity * 2 - 1);
+
+            claimed[pos] = key;
+        }
+    }
+
+    free(shared->claimed);
+
+    shared->claimed = claimed;
+    shared->capacity = capacity;
+
+    return true;
+}
+
+void CReilCFG::shared_free(cfg_shared *shared)
+{
+#ifndef _WIN32
+
+    if (shared->fork)
+    {
+        munmap(shared, shared->size);
+        return;
+    }
+
+#endif
+
+    free(shared->tasks);
+    free(shared->claimed);
+    free(shared);
+}
+
+int CReilCFG::claim(cfg_shared *shared, reil_addr_t addr)
+{
+    size_t size = (size_t)shared->capacity * 2;
+    size_t pos = cfg_hash(addr, size);
+
+    // zero value is used for empty slots
+    reil_addr_t key = addr + 1;
+
+    for (size_t i = 0; i < size; i++, pos = (pos + 1) & (size - 1))
+    {
+        reil_addr_t val = 0;
+
+        if (__atomic_compare_exchange_n(&shared->claimed[pos], &val, key, false, 
+                                        __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+        {
+            int task = __atomic_fetch_add(&shared->claims, 1, __ATOMIC_ACQ_REL);
+
+            // claimed set of forked workers can't be reallocated
+            if (task >= shared->capacity && !shared_grow(shared))
+            {
+                break;
+            }
+
+            shared->tasks[task].addr = addr;
+
+            return task;
+        }
+
+        if (val == key)
+        {
+            // function was already claimed by this or another worker
+            return -1;
+        }
+    }
+
+    __atomic_store_n(&shared->overflow, 1, __ATOMIC_RELEASE);
+
+    return -1;
+}
+
+void CReilCFG::task_push(cfg_shared *shared, int worker, int task)
+{
+    cfg_deque *deque = &shared->deques[worker];
+    cfg_task *tasks = shared->tasks;
+
+    if (!cfg_lock(&deque->lock, &shared->failed)) return;
+
+    tasks[task].prev = deque->tail;
+    tasks[task].next = -1;
+
+    if (deque->tail >= 0) tasks[deque->tail].next = task; else deque->head = task;
+
+    deque->tail = task;
+    cfg_unlock(&deque->lock);
+}
+
+bool CReilCFG::task_pop(cfg_shared *shared, int worker, reil_addr_t *addr)
+{
+    for (int i = 0; i < shared->workers; i++)
+    {
+        int num = (worker + i) % shared->workers, task = -1;
+
+        cfg_deque *deque = &shared->deques[num];
+        cfg_task *tasks = shared->tasks;
+
+        if (!cfg_lock(&deque->lock, &shared->failed)) return false;
+
+        if (num == worker && deque->tail >= 0)
+        {
+            // owner takes the last queued function
+            task = deque->tail;
+            deque->tail = tasks[task].prev;
+
+            if (deque->tail >= 0) tasks[deque->tail].next = -1; else deque->head = -1;
+        }
+        else if (num != worker && deque->head >= 0)
+        {
+            // others are stealing the first one
+            task = deque->head;
+            deque->head = tasks[task].next;
+
+            if (deque->head >= 0) tasks[deque->head].prev = -1; else deque->tail = -1;
+        }
+
+        if (task >= 0) *addr = tasks[task].addr;
+
+        cfg_unlock(&deque->lock);
+
+        if (task >= 0) return true;
+    }
+
+    return false;
+}
+
+void CReilCFG::discover_worker(cfg_shared *shared, int worker)
+{
+    while (true)
+    {
+        reil_addr_t addr = 0;
+
+        if (__atomic_load_n(&shared->failed, __ATOMIC_ACQUIRE))
+        {
+            // results will be discarded anyway
+            break;
+        }
+
+        if (!task_pop(shared, worker, &addr))
+        {
+            if (__atomic_load_n(&shared->pending, __ATOMIC_ACQUIRE) == 0)
+            {
+                // all of the functions were traversed
+                break;
+            }
+
+#ifndef _WIN32
+            // other workers might queue more functions
+            sched_yield();
+#endif
+            continue;
+        }
+
+        traverse(CFG_LOC(addr, 0));
+
+        cfg_func &func = found[addr];
+
+        func.bbs.swap(bbs);
+        func.edges.swap(edges);
+
+        for (vector<reil_addr_t>::iterator it = calls.begin(); it != calls.end(); ++it)
+        {
+            int task = claim(shared, *it);
+
+            if (task >= 0)
+            {
+                __atomic_add_fetch(&shared->pending, 1, __ATOMIC_ACQ_REL);
+                task_push(shared, worker, task);
+            }
+        }
+
+        // pending counter is decremented after queueing of called functions
+        __atomic_sub_fetch(&shared->pending, 1, __ATOMIC_ACQ_REL);
+    }
+}
+
+void CReilCFG::save_results(FILE *fd)
+{
+    int num = (int)found.size();
+
+    cfg_write(fd, &num, sizeof(num));
+
+    for (map<reil_addr_t, cfg_func>::iterator it = found.begin(); it != found.end(); ++it)
+    {
+        int bbs_num = (int)it->second.bbs.size(), edges_num = (int)it->second.edges.size();
+
+        cfg_write(fd, &it->first, sizeof(reil_addr_t));
+        cfg_write(fd, &bbs_num, sizeof(bbs_num));
+        cfg_write(fd, &edges_num, sizeof(edges_num));
+        if (bbs_num > 0) cfg_write(fd, &it->second.bbs[0], sizeof(reil_cfg_bb_t) * bbs_num);
+        if (edges_num > 0) cfg_write(fd, &it->second.edges[0], sizeof(reil_cfg_edge_t) * edges_num);
+    }
+
+    num = (int)translated.size();
+
+    cfg_write(fd, &num, sizeof(num));
+
+    for (vector<cfg_insn *>::iterator it = translated.begin(); it != translated.end(); ++it)
+    {
+        cfg_insn *insn = *it;
+        int insts_num = (int)insn->insts.size();
+
+        cfg_write(fd, &insn->addr, sizeof(insn->addr));
+        cfg_write(fd, &insn->size, sizeof(insn->size));
+        cfg_write_str(fd, insn->data);
+        cfg_write_str(fd, insn->str_mnem);
+        cfg_write_str(fd, insn->str_op);
+
+        // raw_info pointers are updated by cfg_insn_init() on load
+        cfg_write(fd, &insts_num, sizeof(insts_num));
+        if (insts_num > 0) cfg_write(fd, &insn->insts[0], sizeof(reil_inst_t) * insts_num);
+    }
+}
+
+bool CReilCFG::load_results(FILE *fd)
+{
+    int num = 0;
+
+    if (!cfg_read(fd, &num, sizeof(num)))
+    {
+        return false;
+    }
+
+    for (int i = 0; i < num; i++)
+    {
+        reil_addr_t addr = 0;
+        int bbs_num = 0, edges_num = 0;
+
+        if (!cfg_read(fd, &addr, sizeof(addr)) ||
+            !cfg_read(fd, &bbs_num, sizeof(bbs_num)) ||
+            !cfg_read(fd, &edges_num, sizeof(edges_num)) || bbs_num < 0 || edges_num < 0)
+        {
+            return false;
+        }
+
+        cfg_func &func = found[addr];
+
+        func.bbs.resize(bbs_num);
+        func.edges.resize(edges_num);
+
+        if ((bbs_num > 0 && !cfg_read(fd, &func.bbs[0], sizeof(reil_cfg_bb_t) * bbs_num)) ||
+            (edges_num > 0 && !cfg_read(fd, &func.edges[0], sizeof(reil_cfg_edge_t) * edges_num)))
+        {
+            return false;
+        }
+    }
+
+    if (!cfg_read(fd, &num, sizeof(num)))
+    {
+        return false;
+    }
+
+    for (int i = 0; i < num; i++)
+    {
+        cfg_insn *insn = new cfg_insn;
+        int insts_num = 0;
+
+        if (!cfg_read(fd, &insn->addr, sizeof(insn->addr)) ||
+            !cfg_read(fd, &insn->size, sizeof(insn->size)) ||
+            !cfg_read_str(fd, insn->data) ||
+            !cfg_read_str(fd, insn->str_mnem) ||
+            !cfg_read_str(fd, insn->str_op) ||
+            !cfg_read(fd, &insts_num, sizeof(insts_num)) || insts_num < 0)
+        {
+            delete insn;
+            return false;
+        }
+
+        insn->insts.resize(insts_num);
+
+        if (insts_num > 0 && !cfg_read(fd, &insn->insts[0], sizeof(reil_inst_t) * insts_num))
+        {
+            delete insn;
+            return false;
+        }
+
+        map<reil_addr_t, cfg_insn *>::iterator it = insns.find(insn->addr);
+
+        if (it != insns.end() && it->second != NULL)
+        {
+            // shared code of functions might be translated by several workers
+            delete insn;
+            continue;
+        }
+
+        cfg_insn_init(insn);
+        insns[insn->addr] = insn;
+    }
+
+    return true;
+}
+
+bool CReilCFG::discover_fork(cfg_shared *shared, int jobs)
+{
+    bool ret = true;
+
+#ifndef _WIN32
+
+    vector<pid_t> workers;
+    vector<FILE *> files;
+
+    for (int n = 0; n < jobs; n++)
+    {
+        FILE *fd = tmpfile();
+
+        if (fd == NULL)
+        {
+            break;
+        }
+
+        pid_t pid = fork();
+
+        if (pid < 0)
+        {
+            fclose(fd);
+            break;
+        }
+        else if (pid == 0)
+        {
+            translated.clear();
+
+            discover_worker(shared, n);
+            save_results(fd);
+
+            _exit(fflush(fd) == 0 ? 0 : -1);
+        }
+
+        workers.push_back(pid);
+        files.push_back(fd);
+    }
+
+    if (workers.empty())
+    {
+        // unable to start any worker, functions of all deques are stolen by this one
+        discover_worker(shared, 0);
+    }
+
+    vector<bool> exited(workers.size(), false);
+    size_t running = workers.size();
+
+    /*
+        Worker that was killed never decrements the pending counter, so others 
+        would wait for it forever: exit status is polled and failure flag makes
+        the rest of the workers to stop.
+    */
+    while (running > 0)
+    {
+        bool found = false;
+
+        for (size_t n = 0; n < workers.size(); n++)
+        {
+            int status = 0;
+
+            if (exited[n])
+            {
+                continue;
+            }
+
+            pid_t pid = waitpid(workers[n], &status, WNOHANG);
+
+            if (pid == 0 || (pid < 0 && errno == EINTR))
+            {
+                // still running
+                continue;
+            }
+
+            exited[n] = found = true;
+            running -= 1;
+
+            if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+            {
+                fprintf(stderr, "CFG discovery worker %d fails\n", (int)n);
+
+                __atomic_store_n(&shared->failed, 1, __ATOMIC_RELEASE);
+                ret = false;
+            }
+        }
+
+        if (!found) usleep(CFG_WAIT_TIME);
+    }
+
+    for (size_t n = 0; n < workers.size(); n++)
+    {
+        rewind(files[n]);
+
+        if (ret && !load_results(files[n]))
+        {
+            fprintf(stderr, "CFG discovery worker %d fails\n", (int)n);
+            ret = false;
+        }
+
+        fclose(files[n]);
+    }
+
+#endif
+
+    return ret;
+}
+
+int CReilCFG::discover(reil_addr_t *entries, int count, int jobs)
+{
+#ifdef _WIN32
+
+    // fork() is not available
+    jobs = 1;
+
+#endif
+
+    jobs = max(jobs, 1);
+
+    int capacity = CFG_FUNCS_MAX;
+
+    if (jobs == 1)
+    {
+        // claimed set of the calling process grows with the number of found functions
+        for (capacity = CFG_FUNCS_INIT; capacity < count && capacity < CFG_FUNCS_MAX; capacity *= 2);
+    }
+
+    cfg_shared *shared = shared_alloc(jobs, capacity, jobs > 1);
+
+    if (shared == NULL)
+    {
+        return REIL_ERROR;
+    }
+
+    found.clear();
+    translated.clear();
+
+    for (int i = 0; i < count; i++)
+    {
+        int task = claim(shared, entries[i]);
+
+        // distribute entry points between workers
+        if (task >= 0)
+        {
+            shared->pending += 1;
+            task_push(shared, i % jobs, task);
+        }
+    }
+
+    bool ok = true;
+
+    if (jobs > 1)
+    {
+        ok = discover_fork(shared, jobs);
+    }
+    else
+    {
+        discover_worker(shared, 0);
+    }
+
+    if (shared->overflow)
+    {
+        fprintf(stderr, "CFG discovery ERROR: Too many functions\n");
+        ok = false;
+    }
+
+    shared_free(shared);
+
+    leaders.clear();
+    bbs.clear();
+    edges.clear();
+    calls.clear();
+    funcs.clear();
+    translated.clear();
+
+    if (!ok)
+    {
+        found.clear();
+        return REIL_ERROR;
+    }
+
+    for (map<reil_addr_t, cfg_func>::iterator it = found.begin(); it != found.end(); ++it)
+    {
+        reil_cfg_func_t func;
+
+        func.addr = it->first;
+        func.bb_first = (int)bbs.size();
+        func.bb_count = (int)it->second.bbs.size();
+        func.edge_first = (int)edges.size();
+        func.edge_count = (int)it->second.edges.size();
+
+        bbs.insert(bbs.end(), it->second.bbs.begin(), it->second.bbs.end());
+
+        for (vector<reil_cfg_edge_t>::iterator edge = it->second.edges.begin(); 
+             edge != it->second.edges.end(); ++edge)
+        {
+            reil_cfg_edge_t item;
+
+            // use global indexes of basic blocks
+            item.from = edge->from + func.bb_first;
+            item.to = edge->to + func.bb_first;
+
+            edges.push_back(item);
+        }
+
+        funcs.push_back(func);
+    }
+
+    found.clear();
+
+    return (int)funcs.size();
+}
+
+int CReilCFG::func_list(reil_cfg_func_t *funcs, int count)
+{
+    int num = (int)this->funcs.size();
+
+    if (funcs && count > 0 && num > 0)
+    {
+        memcpy(funcs, &this->funcs[0], sizeof(reil_cfg_func_t) * min(count, num));
+    }
+
+    return num;
+}
+
+int CReilCFG::bb_list(reil_cfg_bb_t *bbs, int count)
+{
+    int num = (int)this->bbs.size();
+
+    if (bbs && count > 0 && num > 0)
+    {
+        memcpy(bbs, &this->bbs[0], sizeof(reil_cfg_bb_t) * min(count, num));
+    }
+
+    return num;
+}
+
+int CReilCFG::edge_list(reil_cfg_edge_t *edges, int count)
+{
+    int num = (int)this->edges.size();
+
+    if (edges && count > 0 && num > 0)
+    {
+        memcpy(edges, &this->edges[0], sizeof(reil_cfg_edge_t) * min(count, num));
+    }
+
+    return num;
+}
+
+int CReilCFG::insn_list(reil_addr_t addr, reil_inst_t *insts, int count)
+{
+    map<reil_addr_t, cfg_insn *>::iterator it = insns.find(addr);
+
+    if (it == insns.end() || it->second == NULL)
+    {
+        return REIL_ERROR;
+    }
+
+    int num = (int)it->second->insts.size();
+
+    if (insts && count > 0 && num > 0)
+    {
+        memcpy(insts, &it->second->insts[0], sizeof(reil_inst_t) * min(count, num));
+    }
+
+    return num;
+}
+
+//======================================================================
+// C API
+//======================================================================
+
+extern "C" reil_cfg_t reil_cfg_init(reil_arch_t arch, reil_reader_t reader, void *context)
+{
+    try
+    {
+        return (reil_cfg_t)new CReilCFG(arch, reader, context);
+    }
+    catch (CReilCFGException e)
+    {
+        fprintf(stderr, "reil_cfg_init() ERROR: %s\n", e.reason.c_str());
+    }
+
+    return NULL;
+}
+
+extern "C" void reil_cfg_close(reil_cfg_t cfg)
+{
+    delete (CReilCFG *)cfg;
+}
+
+extern "C" void reil_cfg_set_data_reader(reil_cfg_t cfg, reil_reader_t reader, void *context)
+{
+    ((CReilCFG *)cfg)->set_data_reader(reader, context);
+}
+
+extern "C" int reil_cfg_traverse(reil_cfg_t cfg, reil_addr_t addr, reil_inum_t inum)
+{
+    return ((CReilCFG *)cfg)->traverse(CFG_LOC(addr, inum));
+}
+
+extern "C" int reil_cfg_discover(reil_cfg_t cfg, reil_addr_t *entries, int count, int jobs)
+{
+    return ((CReilCFG *)cfg)->discover(entries, count, jobs);
+}
+
+extern "C" int reil_cfg_func_list(reil_cfg_t cfg, reil_cfg_func_t *funcs, int count)
+{
+    return ((CReilCFG *)cfg)->func_list(funcs, count);
+}
+
+extern "C" int reil_cfg_bb_list(reil_cfg_t cfg, reil_cfg_bb_t *bbs, int count)
+{
+    return ((CReilCFG *)cfg)->bb_list(bbs, count);
+}
+
+extern "C" int reil_cfg_edge_list(reil_cfg_t cfg, reil_cfg_edge_t *edges, int count)
+{
+    return ((CReilCFG *)cfg)->edge_list(edges, count);
+}
+
+extern "C" int reil_cfg_insn_list(reil_cfg_t cfg, reil_addr_t addr, reil_inst_t *insts, int count)
+{
+    return ((CReilCFG *)cfg)->insn_list(addr, insts, count);
+}
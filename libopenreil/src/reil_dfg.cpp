@@ -0,0 +1,1165 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <string>
+#include <deque>
+#include <vector>
+#include <map>
+#include <set>
+#include <algorithm>
+
+using namespace std;
+
+// OpenREIL includes
+#include "libopenreil.h"
+#include "reil_mem.h"
+#include "reil_vm.h"
+#include "reil_vm_ops.h"
+#include "reil_dfg.h"
+
+/*
+    Native data flow optimizer works on the array of IR instructions of the
+    function. Variables (registers and temporary registers) are identified by
+    dense IDs, so data flow states are arrays and bit sets indexed by them.
+    Instructions are split into basic blocks by their actual successors, then
+    optimizer runs the following passes untill nothing changes:
+
+      - constant folding: forward data flow analysis over the constants lattice,
+        constant operands are propagated into the instructions that are using
+        them and expressions with constant operands are replaced with I_STR;
+
+      - common subexpression elimination: local value numbering replaces
+        recomputed expressions with I_STR of the variable that keeps their
+        value and uses of temporary registers with registers that have the
+        same value, temporary register that is stored into the register by
+        the next instruction is replaced with this register;
+
+      - dead code elimination: instructions that are writing variables that
+        are not live (or used only by other dead instructions) are eliminated.
+
+    Optimizer never modifies I_JCC operands, so control flow graph of the
+    function remains the same.
+*/
+
+static const char *dfg_x86_general[] = { "R_EAX", "R_EBX", "R_ECX", "R_EDX",
+                                         "R_ESI", "R_EDI", "R_EBP", "R_ESP", NULL };
+
+static const char *dfg_x86_flags[] = { "R_ZF", "R_PF", "R_CF", "R_AF",
+                                       "R_SF", "R_OF", "R_DFLAG", NULL };
+
+static const char *dfg_arm_general[] = { "R_R0", "R_R1", "R_R2",  "R_R3",  "R_R4",  "R_R5",  "R_R6",  "R_R7",
+                                         "R_R8", "R_R9", "R_R10", "R_R11", "R_R12", "R_R13", "R_R14", "R_R15T", NULL };
+
+static const char *dfg_arm_flags[] = { "R_NF", "R_ZF", "R_CF", "R_VF", NULL };
+
+static bool dfg_insn_less(const dfg_insn &a, const dfg_insn &b)
+{
+    return a.loc < b.loc;
+}
+
+static bool dfg_is_commutative(reil_op_t op)
+{
+    return op == I_ADD || op == I_MUL || op == I_AND || op == I_OR || op == I_XOR || op == I_EQ;
+}
+
+// evaluate expression with constant operands in the same way as native interpreter does
+bool dfg_eval(reil_inst_t *inst, reil_const_t a, reil_const_t b, reil_const_t *val)
+{
+    reil_size_t size_a = inst->a.size, size_c = inst->c.size;
+    reil_size_t size_b = inst->b.type == A_NONE ? size_a : inst->b.size;
+
+    int width_a = vm_width(size_a), width_b = vm_width(size_b), width = max(width_a, width_b);
+
+    reil_const_t mask_c = vm_mask(size_c), ret = 0;
+
+    a &= vm_mask(size_a);
+    b &= vm_mask(size_b);
+
+    switch (inst->op)
+    {
+    case I_STR: ret = vm_op_str::eval(a, b); break;
+    case I_ADD: ret = vm_op_add::eval(a, b); break;
+    case I_SUB: ret = vm_op_sub::eval(a, b); break;
+    case I_NEG: ret = vm_op_neg::eval(a, b); break;
+    case I_MUL: ret = vm_op_mul::eval(a, b); break;
+    case I_DIV: ret = vm_op_div::eval(a, b); break;
+    case I_MOD: ret = vm_op_mod::eval(a, b); break;
+    case I_SHL: ret = vm_op_shl::eval(a, b); break;
+    case I_SHR: ret = vm_op_shr::eval(a, b); break;
+    case I_AND: ret = vm_op_and::eval(a, b); break;
+    case I_OR:  ret = vm_op_or::eval(a, b); break;
+    case I_XOR: ret = vm_op_xor::eval(a, b); break;
+    case I_NOT: ret = vm_op_not::eval(a, b); break;
+    case I_EQ:  ret = vm_op_eq::eval(a, b); break;
+    case I_LT:  ret = vm_op_lt::eval(a, b); break;
+
+    case I_SMUL:
+    case I_SDIV:
+    case I_SMOD:
+        {
+            int64_t sa = vm_sext(a, 64 - width_a), sb = vm_sext(b, 64 - width_b), sr = 0;
+
+            if (inst->op == I_SMUL) sr = vm_op_smul::eval(sa, sb);
+            else if (inst->op == I_SDIV) sr = vm_op_sdiv::eval(sa, sb);
+            else sr = vm_op_smod::eval(sa, sb);
+
+            // result of signed operation is sign extended to the destination size
+            ret = (reil_const_t)vm_sext((reil_const_t)sr, 64 - width);
+            break;
+        }
+
+    default:
+
+        return false;
+    }
+
+    if (inst->op != I_SMUL && inst->op != I_SDIV && inst->op != I_SMOD)
+    {
+        mask_c &= vm_width_mask(width);
+    }
+
+    if (size_a == U1 && size_b == U1)
+    {
+        // the same hack for one bit operands as in pyopenreil VM.Math
+        mask_c &= 1;
+    }
+
+    *val = ret & mask_c;
+
+    return true;
+}
+
+/*
+    Value numbers of the basic block that is processed by local value numbering.
+*/
+typedef struct _dfg_numbering
+{
+    // current value numbers of variables or -1 when it's unknown
+    vector<int> vars;
+
+    // sizes of variables, temporary register might be used with different sizes
+    vector<int> sizes;
+
+    // variables that were assigned with each value number
+    vector<vector<int> > holders;
+
+    map<dfg_expr, int> exprs;
+    map<pair<reil_const_t, int>, int> consts;
+
+    // incremented on each memory write
+    int mem;
+
+    int fresh()
+    {
+        holders.push_back(vector<int>());
+
+        return (int)holders.size() - 1;
+    }
+
+    void set(int var, int num, int size)
+    {
+        vars[var] = num;
+        sizes[var] = size;
+        holders[num].push_back(var);
+    }
+
+    int get(int var, int size)
+    {
+        // value of the variable at the beginning of the basic block
+        if (vars[var] == -1) set(var, fresh(), size);
+
+        return vars[var];
+    }
+
+} dfg_numbering;
+
+CReilDFG::CReilDFG(reil_arch_t arch, reil_inst_t *insts, int count)
+{
+    const char **general_names = NULL, **flags_names = NULL;
+
+    this->arch = arch;
+    this->keep_flags = false;
+    this->eliminated = 0;
+    this->entry = -1;
+
+    switch (arch)
+    {
+    case ARCH_X86:
+
+        general_names = dfg_x86_general;
+        flags_names = dfg_x86_flags;
+        break;
+
+    case ARCH_ARM:
+
+        general_names = dfg_arm_general;
+        flags_names = dfg_arm_flags;
+        break;
+
+    default:
+
+        throw CReilDFGException("Unknown architecture");
+    }
+
+    for (int i = 0; general_names[i]; i++)
+    {
+        reil_arg_t arg;
+
+        memset(&arg, 0, sizeof(arg));
+        arg.type = A_REG;
+        arg.size = U32;
+        strcpy(arg.name, general_names[i]);
+
+        clobbered.push_back(var_id(&arg));
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        dfg_insn insn;
+        reil_arg_t *args[] = { &insts[i].a, &insts[i].b, &insts[i].c };
+
+        for (int n = 0; n < 3; n++)
+        {
+            if (args[n]->type != A_NONE && args[n]->type != A_LOC &&
+                (args[n]->size < U1 || args[n]->size > U64))
+            {
+                throw CReilDFGException("Invalid operand size");
+            }
+        }
+
+        insn.inst = &insts[i];
+        insn.loc = DFG_LOC(insts[i].raw_info.addr, insts[i].inum);
+        insn.succ_count = 0;
+        insn.exit = false;
+        insn.bb = -1;
+
+        update(&insn);
+        insns.push_back(insn);
+    }
+
+    sort(insns.begin(), insns.end(), dfg_insn_less);
+
+    for (size_t i = 1; i < insns.size(); i++)
+    {
+        if (insns[i - 1].loc == insns[i].loc)
+        {
+            throw CReilDFGException("Duplicate instruction");
+        }
+    }
+
+    // all of the variables are known at this point
+    int words = ((int)vars.size() + 63) / 64;
+
+    general.assign(words, 0);
+    flags.assign(words, 0);
+
+    for (vector<int>::iterator it = clobbered.begin(); it != clobbered.end(); ++it)
+    {
+        dfg_set_add(general, *it);
+    }
+
+    for (int i = 0; flags_names[i]; i++)
+    {
+        map<string, int>::iterator it = vars_map.find(flags_names[i]);
+
+        if (it != vars_map.end())
+        {
+            dfg_set_add(flags, it->second);
+            clobbered.push_back(it->second);
+        }
+    }
+}
+
+int CReilDFG::var_id(reil_arg_t *arg)
+{
+    if (arg->type != A_REG && arg->type != A_TEMP)
+    {
+        return -1;
+    }
+
+    map<string, int>::iterator it = vars_map.find(arg->name);
+
+    if (it != vars_map.end())
+    {
+        return it->second;
+    }
+
+    int id = (int)vars.size();
+
+    vars_map[arg->name] = id;
+    vars.push_back(*arg);
+
+    return id;
+}
+
+int CReilDFG::find(DFG_LOC loc)
+{
+    dfg_insn key;
+
+    key.loc = loc;
+
+    vector<dfg_insn>::iterator it = lower_bound(insns.begin(), insns.end(), key, dfg_insn_less);
+
+    return (it != insns.end() && it->loc == loc) ? (int)(it - insns.begin()) : -1;
+}
+
+bool CReilDFG::is_pure(reil_inst_t *inst)
+{
+    // instructions without side effects that are writing variable
+    return inst->op != I_NONE && inst->op != I_UNK && inst->op != I_JCC && inst->op != I_STM &&
+           (inst->c.type == A_REG || inst->c.type == A_TEMP);
+}
+
+bool CReilDFG::is_read(dfg_insn *insn, int var)
+{
+    reil_inst_t *inst = insn->inst;
+
+    switch (inst->op)
+    {
+    case I_NONE:
+
+        return false;
+
+    case I_UNK:
+
+        // operands of unknown instruction are not known
+        return true;
+
+    case I_JCC:
+
+        if ((inst->flags & IOPT_CALL) && dfg_set_test(general, var)) return true;
+
+        return insn->a == var || insn->c == var;
+
+    case I_STM:
+
+        return insn->a == var || insn->c == var;
+
+    default:
+
+        return insn->a == var || insn->b == var;
+    }
+}
+
+bool CReilDFG::is_written(dfg_insn *insn, int var)
+{
+    reil_inst_t *inst = insn->inst;
+
+    switch (inst->op)
+    {
+    case I_NONE:
+    case I_STM:
+
+        return false;
+
+    case I_UNK:
+
+        return true;
+
+    case I_JCC:
+
+        // function call might change any general purpose register or flag
+        return (inst->flags & IOPT_CALL) && (dfg_set_test(general, var) || dfg_set_test(flags, var));
+
+    default:
+
+        return insn->c == var;
+    }
+}
+
+void CReilDFG::update(dfg_insn *insn)
+{
+    insn->a = var_id(&insn->inst->a);
+    insn->b = var_id(&insn->inst->b);
+    insn->c = var_id(&insn->inst->c);
+}
+
+void CReilDFG::eliminate(dfg_insn *insn)
+{
+    reil_inst_t *inst = insn->inst;
+
+    inst->op = I_NONE;
+    inst->flags |= IOPT_ELIMINATED;
+
+    memset(&inst->a, 0, sizeof(inst->a));
+    memset(&inst->b, 0, sizeof(inst->b));
+    memset(&inst->c, 0, sizeof(inst->c));
+
+    insn->a = insn->b = insn->c = -1;
+    eliminated += 1;
+}
+
+void CReilDFG::set_arg(reil_arg_t *arg, int var, reil_size_t size)
+{
+    memset(arg, 0, sizeof(reil_arg_t));
+
+    arg->type = vars[var].type;
+    arg->size = size;
+    strcpy(arg->name, vars[var].name);
+}
+
+void CReilDFG::set_const(reil_arg_t *arg, reil_const_t val, reil_size_t size)
+{
+    memset(arg, 0, sizeof(reil_arg_t));
+
+    arg->type = A_CONST;
+    arg->size = size;
+    arg->val = val & vm_mask(size);
+}
+
+void CReilDFG::build(DFG_LOC loc)
+{
+    int count = (int)insns.size();
+
+    if ((entry = find(loc)) == -1)
+    {
+        throw CReilDFGException("Entry point instruction is not found");
+    }
+
+    vector<bool> leaders(count, false);
+
+    for (int i = 0; i < count; i++)
+    {
+        dfg_insn *insn = &insns[i];
+        reil_inst_t *inst = insn->inst;
+
+        bool next = true;
+
+        insn->succ_count = 0;
+        insn->exit = false;
+
+        if (inst->op == I_JCC && !(inst->flags & IOPT_CALL))
+        {
+            if (inst->c.type == A_CONST || inst->c.type == A_LOC)
+            {
+                int n = find(DFG_LOC(inst->c.val, inst->c.type == A_LOC ? inst->c.inum : 0));
+
+                // jump outside of the function
+                if (n == -1) insn->exit = true;
+                else insn->succ[insn->succ_count++] = n;
+            }
+            else
+            {
+                // return from function or indirect jump
+                insn->exit = true;
+            }
+
+            if ((inst->flags & IOPT_RET) || (inst->a.type == A_CONST && inst->a.val != 0))
+            {
+                // unconditional jump
+                next = false;
+            }
+        }
+
+        if (next)
+        {
+            DFG_LOC loc = (inst->flags & IOPT_ASM_END) ?
+                          DFG_LOC(inst->raw_info.addr + inst->raw_info.size, 0) :
+                          DFG_LOC(inst->raw_info.addr, inst->inum + 1);
+
+            int n = find(loc);
+
+            if (n == -1) insn->exit = true;
+            else if (insn->succ_count == 0 || insn->succ[0] != n) insn->succ[insn->succ_count++] = n;
+        }
+
+        for (int j = 0; j < insn->succ_count; j++)
+        {
+            // branch target
+            if (insn->succ[j] != i + 1) leaders[insn->succ[j]] = true;
+        }
+
+        if (i + 1 < count && (insn->exit || insn->succ_count != 1 || insn->succ[0] != i + 1))
+        {
+            // instruction after the branch
+            leaders[i + 1] = true;
+        }
+    }
+
+    if (count > 0) leaders[0] = true;
+
+    leaders[entry] = true;
+    bbs.clear();
+
+    for (int i = 0; i < count; i++)
+    {
+        if (leaders[i])
+        {
+            dfg_bb bb;
+
+            bb.first = bb.last = i;
+            bb.exit = false;
+
+            bbs.push_back(bb);
+        }
+
+        bbs.back().last = i;
+        insns[i].bb = (int)bbs.size() - 1;
+    }
+
+    for (size_t i = 0; i < bbs.size(); i++)
+    {
+        dfg_insn *insn = &insns[bbs[i].last];
+
+        bbs[i].exit = insn->exit;
+
+        for (int j = 0; j < insn->succ_count; j++)
+        {
+            int succ = insns[insn->succ[j]].bb;
+
+            bbs[i].succ.push_back(succ);
+            bbs[succ].pred.push_back((int)i);
+        }
+    }
+
+    entry = insns[entry].bb;
+}
+
+//======================================================================
+// Constant folding
+//======================================================================
+
+void CReilDFG::fold_transfer(dfg_insn *insn, vector<dfg_val> &vals)
+{
+    reil_inst_t *inst = insn->inst;
+
+    switch (inst->op)
+    {
+    case I_NONE:
+    case I_STM:
+
+        break;
+
+    case I_UNK:
+
+        for (size_t i = 0; i < vals.size(); i++) vals[i].state = DFG_NAC;
+        break;
+
+    case I_JCC:
+
+        if (inst->flags & IOPT_CALL)
+        {
+            for (vector<int>::iterator it = clobbered.begin(); it != clobbered.end(); ++it)
+            {
+                vals[*it].state = DFG_NAC;
+            }
+        }
+
+        break;
+
+    default:
+        {
+            if (insn->c == -1) break;
+
+            reil_const_t a = inst->a.val, b = inst->b.val, val = 0;
+            bool known = inst->op != I_LDM;
+
+            if (insn->a != -1)
+            {
+                known = known && vals[insn->a].state == DFG_CONST;
+                a = vals[insn->a].val;
+            }
+
+            if (insn->b != -1)
+            {
+                known = known && vals[insn->b].state == DFG_CONST;
+                b = vals[insn->b].val;
+            }
+
+            if (known && dfg_eval(inst, a, b, &val))
+            {
+                vals[insn->c].state = DFG_CONST;
+                vals[insn->c].val = val;
+            }
+            else
+            {
+                vals[insn->c].state = DFG_NAC;
+            }
+
+            break;
+        }
+    }
+}
+
+bool CReilDFG::fold_meet(vector<dfg_val> &dst, vector<dfg_val> &src)
+{
+    bool changed = false;
+
+    for (size_t i = 0; i < dst.size(); i++)
+    {
+        if (dst[i].state == DFG_CONST &&
+            (src[i].state != DFG_CONST || src[i].val != dst[i].val))
+        {
+            dst[i].state = DFG_NAC;
+            changed = true;
+        }
+    }
+
+    return changed;
+}
+
+int CReilDFG::fold_insn(dfg_insn *insn, vector<dfg_val> &vals)
+{
+    reil_inst_t *inst = insn->inst;
+    int changed = 0;
+
+    // I_JCC operands are never changed to keep control flow as is
+    if (inst->op == I_NONE || inst->op == I_UNK || inst->op == I_JCC)
+    {
+        return 0;
+    }
+
+    reil_arg_t *src[] = { &inst->a, inst->op == I_STM ? &inst->c : &inst->b };
+    int vars_src[] = { insn->a, inst->op == I_STM ? insn->c : insn->b };
+
+    for (int n = 0; n < 2; n++)
+    {
+        int var = vars_src[n];
+
+        if (var != -1 && vals[var].state == DFG_CONST)
+        {
+            // propagate constant value into the operand
+            set_const(src[n], vals[var].val, src[n]->size);
+            changed += 1;
+        }
+    }
+
+    if (changed > 0) update(insn);
+
+    if (is_pure(inst) && inst->op != I_LDM && inst->op != I_STR &&
+        inst->a.type == A_CONST && (inst->b.type == A_CONST || inst->b.type == A_NONE))
+    {
+        reil_const_t val = 0;
+
+        if (dfg_eval(inst, inst->a.val, inst->b.val, &val))
+        {
+            // replace constant expression with it's value
+            inst->op = I_STR;
+
+            set_const(&inst->a, val, inst->c.size);
+            memset(&inst->b, 0, sizeof(inst->b));
+
+            update(insn);
+            changed += 1;
+        }
+    }
+
+    return changed;
+}
+
+int CReilDFG::constant_folding()
+{
+    int changed = 0;
+
+    // state at the beginning of each reached basic block
+    vector<vector<dfg_val> > input(bbs.size());
+    vector<int> pending;
+    vector<bool> queued(bbs.size(), false);
+
+    dfg_val nac;
+
+    nac.state = DFG_NAC;
+    nac.val = 0;
+
+    // values of all variables at the function entry are unknown
+    input[entry].assign(vars.size(), nac);
+    pending.push_back(entry);
+    queued[entry] = true;
+
+    while (!pending.empty())
+    {
+        int n = pending.back();
+        vector<dfg_val> vals = input[n];
+
+        pending.pop_back();
+        queued[n] = false;
+
+        for (int i = bbs[n].first; i <= bbs[n].last; i++)
+        {
+            fold_transfer(&insns[i], vals);
+        }
+
+        for (vector<int>::iterator it = bbs[n].succ.begin(); it != bbs[n].succ.end(); ++it)
+        {
+            bool updated = false;
+
+            if (input[*it].empty())
+            {
+                // successor was reached for the first time
+                input[*it] = vals;
+                updated = true;
+            }
+            else
+            {
+                updated = fold_meet(input[*it], vals);
+            }
+
+            if (updated && !queued[*it])
+            {
+                pending.push_back(*it);
+                queued[*it] = true;
+            }
+        }
+    }
+
+    for (size_t n = 0; n < bbs.size(); n++)
+    {
+        // unreached code is left as is
+        if (input[n].empty()) continue;
+
+        vector<dfg_val> &vals = input[n];
+
+        for (int i = bbs[n].first; i <= bbs[n].last; i++)
+        {
+            changed += fold_insn(&insns[i], vals);
+            fold_transfer(&insns[i], vals);
+        }
+    }
+
+    return changed;
+}
+
+//======================================================================
+// Common subexpression elimination
+//======================================================================
+
+int CReilDFG::coalesce_temps(dfg_bb *bb)
+{
+    int changed = 0;
+
+    for (int i = bb->first; i <= bb->last; i++)
+    {
+        dfg_insn *insn = &insns[i];
+        int temp = insn->c, j = 0;
+
+        if (!is_pure(insn->inst) || vars[temp].type != A_TEMP)
+        {
+            continue;
+        }
+
+        // find the first instruction that reads temporary register
+        for (j = i + 1; j <= bb->last; j++)
+        {
+            if (is_read(&insns[j], temp) || is_written(&insns[j], temp)) break;
+        }
+
+        if (j > bb->last || !is_read(&insns[j], temp))
+        {
+            continue;
+        }
+
+        dfg_insn *insn_str = &insns[j];
+        reil_inst_t *inst_str = insn_str->inst;
+        int reg = insn_str->c;
+
+        if (inst_str->op != I_STR || insn_str->a != temp || reg == -1 || vars[reg].type != A_REG ||
+            inst_str->a.size != insn->inst->c.size || inst_str->c.size != insn->inst->c.size)
+        {
+            continue;
+        }
+
+        bool live = true, used = false;
+
+        // temporary register must not be used after I_STR
+        for (int k = j + 1; k <= bb->last; k++)
+        {
+            if (is_read(&insns[k], temp)) { used = true; break; }
+            if (is_written(&insns[k], temp)) { live = false; break; }
+        }
+
+        if (used || (live && dfg_set_test(live_out[insn->bb], temp)))
+        {
+            continue;
+        }
+
+        // register must not be accessed between instructions
+        for (int k = i + 1; k < j; k++)
+        {
+            if (is_read(&insns[k], reg) || is_written(&insns[k], reg)) { used = true; break; }
+        }
+
+        if (used) continue;
+
+        set_arg(&insn->inst->c, reg, inst_str->c.size);
+        update(insn);
+
+        eliminate(insn_str);
+        changed += 1;
+    }
+
+    return changed;
+}
+
+int CReilDFG::eliminate_subexpressions()
+{
+    int changed = 0;
+
+    for (size_t n = 0; n < bbs.size(); n++)
+    {
+        dfg_numbering num;
+
+        num.vars.assign(vars.size(), -1);
+        num.sizes.assign(vars.size(), -1);
+        num.mem = 0;
+
+        for (int i = bbs[n].first; i <= bbs[n].last; i++)
+        {
+            dfg_insn *insn = &insns[i];
+            reil_inst_t *inst = insn->inst;
+
+            if (inst->op == I_NONE)
+            {
+                continue;
+            }
+            else if (inst->op == I_UNK)
+            {
+                // unknown instruction might change any variable or memory
+                num.vars.assign(vars.size(), -1);
+                num.mem += 1;
+                continue;
+            }
+
+            reil_arg_t *src[] = { &inst->a, NULL };
+            int vars_src[] = { insn->a, -1 };
+
+            // I_JCC target is never changed
+            if (inst->op == I_STM) { src[1] = &inst->c; vars_src[1] = insn->c; }
+            else if (inst->op != I_JCC) { src[1] = &inst->b; vars_src[1] = insn->b; }
+
+            for (int k = 0; k < 2; k++)
+            {
+                int var = vars_src[k];
+
+                if (var == -1 || vars[var].type != A_TEMP) continue;
+
+                int val = num.get(var, src[k]->size), holder = -1;
+
+                // find register or the first temporary register that has the same value
+                for (vector<int>::iterator it = num.holders[val].begin(); it != num.holders[val].end(); ++it)
+                {
+                    if (num.vars[*it] != val || num.sizes[*it] != src[k]->size) continue;
+
+                    if (holder == -1 || vars[*it].type == A_REG) holder = *it;
+                    if (vars[holder].type == A_REG) break;
+                }
+
+                if (holder != -1 && holder != var)
+                {
+                    set_arg(src[k], holder, src[k]->size);
+                    changed += 1;
+                }
+            }
+
+            update(insn);
+
+            if (inst->op == I_JCC)
+            {
+                if (inst->flags & IOPT_CALL)
+                {
+                    for (vector<int>::iterator it = clobbered.begin(); it != clobbered.end(); ++it)
+                    {
+                        num.vars[*it] = -1;
+                    }
+
+                    num.mem += 1;
+                }
+
+                continue;
+            }
+            else if (inst->op == I_STM)
+            {
+                num.mem += 1;
+                continue;
+            }
+            else if (insn->c == -1)
+            {
+                continue;
+            }
+
+            reil_arg_t *args[] = { &inst->a, &inst->b };
+            int vals[] = { -1, -1 };
+
+            for (int k = 0; k < 2; k++)
+            {
+                int var = k == 0 ? insn->a : insn->b;
+
+                if (var != -1)
+                {
+                    vals[k] = num.get(var, args[k]->size);
+                }
+                else if (args[k]->type == A_CONST)
+                {
+                    pair<reil_const_t, int> key(args[k]->val & vm_mask(args[k]->size), args[k]->size);
+                    map<pair<reil_const_t, int>, int>::iterator it = num.consts.find(key);
+
+                    vals[k] = it != num.consts.end() ? it->second : (num.consts[key] = num.fresh());
+                }
+            }
+
+            int val = -1;
+
+            if (inst->op == I_STR && vals[0] != -1 &&
+                inst->a.size == inst->c.size)
+            {
+                // copy has the value of it's source
+                val = vals[0];
+            }
+            else if (vals[0] != -1 && (vals[1] != -1 || inst->b.type == A_NONE))
+            {
+                dfg_expr expr;
+
+                memset(&expr, 0, sizeof(expr));
+
+                expr.op = inst->op;
+                expr.a = vals[0];
+                expr.b = vals[1];
+                expr.size_a = inst->a.size;
+                expr.size_b = inst->b.type == A_NONE ? -1 : inst->b.size;
+                expr.size_c = inst->c.size;
+
+                // loaded value depends on memory contents
+                expr.mem = inst->op == I_LDM ? num.mem : 0;
+
+                if (dfg_is_commutative(inst->op) && expr.size_a == expr.size_b && expr.a > expr.b)
+                {
+                    swap(expr.a, expr.b);
+                }
+
+                map<dfg_expr, int>::iterator it = num.exprs.find(expr);
+
+                if (it != num.exprs.end())
+                {
+                    int holder = -1;
+
+                    val = it->second;
+
+                    for (vector<int>::iterator it = num.holders[val].begin(); it != num.holders[val].end(); ++it)
+                    {
+                        if (num.vars[*it] == val && num.sizes[*it] == inst->c.size) { holder = *it; break; }
+                    }
+
+                    if (holder != -1 && holder != insn->c)
+                    {
+                        // value was already computed, copy it from the variable
+                        inst->op = I_STR;
+
+                        set_arg(&inst->a, holder, inst->c.size);
+                        memset(&inst->b, 0, sizeof(inst->b));
+
+                        update(insn);
+                        changed += 1;
+                    }
+                }
+                else
+                {
+                    val = num.exprs[expr] = num.fresh();
+                }
+            }
+
+            if (val == -1)
+            {
+                val = num.fresh();
+            }
+            else if (num.vars[insn->c] == val)
+            {
+                // variable already has this value
+                eliminate(insn);
+                changed += 1;
+                continue;
+            }
+
+            num.set(insn->c, val, inst->c.size);
+        }
+    }
+
+    // live variables are needed to find temporary registers that can be replaced
+    liveness();
+
+    for (size_t n = 0; n < bbs.size(); n++)
+    {
+        changed += coalesce_temps(&bbs[n]);
+    }
+
+    return changed;
+}
+
+//======================================================================
+// Dead code elimination
+//======================================================================
+
+bool CReilDFG::live_transfer(dfg_insn *insn, dfg_set &live, bool eliminate)
+{
+    reil_inst_t *inst = insn->inst;
+
+    switch (inst->op)
+    {
+    case I_NONE:
+
+        return false;
+
+    case I_UNK:
+
+        for (size_t i = 0; i < live.size(); i++) live[i] = ~0ULL;
+        return false;
+
+    case I_JCC:
+
+        // called function is reading general purpose registers
+        if (inst->flags & IOPT_CALL) dfg_set_union(live, general);
+
+        if (insn->a != -1) dfg_set_add(live, insn->a);
+        if (insn->c != -1) dfg_set_add(live, insn->c);
+        return false;
+
+    case I_STM:
+
+        if (insn->a != -1) dfg_set_add(live, insn->a);
+        if (insn->c != -1) dfg_set_add(live, insn->c);
+        return false;
+
+    default:
+
+        if (insn->c == -1)
+        {
+            return false;
+        }
+
+        if (!dfg_set_test(live, insn->c))
+        {
+            // operands of dead instruction are not live
+            if (eliminate) this->eliminate(insn);
+
+            return eliminate;
+        }
+
+        dfg_set_del(live, insn->c);
+
+        if (insn->a != -1) dfg_set_add(live, insn->a);
+        if (insn->b != -1) dfg_set_add(live, insn->b);
+        return false;
+    }
+}
+
+void CReilDFG::liveness()
+{
+    int words = ((int)vars.size() + 63) / 64;
+
+    dfg_set exit_live(words, 0);
+    vector<dfg_set> live_in(bbs.size(), dfg_set(words, 0));
+    vector<int> pending;
+    vector<bool> queued(bbs.size(), true);
+
+    for (size_t i = 0; i < vars.size(); i++)
+    {
+        // registers are live at the end of the function, temporary registers are not
+        if (vars[i].type == A_REG && (keep_flags || !dfg_set_test(flags, (int)i)))
+        {
+            dfg_set_add(exit_live, (int)i);
+        }
+    }
+
+    live_out.assign(bbs.size(), dfg_set(words, 0));
+
+    // the last blocks are visited first to reach fixed point faster
+    for (size_t n = 0; n < bbs.size(); n++) pending.push_back((int)n);
+
+    while (!pending.empty())
+    {
+        int n = pending.back();
+        dfg_set live(words, 0);
+
+        pending.pop_back();
+        queued[n] = false;
+
+        if (bbs[n].exit) live = exit_live;
+
+        for (vector<int>::iterator it = bbs[n].succ.begin(); it != bbs[n].succ.end(); ++it)
+        {
+            dfg_set_union(live, live_in[*it]);
+        }
+
+        live_out[n] = live;
+
+        for (int i = bbs[n].last; i >= bbs[n].first; i--)
+        {
+            live_transfer(&insns[i], live, false);
+        }
+
+        if (live != live_in[n])
+        {
+            live_in[n] = live;
+
+            for (vector<int>::iterator it = bbs[n].pred.begin(); it != bbs[n].pred.end(); ++it)
+            {
+                if (!queued[*it])
+                {
+                    pending.push_back(*it);
+                    queued[*it] = true;
+                }
+            }
+        }
+    }
+}
+
+int CReilDFG::eliminate_dead_code()
+{
+    int changed = 0;
+
+    liveness();
+
+    for (size_t n = 0; n < bbs.size(); n++)
+    {
+        dfg_set live = live_out[n];
+
+        for (int i = bbs[n].last; i >= bbs[n].first; i--)
+        {
+            if (live_transfer(&insns[i], live, true)) changed += 1;
+        }
+    }
+
+    return changed;
+}
+
+int CReilDFG::optimize(DFG_LOC loc, int options)
+{
+    build(loc);
+
+    keep_flags = (options & REIL_DFG_KEEP_FLAGS) != 0;
+    eliminated = 0;
+
+    for (int i = 0; i < DFG_MAX_PASSES; i++)
+    {
+        int changed = 0;
+
+        if (options & REIL_DFG_FOLD_CONST) changed += constant_folding();
+        if (options & REIL_DFG_ELIM_SUBEXP) changed += eliminate_subexpressions();
+        if (options & REIL_DFG_ELIM_DEAD) changed += eliminate_dead_code();
+
+        // repeat untill nothing changes
+        if (changed == 0) break;
+    }
+
+    return eliminated;
+}
+
+//======================================================================
+// C API
+//======================================================================
+
+extern "C" int reil_dfg_optimize(reil_arch_t arch, reil_inst_t *insts, int count,
+                                 reil_addr_t addr, reil_inum_t inum, int options)
+{
+    try
+    {
+        CReilDFG dfg(arch, insts, count);
+
+        return dfg.optimize(DFG_LOC(addr, inum), options);
+    }
+    catch (CReilDFGException e)
+    {
+        fprintf(stderr, "reil_dfg_optimize() ERROR: %s\n", e.reason.c_str());
+    }
+
+    return REIL_ERROR;
+}
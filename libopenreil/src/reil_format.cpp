@@ -0,0 +1,466 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+// OpenREIL includes
+#include "libopenreil.h"
+
+// defined in reil_translator.cpp
+extern const char *reil_inst_name[];
+
+// max. length of formatted operand
+#define MAX_ARG_LEN 0x40
+
+/*
+    Output buffer, all of the functions below are writing into the caller
+    specified memory without any heap allocations. Overflow flag is set
+    when there's no enough space in the buffer.
+*/
+typedef struct _out_buff
+{
+    char *ptr;
+    char *end;
+    bool overflow;
+
+} out_buff;
+
+static const char hex_chars[] = "0123456789abcdef";
+
+static const char base64_chars[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static inline void out_init(out_buff *out, char *buff, int len)
+{
+    out->ptr = buff;
+    out->end = buff + len - 1; // reserve space for terminating zero
+    out->overflow = false;
+}
+
+static inline int out_finish(out_buff *out, char *buff)
+{
+    if (out->overflow)
+    {
+        return REIL_ERROR;
+    }
+
+    *out->ptr = '\0';
+
+    return (int)(out->ptr - buff);
+}
+
+static inline void out_char(out_buff *out, char c)
+{
+    if (out->ptr < out->end) *out->ptr++ = c; else out->overflow = true;
+}
+
+static inline void out_mem(out_buff *out, const char *str, size_t len)
+{
+    if (out->ptr + len <= out->end)
+    {
+        memcpy(out->ptr, str, len);
+        out->ptr += len;
+    }
+    else
+    {
+        out->overflow = true;
+    }
+}
+
+static inline void out_str(out_buff *out, const char *str)
+{
+    out_mem(out, str, strlen(str));
+}
+
+static inline void out_pad(out_buff *out, int count)
+{
+    while (count-- > 0) out_char(out, ' ');
+}
+
+static void out_dec(out_buff *out, unsigned long long val)
+{
+    char digits[0x20];
+    int n = 0;
+
+    do
+    {
+        digits[n++] = '0' + (char)(val % 10);
+        val /= 10;
+    }
+    while (val != 0);
+
+    while (n > 0) out_char(out, digits[--n]);
+}
+
+static void out_hex(out_buff *out, unsigned long long val, int width)
+{
+    char digits[0x20];
+    int n = 0;
+
+    do
+    {
+        digits[n++] = hex_chars[val & 0xf];
+        val >>= 4;
+    }
+    while (val != 0);
+
+    // pad value with zeros just like printf("%.8x") does
+    while (n < width) digits[n++] = '0';
+    while (n > 0) out_char(out, digits[--n]);
+}
+
+static void out_json_str(out_buff *out, const char *str)
+{
+    out_char(out, '"');
+
+    for (; *str != '\0'; str++)
+    {
+        unsigned char c = (unsigned char)*str;
+
+        if (c == '"' || c == '\\')
+        {
+            out_char(out, '\\');
+            out_char(out, c);
+        }
+        else if (c < 0x20)
+        {
+            out_mem(out, "\\u00", 4);
+            out_char(out, hex_chars[c >> 4]);
+            out_char(out, hex_chars[c & 0xf]);
+        }
+        else
+        {
+            out_char(out, c);
+        }
+    }
+
+    out_char(out, '"');
+}
+
+static void out_json_name(out_buff *out, const char *name)
+{
+    if (name)
+    {
+        out_json_str(out, name);
+    }
+    else
+    {
+        out_mem(out, "null", 4);
+    }
+}
+
+static void out_base64(out_buff *out, const unsigned char *data, int len)
+{
+    for (int i = 0; i < len; i += 3)
+    {
+        uint32_t val = data[i] << 16;
+
+        if (i + 1 < len) val |= data[i + 1] << 8;
+        if (i + 2 < len) val |= data[i + 2];
+
+        out_char(out, base64_chars[(val >> 18) & 0x3f]);
+        out_char(out, base64_chars[(val >> 12) & 0x3f]);
+        out_char(out, i + 1 < len ? base64_chars[(val >> 6) & 0x3f] : '=');
+        out_char(out, i + 2 < len ? base64_chars[val & 0x3f] : '=');
+    }
+}
+
+static const char *size_name(reil_size_t size)
+{
+    switch (size)
+    {
+    case U1: return "1";
+    case U8: return "8";
+    case U16: return "16";
+    case U32: return "32";
+    case U64: return "64";
+    }
+
+    return "?";
+}
+
+static unsigned long long const_val(reil_const_t val, reil_size_t size)
+{
+    switch (size)
+    {
+    case U1: return val == 0 ? 0 : 1;
+    case U8: return (uint8_t)val;
+    case U16: return (uint16_t)val;
+    case U32: return (uint32_t)val;
+    case U64: return (uint64_t)val;
+    }
+
+    return val;
+}
+
+static void out_arg(out_buff *out, reil_arg_t *arg)
+{
+    switch (arg->type)
+    {
+    case A_NONE:
+
+        out_char(out, ' ');
+        break;
+
+    case A_REG:
+    case A_TEMP:
+
+        out_char(out, '(');
+        out_str(out, arg->name);
+        out_mem(out, ", ", 2);
+        out_str(out, size_name(arg->size));
+        out_char(out, ')');
+        break;
+
+    case A_CONST:
+
+        out_char(out, '(');
+        out_dec(out, const_val(arg->val, arg->size));
+        out_mem(out, ", ", 2);
+        out_str(out, size_name(arg->size));
+        out_char(out, ')');
+        break;
+
+    case A_LOC:
+
+        out_dec(out, (uint32_t)arg->val);
+        out_char(out, '.');
+        out_dec(out, (uint8_t)arg->inum);
+        break;
+    }
+}
+
+// right-aligned operand, just like printf("%16s") does
+static void out_arg_aligned(out_buff *out, reil_arg_t *arg, int width)
+{
+    char buff[MAX_ARG_LEN];
+    out_buff arg_out;
+
+    out_init(&arg_out, buff, sizeof(buff));
+    out_arg(&arg_out, arg);
+
+    int len = (int)(arg_out.ptr - buff);
+
+    out_pad(out, width - len);
+    out_mem(out, buff, len);
+
+    out->overflow |= arg_out.overflow;
+}
+
+static void out_json_arg(out_buff *out, reil_arg_t *arg)
+{
+    // the same format as Arg.serialize() uses
+    switch (arg->type)
+    {
+    case A_NONE:
+
+        out_mem(out, "[]", 2);
+        break;
+
+    case A_REG:
+    case A_TEMP:
+
+        out_char(out, '[');
+        out_dec(out, arg->type);
+        out_mem(out, ", ", 2);
+        out_dec(out, arg->size);
+        out_mem(out, ", ", 2);
+        out_json_str(out, arg->name);
+        out_char(out, ']');
+        break;
+
+    case A_CONST:
+
+        out_char(out, '[');
+        out_dec(out, arg->type);
+        out_mem(out, ", ", 2);
+        out_dec(out, arg->size);
+        out_mem(out, ", ", 2);
+        out_dec(out, arg->val);
+        out_char(out, ']');
+        break;
+
+    case A_LOC:
+
+        out_char(out, '[');
+        out_dec(out, arg->type);
+        out_mem(out, ", [", 3);
+        out_dec(out, arg->val);
+        out_mem(out, ", ", 2);
+        out_dec(out, arg->inum);
+        out_mem(out, "]]", 2);
+        break;
+    }
+}
+
+// counter, source and destination pointers, value and direction registers
+static const char *rep_x86_regs[] = { "R_ECX", "R_ESI", "R_EDI", "R_EAX", "R_DFLAG" };
+
+extern "C" int reil_rep_info(reil_arch_t arch, unsigned long long flags, reil_vm_rep_t *rep)
+{
+    const char **regs = NULL;
+
+    if (!(flags & IOPT_REP))
+    {
+        return REIL_ERROR;
+    }
+
+    switch (arch)
+    {
+    case ARCH_X86: regs = rep_x86_regs; break;
+    default: return REIL_ERROR;
+    }
+
+    rep->op = (reil_vm_rep_op_t)IOPT_REP_OP(flags);
+    rep->cond = (reil_vm_rep_cond_t)IOPT_REP_COND(flags);
+    rep->size = IOPT_REP_SIZE(flags);
+
+    // MOVS and CMPS are using source pointer, STOS and SCAS are using value register
+    bool src = rep->op == REIL_VM_REP_MOVS || rep->op == REIL_VM_REP_CMPS;
+
+    rep->count = regs[0];
+    rep->src = src ? regs[1] : NULL;
+    rep->dst = regs[2];
+    rep->val = src ? NULL : regs[3];
+    rep->dir = regs[4];
+
+    return 0;
+}
+
+extern "C" int reil_inst_to_str(reil_inst_t *inst, char *buff, int len)
+{
+    out_buff out;
+
+    if (buff == NULL || len <= 0 || inst->op > I_LT)
+    {
+        return REIL_ERROR;
+    }
+
+    out_init(&out, buff, len);
+
+    // the same format as reil_inst_print() used to produce with printf()
+    out_hex(&out, inst->raw_info.addr, 8);
+    out_char(&out, '.');
+    out_hex(&out, inst->inum, 2);
+    out_char(&out, ' ');
+
+    const char *name = reil_inst_name[inst->op];
+
+    out_pad(&out, 7 - (int)strlen(name));
+    out_str(&out, name);
+    out_char(&out, ' ');
+
+    out_arg_aligned(&out, &inst->a, 16);
+    out_mem(&out, ", ", 2);
+    out_arg_aligned(&out, &inst->b, 16);
+    out_mem(&out, ", ", 2);
+    out_arg_aligned(&out, &inst->c, 16);
+    out_mem(&out, "  ", 2);
+
+    return out_finish(&out, buff);
+}
+
+extern "C" int reil_inst_to_json(reil_arch_t arch, reil_inst_t *inst, char *buff, int len)
+{
+    out_buff out;
+    reil_vm_rep_t rep;
+    bool attr = false;
+
+    if (buff == NULL || len <= 0)
+    {
+        return REIL_ERROR;
+    }
+
+    out_init(&out, buff, len);
+
+    // address, size, inum and opcode
+    out_mem(&out, "[[", 2);
+    out_dec(&out, inst->raw_info.addr);
+    out_mem(&out, ", ", 2);
+    out_dec(&out, inst->raw_info.size);
+    out_mem(&out, "], ", 3);
+    out_dec(&out, inst->inum);
+    out_mem(&out, ", ", 2);
+    out_dec(&out, inst->op);
+
+    // arguments
+    out_mem(&out, ", [", 3);
+    out_json_arg(&out, &inst->a);
+    out_mem(&out, ", ", 2);
+    out_json_arg(&out, &inst->b);
+    out_mem(&out, ", ", 2);
+    out_json_arg(&out, &inst->c);
+
+    // attributes as list of key-value pairs, see InsnJson.to_json()
+    out_mem(&out, "], [", 4);
+
+    if (inst->flags & ~IOPT_REP_MASK)
+    {
+        out_char(&out, '[');
+        out_dec(&out, REIL_IATTR_FLAGS);
+        out_mem(&out, ", ", 2);
+        out_dec(&out, inst->flags & ~IOPT_REP_MASK);
+        out_char(&out, ']');
+
+        attr = true;
+    }
+
+    if (reil_rep_info(arch, inst->flags, &rep) == 0)
+    {
+        const char *regs[] = { rep.count, rep.src, rep.dst, rep.val, rep.dir };
+
+        if (attr) out_mem(&out, ", ", 2);
+
+        // IOPT_REP_* fields and registers that are used by operation
+        out_char(&out, '[');
+        out_dec(&out, REIL_IATTR_REP);
+        out_mem(&out, ", [", 3);
+        out_dec(&out, rep.op);
+        out_mem(&out, ", ", 2);
+        out_dec(&out, rep.size);
+        out_mem(&out, ", ", 2);
+        out_dec(&out, rep.cond);
+
+        for (size_t i = 0; i < sizeof(regs) / sizeof(regs[0]); i++)
+        {
+            out_mem(&out, ", ", 2);
+            out_json_name(&out, regs[i]);
+        }
+
+        out_mem(&out, "]]", 2);
+
+        attr = true;
+    }
+
+    if (inst->inum == 0 && inst->raw_info.data != NULL)
+    {
+        if (attr) out_mem(&out, ", ", 2);
+
+        // instruction bytes are encoded with base64
+        out_char(&out, '[');
+        out_dec(&out, REIL_IATTR_BIN);
+        out_mem(&out, ", \"", 3);
+        out_base64(&out, inst->raw_info.data, inst->raw_info.size);
+        out_mem(&out, "\"]", 2);
+
+        attr = true;
+    }
+
+    if (inst->inum == 0 && inst->raw_info.str_mnem != NULL && inst->raw_info.str_op != NULL)
+    {
+        if (attr) out_mem(&out, ", ", 2);
+
+        // assembly instruction mnemonic and operands
+        out_char(&out, '[');
+        out_dec(&out, REIL_IATTR_ASM);
+        out_mem(&out, ", [", 3);
+        out_json_str(&out, inst->raw_info.str_mnem);
+        out_mem(&out, ", ", 2);
+        out_json_str(&out, inst->raw_info.str_op);
+        out_mem(&out, "]]", 2);
+    }
+
+    out_mem(&out, "]]", 2);
+
+    return out_finish(&out, buff);
+}
@@ -0,0 +1,448 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <string>
+#include <deque>
+#include <vector>
+#include <map>
+#include <set>
+
+#if defined(__x86_64__) && !defined(_WIN32)
+#include <sys/mman.h>
+#endif
+
+using namespace std;
+
+// OpenREIL includes
+#include "libopenreil.h"
+#include "reil_mem.h"
+#include "reil_vm.h"
+#include "reil_jit.h"
+
+/*
+    JIT compiler for native REIL interpreter. Linear sequence of IR instructions
+    that starts from hot instruction is compiled into x86_64 code that works
+    with the same register values as interpreter, compiled code replaces the
+    handler of the first instruction. Simple arithmetic and logic instructions
+    are translated directly, any other instructions (memory access, signed
+    arithmetic, invalid instructions) are executed by calling their interpreter
+    handlers. Last instruction of the block is always executed by it's handler,
+    so compiled block follows the same contract as any other handler: it
+    returns the next instruction or NULL with vm_state describing the error
+    or unresolved location, vm_state::exit is set to the instruction that
+    returned NULL.
+
+    Generated code keeps vm_state pointer in RBX, operands are loaded into RAX
+    and RCX, RDX is used as scratch register.
+*/
+
+#ifdef VM_JIT_SUPPORTED
+
+static inline bool jit_is_imm(vm_insn *insn, reil_const_t *val)
+{
+    return val == &insn->imm_a || val == &insn->imm_b || val == &insn->imm_c;
+}
+
+CReilJIT::CReilJIT(reil_const_t *ip, reil_const_t ip_mask, unsigned long long *executed, vm_insn **exit)
+{
+    this->ip = ip;
+    this->ip_mask = ip_mask;
+    this->executed = executed;
+    this->exit = exit;
+
+    code_used = 0;
+
+    void *mem = mmap(NULL, VM_JIT_CODE_SIZE, PROT_READ | PROT_WRITE | PROT_EXEC,
+                     MAP_PRIVATE | MAP_ANON, -1, 0);
+
+    // JIT is not available when executable memory can't be allocated
+    code = mem == MAP_FAILED ? NULL : (uint8_t *)mem;
+}
+
+CReilJIT::~CReilJIT()
+{
+    flush();
+
+    if (code) munmap(code, VM_JIT_CODE_SIZE);
+}
+
+void CReilJIT::emit_u32(uint32_t val)
+{
+    for (int i = 0; i < 4; i++) emit_u8((uint8_t)(val >> (i * 8)));
+}
+
+void CReilJIT::emit_u64(uint64_t val)
+{
+    for (int i = 0; i < 8; i++) emit_u8((uint8_t)(val >> (i * 8)));
+}
+
+void CReilJIT::emit_bytes(const char *data, int size)
+{
+    buff.insert(buff.end(), (const uint8_t *)data, (const uint8_t *)data + size);
+}
+
+void CReilJIT::emit_mov_imm(reil_const_t val)
+{
+    if (val == 0)
+    {
+        // xor eax, eax
+        emit_bytes("\x31\xc0", 2);
+    }
+    else if (val <= 0xffffffff)
+    {
+        // mov eax, imm32
+        emit_u8(0xb8);
+        emit_u32((uint32_t)val);
+    }
+    else
+    {
+        // mov rax, imm64
+        emit_bytes("\x48\xb8", 2);
+        emit_u64(val);
+    }
+}
+
+void CReilJIT::emit_mask(reil_const_t mask)
+{
+    switch (mask)
+    {
+    case 0xffffffffffffffffULL:
+
+        break;
+
+    case 0xffffffff:
+
+        // mov eax, eax
+        emit_bytes("\x89\xc0", 2);
+        break;
+
+    case 0xffff:
+
+        // movzx eax, ax
+        emit_bytes("\x0f\xb7\xc0", 3);
+        break;
+
+    case 0xff:
+
+        // movzx eax, al
+        emit_bytes("\x0f\xb6\xc0", 3);
+        break;
+
+    case 0x1:
+
+        // and eax, 1
+        emit_bytes("\x83\xe0\x01", 3);
+        break;
+
+    default:
+
+        // mov rdx, imm64 ; and rax, rdx
+        emit_bytes("\x48\xba", 2);
+        emit_u64(mask);
+        emit_bytes("\x48\x21\xd0", 3);
+        break;
+    }
+}
+
+void CReilJIT::emit_load(vm_insn *insn, reil_const_t *val, reil_const_t mask)
+{
+    if (jit_is_imm(insn, val))
+    {
+        emit_mov_imm(*val & mask);
+        return;
+    }
+
+    // mov rax, [moffs64]
+    emit_bytes("\x48\xa1", 2);
+    emit_u64((uint64_t)val);
+
+    emit_mask(mask);
+}
+
+void CReilJIT::emit_store(reil_const_t *val)
+{
+    // mov [moffs64], rax
+    emit_bytes("\x48\xa3", 2);
+    emit_u64((uint64_t)val);
+}
+
+void CReilJIT::emit_ip(reil_addr_t addr)
+{
+    emit_mov_imm(addr & ip_mask);
+    emit_store(ip);
+}
+
+void CReilJIT::emit_executed(int count)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    // mov rax, imm64 ; add qword [rax], imm32
+    emit_bytes("\x48\xb8", 2);
+    emit_u64((uint64_t)executed);
+    emit_bytes("\x48\x81\x00", 3);
+    emit_u32(count);
+}
+
+void CReilJIT::emit_call(vm_insn *insn)
+{
+    // mov rdi, rbx ; mov rsi, imm64 ; mov rax, imm64
+    emit_bytes("\x48\x89\xdf", 3);
+    emit_bytes("\x48\xbe", 2);
+    emit_u64((uint64_t)insn);
+    emit_bytes("\x48\xb8", 2);
+    emit_u64((uint64_t)insn->exec);
+}
+
+bool CReilJIT::emit_insn(vm_insn *insn)
+{
+    bool has_b = false;
+
+    switch (insn->op)
+    {
+    case I_STR:
+    case I_NEG:
+    case I_NOT:
+
+        break;
+
+    case I_ADD:
+    case I_SUB:
+    case I_MUL:
+    case I_DIV:
+    case I_MOD:
+    case I_SHL:
+    case I_SHR:
+    case I_AND:
+    case I_OR:
+    case I_XOR:
+    case I_EQ:
+    case I_LT:
+
+        has_b = true;
+        break;
+
+    default:
+
+        return false;
+    }
+
+    if (jit_is_imm(insn, insn->c))
+    {
+        // invalid instruction, let the interpreter to report an error
+        return false;
+    }
+
+    if (has_b)
+    {
+        // mov rcx, rax
+        emit_load(insn, insn->b, insn->mask_b);
+        emit_bytes("\x48\x89\xc1", 3);
+    }
+
+    emit_load(insn, insn->a, insn->mask_a);
+
+    switch (insn->op)
+    {
+    case I_STR: break;
+
+    case I_ADD: emit_bytes("\x48\x01\xc8", 3); break;     // add rax, rcx
+    case I_SUB: emit_bytes("\x48\x29\xc8", 3); break;     // sub rax, rcx
+    case I_MUL: emit_bytes("\x48\x0f\xaf\xc1", 4); break; // imul rax, rcx
+    case I_AND: emit_bytes("\x48\x21\xc8", 3); break;     // and rax, rcx
+    case I_OR:  emit_bytes("\x48\x09\xc8", 3); break;     // or rax, rcx
+    case I_XOR: emit_bytes("\x48\x31\xc8", 3); break;     // xor rax, rcx
+    case I_NOT: emit_bytes("\x48\xf7\xd0", 3); break;     // not rax
+    case I_NEG: emit_bytes("\x48\xf7\xd8", 3); break;     // neg rax
+
+    case I_EQ:
+
+        // cmp rax, rcx ; sete al ; movzx eax, al
+        emit_bytes("\x48\x39\xc8\x0f\x94\xc0\x0f\xb6\xc0", 9);
+        break;
+
+    case I_LT:
+
+        // cmp rax, rcx ; setb al ; movzx eax, al
+        emit_bytes("\x48\x39\xc8\x0f\x92\xc0\x0f\xb6\xc0", 9);
+        break;
+
+    case I_SHL:
+    case I_SHR:
+
+        // shl/shr rax, cl
+        emit_bytes(insn->op == I_SHL ? "\x48\xd3\xe0" : "\x48\xd3\xe8", 3);
+
+        // result is zero when shift count is 64 or more:
+        // cmp rcx, 64 ; sbb rdx, rdx ; and rax, rdx
+        emit_bytes("\x48\x83\xf9\x40\x48\x19\xd2\x48\x21\xd0", 10);
+        break;
+
+    case I_DIV:
+    case I_MOD:
+
+        // result is zero on division by zero:
+        // test rcx, rcx ; jnz $+4 ; xor eax, eax ; jmp done
+        emit_bytes("\x48\x85\xc9\x75\x04\x31\xc0\xeb", 8);
+        emit_u8(insn->op == I_DIV ? 5 : 8);
+
+        // xor edx, edx ; div rcx
+        emit_bytes("\x31\xd2\x48\xf7\xf1", 5);
+
+        // mov rax, rdx
+        if (insn->op == I_MOD) emit_bytes("\x48\x89\xd0", 3);
+
+        break;
+
+    default:
+
+        return false;
+    }
+
+    emit_mask(insn->mask_c);
+    emit_store(insn->c);
+
+    return true;
+}
+
+bool CReilJIT::compile(vm_insn *entry)
+{
+    vector<vm_insn *> insns;
+    vector<pair<size_t, int> > exits;
+
+    if (code == NULL)
+    {
+        return true;
+    }
+
+    // collect linear sequence of instructions
+    for (vm_insn *insn = entry; ; insn = insn->next)
+    {
+        insns.push_back(insn);
+
+        // instructions with execution events and rep-prefixed instructions are checked by interpreter
+        if (insn->op == I_JCC || insn->next == NULL || insn->next->stop || insn->next->events ||
+            insn->next->rep || insn->next == entry || insns.size() >= VM_JIT_MAX_INSNS)
+        {
+            break;
+        }
+    }
+
+    if (insns.size() < 2)
+    {
+        // nothing to compile
+        return true;
+    }
+
+    buff.clear();
+
+    // push rbx ; mov rbx, rdi
+    emit_bytes("\x53\x48\x89\xfb", 4);
+
+    reil_addr_t addr = entry->addr;
+
+    for (size_t i = 0; i < insns.size(); i++)
+    {
+        vm_insn *insn = insns[i];
+
+        if (insn->addr != addr)
+        {
+            // interpreter updates IP register before each instruction
+            emit_ip(insn->addr);
+            addr = insn->addr;
+        }
+
+        if (i == insns.size() - 1)
+        {
+            // the first instruction was counted by interpreter
+            emit_executed(insns.size() - 1);
+        }
+        else if (emit_insn(insn))
+        {
+            continue;
+        }
+
+        // call rax ; test rax, rax ; jz exit
+        emit_call(insn);
+        emit_bytes("\xff\xd0\x48\x85\xc0\x0f\x84", 7);
+
+        exits.push_back(make_pair(buff.size(), (int)i));
+        emit_u32(0);
+    }
+
+    // pop rbx ; ret
+    emit_bytes("\x5b\xc3", 2);
+
+    for (vector<pair<size_t, int> >::iterator it = exits.begin(); it != exits.end(); ++it)
+    {
+        // handler returned NULL, update jump offset
+        uint32_t offset = (uint32_t)(buff.size() - (it->first + 4));
+        memcpy(&buff[it->first], &offset, sizeof(offset));
+
+        if ((size_t)it->second < insns.size() - 1)
+        {
+            emit_executed(it->second);
+        }
+
+        // mov rax, imm64 ; mov rdx, imm64 ; mov [rax], rdx
+        emit_bytes("\x48\xb8", 2);
+        emit_u64((uint64_t)exit);
+        emit_bytes("\x48\xba", 2);
+        emit_u64((uint64_t)insns[it->second]);
+        emit_bytes("\x48\x89\x10", 3);
+
+        // xor eax, eax ; pop rbx ; ret
+        emit_bytes("\x31\xc0\x5b\xc3", 4);
+    }
+
+    if (code_used + buff.size() > VM_JIT_CODE_SIZE)
+    {
+        // out of executable memory
+        return false;
+    }
+
+    uint8_t *ptr = code + code_used;
+
+    memcpy(ptr, &buff[0], buff.size());
+    code_used += (buff.size() + 0xf) & ~0xf;
+
+    entry->handler = (vm_handler_t)ptr;
+    entries.push_back(entry);
+
+    for (size_t i = 1; i < insns.size(); i++)
+    {
+        insns[i]->compiled = true;
+    }
+
+    return true;
+}
+
+void CReilJIT::flush(void)
+{
+    for (vector<vm_insn *>::iterator it = entries.begin(); it != entries.end(); ++it)
+    {
+        // restore interpreter handler
+        (*it)->handler = (*it)->exec;
+    }
+
+    entries.clear();
+    code_used = 0;
+}
+
+#else // VM_JIT_SUPPORTED
+
+CReilJIT::CReilJIT(reil_const_t *ip, reil_const_t ip_mask, unsigned long long *executed, vm_insn **exit)
+{
+    code = NULL;
+}
+
+CReilJIT::~CReilJIT() {}
+
+bool CReilJIT::compile(vm_insn *insn) { return true; }
+
+void CReilJIT::flush(void) {}
+
+#endif // VM_JIT_SUPPORTED
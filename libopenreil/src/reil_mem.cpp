@@ -0,0 +1,702 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <vector>
+#include <map>
+
+using namespace std;
+
+// OpenREIL includes
+#include "libopenreil.h"
+#include "reil_mem.h"
+
+/*
+    Guest memory for native REIL interpreter. Memory is stored in pages of
+    MEM_PAGE_SIZE bytes with the bitmap of accessible bytes, so semantics of
+    the memory accesses are exactly the same as in pyopenreil VM.Mem class
+    that keeps each byte separately. Pages are stored in hash table and
+    direct-mapped translation cache keeps the last used ones.
+
+    Snapshots are sharing pages with the memory, shared page is copied when
+    it's being modified. Memory keeps the list of pages that were changed
+    since the last taken or restored snapshot, so restoring of the same 
+    snapshot again costs only O(dirty pages).
+*/
+
+static inline size_t mem_hash(reil_addr_t num, size_t mask)
+{
+    return (size_t)((num * 0x9e3779b97f4a7c15ULL) >> 32) & mask;
+}
+
+static inline int mem_size_len(reil_size_t size)
+{
+    switch (size)
+    {
+    case U1:
+    case U8: return 1;
+    case U16: return 2;
+    case U32: return 4;
+    case U64: return 8;
+    }
+
+    return -1;
+}
+
+static inline void page_release(mem_page *page)
+{
+    if (mem_ref(&page->refs, -1) == 0)
+    {
+        delete page;
+    }
+}
+
+static inline bool page_is_valid(mem_page *page, int offs, int len)
+{
+    if (page->valid_count == MEM_PAGE_SIZE)
+    {
+        return true;
+    }
+
+    for (int i = offs; i < offs + len; i++)
+    {
+        if (!(page->valid[i / 8] & (1 << (i % 8))))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static inline void page_set_valid(mem_page *page, int offs, int len)
+{
+    if (page->valid_count == MEM_PAGE_SIZE)
+    {
+        return;
+    }
+
+    if (offs == 0 && len == MEM_PAGE_SIZE)
+    {
+        memset(page->valid, 0xff, sizeof(page->valid));
+        page->valid_count = MEM_PAGE_SIZE;
+        return;
+    }
+
+    for (int i = offs; i < offs + len; i++)
+    {
+        if (!(page->valid[i / 8] & (1 << (i % 8))))
+        {
+            page->valid[i / 8] |= (1 << (i % 8));
+            page->valid_count += 1;
+        }
+    }
+}
+
+CReilMemSnapshot::~CReilMemSnapshot()
+{
+    for (map<reil_addr_t, mem_page *>::iterator it = pages.begin(); it != pages.end(); ++it)
+    {
+        page_release(it->second);
+    }
+}
+
+CReilMem::CReilMem(bool strict, reil_addr_t lowest_addr, reil_mem_fault_t fault, void *context)
+{
+    this->strict = strict;
+    this->lowest_addr = lowest_addr;
+    this->fault = fault;
+    this->context = context;
+
+    error = REIL_MEM_OK;
+    error_addr = 0;
+
+    alloc_last = REIL_MEM_ALLOC_BASE;
+
+    base = NULL;
+
+    table_reset(0);
+    tlb_flush();
+}
+
+CReilMem::~CReilMem()
+{
+    clear();
+}
+
+void CReilMem::tlb_flush(void)
+{
+    for (int i = 0; i < MEM_TLB_SIZE; i++)
+    {
+        tlb[i].num = 0;
+        tlb[i].page = NULL;
+    }
+}
+
+void CReilMem::tlb_flush(reil_addr_t num)
+{
+    mem_tlb_entry *entry = &tlb[num & (MEM_TLB_SIZE - 1)];
+
+    if (entry->num == num)
+    {
+        entry->page = NULL;
+    }
+}
+
+int CReilMem::table_slot(reil_addr_t num)
+{
+    size_t mask = table.size() - 1;
+
+    for (size_t i = mem_hash(num, mask); table[i] != NULL; i = (i + 1) & mask)
+    {
+        if (table[i]->num == num)
+        {
+            return (int)i;
+        }
+    }
+
+    return -1;
+}
+
+void CReilMem::table_insert(mem_page *page)
+{
+    // keep load factor of the table below 0.5
+    if ((table_count + 1) * 2 > (int)table.size())
+    {
+        table_grow();
+    }
+
+    size_t mask = table.size() - 1, i = mem_hash(page->num, mask);
+
+    while (table[i] != NULL)
+    {
+        i = (i + 1) & mask;
+    }
+
+    table[i] = page;
+    table_count += 1;
+}
+
+void CReilMem::table_remove(int slot)
+{
+    size_t mask = table.size() - 1, i = slot, j = slot;
+
+    table[i] = NULL;
+    table_count -= 1;
+
+    // move following entries of the same cluster into the hole if needed
+    while (table[j = (j + 1) & mask] != NULL)
+    {
+        size_t k = mem_hash(table[j]->num, mask);
+
+        if (i <= j ? (i < k && k <= j) : (i < k || k <= j))
+        {
+            // entry is reachable from it's hash slot without the hole
+            continue;
+        }
+
+        table[i] = table[j];
+        table[j] = NULL;
+        i = j;
+    }
+}
+
+void CReilMem::table_grow(void)
+{
+    vector<mem_page *> old_table(table.size() * 2, (mem_page *)NULL);
+
+    old_table.swap(table);
+
+    size_t mask = table.size() - 1;
+
+    // re-insert existing pages into the bigger table
+    for (vector<mem_page *>::iterator it = old_table.begin(); it != old_table.end(); ++it)
+    {
+        if (*it == NULL)
+        {
+            continue;
+        }
+
+        size_t i = mem_hash((*it)->num, mask);
+
+        while (table[i] != NULL)
+        {
+            i = (i + 1) & mask;
+        }
+
+        table[i] = *it;
+    }
+}
+
+void CReilMem::table_reset(int count)
+{
+    size_t size = MEM_TABLE_SIZE;
+
+    while (size < (size_t)count * 2)
+    {
+        size *= 2;
+    }
+
+    table.assign(size, NULL);
+    table_count = 0;
+}
+
+mem_page *CReilMem::page_find(reil_addr_t num)
+{
+    int slot = table_slot(num);
+
+    return slot == -1 ? NULL : table[slot];
+}
+
+mem_page *CReilMem::page_get(reil_addr_t num)
+{
+    mem_page *page = page_find(num);
+
+    if (page)
+    {
+        return mem_refs(&page->refs) > 1 ? page_copy(page) : page;
+    }
+
+    page = new mem_page;
+    memset(page, 0, sizeof(mem_page));
+    page->num = num;
+    page->refs = 1;
+
+    table_insert(page);
+
+    if (base) dirty.push_back(num);
+
+    return page;
+}
+
+mem_page *CReilMem::page_copy(mem_page *page)
+{
+    mem_page *copy = new mem_page;
+
+    memcpy(copy, page, sizeof(mem_page));
+    copy->refs = 1;
+
+    // replace shared page with it's private copy
+    table[table_slot(page->num)] = copy;
+    page_release(page);
+
+    mem_tlb_entry *entry = &tlb[copy->num & (MEM_TLB_SIZE - 1)];
+
+    entry->num = copy->num;
+    entry->page = copy;
+
+    if (base) dirty.push_back(copy->num);
+
+    return copy;
+}
+
+void CReilMem::clear(void)
+{
+    for (vector<mem_page *>::iterator it = table.begin(); it != table.end(); ++it)
+    {
+        if (*it) page_release(*it);
+    }
+
+    table_reset(0);
+    tlb_flush();
+
+    if (base)
+    {
+        base->release();
+        base = NULL;
+    }
+
+    dirty.clear();
+}
+
+CReilMemSnapshot *CReilMem::snapshot(void)
+{
+    CReilMemSnapshot *snap = new CReilMemSnapshot(alloc_last);
+
+    for (vector<mem_page *>::iterator it = table.begin(); it != table.end(); ++it)
+    {
+        if (*it)
+        {
+            // share page with the snapshot
+            mem_ref(&(*it)->refs, 1);
+            snap->pages[(*it)->num] = *it;
+        }
+    }
+
+    // track changes since this snapshot
+    snap->ref();
+
+    if (base) base->release();
+    base = snap;
+
+    dirty.clear();
+
+    return snap;
+}
+
+void CReilMem::restore(CReilMemSnapshot *snap)
+{
+    if (snap == base)
+    {
+        // revert only the pages that were changed since snapshot
+        for (vector<reil_addr_t>::iterator it = dirty.begin(); it != dirty.end(); ++it)
+        {
+            map<reil_addr_t, mem_page *>::iterator old = snap->pages.find(*it);
+            int slot = table_slot(*it);
+
+            if (slot != -1)
+            {
+                mem_page *page = table[slot];
+
+                if (old != snap->pages.end())
+                {
+                    mem_ref(&old->second->refs, 1);
+                    table[slot] = old->second;
+                }
+                else
+                {
+                    // page was allocated after snapshot
+                    table_remove(slot);
+                }
+
+                page_release(page);
+            }
+            else if (old != snap->pages.end())
+            {
+                mem_ref(&old->second->refs, 1);
+                table_insert(old->second);
+            }
+
+            tlb_flush(*it);
+        }
+    }
+    else
+    {
+        for (vector<mem_page *>::iterator it = table.begin(); it != table.end(); ++it)
+        {
+            if (*it) page_release(*it);
+        }
+
+        table_reset(snap->pages.size());
+        tlb_flush();
+
+        for (map<reil_addr_t, mem_page *>::iterator it = snap->pages.begin(); it != snap->pages.end(); ++it)
+        {
+            mem_ref(&it->second->refs, 1);
+            table_insert(it->second);
+        }
+
+        snap->ref();
+
+        if (base) base->release();
+        base = snap;
+    }
+
+    dirty.clear();
+
+    alloc_last = snap->alloc_last;
+
+    error = REIL_MEM_OK;
+    error_addr = 0;
+}
+
+bool CReilMem::set_error(reil_mem_error_t error, reil_addr_t addr)
+{
+    this->error = error;
+    this->error_addr = addr;
+
+    return false;
+}
+
+reil_mem_error_t CReilMem::get_error(reil_addr_t *addr)
+{
+    if (addr) *addr = error_addr;
+
+    return error;
+}
+
+bool CReilMem::check_addr(reil_addr_t addr)
+{
+    if (addr < lowest_addr)
+    {
+        return set_error(REIL_MEM_ERR_NULL, addr);
+    }
+
+    return true;
+}
+
+bool CReilMem::read_raw(reil_addr_t addr, uint8_t *buff, int size)
+{
+    while (size > 0)
+    {
+        mem_page *page = page_lookup(MEM_PAGE_NUM(addr));
+        int offs = MEM_PAGE_OFFS(addr), len = min(size, MEM_PAGE_SIZE - offs);
+
+        if (page == NULL || !page_is_valid(page, offs, len))
+        {
+            return false;
+        }
+
+        memcpy(buff, page->data + offs, len);
+
+        addr += len;
+        buff += len;
+        size -= len;
+    }
+
+    return true;
+}
+
+bool CReilMem::write_raw(reil_addr_t addr, uint8_t *buff, int size)
+{
+    reil_addr_t ptr = addr;
+    int left = size;
+
+    // check that all of the range is accessible before modifying anything
+    while (left > 0)
+    {
+        mem_page *page = page_lookup(MEM_PAGE_NUM(ptr));
+        int offs = MEM_PAGE_OFFS(ptr), len = min(left, MEM_PAGE_SIZE - offs);
+
+        if (page == NULL || !page_is_valid(page, offs, len))
+        {
+            return false;
+        }
+
+        ptr += len;
+        left -= len;
+    }
+
+    while (size > 0)
+    {
+        mem_page *page = page_lookup_write(MEM_PAGE_NUM(addr));
+        int offs = MEM_PAGE_OFFS(addr), len = min(size, MEM_PAGE_SIZE - offs);
+
+        memcpy(page->data + offs, buff, len);
+
+        addr += len;
+        buff += len;
+        size -= len;
+    }
+
+    return true;
+}
+
+bool CReilMem::read(reil_addr_t addr, uint8_t *buff, int size)
+{
+    if (!check_addr(addr))
+    {
+        return false;
+    }
+
+    if (read_raw(addr, buff, size))
+    {
+        return true;
+    }
+
+    // try to get the data from external memory reader
+    if (fault && fault((reil_mem_t)this, addr, size, context) != REIL_ERROR &&
+        read_raw(addr, buff, size))
+    {
+        return true;
+    }
+
+    return set_error(REIL_MEM_ERR_READ, addr);
+}
+
+bool CReilMem::write(reil_addr_t addr, uint8_t *buff, int size)
+{
+    if (!check_addr(addr))
+    {
+        return false;
+    }
+
+    if (!strict)
+    {
+        // allocate memory at address that was not available
+        return alloc(addr, buff, size, size);
+    }
+
+    if (write_raw(addr, buff, size))
+    {
+        return true;
+    }
+
+    // check if external memory reader knows this address
+    if (fault && fault((reil_mem_t)this, addr, size, context) != REIL_ERROR)
+    {
+        return alloc(addr, buff, size, size);
+    }
+
+    return set_error(REIL_MEM_ERR_WRITE, addr);
+}
+
+bool CReilMem::load_slow(reil_addr_t addr, int len, reil_const_t *val)
+{
+    uint8_t buff[sizeof(reil_const_t)];
+
+    if (!read(addr, buff, len))
+    {
+        return false;
+    }
+
+    *val = mem_get_le(buff, len);
+
+    return true;
+}
+
+bool CReilMem::store_slow(reil_addr_t addr, int len, reil_const_t val)
+{
+    uint8_t buff[sizeof(reil_const_t)];
+
+    mem_put_le(buff, len, val);
+
+    return write(addr, buff, len);
+}
+
+bool CReilMem::alloc(reil_addr_t addr, uint8_t *data, int data_size, int size)
+{
+    if (!check_addr(addr))
+    {
+        return false;
+    }
+
+    data_size = data == NULL ? 0 : min(data_size, size);
+
+    while (size > 0)
+    {
+        mem_page *page = page_get(MEM_PAGE_NUM(addr));
+        int offs = MEM_PAGE_OFFS(addr), len = min(size, MEM_PAGE_SIZE - offs);
+
+        // fill target memory range with specified data or zeros
+        int copy = max(0, min(len, data_size));
+
+        if (copy > 0) memcpy(page->data + offs, data, copy);
+        if (copy < len) memset(page->data + offs + copy, 0, len - copy);
+
+        page_set_valid(page, offs, len);
+
+        addr += len;
+        size -= len;
+
+        if (data)
+        {
+            data += copy;
+            data_size -= copy;
+        }
+    }
+
+    return true;
+}
+
+reil_addr_t CReilMem::alloc_addr(int size)
+{
+    reil_addr_t ret = alloc_last;
+
+    alloc_last += size;
+
+    return ret;
+}
+
+//======================================================================
+// C API
+//======================================================================
+
+extern "C" reil_mem_t reil_mem_init(int strict, reil_addr_t lowest_addr, reil_mem_fault_t fault, void *context)
+{
+    return (reil_mem_t)new CReilMem(strict != 0, lowest_addr, fault, context);
+}
+
+extern "C" void reil_mem_close(reil_mem_t mem)
+{
+    delete (CReilMem *)mem;
+}
+
+extern "C" void reil_mem_set_strict(reil_mem_t mem, int strict)
+{
+    ((CReilMem *)mem)->set_strict(strict != 0);
+}
+
+extern "C" int reil_mem_read(reil_mem_t mem, reil_addr_t addr, unsigned char *buff, int size)
+{
+    if (size < 0)
+    {
+        return REIL_ERROR;
+    }
+
+    return ((CReilMem *)mem)->read(addr, buff, size) ? 0 : REIL_ERROR;
+}
+
+extern "C" int reil_mem_write(reil_mem_t mem, reil_addr_t addr, unsigned char *buff, int size)
+{
+    if (size < 0)
+    {
+        return REIL_ERROR;
+    }
+
+    return ((CReilMem *)mem)->write(addr, buff, size) ? 0 : REIL_ERROR;
+}
+
+extern "C" int reil_mem_load(reil_mem_t mem, reil_addr_t addr, reil_size_t size, reil_const_t *val)
+{
+    int len = mem_size_len(size);
+
+    if (len == -1)
+    {
+        return REIL_ERROR;
+    }
+
+    return ((CReilMem *)mem)->load(addr, len, val) ? 0 : REIL_ERROR;
+}
+
+extern "C" int reil_mem_store(reil_mem_t mem, reil_addr_t addr, reil_size_t size, reil_const_t val)
+{
+    int len = mem_size_len(size);
+
+    if (len == -1)
+    {
+        return REIL_ERROR;
+    }
+
+    return ((CReilMem *)mem)->store(addr, len, val) ? 0 : REIL_ERROR;
+}
+
+extern "C" int reil_mem_alloc(reil_mem_t mem, reil_addr_t addr, unsigned char *data, int data_size, int size)
+{
+    if (size < 0 || data_size < 0)
+    {
+        return REIL_ERROR;
+    }
+
+    return ((CReilMem *)mem)->alloc(addr, data, data_size, size) ? 0 : REIL_ERROR;
+}
+
+extern "C" reil_addr_t reil_mem_alloc_addr(reil_mem_t mem, int size)
+{
+    return ((CReilMem *)mem)->alloc_addr(size);
+}
+
+extern "C" void reil_mem_clear(reil_mem_t mem)
+{
+    ((CReilMem *)mem)->clear();
+}
+
+extern "C" reil_mem_snapshot_t reil_mem_snapshot(reil_mem_t mem)
+{
+    return (reil_mem_snapshot_t)((CReilMem *)mem)->snapshot();
+}
+
+extern "C" void reil_mem_restore(reil_mem_t mem, reil_mem_snapshot_t snap)
+{
+    ((CReilMem *)mem)->restore((CReilMemSnapshot *)snap);
+}
+
+extern "C" void reil_mem_snapshot_close(reil_mem_snapshot_t snap)
+{
+    ((CReilMemSnapshot *)snap)->release();
+}
+
+extern "C" int reil_mem_get_error(reil_mem_t mem, reil_addr_t *addr)
+{
+    return ((CReilMem *)mem)->get_error(addr);
+}
@@ -0,0 +1,954 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <string>
+#include <deque>
+#include <vector>
+#include <map>
+#include <set>
+#include <algorithm>
+
+using namespace std;
+
+#ifdef HAVE_Z3
+#include <z3.h>
+#endif
+
+// OpenREIL includes
+#include "libopenreil.h"
+#include "reil_mem.h"
+#include "reil_vm.h"
+#include "reil_vm_ops.h"
+#include "reil_dfg.h"
+#include "reil_sym.h"
+#include "reil_smt.h"
+
+/*
+    Symbolic expressions are exported into QF_ABV formulas with the same semantics
+    as DFG constant propagation and VM have:
+
+      - operands of REIL_SYM_EXP are zero extended (signed operations are using
+        sign extension) to the wider operand size where U1 counts as 8 bits
+        unless both of the operands are U1, then the result is truncated or
+        extended to the node size;
+
+      - division and modulus by zero are zero, shifts by the value that is not
+        less than operand width are zero, I_EQ and I_LT are giving 0 or 1;
+
+      - REIL_SYM_PTR reads little endian bytes of 8-bit array indexed with
+        64-bit address, or separate value for each byte at constant address;
+
+      - REIL_SYM_COND is true when condition is not zero, REIL_SYM_LOC is 64-bit
+        address of machine instruction.
+
+    Expression DAG is walked in postorder without recursion, SMT-LIB2 term binds
+    every node that is used more than once with let (operands that are printed
+    several times, like divisor or memory address, are counted as several uses),
+    so the size of the text is linear to the number of nodes. Z3 AST is built
+    node by node with the node value reused for every use of it.
+*/
+
+static inline int smt_bits(reil_size_t size)
+{
+    return size == U1 ? 1 : vm_width(size);
+}
+
+static inline bool smt_signed(reil_op_t op)
+{
+    return op == I_SMUL || op == I_SDIV || op == I_SMOD;
+}
+
+static inline bool smt_div(reil_op_t op)
+{
+    return op == I_DIV || op == I_MOD || op == I_SDIV || op == I_SMOD;
+}
+
+static string smt_num(reil_const_t val, int bits)
+{
+    char buff[0x20];
+
+    if (bits == 1)
+    {
+        return (val & 1) ? "#b1" : "#b0";
+    }
+
+    snprintf(buff, sizeof(buff), "#x%.*llx", bits / 4,
+             (unsigned long long)(val & vm_width_mask(bits)));
+
+    return string(buff);
+}
+
+static string smt_int(long long val)
+{
+    char buff[0x20];
+
+    snprintf(buff, sizeof(buff), "%lld", val);
+
+    return string(buff);
+}
+
+static string smt_sort(int bits)
+{
+    return "(_ BitVec " + smt_int(bits) + ")";
+}
+
+static void smt_text(vector<smt_item> &items, string text)
+{
+    smt_item item;
+
+    item.node = -1;
+    item.text = text;
+
+    items.push_back(item);
+}
+
+static void smt_node(vector<smt_item> &items, int n, int from, int to, bool sign)
+{
+    smt_item item;
+
+    item.node = n;
+
+    if (to < from)
+    {
+        smt_text(items, "((_ extract " + smt_int(to - 1) + " 0) ");
+    }
+    else if (to > from)
+    {
+        // U1 value is always zero extended
+        smt_text(items, string(sign && from > 1 ? "((_ sign_extend " : "((_ zero_extend ") +
+                        smt_int(to - from) + ") ");
+    }
+
+    items.push_back(item);
+
+    if (to != from)
+    {
+        smt_text(items, ")");
+    }
+}
+
+CReilSmt::CReilSmt(CReilSym *sym, int options)
+{
+    this->sym = sym;
+    this->options = options;
+    this->mark = 0;
+}
+
+//======================================================================
+// Expression DAG
+//======================================================================
+
+int CReilSmt::bits(int n)
+{
+    sym_node *node = &sym->nodes[n];
+
+    while (node->kind == REIL_SYM_COND)
+    {
+        // condition might select instruction address
+        node = &sym->nodes[node->b];
+    }
+
+    return node->kind == REIL_SYM_LOC ? 64 : smt_bits(node->size);
+}
+
+int CReilSmt::width(sym_node *node)
+{
+    reil_size_t size_a = sym->nodes[node->a].size;
+    reil_size_t size_b = node->b == -1 ? size_a : sym->nodes[node->b].size;
+
+    if (size_a == U1 && size_b == U1)
+    {
+        return 1;
+    }
+
+    return max(vm_width(size_a), vm_width(size_b));
+}
+
+int CReilSmt::uses(sym_node *node, int arg)
+{
+    if (node->kind == REIL_SYM_PTR && !(options & REIL_SMT_MEM_BYTES))
+    {
+        // address of each byte
+        return max(1, smt_bits(node->size) / 8);
+    }
+
+    if (node->kind == REIL_SYM_EXP && smt_div(node->op) && arg == 1)
+    {
+        // divisor is checked for zero
+        return 2;
+    }
+
+    return 1;
+}
+
+bool CReilSmt::order(int root, vector<int> &list)
+{
+    vector<pair<int, bool> > stack;
+
+    if (!sym->valid(root) || sym->nodes[root].kind == REIL_SYM_IP)
+    {
+        return false;
+    }
+
+    if (marks.size() < sym->nodes.size())
+    {
+        marks.resize(sym->nodes.size(), 0);
+        touched.resize(sym->nodes.size(), 0);
+        refs.resize(sym->nodes.size(), 0);
+    }
+
+    // new walk
+    mark += 1;
+
+    stack.push_back(make_pair(root, false));
+
+    while (!stack.empty())
+    {
+        int n = stack.back().first;
+
+        if (stack.back().second)
+        {
+            stack.pop_back();
+            list.push_back(n);
+            continue;
+        }
+
+        if (marks[n] == mark)
+        {
+            stack.pop_back();
+            continue;
+        }
+
+        marks[n] = mark;
+        stack.back().second = true;
+
+        sym_node *node = &sym->nodes[n];
+        int args[] = { node->a, node->b, node->c };
+
+        for (int i = 0; i < 3; i++)
+        {
+            int arg = args[i];
+
+            if (arg == -1) continue;
+
+            int kind = sym->nodes[arg].kind;
+
+            // instruction address is allowed only as the branch of condition
+            if (kind == REIL_SYM_IP ||
+                (kind == REIL_SYM_LOC && (node->kind != REIL_SYM_COND || i == 0)))
+            {
+                return false;
+            }
+
+            if (touched[arg] != mark)
+            {
+                touched[arg] = mark;
+                refs[arg] = 0;
+            }
+
+            refs[arg] += uses(node, i);
+
+            if (marks[arg] != mark)
+            {
+                stack.push_back(make_pair(arg, false));
+            }
+        }
+
+        if (node->kind == REIL_SYM_LOC && node->inum != 0)
+        {
+            // IR address inside of machine instruction
+            return false;
+        }
+
+        if (node->kind == REIL_SYM_PTR && (options & REIL_SMT_MEM_BYTES) &&
+            sym->nodes[node->a].kind != REIL_SYM_CONST)
+        {
+            return false;
+        }
+
+        if (node->kind == REIL_SYM_COND && bits(node->b) != bits(node->c))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//======================================================================
+// Declarations
+//======================================================================
+
+string CReilSmt::name(int n)
+{
+    map<int, string>::iterator it = val_names.find(n);
+
+    if (it != val_names.end())
+    {
+        return it->second;
+    }
+
+    sym_node *node = &sym->nodes[n];
+    string ret = sym->names[node->name];
+
+    if (node->type == A_TEMP)
+    {
+        char buff[0x20];
+
+        // temporary registers of different machine instructions are different values
+        snprintf(buff, sizeof(buff), "_%llx", (unsigned long long)node->val);
+        ret += buff;
+    }
+
+    if (val_taken.find(ret) != val_taken.end())
+    {
+        // the same register with another size
+        ret += "_" + smt_int(n);
+    }
+
+    val_taken.insert(ret);
+    val_names[n] = ret;
+
+    return ret;
+}
+
+string CReilSmt::mem(reil_const_t addr)
+{
+    char buff[0x20];
+
+    snprintf(buff, sizeof(buff), SMT_MEM_NAME "_%llx", (unsigned long long)addr);
+
+    return string(buff);
+}
+
+bool CReilSmt::declare(vector<int> &list, string &text)
+{
+    for (size_t i = 0; i < list.size(); i++)
+    {
+        sym_node *node = &sym->nodes[list[i]];
+
+        if (node->kind == REIL_SYM_VAL && val_names.find(list[i]) == val_names.end())
+        {
+            text += "(declare-fun " + name(list[i]) + " () " + smt_sort(smt_bits(node->size)) + ")\n";
+        }
+        else if (node->kind == REIL_SYM_PTR && !(options & REIL_SMT_MEM_BYTES))
+        {
+            if (val_taken.find(SMT_MEM_NAME) == val_taken.end())
+            {
+                text += "(declare-fun " SMT_MEM_NAME " () (Array " + smt_sort(64) + " " + smt_sort(8) + "))\n";
+                val_taken.insert(SMT_MEM_NAME);
+            }
+        }
+        else if (node->kind == REIL_SYM_PTR)
+        {
+            int count = max(1, smt_bits(node->size) / 8);
+
+            for (int n = 0; n < count; n++)
+            {
+                reil_const_t addr = sym->nodes[node->a].val + n;
+
+                if (mem_bytes.find(addr) == mem_bytes.end())
+                {
+                    text += "(declare-fun " + mem(addr) + " () " + smt_sort(8) + ")\n";
+                    mem_bytes.insert(addr);
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+//======================================================================
+// SMT-LIB2
+//======================================================================
+
+bool CReilSmt::atom(int n, string &text)
+{
+    sym_node *node = &sym->nodes[n];
+
+    switch (node->kind)
+    {
+    case REIL_SYM_CONST:
+    case REIL_SYM_LOC:
+
+        text = smt_num(node->val, bits(n));
+        return true;
+
+    case REIL_SYM_VAL:
+
+        text = name(n);
+        return true;
+    }
+
+    return false;
+}
+
+bool CReilSmt::expand(int n, vector<smt_item> &items)
+{
+    sym_node *node = &sym->nodes[n];
+
+    items.clear();
+
+    if (node->kind == REIL_SYM_PTR)
+    {
+        int count = max(1, smt_bits(node->size) / 8);
+        vector<smt_item> addr;
+
+        smt_node(addr, node->a, bits(node->a), 64, false);
+
+        if (node->size == U1)
+        {
+            smt_text(items, "((_ extract 0 0) ");
+        }
+
+        // bytes from the highest one
+        for (int i = count - 1; i >= 0; i--)
+        {
+            if (i > 0)
+            {
+                smt_text(items, "(concat ");
+            }
+
+            if (options & REIL_SMT_MEM_BYTES)
+            {
+                smt_text(items, mem(sym->nodes[node->a].val + i));
+            }
+            else if (sym->nodes[node->a].kind == REIL_SYM_CONST)
+            {
+                smt_text(items, "(select " SMT_MEM_NAME " " + smt_num(sym->nodes[node->a].val + i, 64) + ")");
+            }
+            else
+            {
+                smt_text(items, "(select " SMT_MEM_NAME " ");
+
+                if (i > 0) smt_text(items, "(bvadd ");
+
+                items.insert(items.end(), addr.begin(), addr.end());
+
+                if (i > 0) smt_text(items, " " + smt_num(i, 64) + ")");
+
+                smt_text(items, ")");
+            }
+
+            if (i > 0)
+            {
+                smt_text(items, " ");
+            }
+        }
+
+        smt_text(items, string(count - 1, ')'));
+
+        if (node->size == U1)
+        {
+            smt_text(items, ")");
+        }
+
+        return true;
+    }
+    else if (node->kind == REIL_SYM_COND)
+    {
+        smt_text(items, "(ite (= ");
+        smt_node(items, node->a, 0, 0, false);
+        smt_text(items, " " + smt_num(0, bits(node->a)) + ") ");
+        smt_node(items, node->c, 0, 0, false);
+        smt_text(items, " ");
+        smt_node(items, node->b, 0, 0, false);
+        smt_text(items, ")");
+
+        return true;
+    }
+    else if (node->kind != REIL_SYM_EXP)
+    {
+        return false;
+    }
+
+    int size = smt_bits(node->size);
+
+    if (node->op == I_STR)
+    {
+        smt_node(items, node->a, bits(node->a), size, false);
+        return true;
+    }
+
+    const char *func = NULL;
+    bool sign = smt_signed(node->op);
+    int w = width(node);
+
+    switch (node->op)
+    {
+    case I_ADD: func = "bvadd"; break;
+    case I_SUB: func = "bvsub"; break;
+    case I_NEG: func = "bvneg"; break;
+    case I_MUL: func = "bvmul"; break;
+    case I_DIV: func = "bvudiv"; break;
+    case I_MOD: func = "bvurem"; break;
+    case I_SMUL: func = "bvmul"; break;
+    case I_SDIV: func = "bvsdiv"; break;
+    case I_SMOD: func = "bvsrem"; break;
+    case I_SHL: func = "bvshl"; break;
+    case I_SHR: func = "bvlshr"; break;
+    case I_AND: func = "bvand"; break;
+    case I_OR: func = "bvor"; break;
+    case I_XOR: func = "bvxor"; break;
+    case I_NOT: func = "bvnot"; break;
+    case I_EQ: func = "="; break;
+    case I_LT: func = "bvult"; break;
+
+    default:
+
+        return false;
+    }
+
+    if (node->op == I_EQ || node->op == I_LT)
+    {
+        smt_text(items, string("(ite (") + func + " ");
+        smt_node(items, node->a, bits(node->a), w, false);
+        smt_text(items, " ");
+        smt_node(items, node->b, bits(node->b), w, false);
+        smt_text(items, ") " + smt_num(1, size) + " " + smt_num(0, size) + ")");
+
+        return true;
+    }
+
+    // result of signed operation is sign extended to the node size
+    if (size < w)
+    {
+        smt_text(items, "((_ extract " + smt_int(size - 1) + " 0) ");
+    }
+    else if (size > w)
+    {
+        smt_text(items, string(sign && w > 1 ? "((_ sign_extend " : "((_ zero_extend ") +
+                        smt_int(size - w) + ") ");
+    }
+
+    if (smt_div(node->op))
+    {
+        smt_text(items, "(ite (= ");
+        smt_node(items, node->b, bits(node->b), w, sign);
+        smt_text(items, " " + smt_num(0, w) + ") " + smt_num(0, w) + " ");
+    }
+
+    smt_text(items, string("(") + func + " ");
+    smt_node(items, node->a, bits(node->a), w, sign);
+
+    if (node->b != -1)
+    {
+        smt_text(items, " ");
+        smt_node(items, node->b, bits(node->b), w, sign);
+    }
+
+    smt_text(items, ")");
+
+    if (smt_div(node->op))
+    {
+        smt_text(items, ")");
+    }
+
+    if (size != w)
+    {
+        smt_text(items, ")");
+    }
+
+    return true;
+}
+
+bool CReilSmt::shared(int n)
+{
+    int kind = sym->nodes[n].kind;
+
+    return touched[n] == mark && refs[n] > 1 &&
+           (kind == REIL_SYM_EXP || kind == REIL_SYM_PTR || kind == REIL_SYM_COND);
+}
+
+bool CReilSmt::print(int n, string &text)
+{
+    vector<smt_item> stack, items;
+    smt_item item;
+
+    item.node = n;
+    stack.push_back(item);
+
+    while (!stack.empty())
+    {
+        item = stack.back();
+        stack.pop_back();
+
+        if (item.node == -1)
+        {
+            text += item.text;
+            continue;
+        }
+
+        string atom_text;
+
+        if (atom(item.node, atom_text))
+        {
+            text += atom_text;
+        }
+        else if (item.node != n && shared(item.node))
+        {
+            // node that was bound by let
+            text += "?x" + smt_int(item.node);
+        }
+        else
+        {
+            if (!expand(item.node, items))
+            {
+                return false;
+            }
+
+            stack.insert(stack.end(), items.rbegin(), items.rend());
+        }
+    }
+
+    return true;
+}
+
+bool CReilSmt::smt2(int *nodes, int count, string &text)
+{
+    string decls, body;
+
+    for (int i = 0; i < count; i++)
+    {
+        vector<int> list;
+        string term;
+        int lets = 0;
+
+        if (!order(nodes[i], list) || !declare(list, decls))
+        {
+            return false;
+        }
+
+        for (size_t n = 0; n < list.size(); n++)
+        {
+            // operands are bound before the node itself
+            if (shared(list[n]))
+            {
+                term += "(let ((?x" + smt_int(list[n]) + " ";
+
+                if (!print(list[n], term))
+                {
+                    return false;
+                }
+
+                term += "))\n  ";
+                lets += 1;
+            }
+        }
+
+        if (!print(nodes[i], term))
+        {
+            return false;
+        }
+
+        term += string(lets, ')');
+
+        if (options & REIL_SMT_ASSERT)
+        {
+            body += "(assert (not (= " + term + " " + smt_num(0, bits(nodes[i])) + ")))\n";
+        }
+        else
+        {
+            body += "(define-fun E_" + smt_int(i) + " () " + smt_sort(bits(nodes[i])) + "\n  " + term + ")\n";
+        }
+    }
+
+    text = decls + body;
+
+    return true;
+}
+
+//======================================================================
+// Z3
+//======================================================================
+
+#ifdef HAVE_Z3
+
+/*
+    AST that is created with Z3_mk_context_rc() context can be freed by the next
+    API call, so every AST gets the reference until the end of export.
+*/
+typedef struct _smt_z3
+{
+    Z3_context ctx;
+    vector<Z3_ast> refs;
+
+} smt_z3;
+
+static Z3_ast z3_keep(smt_z3 *z, Z3_ast ast)
+{
+    Z3_inc_ref(z->ctx, ast);
+    z->refs.push_back(ast);
+
+    return ast;
+}
+
+static Z3_sort z3_sort(smt_z3 *z, int bits)
+{
+    Z3_sort sort = Z3_mk_bv_sort(z->ctx, bits);
+
+    z3_keep(z, Z3_sort_to_ast(z->ctx, sort));
+
+    return sort;
+}
+
+static Z3_ast z3_num(smt_z3 *z, reil_const_t val, int bits)
+{
+    return z3_keep(z, Z3_mk_unsigned_int64(z->ctx, val & vm_width_mask(bits), z3_sort(z, bits)));
+}
+
+static Z3_ast z3_var(smt_z3 *z, string name, Z3_sort sort)
+{
+    return z3_keep(z, Z3_mk_const(z->ctx, Z3_mk_string_symbol(z->ctx, name.c_str()), sort));
+}
+
+static Z3_ast z3_resize(smt_z3 *z, Z3_ast ast, int from, int to, bool sign)
+{
+    if (to < from)
+    {
+        return z3_keep(z, Z3_mk_extract(z->ctx, to - 1, 0, ast));
+    }
+    else if (to > from)
+    {
+        return z3_keep(z, sign && from > 1 ? Z3_mk_sign_ext(z->ctx, to - from, ast) :
+                                             Z3_mk_zero_ext(z->ctx, to - from, ast));
+    }
+
+    return ast;
+}
+
+static Z3_ast z3_op(smt_z3 *z, reil_op_t op, Z3_ast a, Z3_ast b)
+{
+    Z3_context c = z->ctx;
+
+    switch (op)
+    {
+    case I_ADD: return Z3_mk_bvadd(c, a, b);
+    case I_SUB: return Z3_mk_bvsub(c, a, b);
+    case I_NEG: return Z3_mk_bvneg(c, a);
+    case I_MUL: return Z3_mk_bvmul(c, a, b);
+    case I_DIV: return Z3_mk_bvudiv(c, a, b);
+    case I_MOD: return Z3_mk_bvurem(c, a, b);
+    case I_SMUL: return Z3_mk_bvmul(c, a, b);
+    case I_SDIV: return Z3_mk_bvsdiv(c, a, b);
+    case I_SMOD: return Z3_mk_bvsrem(c, a, b);
+    case I_SHL: return Z3_mk_bvshl(c, a, b);
+    case I_SHR: return Z3_mk_bvlshr(c, a, b);
+    case I_AND: return Z3_mk_bvand(c, a, b);
+    case I_OR: return Z3_mk_bvor(c, a, b);
+    case I_XOR: return Z3_mk_bvxor(c, a, b);
+    case I_NOT: return Z3_mk_bvnot(c, a);
+    case I_EQ: return Z3_mk_eq(c, a, b);
+    case I_LT: return Z3_mk_bvult(c, a, b);
+
+    default:
+
+        return NULL;
+    }
+}
+
+#endif // HAVE_Z3
+
+bool CReilSmt::z3(void *ctx, int *nodes, int count, void **out)
+{
+#ifdef HAVE_Z3
+
+    smt_z3 z;
+    map<int, Z3_ast> vals;
+    Z3_ast array = NULL;
+    bool ret = true;
+
+    z.ctx = (Z3_context)ctx;
+
+    for (int i = 0; i < count && ret; i++)
+    {
+        vector<int> list;
+
+        if (!order(nodes[i], list))
+        {
+            ret = false;
+            break;
+        }
+
+        for (size_t l = 0; l < list.size(); l++)
+        {
+            int n = list[l];
+            sym_node *node = &sym->nodes[n];
+            Z3_ast val = NULL;
+
+            if (vals.find(n) != vals.end())
+            {
+                continue;
+            }
+
+            if (node->kind == REIL_SYM_CONST || node->kind == REIL_SYM_LOC)
+            {
+                val = z3_num(&z, node->val, bits(n));
+            }
+            else if (node->kind == REIL_SYM_VAL)
+            {
+                val = z3_var(&z, name(n), z3_sort(&z, bits(n)));
+            }
+            else if (node->kind == REIL_SYM_PTR)
+            {
+                int count = max(1, smt_bits(node->size) / 8);
+                Z3_ast addr = z3_resize(&z, vals[node->a], bits(node->a), 64, false);
+
+                if (array == NULL && !(options & REIL_SMT_MEM_BYTES))
+                {
+                    Z3_sort sort = Z3_mk_array_sort(z.ctx, z3_sort(&z, 64), z3_sort(&z, 8));
+
+                    z3_keep(&z, Z3_sort_to_ast(z.ctx, sort));
+                    array = z3_var(&z, SMT_MEM_NAME, sort);
+                }
+
+                for (int b = 0; b < count; b++)
+                {
+                    Z3_ast byte = NULL;
+
+                    if (options & REIL_SMT_MEM_BYTES)
+                    {
+                        byte = z3_var(&z, mem(sym->nodes[node->a].val + b), z3_sort(&z, 8));
+                    }
+                    else
+                    {
+                        Z3_ast offs = b == 0 ? addr : z3_keep(&z, Z3_mk_bvadd(z.ctx, addr, z3_num(&z, b, 64)));
+
+                        byte = z3_keep(&z, Z3_mk_select(z.ctx, array, offs));
+                    }
+
+                    // higher bytes are concatenated from the left
+                    val = val == NULL ? byte : z3_keep(&z, Z3_mk_concat(z.ctx, byte, val));
+                }
+
+                if (node->size == U1)
+                {
+                    val = z3_resize(&z, val, 8, 1, false);
+                }
+            }
+            else if (node->kind == REIL_SYM_COND)
+            {
+                Z3_ast cond = z3_keep(&z, Z3_mk_eq(z.ctx, vals[node->a], z3_num(&z, 0, bits(node->a))));
+
+                val = z3_keep(&z, Z3_mk_ite(z.ctx, cond, vals[node->c], vals[node->b]));
+            }
+            else if (node->kind == REIL_SYM_EXP && node->op == I_STR)
+            {
+                val = z3_resize(&z, vals[node->a], bits(node->a), smt_bits(node->size), false);
+            }
+            else if (node->kind == REIL_SYM_EXP)
+            {
+                int size = smt_bits(node->size), w = width(node);
+                bool sign = smt_signed(node->op);
+
+                Z3_ast a = z3_resize(&z, vals[node->a], bits(node->a), w, sign);
+                Z3_ast b = node->b == -1 ? NULL : z3_resize(&z, vals[node->b], bits(node->b), w, sign);
+
+                if ((val = z3_op(&z, node->op, a, b)) == NULL)
+                {
+                    ret = false;
+                    break;
+                }
+
+                val = z3_keep(&z, val);
+
+                if (node->op == I_EQ || node->op == I_LT)
+                {
+                    val = z3_keep(&z, Z3_mk_ite(z.ctx, val, z3_num(&z, 1, size), z3_num(&z, 0, size)));
+                }
+                else
+                {
+                    if (smt_div(node->op))
+                    {
+                        Z3_ast zero = z3_num(&z, 0, w);
+                        Z3_ast cond = z3_keep(&z, Z3_mk_eq(z.ctx, b, zero));
+
+                        // division by zero gives zero
+                        val = z3_keep(&z, Z3_mk_ite(z.ctx, cond, zero, val));
+                    }
+
+                    val = z3_resize(&z, val, w, size, sign && w > 1);
+                }
+            }
+            else
+            {
+                ret = false;
+                break;
+            }
+
+            vals[n] = val;
+        }
+    }
+
+    for (int i = 0; i < count && ret; i++)
+    {
+        Z3_ast val = vals[nodes[i]];
+
+        if (options & REIL_SMT_ASSERT)
+        {
+            Z3_ast cond = z3_keep(&z, Z3_mk_eq(z.ctx, val, z3_num(&z, 0, bits(nodes[i]))));
+
+            val = z3_keep(&z, Z3_mk_not(z.ctx, cond));
+        }
+
+        // caller owns the result
+        Z3_inc_ref(z.ctx, val);
+        out[i] = (void *)val;
+    }
+
+    for (size_t i = 0; i < z.refs.size(); i++)
+    {
+        Z3_dec_ref(z.ctx, z.refs[i]);
+    }
+
+    return ret;
+
+#else
+
+    // Z3 support is not compiled in
+    (void)ctx; (void)nodes; (void)count; (void)out;
+
+    return false;
+
+#endif
+}
+
+//======================================================================
+// C API
+//======================================================================
+
+extern "C" int reil_sym_smt2(reil_sym_t sym, int *nodes, int count, int options, char *buff, int size)
+{
+    CReilSmt smt((CReilSym *)sym, options);
+    string text;
+
+    if (count < 0 || (count > 0 && nodes == NULL) || !smt.smt2(nodes, count, text))
+    {
+        return REIL_ERROR;
+    }
+
+    if (buff && size > 0)
+    {
+        int len = min(size - 1, (int)text.size());
+
+        memcpy(buff, text.c_str(), len);
+        buff[len] = '\0';
+    }
+
+    return (int)text.size();
+}
+
+extern "C" int reil_sym_z3(reil_sym_t sym, void *ctx, int *nodes, int count, int options, void **out)
+{
+    CReilSmt smt((CReilSym *)sym, options);
+
+    if (ctx == NULL || count < 0 || (count > 0 && (nodes == NULL || out == NULL)) ||
+        !smt.z3(ctx, nodes, count, out))
+    {
+        return REIL_ERROR;
+    }
+
+    return 0;
+}
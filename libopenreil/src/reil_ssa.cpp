@@ -0,0 +1,1050 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+
+using namespace std;
+
+// OpenREIL includes
+#include "libopenreil.h"
+#include "reil_dfg.h"
+#include "reil_ssa.h"
+
+/*
+    SSA construction follows Cytron et al. with the following parts:
+
+      - dominator tree is computed by iterative algorithm of Cooper, Harvey
+        and Kennedy over reverse postorder of reachable blocks;
+
+      - dominance frontiers are found by walking up the dominator tree from
+        predecessors of each block untill its immediate dominator;
+
+      - phi functions are placed at iterated dominance frontiers of blocks
+        that are defining variable, but only where variable is live (pruned
+        SSA), so temporary registers that are local to machine instruction
+        don't get phi functions at all;
+
+      - variables are renamed by preorder walk of the dominator tree with
+        explicit stack, so deep trees of large functions are fine.
+
+    Slicing walks def-use chains of SSA variables with bit sets of visited
+    instructions and variables, so each query takes time proportional to the
+    size of the slice (plus the size of bit sets).
+*/
+
+CReilSSA::CReilSSA(reil_arch_t arch, reil_inst_t *insts, int count, DFG_LOC loc)
+    : CReilDFG(arch, insts, count)
+{
+    // slicing queries are looking at instructions long after they were passed
+    ssa_insts.assign(insts, insts + count);
+
+    for (size_t i = 0; i < insns.size(); i++)
+    {
+        insns[i].inst = &ssa_insts[insns[i].inst - insts];
+    }
+
+    build(loc);
+
+    for (size_t i = 0; i < vars.size(); i++)
+    {
+        if (vars[i].type == A_REG) regs.push_back((int)i);
+        if (dfg_set_test(general, (int)i)) general_regs.push_back((int)i);
+    }
+
+    dominators();
+    frontiers();
+    place_phis();
+    rename();
+    link_uses();
+}
+
+void CReilSSA::insn_uses(dfg_insn *insn, vector<int> &uses)
+{
+    reil_inst_t *inst = insn->inst;
+
+    uses.clear();
+
+    switch (inst->op)
+    {
+    case I_NONE:
+
+        break;
+
+    case I_UNK:
+
+        // unknown instruction might read any register
+        uses = regs;
+        break;
+
+    case I_JCC:
+
+        if (inst->flags & IOPT_CALL) uses = general_regs;
+
+        // no break here
+
+    case I_STM:
+
+        if (insn->a != -1) uses.push_back(insn->a);
+        if (insn->c != -1) uses.push_back(insn->c);
+        break;
+
+    default:
+
+        if (insn->a != -1) uses.push_back(insn->a);
+        if (insn->b != -1) uses.push_back(insn->b);
+        break;
+    }
+
+    if (uses.size() > 1)
+    {
+        sort(uses.begin(), uses.end());
+        uses.erase(unique(uses.begin(), uses.end()), uses.end());
+    }
+}
+
+void CReilSSA::insn_defs(dfg_insn *insn, vector<int> &defs)
+{
+    reil_inst_t *inst = insn->inst;
+
+    defs.clear();
+
+    if (inst->op == I_UNK)
+    {
+        // unknown instruction might write any register
+        defs = regs;
+    }
+    else if (inst->op == I_JCC && (inst->flags & IOPT_CALL))
+    {
+        // function call might change any general purpose register or flag
+        defs = clobbered;
+    }
+    else if (is_pure(inst) && insn->c != -1)
+    {
+        defs.push_back(insn->c);
+    }
+}
+
+//======================================================================
+// Dominators
+//======================================================================
+
+void CReilSSA::dominators()
+{
+    int count = (int)bbs.size();
+    vector<int> post;
+    vector<pair<int, size_t> > stack;
+    vector<bool> visited(count, false);
+
+    // iterative DFS to find postorder of reachable blocks
+    stack.push_back(make_pair(entry, (size_t)0));
+    visited[entry] = true;
+
+    while (!stack.empty())
+    {
+        int n = stack.back().first;
+        size_t &next = stack.back().second;
+
+        if (next < bbs[n].succ.size())
+        {
+            int succ = bbs[n].succ[next++];
+
+            if (!visited[succ])
+            {
+                visited[succ] = true;
+                stack.push_back(make_pair(succ, (size_t)0));
+            }
+        }
+        else
+        {
+            post.push_back(n);
+            stack.pop_back();
+        }
+    }
+
+    post_num.assign(count, -1);
+    idom.assign(count, -1);
+
+    for (size_t i = 0; i < post.size(); i++) post_num[post[i]] = (int)i;
+
+    order.assign(post.rbegin(), post.rend());
+
+    idom[entry] = entry;
+
+    bool changed = true;
+
+    while (changed)
+    {
+        changed = false;
+
+        for (size_t i = 1; i < order.size(); i++)
+        {
+            int n = order[i], new_idom = -1;
+
+            for (vector<int>::iterator it = bbs[n].pred.begin(); it != bbs[n].pred.end(); ++it)
+            {
+                int pred = *it;
+
+                // predecessor was not processed yet
+                if (idom[pred] == -1) continue;
+
+                if (new_idom == -1)
+                {
+                    new_idom = pred;
+                    continue;
+                }
+
+                // find common dominator of both blocks
+                int a = pred, b = new_idom;
+
+                while (a != b)
+                {
+                    while (post_num[a] < post_num[b]) a = idom[a];
+                    while (post_num[b] < post_num[a]) b = idom[b];
+                }
+
+                new_idom = a;
+            }
+
+            if (idom[n] != new_idom)
+            {
+                idom[n] = new_idom;
+                changed = true;
+            }
+        }
+    }
+
+    // children of each node in dominator tree
+    dom_first.assign(count + 1, 0);
+    dom_children.assign(order.size() > 0 ? order.size() - 1 : 0, 0);
+
+    for (size_t i = 1; i < order.size(); i++) dom_first[idom[order[i]] + 1] += 1;
+    for (int n = 0; n < count; n++) dom_first[n + 1] += dom_first[n];
+
+    vector<int> pos(dom_first.begin(), dom_first.end() - 1);
+
+    for (size_t i = 1; i < order.size(); i++) dom_children[pos[idom[order[i]]]++] = order[i];
+
+    // preorder and postorder numbers of dominator tree nodes
+    int pre_count = 0, post_count = 0;
+
+    dom_pre.assign(count, -1);
+    dom_post.assign(count, -1);
+
+    stack.clear();
+    stack.push_back(make_pair(entry, (size_t)dom_first[entry]));
+    dom_pre[entry] = pre_count++;
+
+    while (!stack.empty())
+    {
+        int n = stack.back().first;
+        size_t &next = stack.back().second;
+
+        if (next < (size_t)dom_first[n + 1])
+        {
+            int child = dom_children[next++];
+
+            dom_pre[child] = pre_count++;
+            stack.push_back(make_pair(child, (size_t)dom_first[child]));
+        }
+        else
+        {
+            dom_post[n] = post_count++;
+            stack.pop_back();
+        }
+    }
+}
+
+void CReilSSA::frontiers()
+{
+    int count = (int)bbs.size();
+    vector<vector<int> > df(count);
+
+    for (size_t i = 0; i < order.size(); i++)
+    {
+        int n = order[i];
+
+        for (vector<int>::iterator it = bbs[n].pred.begin(); it != bbs[n].pred.end(); ++it)
+        {
+            int runner = *it;
+
+            // skip unreachable predecessors
+            if (post_num[runner] == -1) continue;
+
+            /*
+                Entry block has no immediate dominator, so it's in the
+                frontier of all of the blocks that are jumping to it.
+            */
+            while (n == entry || runner != idom[n])
+            {
+                if (df[runner].empty() || df[runner].back() != n) df[runner].push_back(n);
+
+                if (runner == entry) break;
+
+                runner = idom[runner];
+            }
+        }
+    }
+
+    df_first.assign(count + 1, 0);
+    df_bbs.clear();
+
+    for (int n = 0; n < count; n++)
+    {
+        df_bbs.insert(df_bbs.end(), df[n].begin(), df[n].end());
+        df_first[n + 1] = (int)df_bbs.size();
+    }
+}
+
+//======================================================================
+// Phi functions placement
+//======================================================================
+
+void CReilSSA::place_phis()
+{
+    int count = (int)bbs.size(), words = ((int)vars.size() + 63) / 64;
+
+    vector<dfg_set> gen(count, dfg_set(words, 0)), kill(count, dfg_set(words, 0));
+    vector<dfg_set> live_in(count, dfg_set(words, 0));
+    vector<vector<int> > def_sites(vars.size());
+    vector<int> uses, defs;
+
+    dfg_set exit_live(words, 0);
+
+    // registers are live at the end of the function
+    for (vector<int>::iterator it = regs.begin(); it != regs.end(); ++it) dfg_set_add(exit_live, *it);
+
+    for (size_t i = 0; i < order.size(); i++)
+    {
+        int n = order[i];
+
+        for (int j = bbs[n].first; j <= bbs[n].last; j++)
+        {
+            insn_uses(&insns[j], uses);
+            insn_defs(&insns[j], defs);
+
+            for (vector<int>::iterator it = uses.begin(); it != uses.end(); ++it)
+            {
+                // upward exposed use
+                if (!dfg_set_test(kill[n], *it)) dfg_set_add(gen[n], *it);
+            }
+
+            for (vector<int>::iterator it = defs.begin(); it != defs.end(); ++it)
+            {
+                if (!dfg_set_test(kill[n], *it))
+                {
+                    dfg_set_add(kill[n], *it);
+                    def_sites[*it].push_back(n);
+                }
+            }
+        }
+    }
+
+    // backward liveness analysis, postorder is visited first
+    vector<int> pending(order.begin(), order.end());
+    vector<bool> queued(count, false);
+
+    for (size_t i = 0; i < order.size(); i++) queued[order[i]] = true;
+
+    while (!pending.empty())
+    {
+        int n = pending.back();
+        dfg_set live(words, 0);
+
+        pending.pop_back();
+        queued[n] = false;
+
+        if (bbs[n].exit) live = exit_live;
+
+        for (vector<int>::iterator it = bbs[n].succ.begin(); it != bbs[n].succ.end(); ++it)
+        {
+            dfg_set_union(live, live_in[*it]);
+        }
+
+        for (int i = 0; i < words; i++) live[i] = gen[n][i] | (live[i] & ~kill[n][i]);
+
+        if (live != live_in[n])
+        {
+            live_in[n] = live;
+
+            for (vector<int>::iterator it = bbs[n].pred.begin(); it != bbs[n].pred.end(); ++it)
+            {
+                if (post_num[*it] != -1 && !queued[*it])
+                {
+                    pending.push_back(*it);
+                    queued[*it] = true;
+                }
+            }
+        }
+    }
+
+    // iteration number of the last phi placement and worklist addition for each block
+    vector<int> has_phi(count, -1), added(count, -1);
+    vector<int> work;
+
+    bb_phis.assign(count, vector<int>());
+
+    for (size_t var = 0; var < vars.size(); var++)
+    {
+        work = def_sites[var];
+
+        for (vector<int>::iterator it = work.begin(); it != work.end(); ++it) added[*it] = (int)var;
+
+        while (!work.empty())
+        {
+            int n = work.back();
+
+            work.pop_back();
+
+            for (int i = df_first[n]; i < df_first[n + 1]; i++)
+            {
+                int y = df_bbs[i];
+
+                if (has_phi[y] == (int)var) continue;
+
+                has_phi[y] = (int)var;
+
+                // pruned SSA: variable must be live at the beginning of the block
+                if (dfg_set_test(live_in[y], (int)var)) bb_phis[y].push_back((int)var);
+
+                if (added[y] != (int)var)
+                {
+                    added[y] = (int)var;
+                    work.push_back(y);
+                }
+            }
+        }
+    }
+}
+
+//======================================================================
+// Renaming
+//======================================================================
+
+int CReilSSA::new_var(int var, int insn, int phi)
+{
+    reil_ssa_var_t ssa_var;
+
+    memset(&ssa_var, 0, sizeof(ssa_var));
+
+    ssa_var.type = vars[var].type;
+    strcpy(ssa_var.name, vars[var].name);
+    ssa_var.version = insn == -1 && phi == -1 ? 0 : ++versions[var];
+    ssa_var.insn = insn;
+    ssa_var.phi = phi;
+
+    ssa_vars.push_back(ssa_var);
+
+    return (int)ssa_vars.size() - 1;
+}
+
+int CReilSSA::top_var(int var)
+{
+    if (!stacks[var].empty())
+    {
+        return stacks[var].back();
+    }
+
+    // variable was not defined yet, use its value at the function entry
+    if (entry_vars[var] == -1) entry_vars[var] = new_var(var, -1, -1);
+
+    return entry_vars[var];
+}
+
+void CReilSSA::add_use(int var, int insn, int phi)
+{
+    reil_ssa_use_t use;
+
+    use.insn = insn;
+    use.phi = phi;
+
+    var_uses.push_back(make_pair(var, use));
+}
+
+void CReilSSA::rename()
+{
+    int count = (int)bbs.size();
+
+    ssa_bbs.assign(count, reil_ssa_bb_t());
+    ssa_insns.assign(insns.size(), reil_ssa_insn_t());
+
+    stacks.assign(vars.size(), vector<int>());
+    versions.assign(vars.size(), 0);
+    entry_vars.assign(vars.size(), -1);
+
+    for (int n = 0; n < count; n++)
+    {
+        reil_ssa_bb_t *bb = &ssa_bbs[n];
+
+        bb->first = bbs[n].first;
+        bb->last = bbs[n].last;
+        bb->idom = n == entry ? -1 : idom[n];
+        bb->reachable = post_num[n] != -1;
+        bb->phi_first = (int)ssa_phis.size();
+        bb->phi_count = (int)bb_phis[n].size();
+
+        int args = (int)(n == entry);
+
+        for (vector<int>::iterator it = bbs[n].pred.begin(); it != bbs[n].pred.end(); ++it)
+        {
+            if (post_num[*it] != -1) args += 1;
+        }
+
+        for (size_t i = 0; i < bb_phis[n].size(); i++)
+        {
+            reil_ssa_phi_t phi;
+
+            phi.bb = n;
+            phi.var = -1;
+            phi.arg_first = (int)ssa_phi_args.size();
+            phi.arg_count = args;
+
+            ssa_phis.push_back(phi);
+
+            if (n == entry)
+            {
+                reil_ssa_phi_arg_t arg;
+
+                arg.bb = -1;
+                arg.var = top_var(bb_phis[n][i]);
+
+                // value at the function entry
+                add_use(arg.var, -1, (int)ssa_phis.size() - 1);
+                ssa_phi_args.push_back(arg);
+            }
+
+            for (vector<int>::iterator it = bbs[n].pred.begin(); it != bbs[n].pred.end(); ++it)
+            {
+                if (post_num[*it] != -1)
+                {
+                    reil_ssa_phi_arg_t arg;
+
+                    arg.bb = *it;
+                    arg.var = -1;
+
+                    ssa_phi_args.push_back(arg);
+                }
+            }
+        }
+    }
+
+    for (size_t i = 0; i < insns.size(); i++)
+    {
+        reil_ssa_insn_t *insn = &ssa_insns[i];
+
+        insn->addr = insns[i].loc.first;
+        insn->inum = insns[i].loc.second;
+        insn->bb = insns[i].bb;
+        insn->a = insn->b = insn->c = -1;
+    }
+
+    // variables that were pushed to the stacks and number of them at each level of the walk
+    vector<int> pushed;
+    vector<size_t> saved;
+
+    // preorder walk of the dominator tree: block and index of its next child
+    vector<pair<int, int> > walk;
+
+    walk.push_back(make_pair(entry, dom_first[entry]));
+    saved.push_back(0);
+
+    rename_bb(entry, pushed);
+
+    while (!walk.empty())
+    {
+        int n = walk.back().first;
+
+        if (walk.back().second < dom_first[n + 1])
+        {
+            int child = dom_children[walk.back().second++];
+
+            walk.push_back(make_pair(child, dom_first[child]));
+            saved.push_back(pushed.size());
+
+            rename_bb(child, pushed);
+        }
+        else
+        {
+            // definitions of the block are not visible outside of its subtree
+            while (pushed.size() > saved.back())
+            {
+                stacks[pushed.back()].pop_back();
+                pushed.pop_back();
+            }
+
+            walk.pop_back();
+            saved.pop_back();
+        }
+    }
+}
+
+void CReilSSA::rename_bb(int n, vector<int> &pushed)
+{
+    vector<int> uses, defs;
+
+    for (size_t i = 0; i < bb_phis[n].size(); i++)
+    {
+        int phi = ssa_bbs[n].phi_first + (int)i, var = bb_phis[n][i];
+
+        ssa_phis[phi].var = new_var(var, -1, phi);
+
+        stacks[var].push_back(ssa_phis[phi].var);
+        pushed.push_back(var);
+    }
+
+    for (int i = bbs[n].first; i <= bbs[n].last; i++)
+    {
+        dfg_insn *insn = &insns[i];
+        reil_ssa_insn_t *ssa_insn = &ssa_insns[i];
+
+        insn_uses(insn, uses);
+        insn_defs(insn, defs);
+
+        for (vector<int>::iterator it = uses.begin(); it != uses.end(); ++it)
+        {
+            add_use(top_var(*it), i, -1);
+        }
+
+        if (insn->a != -1) ssa_insn->a = top_var(insn->a);
+        if (insn->b != -1) ssa_insn->b = top_var(insn->b);
+
+        // operand c is read by I_STM and I_JCC
+        if (insn->c != -1 && !is_pure(insn->inst)) ssa_insn->c = top_var(insn->c);
+
+        for (vector<int>::iterator it = defs.begin(); it != defs.end(); ++it)
+        {
+            stacks[*it].push_back(new_var(*it, i, -1));
+            pushed.push_back(*it);
+        }
+
+        if (insn->c != -1 && is_pure(insn->inst)) ssa_insn->c = stacks[insn->c].back();
+    }
+
+    for (vector<int>::iterator it = bbs[n].succ.begin(); it != bbs[n].succ.end(); ++it)
+    {
+        int succ = *it, arg = (int)(succ == entry);
+
+        // find argument index of this predecessor
+        for (vector<int>::iterator pred = bbs[succ].pred.begin(); *pred != n; ++pred)
+        {
+            if (post_num[*pred] != -1) arg += 1;
+        }
+
+        for (size_t i = 0; i < bb_phis[succ].size(); i++)
+        {
+            int phi = ssa_bbs[succ].phi_first + (int)i;
+            reil_ssa_phi_arg_t *phi_arg = &ssa_phi_args[ssa_phis[phi].arg_first + arg];
+
+            phi_arg->var = top_var(bb_phis[succ][i]);
+            add_use(phi_arg->var, -1, phi);
+        }
+    }
+}
+
+void CReilSSA::link_uses()
+{
+    vector<int> pos(ssa_vars.size() + 1, 0);
+
+    // counting sort of uses by variable
+    for (size_t i = 0; i < var_uses.size(); i++) pos[var_uses[i].first + 1] += 1;
+    for (size_t i = 0; i < ssa_vars.size(); i++) pos[i + 1] += pos[i];
+
+    for (size_t i = 0; i < ssa_vars.size(); i++)
+    {
+        ssa_vars[i].use_first = pos[i];
+        ssa_vars[i].use_count = pos[i + 1] - pos[i];
+    }
+
+    ssa_uses.resize(var_uses.size());
+
+    for (size_t i = 0; i < var_uses.size(); i++) ssa_uses[pos[var_uses[i].first]++] = var_uses[i].second;
+
+    var_uses.clear();
+    stacks.clear();
+}
+
+//======================================================================
+// Results
+//======================================================================
+
+template<class T> static int ssa_copy(vector<T> &items, T *buff, int count)
+{
+    int num = (int)items.size();
+
+    if (buff && count > 0 && num > 0)
+    {
+        memcpy(buff, &items[0], sizeof(T) * min(count, num));
+    }
+
+    return num;
+}
+
+int CReilSSA::bb_list(reil_ssa_bb_t *bbs, int count)
+{
+    return ssa_copy(ssa_bbs, bbs, count);
+}
+
+int CReilSSA::insn_list(reil_ssa_insn_t *insns, int count)
+{
+    return ssa_copy(ssa_insns, insns, count);
+}
+
+int CReilSSA::var_list(reil_ssa_var_t *vars, int count)
+{
+    return ssa_copy(ssa_vars, vars, count);
+}
+
+int CReilSSA::use_list(reil_ssa_use_t *uses, int count)
+{
+    return ssa_copy(ssa_uses, uses, count);
+}
+
+int CReilSSA::phi_list(reil_ssa_phi_t *phis, int count)
+{
+    return ssa_copy(ssa_phis, phis, count);
+}
+
+int CReilSSA::phi_arg_list(reil_ssa_phi_arg_t *args, int count)
+{
+    return ssa_copy(ssa_phi_args, args, count);
+}
+
+int CReilSSA::df_list(int bb, int *bbs, int count)
+{
+    if (bb < 0 || bb >= (int)ssa_bbs.size())
+    {
+        return REIL_ERROR;
+    }
+
+    int num = df_first[bb + 1] - df_first[bb];
+
+    if (bbs && count > 0 && num > 0)
+    {
+        memcpy(bbs, &df_bbs[df_first[bb]], sizeof(int) * min(count, num));
+    }
+
+    return num;
+}
+
+bool CReilSSA::dominates(int a, int b)
+{
+    if (a < 0 || a >= (int)ssa_bbs.size() || b < 0 || b >= (int)ssa_bbs.size() ||
+        dom_pre[a] == -1 || dom_pre[b] == -1)
+    {
+        return false;
+    }
+
+    // b is in the subtree of a
+    return dom_pre[a] <= dom_pre[b] && dom_post[b] <= dom_post[a];
+}
+
+//======================================================================
+// Slicing
+//======================================================================
+
+bool CReilSSA::is_mem_read(reil_inst_t *inst)
+{
+    return inst->op == I_LDM || inst->op == I_UNK || 
+           (inst->op == I_JCC && (inst->flags & IOPT_CALL));
+}
+
+bool CReilSSA::is_mem_write(reil_inst_t *inst)
+{
+    return inst->op == I_STM || inst->op == I_UNK || 
+           (inst->op == I_JCC && (inst->flags & IOPT_CALL));
+}
+
+void CReilSSA::slice_index()
+{
+    int count = (int)insns.size();
+
+    if (!use_first.empty())
+    {
+        // already built by previous query
+        return;
+    }
+
+    use_first.assign(count + 1, 0);
+    def_first.assign(count + 1, 0);
+
+    for (size_t i = 0; i < ssa_vars.size(); i++)
+    {
+        reil_ssa_var_t *var = &ssa_vars[i];
+
+        for (int j = var->use_first; j < var->use_first + var->use_count; j++)
+        {
+            if (ssa_uses[j].insn != -1) use_first[ssa_uses[j].insn + 1] += 1;
+        }
+
+        if (var->insn != -1) def_first[var->insn + 1] += 1;
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        use_first[i + 1] += use_first[i];
+        def_first[i + 1] += def_first[i];
+    }
+
+    vector<int> use_pos(use_first.begin(), use_first.end() - 1);
+    vector<int> def_pos(def_first.begin(), def_first.end() - 1);
+
+    use_vars.resize(use_first[count]);
+    def_vars.resize(def_first[count]);
+
+    for (size_t i = 0; i < ssa_vars.size(); i++)
+    {
+        reil_ssa_var_t *var = &ssa_vars[i];
+
+        for (int j = var->use_first; j < var->use_first + var->use_count; j++)
+        {
+            if (ssa_uses[j].insn != -1) use_vars[use_pos[ssa_uses[j].insn]++] = (int)i;
+        }
+
+        if (var->insn != -1) def_vars[def_pos[var->insn]++] = (int)i;
+    }
+}
+
+void CReilSSA::slice_add(ssa_slice &s, int n)
+{
+    if (((s.options & REIL_SLICE_LOCAL) && insns[n].bb != s.bb) || dfg_set_test(s.insns, n))
+    {
+        return;
+    }
+
+    dfg_set_add(s.insns, n);
+    s.count += 1;
+
+    if (s.options & REIL_SLICE_FORWARD)
+    {
+        // variables that are defined by instruction
+        s.work.insert(s.work.end(), def_vars.begin() + def_first[n], def_vars.begin() + def_first[n + 1]);
+
+        if ((s.options & REIL_SLICE_MEM) && is_mem_write(insns[n].inst)) slice_mem(s, n);
+    }
+    else
+    {
+        // variables that are used by instruction
+        s.work.insert(s.work.end(), use_vars.begin() + use_first[n], use_vars.begin() + use_first[n + 1]);
+
+        if ((s.options & REIL_SLICE_MEM) && is_mem_read(insns[n].inst)) slice_mem(s, n);
+    }
+}
+
+void CReilSSA::slice_var(ssa_slice &s, int n)
+{
+    if (dfg_set_test(s.vars, n))
+    {
+        return;
+    }
+
+    dfg_set_add(s.vars, n);
+
+    reil_ssa_var_t *var = &ssa_vars[n];
+
+    if (s.options & REIL_SLICE_FORWARD)
+    {
+        for (int i = var->use_first; i < var->use_first + var->use_count; i++)
+        {
+            reil_ssa_use_t *use = &ssa_uses[i];
+
+            if (use->insn != -1) slice_add(s, use->insn);
+
+            // phi functions are joining values from other blocks
+            else if (!(s.options & REIL_SLICE_LOCAL)) s.work.push_back(ssa_phis[use->phi].var);
+        }
+    }
+    else if (var->insn != -1)
+    {
+        slice_add(s, var->insn);
+    }
+    else if (var->phi != -1 && !(s.options & REIL_SLICE_LOCAL))
+    {
+        reil_ssa_phi_t *phi = &ssa_phis[var->phi];
+
+        for (int i = phi->arg_first; i < phi->arg_first + phi->arg_count; i++)
+        {
+            s.work.push_back(ssa_phi_args[i].var);
+        }
+    }
+}
+
+void CReilSSA::slice_mem(ssa_slice &s, int n)
+{
+    bool forward = (s.options & REIL_SLICE_FORWARD) != 0;
+    dfg_bb *bb = &bbs[insns[n].bb];
+
+    // memory accesses of the same block that are before or after the instruction
+    for (int i = forward ? n + 1 : bb->first; i <= (forward ? bb->last : n - 1); i++)
+    {
+        if (forward ? is_mem_read(insns[i].inst) : is_mem_write(insns[i].inst)) slice_add(s, i);
+    }
+
+    if (s.options & REIL_SLICE_LOCAL)
+    {
+        return;
+    }
+
+    vector<int> stack(forward ? bb->succ : bb->pred);
+
+    // memory accesses of all blocks that are reachable from the instruction or can reach it
+    while (!stack.empty())
+    {
+        int b = stack.back();
+
+        stack.pop_back();
+
+        if (dfg_set_test(s.mem_bbs, b) || post_num[b] == -1)
+        {
+            continue;
+        }
+
+        dfg_set_add(s.mem_bbs, b);
+
+        for (int i = bbs[b].first; i <= bbs[b].last; i++)
+        {
+            if (forward ? is_mem_read(insns[i].inst) : is_mem_write(insns[i].inst)) slice_add(s, i);
+        }
+
+        vector<int> &next = forward ? bbs[b].succ : bbs[b].pred;
+
+        stack.insert(stack.end(), next.begin(), next.end());
+    }
+}
+
+int CReilSSA::slice(DFG_LOC loc, int arg, int options, unsigned long long *bitmap, int count)
+{
+    int n = find(loc);
+
+    if (n == -1 || arg < REIL_SLICE_ARG_A || arg > REIL_SLICE_ARG_C)
+    {
+        return REIL_ERROR;
+    }
+
+    reil_inst_t *inst = insns[n].inst;
+    reil_ssa_insn_t *insn = &ssa_insns[n];
+
+    reil_arg_t *args[] = { &inst->a, &inst->b, &inst->c };
+    int vars[] = { insn->a, insn->b, insn->c };
+
+    if (args[arg]->type == A_NONE)
+    {
+        return REIL_ERROR;
+    }
+
+    slice_index();
+
+    ssa_slice s;
+
+    s.options = options;
+    s.bb = insns[n].bb;
+    s.count = 0;
+
+    s.insns.assign((insns.size() + 63) / 64, 0);
+    s.vars.assign((ssa_vars.size() + 63) / 64, 0);
+    s.mem_bbs.assign((bbs.size() + 63) / 64, 0);
+
+    if ((options & REIL_SLICE_FORWARD) || (arg == REIL_SLICE_ARG_C && is_pure(inst)))
+    {
+        // instruction itself with all of its operands or results
+        slice_add(s, n);
+    }
+    else if (vars[arg] != -1)
+    {
+        // only definitions of given operand
+        s.work.push_back(vars[arg]);
+    }
+
+    while (!s.work.empty())
+    {
+        int var = s.work.back();
+
+        s.work.pop_back();
+        slice_var(s, var);
+    }
+
+    if (!dfg_set_test(s.insns, n))
+    {
+        dfg_set_add(s.insns, n);
+        s.count += 1;
+    }
+
+    if (bitmap && count > 0)
+    {
+        memcpy(bitmap, &s.insns[0], sizeof(unsigned long long) * min(count, (int)s.insns.size()));
+    }
+
+    return s.count;
+}
+
+//======================================================================
+// C API
+//======================================================================
+
+extern "C" reil_ssa_t reil_ssa_init(reil_arch_t arch, reil_inst_t *insts, int count, 
+                                    reil_addr_t addr, reil_inum_t inum)
+{
+    try
+    {
+        return (reil_ssa_t)new CReilSSA(arch, insts, count, DFG_LOC(addr, inum));
+    }
+    catch (CReilDFGException e)
+    {
+        fprintf(stderr, "reil_ssa_init() ERROR: %s\n", e.reason.c_str());
+    }
+
+    return NULL;
+}
+
+extern "C" void reil_ssa_close(reil_ssa_t ssa)
+{
+    delete (CReilSSA *)ssa;
+}
+
+extern "C" int reil_ssa_bb_list(reil_ssa_t ssa, reil_ssa_bb_t *bbs, int count)
+{
+    return ((CReilSSA *)ssa)->bb_list(bbs, count);
+}
+
+extern "C" int reil_ssa_insn_list(reil_ssa_t ssa, reil_ssa_insn_t *insns, int count)
+{
+    return ((CReilSSA *)ssa)->insn_list(insns, count);
+}
+
+extern "C" int reil_ssa_var_list(reil_ssa_t ssa, reil_ssa_var_t *vars, int count)
+{
+    return ((CReilSSA *)ssa)->var_list(vars, count);
+}
+
+extern "C" int reil_ssa_use_list(reil_ssa_t ssa, reil_ssa_use_t *uses, int count)
+{
+    return ((CReilSSA *)ssa)->use_list(uses, count);
+}
+
+extern "C" int reil_ssa_phi_list(reil_ssa_t ssa, reil_ssa_phi_t *phis, int count)
+{
+    return ((CReilSSA *)ssa)->phi_list(phis, count);
+}
+
+extern "C" int reil_ssa_phi_arg_list(reil_ssa_t ssa, reil_ssa_phi_arg_t *args, int count)
+{
+    return ((CReilSSA *)ssa)->phi_arg_list(args, count);
+}
+
+extern "C" int reil_ssa_df_list(reil_ssa_t ssa, int bb, int *bbs, int count)
+{
+    return ((CReilSSA *)ssa)->df_list(bb, bbs, count);
+}
+
+extern "C" int reil_ssa_dominates(reil_ssa_t ssa, int a, int b)
+{
+    return ((CReilSSA *)ssa)->dominates(a, b) ? 1 : 0;
+}
+
+extern "C" int reil_ssa_slice(reil_ssa_t ssa, reil_addr_t addr, reil_inum_t inum, int arg, int options,
+                              unsigned long long *bitmap, int count)
+{
+    return ((CReilSSA *)ssa)->slice(DFG_LOC(addr, inum), arg, options, bitmap, count);
+}
@@ -0,0 +1,936 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <string>
+#include <deque>
+#include <vector>
+#include <map>
+#include <set>
+#include <algorithm>
+
+using namespace std;
+
+// OpenREIL includes
+#include "libopenreil.h"
+#include "reil_mem.h"
+#include "reil_vm.h"
+#include "reil_vm_ops.h"
+#include "reil_dfg.h"
+#include "reil_sym.h"
+
+/*
+    Symbolic expressions are nodes of DAG that are hash-consed: before the
+    new node is created it's looked up in the hash table by its kind, operation,
+    size, operands and value, so structurally equal expressions are sharing
+    the same node and comparing expressions is comparing their indexes.
+
+    Expressions are simplified before lookup, so simplified form is the only
+    one that exists:
+
+      - operations over constants are folded with the same semantics as DFG
+        constant propagation and VM have;
+
+      - I_AND with mask that covers all bits of the result and I_OR or other
+        operations with neutral constant are turned into I_STR node that
+        converts value to the result size, chains of conversions are collapsed;
+
+      - constant operand of commutative operation goes second, other operands
+        are ordered by node index, constants of nested I_ADD, I_MUL, I_AND,
+        I_OR and I_XOR are combined;
+
+      - x - x, x ^ x, x & 0 and x * 0 are zero, x & x and x | x are x, x ^ ~0
+        is ~x, ~~x, --x and (x ^ y) ^ y are x.
+
+    Symbolic execution works just like Insn.to_symbolic() of pyopenreil: state
+    maps registers, temporary registers and memory locations to expressions
+    of their values, I_LDM reads memory contents of REIL_SYM_PTR node and I_JCC
+    sets instruction pointer.
+
+    State that was produced by executing some code from the empty state is
+    the summary of this code: its expressions are using initial values of
+    registers, so applying the summary to another state is substitution of
+    these values, and result is the same as executing the code from this
+    state up to simplification order.
+*/
+
+static inline unsigned int sym_mix(unsigned int h, unsigned int val)
+{
+    return h ^ (val + 0x9e3779b9 + (h << 6) + (h >> 2));
+}
+
+static inline bool sym_commutative(reil_op_t op)
+{
+    return op == I_ADD || op == I_MUL || op == I_AND || op == I_OR || op == I_XOR || op == I_EQ;
+}
+
+static inline bool sym_valid_size(reil_size_t size)
+{
+    return size >= U1 && size <= U64;
+}
+
+CReilSym::CReilSym()
+{
+    table.assign(SYM_TABLE_SIZE, -1);
+}
+
+//======================================================================
+// Hash-consing
+//======================================================================
+
+unsigned int CReilSym::hash(sym_node &node)
+{
+    unsigned int h = (unsigned int)node.kind;
+
+    h = sym_mix(h, (unsigned int)node.op);
+    h = sym_mix(h, (unsigned int)node.size);
+    h = sym_mix(h, (unsigned int)node.a);
+    h = sym_mix(h, (unsigned int)node.b);
+    h = sym_mix(h, (unsigned int)node.c);
+    h = sym_mix(h, (unsigned int)node.val);
+    h = sym_mix(h, (unsigned int)(node.val >> 32));
+    h = sym_mix(h, (unsigned int)node.inum);
+    h = sym_mix(h, (unsigned int)node.type);
+    h = sym_mix(h, (unsigned int)node.name);
+
+    return h;
+}
+
+bool CReilSym::same(sym_node &a, sym_node &b)
+{
+    return a.kind == b.kind && a.op == b.op && a.size == b.size &&
+           a.a == b.a && a.b == b.b && a.c == b.c && a.val == b.val &&
+           a.inum == b.inum && a.type == b.type && a.name == b.name;
+}
+
+void CReilSym::grow()
+{
+    size_t mask = table.size() * 2 - 1;
+
+    table.assign(table.size() * 2, -1);
+
+    for (size_t i = 0; i < nodes.size(); i++)
+    {
+        size_t pos = hash(nodes[i]) & mask;
+
+        while (table[pos] != -1) pos = (pos + 1) & mask;
+
+        table[pos] = (int)i;
+    }
+}
+
+int CReilSym::add(sym_node &node)
+{
+    size_t mask = table.size() - 1;
+    size_t pos = hash(node) & mask;
+
+    while (table[pos] != -1)
+    {
+        // node already exists
+        if (same(nodes[table[pos]], node)) return table[pos];
+
+        pos = (pos + 1) & mask;
+    }
+
+    int n = (int)nodes.size();
+
+    nodes.push_back(node);
+    table[pos] = n;
+
+    if (nodes.size() * 2 > table.size()) grow();
+
+    return n;
+}
+
+static void sym_init(sym_node &node, int kind, reil_size_t size)
+{
+    node.kind = kind;
+    node.op = I_NONE;
+    node.size = size;
+    node.a = node.b = node.c = -1;
+    node.val = 0;
+    node.inum = 0;
+    node.type = A_NONE;
+    node.name = -1;
+}
+
+//======================================================================
+// Nodes
+//======================================================================
+
+int CReilSym::constant(reil_const_t val, reil_size_t size)
+{
+    if (!sym_valid_size(size))
+    {
+        return REIL_ERROR;
+    }
+
+    sym_node node;
+    sym_init(node, REIL_SYM_CONST, size);
+
+    node.val = val & vm_mask(size);
+
+    return add(node);
+}
+
+int CReilSym::val(const char *name, reil_type_t type, reil_size_t size, reil_addr_t addr)
+{
+    if (!sym_valid_size(size) || (type != A_REG && type != A_TEMP))
+    {
+        return REIL_ERROR;
+    }
+
+    string key(name, strnlen(name, REIL_MAX_NAME_LEN - 1));
+    map<string, int>::iterator it = name_ids.find(key);
+
+    sym_node node;
+    sym_init(node, REIL_SYM_VAL, size);
+
+    if (it == name_ids.end())
+    {
+        node.name = name_ids[key] = (int)names.size();
+        names.push_back(key);
+    }
+    else
+    {
+        node.name = it->second;
+    }
+
+    // temporary registers are local for machine instruction
+    node.val = type == A_TEMP ? addr : 0;
+    node.type = type;
+
+    return add(node);
+}
+
+int CReilSym::ptr(int addr, reil_size_t size)
+{
+    if (!sym_valid_size(size) || !valid(addr))
+    {
+        return REIL_ERROR;
+    }
+
+    sym_node node;
+    sym_init(node, REIL_SYM_PTR, size);
+
+    node.a = addr;
+
+    return add(node);
+}
+
+int CReilSym::cond(int cond, int a, int b)
+{
+    if (!valid(cond) || !valid(a) || !valid(b))
+    {
+        return REIL_ERROR;
+    }
+
+    if (nodes[cond].kind == REIL_SYM_CONST)
+    {
+        return nodes[cond].val != 0 ? a : b;
+    }
+
+    if (a == b)
+    {
+        return a;
+    }
+
+    sym_node node;
+    sym_init(node, REIL_SYM_COND, nodes[a].size);
+
+    node.a = cond;
+    node.b = a;
+    node.c = b;
+
+    return add(node);
+}
+
+int CReilSym::loc(reil_addr_t addr, reil_inum_t inum)
+{
+    sym_node node;
+    sym_init(node, REIL_SYM_LOC, U1);
+
+    node.val = addr;
+    node.inum = inum;
+
+    return add(node);
+}
+
+int CReilSym::ip()
+{
+    sym_node node;
+    sym_init(node, REIL_SYM_IP, U1);
+
+    return add(node);
+}
+
+int CReilSym::exp(reil_op_t op, int a, int b, reil_size_t size)
+{
+    bool unary = op == I_STR || op == I_NEG || op == I_NOT;
+
+    if (op < I_STR || op > I_LT || op == I_STM || op == I_LDM || !sym_valid_size(size) ||
+        !valid(a) || (unary ? b != -1 : !valid(b)))
+    {
+        return REIL_ERROR;
+    }
+
+    return simplify(op, a, b, size);
+}
+
+bool CReilSym::node(int n, reil_sym_node_t *info)
+{
+    if (!valid(n))
+    {
+        return false;
+    }
+
+    sym_node *node = &nodes[n];
+
+    memset(info, 0, sizeof(reil_sym_node_t));
+
+    info->kind = node->kind;
+    info->op = node->op;
+    info->size = node->size;
+    info->a = node->a;
+    info->b = node->b;
+    info->c = node->c;
+    info->val = node->val;
+    info->inum = node->inum;
+    info->type = node->type;
+
+    if (node->name != -1)
+    {
+        strncpy(info->name, names[node->name].c_str(), REIL_MAX_NAME_LEN - 1);
+    }
+
+    return true;
+}
+
+//======================================================================
+// Simplification
+//======================================================================
+
+bool CReilSym::is_const(int n, reil_const_t val)
+{
+    return nodes[n].kind == REIL_SYM_CONST && nodes[n].val == (val & vm_mask(nodes[n].size));
+}
+
+int CReilSym::cast(int a, reil_size_t size)
+{
+    reil_size_t size_a = nodes[a].size;
+
+    if (size_a == size)
+    {
+        return a;
+    }
+
+    if (nodes[a].kind == REIL_SYM_CONST)
+    {
+        return constant(nodes[a].val, size);
+    }
+
+    if (nodes[a].kind == REIL_SYM_EXP && nodes[a].op == I_STR)
+    {
+        int x = nodes[a].a;
+
+        // truncation after any conversion or any conversion after extension
+        if (size <= size_a || size_a >= nodes[x].size) return cast(x, size);
+    }
+
+    sym_node node;
+    sym_init(node, REIL_SYM_EXP, size);
+
+    node.op = I_STR;
+    node.a = a;
+
+    return add(node);
+}
+
+int CReilSym::simplify(reil_op_t op, int a, int b, reil_size_t size)
+{
+    bool unary = b == -1;
+
+    if (nodes[a].kind == REIL_SYM_CONST && (unary || nodes[b].kind == REIL_SYM_CONST))
+    {
+        reil_inst_t inst;
+        reil_const_t val = 0;
+
+        memset(&inst, 0, sizeof(inst));
+
+        inst.op = op;
+        inst.a.type = A_CONST;
+        inst.a.size = nodes[a].size;
+        inst.b.type = unary ? A_NONE : A_CONST;
+        inst.b.size = unary ? U1 : nodes[b].size;
+        inst.c.type = A_TEMP;
+        inst.c.size = size;
+
+        if (dfg_eval(&inst, nodes[a].val, unary ? 0 : nodes[b].val, &val))
+        {
+            return constant(val, size);
+        }
+    }
+
+    if (op == I_STR)
+    {
+        return cast(a, size);
+    }
+
+    if (unary)
+    {
+        sym_node *arg = &nodes[a];
+
+        // ~~x and --x
+        if (arg->kind == REIL_SYM_EXP && arg->op == op &&
+            arg->size == size && nodes[arg->a].size == size)
+        {
+            return arg->a;
+        }
+    }
+    else
+    {
+        if (sym_commutative(op) &&
+            (nodes[a].kind == REIL_SYM_CONST || (nodes[b].kind != REIL_SYM_CONST && a > b)))
+        {
+            // canonical order of operands
+            swap(a, b);
+        }
+
+        reil_size_t size_a = nodes[a].size, size_b = nodes[b].size;
+        bool same_size = size_a == size && size_b == size;
+
+        if (nodes[b].kind == REIL_SYM_CONST)
+        {
+            reil_const_t val = nodes[b].val;
+
+            switch (op)
+            {
+            case I_ADD:
+            case I_SUB:
+            case I_OR:
+            case I_XOR:
+            case I_SHL:
+            case I_SHR:
+
+                if (val == 0) return cast(a, size);
+                break;
+
+            case I_MUL:
+            case I_DIV:
+
+                if (val == 1) return cast(a, size);
+                if (val == 0 && op == I_MUL) return constant(0, size);
+                break;
+
+            case I_AND:
+                {
+                    reil_const_t mask = vm_mask(min(size_a, size));
+
+                    // masking that doesn't clear any bits of the operand is conversion
+                    if (val == 0) return constant(0, size);
+                    if ((val & mask) == mask) return cast(a, size);
+                    break;
+                }
+
+            default:
+
+                break;
+            }
+
+            if (op == I_XOR && same_size && val == vm_mask(size))
+            {
+                return simplify(I_NOT, a, -1, size);
+            }
+
+            sym_node *arg = &nodes[a];
+
+            if ((op == I_ADD || op == I_MUL || op == I_AND || op == I_OR || op == I_XOR) &&
+                same_size && arg->kind == REIL_SYM_EXP && arg->op == op &&
+                nodes[arg->a].size == size && nodes[arg->b].kind == REIL_SYM_CONST &&
+                nodes[arg->b].size == size)
+            {
+                int x = arg->a;
+
+                // (x op c1) op c2 is x op (c1 op c2)
+                return simplify(op, x, simplify(op, arg->b, b, size), size);
+            }
+        }
+
+        if (a == b)
+        {
+            switch (op)
+            {
+            case I_SUB:
+            case I_XOR:
+            case I_LT:
+
+                return constant(0, size);
+
+            case I_EQ:
+
+                return constant(1, size);
+
+            case I_AND:
+            case I_OR:
+
+                return cast(a, size);
+
+            default:
+
+                break;
+            }
+        }
+
+        if (op == I_XOR && same_size)
+        {
+            int pair[] = { a, b };
+
+            // (x ^ y) ^ y
+            for (int i = 0; i < 2; i++)
+            {
+                sym_node *arg = &nodes[pair[i]];
+                int other = pair[1 - i];
+
+                if (arg->kind == REIL_SYM_EXP && arg->op == I_XOR &&
+                    nodes[arg->a].size == size && nodes[arg->b].size == size)
+                {
+                    if (arg->a == other) return arg->b;
+                    if (arg->b == other) return arg->a;
+                }
+            }
+        }
+    }
+
+    sym_node node;
+    sym_init(node, REIL_SYM_EXP, size);
+
+    node.op = op;
+    node.a = a;
+    node.b = b;
+
+    return add(node);
+}
+
+//======================================================================
+// Symbolic execution
+//======================================================================
+
+int CReilSym::arg_val(reil_inst_t *inst, reil_arg_t *arg)
+{
+    if (arg->type != A_REG && arg->type != A_TEMP)
+    {
+        return REIL_ERROR;
+    }
+
+    return val(arg->name, arg->type, arg->size, inst->raw_info.addr);
+}
+
+int CReilSym::arg(reil_inst_t *inst, reil_arg_t *arg, vector<reil_sym_item_t> &state, map<int, int> &index)
+{
+    switch (arg->type)
+    {
+    case A_NONE:
+
+        return -1;
+
+    case A_CONST:
+
+        return constant(arg->val, arg->size);
+
+    case A_LOC:
+
+        return loc(arg->val, arg->inum);
+
+    case A_REG:
+    case A_TEMP:
+        {
+            int n = arg_val(inst, arg);
+            map<int, int>::iterator it = index.find(n);
+
+            // current value or initial value of register
+            return it == index.end() ? n : state[it->second].exp;
+        }
+    }
+
+    return REIL_ERROR;
+}
+
+void CReilSym::update(vector<reil_sym_item_t> &state, map<int, int> &index, int val, int exp)
+{
+    map<int, int>::iterator it = index.find(val);
+
+    if (it != index.end())
+    {
+        state[it->second].exp = exp;
+    }
+    else
+    {
+        reil_sym_item_t item;
+
+        item.val = val;
+        item.exp = exp;
+
+        index[val] = (int)state.size();
+        state.push_back(item);
+    }
+}
+
+bool CReilSym::index_build(vector<reil_sym_item_t> &state, map<int, int> &index)
+{
+    for (size_t i = 0; i < state.size(); i++)
+    {
+        if (!valid(state[i].val) || !valid(state[i].exp))
+        {
+            return false;
+        }
+
+        index[state[i].val] = (int)i;
+    }
+
+    return true;
+}
+
+bool CReilSym::exec(reil_inst_t *insts, int count, vector<reil_sym_item_t> &state)
+{
+    map<int, int> index;
+
+    if (!index_build(state, index))
+    {
+        return false;
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        reil_inst_t *inst = &insts[i];
+
+        if (inst->op == I_NONE || inst->op == I_UNK)
+        {
+            // instruction doesn't update state
+            continue;
+        }
+
+        int a = arg(inst, &inst->a, state, index);
+        int b = arg(inst, &inst->b, state, index);
+        int val = -1, exp = -1;
+
+        if (a == -1 || (inst->b.type != A_NONE && b == -1))
+        {
+            return false;
+        }
+
+        switch (inst->op)
+        {
+        case I_STR:
+
+            val = arg_val(inst, &inst->c);
+            exp = cast(a, inst->c.size);
+            break;
+
+        case I_STM:
+            {
+                int addr = arg(inst, &inst->c, state, index);
+
+                val = addr == -1 ? REIL_ERROR : ptr(addr, inst->a.size);
+                exp = a;
+                break;
+            }
+
+        case I_LDM:
+
+            val = arg_val(inst, &inst->c);
+            exp = ptr(a, inst->c.size);
+            break;
+
+        case I_JCC:
+            {
+                int target = arg(inst, &inst->c, state, index);
+
+                if (target != -1 && nodes[target].kind == REIL_SYM_CONST)
+                {
+                    // make IR address from numeric constant
+                    target = loc(nodes[target].val, 0);
+                }
+
+                if (inst->a.type == A_CONST)
+                {
+                    // unconditional jump
+                    if (inst->a.val == 0) continue;
+
+                    exp = target;
+                }
+                else
+                {
+                    int next = (inst->flags & IOPT_ASM_END) ?
+                               loc(inst->raw_info.addr + inst->raw_info.size, 0) :
+                               loc(inst->raw_info.addr, inst->inum + 1);
+
+                    exp = target == -1 ? REIL_ERROR : cond(a, target, next);
+                }
+
+                val = ip();
+                break;
+            }
+
+        default:
+
+            val = arg_val(inst, &inst->c);
+            exp = CReilSym::exp(inst->op, a, b, inst->c.size);
+            break;
+        }
+
+        if (val == REIL_ERROR || exp == REIL_ERROR)
+        {
+            return false;
+        }
+
+        update(state, index, val, exp);
+    }
+
+    return true;
+}
+
+//======================================================================
+// Summaries
+//======================================================================
+
+int CReilSym::subst(int n, vector<reil_sym_item_t> &state, map<int, int> &index, map<int, int> &done)
+{
+    vector<pair<int, bool> > stack;
+
+    stack.push_back(make_pair(n, false));
+
+    // expressions might be very deep, so walk is not recursive
+    while (!stack.empty())
+    {
+        int cur = stack.back().first;
+
+        if (done.find(cur) != done.end())
+        {
+            stack.pop_back();
+            continue;
+        }
+
+        // nodes vector might be reallocated by new nodes
+        sym_node node = nodes[cur];
+        int args[] = { node.a, node.b, node.c };
+
+        if (!stack.back().second)
+        {
+            stack.back().second = true;
+
+            for (int i = 0; i < 3; i++)
+            {
+                if (args[i] != -1) stack.push_back(make_pair(args[i], false));
+            }
+
+            continue;
+        }
+
+        stack.pop_back();
+
+        int ret = cur;
+
+        switch (node.kind)
+        {
+        case REIL_SYM_VAL:
+            {
+                map<int, int>::iterator it = index.find(cur);
+
+                if (it != index.end()) ret = state[it->second].exp;
+
+                break;
+            }
+
+        case REIL_SYM_PTR:
+
+            ret = ptr(done[node.a], node.size);
+            break;
+
+        case REIL_SYM_EXP:
+
+            ret = simplify(node.op, done[node.a], node.b == -1 ? -1 : done[node.b], node.size);
+            break;
+
+        case REIL_SYM_COND:
+
+            ret = cond(done[node.a], done[node.b], done[node.c]);
+            break;
+        }
+
+        if (ret == REIL_ERROR)
+        {
+            return REIL_ERROR;
+        }
+
+        done[cur] = ret;
+    }
+
+    return done[n];
+}
+
+bool CReilSym::apply(vector<reil_sym_item_t> &summary, vector<reil_sym_item_t> &state)
+{
+    vector<reil_sym_item_t> items;
+    map<int, int> index, done;
+    set<int> vals;
+
+    if (!index_build(state, index))
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < summary.size(); i++)
+    {
+        reil_sym_item_t item = summary[i];
+
+        if (!valid(item.val) || !valid(item.exp))
+        {
+            return false;
+        }
+
+        if (nodes[item.val].kind == REIL_SYM_PTR)
+        {
+            int addr = subst(nodes[item.val].a, state, index, done);
+
+            // memory write address in terms of the given state
+            item.val = addr == REIL_ERROR ? REIL_ERROR : ptr(addr, nodes[item.val].size);
+        }
+
+        item.exp = subst(item.exp, state, index, done);
+
+        if (item.val == REIL_ERROR || item.exp == REIL_ERROR)
+        {
+            return false;
+        }
+
+        if (!vals.insert(item.val).second)
+        {
+            // order of aliased memory writes is lost in summary
+            return false;
+        }
+
+        items.push_back(item);
+    }
+
+    // summary expressions are using values that state had before update
+    for (size_t i = 0; i < items.size(); i++)
+    {
+        update(state, index, items[i].val, items[i].exp);
+    }
+
+    return true;
+}
+
+//======================================================================
+// C API
+//======================================================================
+
+extern "C" reil_sym_t reil_sym_init(void)
+{
+    return (reil_sym_t)new CReilSym();
+}
+
+extern "C" void reil_sym_close(reil_sym_t sym)
+{
+    delete (CReilSym *)sym;
+}
+
+extern "C" int reil_sym_const(reil_sym_t sym, reil_const_t val, reil_size_t size)
+{
+    return ((CReilSym *)sym)->constant(val, size);
+}
+
+extern "C" int reil_sym_val(reil_sym_t sym, const char *name, reil_type_t type, reil_size_t size, reil_addr_t addr)
+{
+    return ((CReilSym *)sym)->val(name, type, size, addr);
+}
+
+extern "C" int reil_sym_ptr(reil_sym_t sym, int addr, reil_size_t size)
+{
+    return ((CReilSym *)sym)->ptr(addr, size);
+}
+
+extern "C" int reil_sym_exp(reil_sym_t sym, reil_op_t op, int a, int b, reil_size_t size)
+{
+    return ((CReilSym *)sym)->exp(op, a, b, size);
+}
+
+extern "C" int reil_sym_cond(reil_sym_t sym, int cond, int a, int b)
+{
+    return ((CReilSym *)sym)->cond(cond, a, b);
+}
+
+extern "C" int reil_sym_loc(reil_sym_t sym, reil_addr_t addr, reil_inum_t inum)
+{
+    return ((CReilSym *)sym)->loc(addr, inum);
+}
+
+extern "C" int reil_sym_ip(reil_sym_t sym)
+{
+    return ((CReilSym *)sym)->ip();
+}
+
+extern "C" int reil_sym_node(reil_sym_t sym, int node, reil_sym_node_t *info)
+{
+    return ((CReilSym *)sym)->node(node, info) ? 0 : REIL_ERROR;
+}
+
+extern "C" int reil_sym_count(reil_sym_t sym)
+{
+    return ((CReilSym *)sym)->count();
+}
+
+extern "C" int reil_sym_exec(reil_sym_t sym, reil_inst_t *insts, int count,
+                             reil_sym_item_t *state, int state_count, reil_sym_item_t *out, int out_count)
+{
+    vector<reil_sym_item_t> items;
+
+    if (state && state_count > 0)
+    {
+        items.assign(state, state + state_count);
+    }
+
+    if (!((CReilSym *)sym)->exec(insts, count, items))
+    {
+        return REIL_ERROR;
+    }
+
+    int num = (int)items.size();
+
+    if (out && out_count > 0 && num > 0)
+    {
+        memcpy(out, &items[0], sizeof(reil_sym_item_t) * min(out_count, num));
+    }
+
+    return num;
+}
+
+extern "C" int reil_sym_apply(reil_sym_t sym, reil_sym_item_t *summary, int summary_count,
+                              reil_sym_item_t *state, int state_count, reil_sym_item_t *out, int out_count)
+{
+    vector<reil_sym_item_t> items, updates;
+
+    if (summary && summary_count > 0)
+    {
+        updates.assign(summary, summary + summary_count);
+    }
+
+    if (state && state_count > 0)
+    {
+        items.assign(state, state + state_count);
+    }
+
+    if (!((CReilSym *)sym)->apply(updates, items))
+    {
+        return REIL_ERROR;
+    }
+
+    int num = (int)items.size();
+
+    if (out && out_count > 0 && num > 0)
+    {
+        memcpy(out, &items[0], sizeof(reil_sym_item_t) * min(out_count, num));
+    }
+
+    return num;
+}
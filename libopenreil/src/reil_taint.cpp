@@ -0,0 +1,180 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+
+using namespace std;
+
+// OpenREIL includes
+#include "libopenreil.h"
+#include "reil_mem.h"
+#include "reil_taint.h"
+
+/*
+    Shadow state of the taint tracking for native REIL interpreter. Each
+    register has 64-bit mask of tainted bits that is indexed by register ID,
+    memory has shadow pages that are parallel to the guest memory pages and
+    keep taint bits of each guest byte. Shadow page exists only when some
+    of it's bytes were tainted, direct-mapped translation cache keeps the
+    last used pages and pages without taint.
+
+    Propagation rules are applied by interpreter instruction handlers, see
+    reil_vm.cpp. With REIL_TAINT_BYTES option taint bits are rounded to the
+    whole bytes after each operation.
+*/
+
+CReilTaint::CReilTaint(int options)
+{
+    set_options(options);
+    tlb_flush();
+}
+
+CReilTaint::~CReilTaint()
+{
+    clear();
+}
+
+void CReilTaint::set_options(int options)
+{
+    this->options = options;
+    this->bytes = (options & REIL_TAINT_BYTES) != 0;
+}
+
+void CReilTaint::reserve(int count)
+{
+    if ((int)regs.size() < count)
+    {
+        regs.resize(count, 0);
+    }
+}
+
+void CReilTaint::clear(void)
+{
+    for (map<reil_addr_t, taint_page *>::iterator it = pages.begin(); it != pages.end(); ++it)
+    {
+        delete it->second;
+    }
+
+    pages.clear();
+    tlb_flush();
+
+    for (vector<reil_const_t>::iterator it = regs.begin(); it != regs.end(); ++it)
+    {
+        *it = 0;
+    }
+}
+
+void CReilTaint::tlb_flush(void)
+{
+    for (int i = 0; i < MEM_TLB_SIZE; i++)
+    {
+        // page number never has all bits set
+        tlb[i].num = (reil_addr_t)-1;
+        tlb[i].page = NULL;
+    }
+}
+
+taint_page *CReilTaint::page_get(reil_addr_t num)
+{
+    taint_page *page = page_lookup(num);
+
+    if (page == NULL)
+    {
+        page = new taint_page;
+        memset(page->data, 0, sizeof(page->data));
+
+        pages[num] = page;
+
+        // replace cached missing page
+        tlb[num & (MEM_TLB_SIZE - 1)].page = page;
+    }
+
+    return page;
+}
+
+reil_const_t CReilTaint::load_slow(reil_addr_t addr, int len)
+{
+    uint8_t buff[sizeof(reil_const_t)];
+
+    read(addr, buff, len);
+
+    return mem_get_le(buff, len);
+}
+
+void CReilTaint::store_slow(reil_addr_t addr, int len, reil_const_t t)
+{
+    // value crosses the page boundary
+    for (int i = 0; i < len; i++)
+    {
+        store(addr + i, 1, (t >> (i * 8)) & 0xff);
+    }
+}
+
+void CReilTaint::read(reil_addr_t addr, uint8_t *buff, int size)
+{
+    while (size > 0)
+    {
+        int offs = (int)MEM_PAGE_OFFS(addr), len = min(size, MEM_PAGE_SIZE - offs);
+        taint_page *page = page_lookup(MEM_PAGE_NUM(addr));
+
+        if (page)
+        {
+            memcpy(buff, page->data + offs, len);
+        }
+        else
+        {
+            memset(buff, 0, len);
+        }
+
+        addr += len;
+        buff += len;
+        size -= len;
+    }
+}
+
+void CReilTaint::fill(reil_addr_t addr, int size, uint8_t t)
+{
+    if (bytes && t != 0)
+    {
+        t = 0xff;
+    }
+
+    while (size > 0)
+    {
+        int offs = (int)MEM_PAGE_OFFS(addr), len = min(size, MEM_PAGE_SIZE - offs);
+        taint_page *page = page_lookup(MEM_PAGE_NUM(addr));
+
+        if (page || t != 0)
+        {
+            if (page == NULL) page = page_get(MEM_PAGE_NUM(addr));
+
+            memset(page->data + offs, t, len);
+        }
+
+        addr += len;
+        size -= len;
+    }
+}
+
+int CReilTaint::sink_add(reil_addr_t addr, string name)
+{
+    taint_sink sink;
+
+    sink.addr = addr;
+    sink.name = name;
+
+    sinks.push_back(sink);
+    sink_addrs.insert(addr);
+
+    return (int)sinks.size() - 1;
+}
+
+void CReilTaint::sink_clear(void)
+{
+    sinks.clear();
+    sink_addrs.clear();
+}
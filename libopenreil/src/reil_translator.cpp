@@ -6,6 +6,8 @@
 #include <iostream>
 #include <iomanip>
 #include <string>
+#include <vector>
+#include <map>
 #include <algorithm>
 
 using namespace std;
@@ -119,11 +121,12 @@ void Relative::destroy(Constant *expr)
     delete expr;
 }
 
-CReilFromBilTranslator::CReilFromBilTranslator(VexArch arch, reil_inst_handler_t handler, void *context)
+CReilFromBilTranslator::CReilFromBilTranslator(VexArch arch, reil_inst_handler_t handler, void *context, reil_stats_t *stats)
 {
     guest = arch;
     inst_handler = handler;
     inst_handler_context = context;
+    this->stats = stats;
     reset_state(NULL);
 }
 
@@ -201,7 +204,11 @@ int32_t CReilFromBilTranslator::tempreg_alloc(void)
         }   
 
         tempreg_count += 1;     
-        if (!found) return ret;
+        if (!found) 
+        {
+            stats->temp_allocated += 1;
+            return ret;
+        }
     }
 
     reil_assert(0, "error while allocating temp registry");
@@ -262,6 +269,67 @@ uint64_t CReilFromBilTranslator::convert_special(Special *special)
     return 0;
 }
 
+uint64_t CReilFromBilTranslator::convert_rep(reil_raw_t *raw_info)
+{
+    int rep = 0, size = 4, i = 0;
+
+    if (guest != VexArchX86 || raw_info->data == NULL)
+    {
+        return 0;
+    }
+
+    for (; i < raw_info->size - 1; i++)
+    {
+        // check for legacy prefixes
+        uint8_t prefix = raw_info->data[i];
+
+        if (prefix == 0xf3 || prefix == 0xf2)
+        {
+            rep = prefix;
+        }
+        else if (prefix == 0x66)
+        {
+            size = 2;
+        }
+        else
+        {
+            // segment override and 16-bit addressing are not supported
+            break;
+        }
+    }
+
+    if (rep == 0 || i != raw_info->size - 1)
+    {
+        return 0;
+    }
+
+    reil_vm_rep_op_t op;
+    reil_vm_rep_cond_t cond = REIL_VM_REP_ALWAYS;
+
+    // string instruction opcode
+    switch (raw_info->data[i] & 0xfe)
+    {
+    case 0xa4: op = REIL_VM_REP_MOVS; break;
+    case 0xaa: op = REIL_VM_REP_STOS; break;
+    case 0xa6: op = REIL_VM_REP_CMPS; break;
+    case 0xae: op = REIL_VM_REP_SCAS; break;
+    default: return 0;
+    }
+
+    if (op == REIL_VM_REP_CMPS || op == REIL_VM_REP_SCAS)
+    {
+        cond = rep == 0xf3 ? REIL_VM_REP_EQ : REIL_VM_REP_NE;
+    }
+
+    if (!(raw_info->data[i] & 1))
+    {
+        // byte operation
+        size = 1;
+    }
+
+    return IOPT_REP_INFO(op, size, cond);
+}
+
 reil_size_t CReilFromBilTranslator::convert_operand_size(reg_t typ)
 {
     switch (typ)
@@ -385,6 +453,9 @@ void CReilFromBilTranslator::process_reil_inst(reil_inst_t *reil_inst)
         reil_inst->raw_info.data = current_raw_info->data;
         reil_inst->raw_info.str_mnem = current_raw_info->str_mnem;
         reil_inst->raw_info.str_op = current_raw_info->str_op;
+
+        // tag rep-prefixed string instructions
+        reil_inst->flags |= convert_rep(current_raw_info);
     }        
 
     reil_inst_t *temp = new reil_inst_t;
@@ -1618,6 +1689,9 @@ Stmt *CReilFromBilTranslator::get_bil_stmt(int pos)
 void CReilFromBilTranslator::process_bil(reil_raw_t *raw_info, bap_block_t *block)
 {
     int size = block->bap_ir->size();
+    uint64_t handler_time = 0;
+
+    STATS_START(bil_start);
 
     reset_state(block);
 
@@ -1640,6 +1714,8 @@ void CReilFromBilTranslator::process_bil(reil_raw_t *raw_info, bap_block_t *bloc
     {
         log_write(LOG_BIL, "   // %.8llx was not translated", raw_info->addr);
 
+        stats->insn_unknown += 1;
+
         // add metainformation about unknown instruction into the code
         process_unknown_insn();
 
@@ -1736,13 +1812,25 @@ _end:
         {
             reil_inst_t *reil_inst = *it;
 
+            STATS_START(handler_start);
+
             // call user-specified REIL instruction handler
             inst_handler(reil_inst, inst_handler_context);
+
+            STATS_END(handler_time, stats->handler.count, handler_start);
         }
     }
 
     log_write(LOG_BIL, "}");
 
+    stats->reil_emitted += translated_insts.size();
+    stats->handler.time += handler_time;
+
+    // process_bil() time not including user-specified handler time
+    STATS_END(stats->bil.time, stats->bil.count, bil_start);
+
+    stats->bil.time -= handler_time;
+
     // cleanup
     reset_state(NULL);
 
@@ -1757,7 +1845,11 @@ CReilTranslator::CReilTranslator(VexArch arch, reil_inst_handler_t handler, void
     context = init_bap_context(arch);
     assert(context);
 
-    translator = new CReilFromBilTranslator(arch, handler, handler_context);
+    memset(&stats, 0, sizeof(stats));
+
+    profile_enabled = false;
+
+    translator = new CReilFromBilTranslator(arch, handler, handler_context, &stats);
     assert(translator);
 }
 
@@ -1773,6 +1865,18 @@ int CReilTranslator::process_inst(address_t addr, uint8_t *data, int size)
     int ret = 0;
     reil_raw_t raw_info;
     memset(&raw_info, 0, sizeof(raw_info));
+
+    // remember counters values for profile
+    unsigned long long reil_emitted = stats.reil_emitted;
+    unsigned long long temp_allocated = stats.temp_allocated;
+
+#ifdef USE_STATS
+
+    unsigned long long handler_time = stats.handler.time;
+
+#endif
+
+    STATS_START(inst_start);
     
     // translate to VEX
     bap_block_t *block = generate_vex_ir(context, data, addr);
@@ -1823,12 +1927,138 @@ int CReilTranslator::process_inst(address_t addr, uint8_t *data, int size)
         Stmt::destroy(s);
     }
 
+    if (profile_enabled)
+    {
+        reil_profile_entry_t *entry = profile_entry(block);
+
+        entry->count += 1;
+        entry->reil_emitted += stats.reil_emitted - reil_emitted;
+        entry->temp_allocated += stats.temp_allocated - temp_allocated;
+
+#ifdef USE_STATS
+
+        // don't count time spent in user specified instruction handler
+        entry->time += stats_tsc() - inst_start - (stats.handler.time - handler_time);
+
+#endif
+    }
+
     delete block->bap_ir;
     delete block;        
     
+    // update VEX memory arena high-water mark
+    stats.vex_mem_max = max(stats.vex_mem_max, (unsigned long long)vx_MaxUsed());
+    stats.insn_translated += 1;
+
     // free VEX memory
     // asmir_close() is also doing that
     vx_FreeAll();
     
     return ret;
 }
+
+#define STATS_STAGE_COPY(_dst_, _src_)                      \
+                                                            \
+    (_dst_).time = stats_tsc_to_ns((_src_).time);           \
+    (_dst_).count = (_src_).count;
+
+#define STATS_STAGE_COPY_BAP(_dst_, _name_)                 \
+                                                            \
+    (_dst_).time = stats_tsc_to_ns(context->stats._name_##_time);   \
+    (_dst_).count = context->stats._name_##_count;
+
+void CReilTranslator::get_stats(reil_stats_t *ret)
+{
+    memcpy(ret, &stats, sizeof(reil_stats_t));
+
+    // libasmir translation stages
+    STATS_STAGE_COPY_BAP(ret->disasm, disasm);
+    STATS_STAGE_COPY_BAP(ret->vex, vex);
+    STATS_STAGE_COPY_BAP(ret->irbb, irbb);
+    STATS_STAGE_COPY_BAP(ret->bap, bap);
+
+    // libopenreil translation stages
+    STATS_STAGE_COPY(ret->bil, stats.bil);
+    STATS_STAGE_COPY(ret->handler, stats.handler);
+}
+
+void CReilTranslator::reset_stats(void)
+{
+    memset(&stats, 0, sizeof(stats));
+    memset(&context->stats, 0, sizeof(context->stats));
+
+    vx_ResetMaxUsed();
+}
+
+void CReilTranslator::failed_inst(void)
+{
+    stats.insn_failed += 1;
+}
+
+reil_profile_entry_t *CReilTranslator::profile_entry(bap_block_t *block)
+{
+    pair<unsigned int, string> key(block->inst_id, block->str_mnem);
+
+    map<pair<unsigned int, string>, reil_profile_entry_t>::iterator it = profile.find(key);
+    if (it != profile.end())
+    {
+        return &it->second;
+    }
+
+    reil_profile_entry_t entry;
+    memset(&entry, 0, sizeof(entry));
+
+    entry.id = block->inst_id;
+    strncpy(entry.mnem, block->str_mnem.c_str(), REIL_MAX_MNEM_LEN - 1);
+
+    return &(profile[key] = entry);
+}
+
+void CReilTranslator::profile_enable(bool enable)
+{
+    profile_enabled = enable;
+}
+
+static bool profile_compare(const reil_profile_entry_t &a, const reil_profile_entry_t &b)
+{
+    if (a.time != b.time)
+    {
+        return a.time > b.time;
+    }
+
+    return a.reil_emitted > b.reil_emitted;
+}
+
+int CReilTranslator::profile_get(reil_profile_entry_t *entries, int count)
+{
+    if (entries == NULL || count <= 0)
+    {
+        return (int)profile.size();
+    }
+
+    vector<reil_profile_entry_t> sorted;
+    map<pair<unsigned int, string>, reil_profile_entry_t>::iterator it;
+
+    for (it = profile.begin(); it != profile.end(); ++it)
+    {
+        reil_profile_entry_t entry = it->second;
+
+        entry.time = stats_tsc_to_ns(entry.time);
+        sorted.push_back(entry);
+    }
+
+    // most expensive instructions goes first
+    sort(sorted.begin(), sorted.end(), profile_compare);
+
+    for (int i = 0; i < count && i < (int)sorted.size(); i++)
+    {
+        entries[i] = sorted[i];
+    }
+
+    return (int)profile.size();
+}
+
+void CReilTranslator::profile_reset(void)
+{
+    profile.clear();
+}
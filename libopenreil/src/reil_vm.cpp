@@ -0,0 +1,1986 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <string>
+#include <deque>
+#include <vector>
+#include <map>
+#include <set>
+
+using namespace std;
+
+// OpenREIL includes
+#include "libopenreil.h"
+#include "reil_mem.h"
+#include "reil_vm.h"
+#include "reil_vm_ops.h"
+#include "reil_jit.h"
+#include "reil_taint.h"
+
+/*
+    Native REIL interpreter. Each loaded IR instruction is decoded only once
+    into vm_insn structure with pointers to the operand values and handler
+    that was chosen for given opcode and operand sizes. Instructions are linked
+    together by next and jump pointers, so in most cases execution goes without
+    any lookups.
+
+    Semantics of the instructions are the same as in pyopenreil VM.Math class:
+    result of the operation has width of the widest operand and it's casted
+    to the destination register size. The only exception is I_SDIV and I_SMOD
+    that are rounding the quotient towards zero like x86 IDIV does, while
+    VM.Math uses numpy floor division.
+*/
+
+// used when memory callbacks wasn't specified
+static int vm_mem_read_none(reil_addr_t, reil_size_t, reil_const_t *, void *)
+{
+    return REIL_ERROR;
+}
+
+static int vm_mem_write_none(reil_addr_t, reil_size_t, reil_const_t, void *)
+{
+    return REIL_ERROR;
+}
+
+//======================================================================
+// Instruction handlers
+//======================================================================
+
+static inline vm_insn *vm_next(vm_state *state, vm_insn *insn)
+{
+    if (insn->next)
+    {
+        return insn->next;
+    }
+
+    // let the interpreter to find next instruction and link it
+    state->next = insn->next_loc;
+    state->link = &insn->next;
+
+    return NULL;
+}
+
+static inline bool vm_is_code(vm_state *state, reil_addr_t addr, int len)
+{
+    if (addr >= state->code_end || addr + len <= state->code_start)
+    {
+        return false;
+    }
+
+    reil_addr_t first = addr / REIL_MEM_PAGE_SIZE, last = (addr + len - 1) / REIL_MEM_PAGE_SIZE;
+
+    return state->code_pages.find(first) != state->code_pages.end() ||
+           state->code_pages.find(last) != state->code_pages.end();
+}
+
+static inline vm_insn *vm_error(vm_state *state, reil_vm_status_t status)
+{
+    state->error = true;
+    state->status = status;
+
+    return NULL;
+}
+
+//======================================================================
+// Execution hooks
+//======================================================================
+
+static inline unsigned int vm_cov_id(reil_addr_t addr, reil_inum_t inum)
+{
+    // spread location bits over the whole coverage bitmap
+    uint64_t val = ((uint64_t)addr ^ ((uint64_t)inum << 48)) * 0x9e3779b97f4a7c15ULL;
+
+    return (unsigned int)(val >> 48) & (REIL_VM_COV_MAP_SIZE - 1);
+}
+
+static inline bool vm_hook_addr(vm_hooks *hooks, reil_addr_t addr)
+{
+    return hooks->addrs.empty() || hooks->addrs.find(addr) != hooks->addrs.end();
+}
+
+static bool vm_hook_mem(vm_hooks *hooks, reil_addr_t addr, int len)
+{
+    if (hooks->ranges.empty())
+    {
+        return true;
+    }
+
+    for (vector<pair<reil_addr_t, reil_addr_t> >::iterator it = hooks->ranges.begin(); 
+         it != hooks->ranges.end(); ++it)
+    {
+        if (addr < it->second && it->first < addr + len)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static bool vm_hook_flush(vm_state *state)
+{
+    vm_hooks *hooks = &state->hooks;
+
+    if (hooks->events.empty() || hooks->handler == NULL)
+    {
+        hooks->events.clear();
+        return true;
+    }
+
+    int ret = hooks->handler(hooks->vm, &hooks->events[0], (int)hooks->events.size(), hooks->context);
+
+    hooks->events.clear();
+
+    return ret != REIL_ERROR;
+}
+
+static bool vm_hook_queue(vm_state *state, int type, vm_insn *insn, 
+                          reil_addr_t mem_addr, reil_size_t mem_size, reil_const_t val)
+{
+    reil_vm_event_t event;
+
+    event.type = type;
+    event.addr = insn->addr;
+    event.inum = insn->inum;
+    event.mem_addr = mem_addr;
+    event.mem_size = mem_size;
+    event.val = val;
+
+    state->hooks.events.push_back(event);
+
+    // deliver events to the handler when queue is full
+    return state->hooks.events.size() < VM_HOOK_BATCH || vm_hook_flush(state);
+}
+
+// operands and result are of the same size
+template <typename T, class OP>
+static vm_insn *vm_binop(vm_state *state, vm_insn *insn)
+{
+    *insn->c = (T)OP::eval((T)*insn->a, (T)*insn->b);
+
+    return vm_next(state, insn);
+}
+
+template <class OP>
+static vm_insn *vm_binop_generic(vm_state *state, vm_insn *insn)
+{
+    *insn->c = OP::eval(*insn->a & insn->mask_a, *insn->b & insn->mask_b) & insn->mask_c;
+
+    return vm_next(state, insn);
+}
+
+template <typename T, typename S, class OP>
+static vm_insn *vm_sbinop(vm_state *state, vm_insn *insn)
+{
+    *insn->c = (T)OP::eval((S)(T)*insn->a, (S)(T)*insn->b);
+
+    return vm_next(state, insn);
+}
+
+template <class OP>
+static vm_insn *vm_sbinop_generic(vm_state *state, vm_insn *insn)
+{
+    int64_t ret = OP::eval(vm_sext(*insn->a, insn->sext_a), vm_sext(*insn->b, insn->sext_b));
+
+    // result of signed operation is sign extended to the destination size
+    *insn->c = (reil_const_t)vm_sext((reil_const_t)ret, insn->sext_r) & insn->mask_c;
+
+    return vm_next(state, insn);
+}
+
+static vm_insn *vm_none(vm_state *state, vm_insn *insn)
+{
+    return vm_next(state, insn);
+}
+
+static vm_insn *vm_invalid(vm_state *state, vm_insn *)
+{
+    return vm_error(state, REIL_VM_ERR_INSN);
+}
+
+static vm_insn *vm_ldm(vm_state *state, vm_insn *insn)
+{
+    reil_addr_t addr = *insn->a & insn->mask_a;
+    reil_const_t val = 0;
+
+    if (state->mem)
+    {
+        if (!state->mem->load(addr, insn->mem_len, &val))
+        {
+            return vm_error(state, REIL_VM_ERR_MEM);
+        }
+    }
+    else if (state->mem_read(addr, insn->mem_size, &val, state->context) == REIL_ERROR)
+    {
+        return vm_error(state, REIL_VM_ERR_MEM);
+    }
+
+    *insn->c = val & insn->mask_c;
+
+    return vm_next(state, insn);
+}
+
+static vm_insn *vm_stm(vm_state *state, vm_insn *insn)
+{
+    reil_addr_t addr = *insn->c & insn->mask_c;
+    reil_const_t val = *insn->a & insn->mask_a;
+
+    if (state->mem)
+    {
+        if (!state->mem->store(addr, insn->mem_len, val))
+        {
+            return vm_error(state, REIL_VM_ERR_MEM);
+        }
+    }
+    else if (state->mem_write(addr, insn->mem_size, val, state->context) == REIL_ERROR)
+    {
+        return vm_error(state, REIL_VM_ERR_MEM);
+    }
+
+    if (vm_is_code(state, addr, insn->mem_len))
+    {
+        // loaded instructions must be flushed before the next one
+        state->code_written = true;
+        state->next = insn->next_loc;
+        state->link = NULL;
+
+        return NULL;
+    }
+
+    return vm_next(state, insn);
+}
+
+// memory access handlers that are used only when memory hooks are enabled
+static vm_insn *vm_ldm_hook(vm_state *state, vm_insn *insn)
+{
+    reil_addr_t addr = *insn->a & insn->mask_a;
+    vm_insn *next = vm_ldm(state, insn);
+
+    if (next == NULL && state->error)
+    {
+        return NULL;
+    }
+
+    if (vm_hook_mem(&state->hooks, addr, insn->mem_len) &&
+        !vm_hook_queue(state, REIL_VM_HOOK_MEM_READ, insn, addr, insn->mem_size, *insn->c))
+    {
+        return vm_error(state, REIL_VM_ERR_HOOK);
+    }
+
+    return next;
+}
+
+static vm_insn *vm_stm_hook(vm_state *state, vm_insn *insn)
+{
+    reil_addr_t addr = *insn->c & insn->mask_c;
+    reil_const_t val = *insn->a & insn->mask_a;
+    vm_insn *next = vm_stm(state, insn);
+
+    if (next == NULL && state->error)
+    {
+        return NULL;
+    }
+
+    if (vm_hook_mem(&state->hooks, addr, insn->mem_len) &&
+        !vm_hook_queue(state, REIL_VM_HOOK_MEM_WRITE, insn, addr, insn->mem_size, val))
+    {
+        return vm_error(state, REIL_VM_ERR_HOOK);
+    }
+
+    return next;
+}
+
+static vm_insn *vm_jcc_loc(vm_state *state, vm_insn *insn)
+{
+    if ((*insn->a & insn->mask_a) == 0)
+    {
+        // condition is not taken
+        return vm_next(state, insn);
+    }
+
+    if (insn->jump)
+    {
+        return insn->jump;
+    }
+
+    state->next = insn->jump_loc;
+    state->link = &insn->jump;
+
+    return NULL;
+}
+
+static vm_insn *vm_jcc(vm_state *state, vm_insn *insn)
+{
+    if ((*insn->a & insn->mask_a) == 0)
+    {
+        // condition is not taken
+        return vm_next(state, insn);
+    }
+
+    reil_addr_t addr = *insn->c & insn->mask_c;
+
+    // check if jump goes to the same location as previous time
+    if (insn->jump && insn->jump->addr == addr && insn->jump->inum == 0)
+    {
+        return insn->jump;
+    }
+
+    state->next = VM_LOC(addr, 0);
+    state->link = &insn->jump;
+
+    return NULL;
+}
+
+template <class OP>
+static vm_handler_t vm_binop_handler(bool same_size, reil_size_t size)
+{
+    if (same_size)
+    {
+        switch (size)
+        {
+        case U8: return vm_binop<uint8_t, OP>;
+        case U16: return vm_binop<uint16_t, OP>;
+        case U32: return vm_binop<uint32_t, OP>;
+        case U64: return vm_binop<uint64_t, OP>;
+        default: break;
+        }
+    }
+
+    return vm_binop_generic<OP>;
+}
+
+template <class OP>
+static vm_handler_t vm_sbinop_handler(bool same_size, reil_size_t size)
+{
+    if (same_size)
+    {
+        switch (size)
+        {
+        case U8: return vm_sbinop<uint8_t, int8_t, OP>;
+        case U16: return vm_sbinop<uint16_t, int16_t, OP>;
+        case U32: return vm_sbinop<uint32_t, int32_t, OP>;
+        case U64: return vm_sbinop<uint64_t, int64_t, OP>;
+        default: break;
+        }
+    }
+
+    return vm_sbinop_generic<OP>;
+}
+
+//======================================================================
+// Taint tracking
+//======================================================================
+
+static bool vm_taint_event(vm_state *state, int type, vm_insn *insn, 
+                           reil_addr_t addr, reil_size_t size, reil_const_t mask)
+{
+    vm_hooks *hooks = &state->hooks;
+
+    if (!(hooks->mask & type))
+    {
+        return true;
+    }
+
+    // memory access is filtered by memory ranges, jumps by instruction addresses
+    if (type == REIL_VM_HOOK_TAINT_MEM ? !vm_hook_mem(hooks, addr, insn->mem_len) : !vm_hook_addr(hooks, insn->addr))
+    {
+        return true;
+    }
+
+    return vm_hook_queue(state, type, insn, addr, size, mask);
+}
+
+/*
+    Taint handlers are updating shadow state and calling interpreter handler
+    of the instruction. Operands values and taint bits are read before the
+    execution because destination might be the same register.
+*/
+template <class RULE>
+static vm_insn *vm_taint_binop(vm_state *state, vm_insn *insn)
+{
+    CReilTaint *taint = state->taint;
+    reil_const_t ta = taint->reg(insn->reg_a) & insn->mask_a;
+    reil_const_t tb = taint->reg(insn->reg_b) & insn->mask_b;
+
+    if ((ta | tb) == 0)
+    {
+        taint->reg_set(insn->reg_c, 0, 0);
+    }
+    else
+    {
+        reil_const_t t = RULE::prop(*insn->a & insn->mask_a, *insn->b & insn->mask_b, ta, tb);
+
+        taint->reg_set(insn->reg_c, t, insn->mask_c);
+    }
+
+    return insn->exec(state, insn);
+}
+
+static vm_insn *vm_taint_ldm(vm_state *state, vm_insn *insn)
+{
+    CReilTaint *taint = state->taint;
+    reil_addr_t addr = *insn->a & insn->mask_a;
+    reil_const_t ta = taint->reg(insn->reg_a) & insn->mask_a;
+    vm_insn *next = insn->exec(state, insn);
+
+    if (next == NULL && state->error)
+    {
+        return NULL;
+    }
+
+    reil_const_t t = taint->load(addr, insn->mem_len);
+
+    if (ta != 0)
+    {
+        if (taint->get_options() & REIL_TAINT_ADDR) t = insn->mask_c;
+
+        if (!vm_taint_event(state, REIL_VM_HOOK_TAINT_MEM, insn, addr, insn->mem_size, ta))
+        {
+            return vm_error(state, REIL_VM_ERR_HOOK);
+        }
+    }
+
+    taint->reg_set(insn->reg_c, t, insn->mask_c);
+
+    return next;
+}
+
+static vm_insn *vm_taint_stm(vm_state *state, vm_insn *insn)
+{
+    CReilTaint *taint = state->taint;
+    reil_addr_t addr = *insn->c & insn->mask_c;
+    reil_const_t ta = taint->reg(insn->reg_a) & insn->mask_a;
+    reil_const_t tc = taint->reg(insn->reg_c) & insn->mask_c;
+    vm_insn *next = insn->exec(state, insn);
+
+    if (next == NULL && state->error)
+    {
+        return NULL;
+    }
+
+    if (tc != 0)
+    {
+        if (taint->get_options() & REIL_TAINT_ADDR) ta = vm_width_mask(insn->mem_len * 8);
+
+        if (!vm_taint_event(state, REIL_VM_HOOK_TAINT_MEM, insn, addr, insn->mem_size, tc))
+        {
+            return vm_error(state, REIL_VM_ERR_HOOK);
+        }
+    }
+
+    taint->store(addr, insn->mem_len, ta);
+
+    return next;
+}
+
+static vm_insn *vm_taint_jcc(vm_state *state, vm_insn *insn)
+{
+    CReilTaint *taint = state->taint;
+    reil_const_t cond = *insn->a & insn->mask_a, addr = *insn->c & insn->mask_c;
+    reil_const_t ta = taint->reg(insn->reg_a) & insn->mask_a;
+    reil_const_t tc = taint->reg(insn->reg_c) & insn->mask_c;
+
+    if (ta != 0 && !vm_taint_event(state, REIL_VM_HOOK_TAINT_COND, insn, cond, U1, ta))
+    {
+        return vm_error(state, REIL_VM_ERR_HOOK);
+    }
+
+    if (tc != 0 && cond != 0 && !vm_taint_event(state, REIL_VM_HOOK_TAINT_JUMP, insn, addr, U1, tc))
+    {
+        return vm_error(state, REIL_VM_ERR_HOOK);
+    }
+
+    return insn->exec(state, insn);
+}
+
+static vm_handler_t vm_taint_handler(vm_insn *insn)
+{
+    switch (insn->op)
+    {
+    case I_LDM: return vm_taint_ldm;
+    case I_STM: return vm_taint_stm;
+    case I_JCC: return vm_taint_jcc;
+
+    default: break;
+    }
+
+    if (insn->reg_c < 0)
+    {
+        // I_NONE, I_UNK or invalid instruction
+        return insn->exec;
+    }
+
+    switch (insn->op)
+    {
+    case I_STR: return vm_taint_binop<vm_taint_str>;
+    case I_ADD: return vm_taint_binop<vm_taint_add>;
+    case I_SUB: return vm_taint_binop<vm_taint_sub>;
+    case I_NEG: return vm_taint_binop<vm_taint_neg>;
+    case I_MUL: return vm_taint_binop<vm_taint_mul>;
+    case I_DIV: return vm_taint_binop<vm_taint_div>;
+    case I_MOD: return vm_taint_binop<vm_taint_div>;
+    case I_SHL: return vm_taint_binop<vm_taint_shl>;
+    case I_SHR: return vm_taint_binop<vm_taint_shr>;
+    case I_AND: return vm_taint_binop<vm_taint_and>;
+    case I_OR:  return vm_taint_binop<vm_taint_or>;
+    case I_XOR: return vm_taint_binop<vm_taint_xor>;
+    case I_NOT: return vm_taint_binop<vm_taint_not>;
+    case I_EQ:  return vm_taint_binop<vm_taint_eq>;
+    case I_LT:  return vm_taint_binop<vm_taint_lt>;
+
+    // signed results are sign extended, smeared taint covers the extended bits as well
+    case I_SMUL: return vm_taint_binop<vm_taint_mul>;
+    case I_SDIV: return vm_taint_binop<vm_taint_div>;
+    case I_SMOD: return vm_taint_binop<vm_taint_div>;
+
+    default: break;
+    }
+
+    return insn->exec;
+}
+
+//======================================================================
+// Interpreter
+//======================================================================
+
+CReilVM::CReilVM(reil_arch_t arch, reil_vm_fetch_t fetch,
+                 reil_vm_mem_read_t mem_read, reil_vm_mem_write_t mem_write, void *context)
+{
+    string ip_name;
+
+    switch (arch)
+    {
+    case ARCH_X86:
+
+        ip_name = "R_EIP";
+        break;
+
+    case ARCH_ARM:
+
+        ip_name = "R_R15T";
+        break;
+
+    default:
+
+        throw CReilVMException("Unknown architecture");
+    }
+
+    this->fetch = fetch;
+    this->context = context;
+
+    state.mem = NULL;
+    state.mem_read = mem_read ? mem_read : vm_mem_read_none;
+    state.mem_write = mem_write ? mem_write : vm_mem_write_none;
+    state.context = context;
+    state.error = false;
+    state.link = NULL;
+
+    state.code_start = (reil_addr_t)-1;
+    state.code_end = 0;
+    state.code_written = false;
+    state.exit = NULL;
+
+    state.hooks.mask = 0;
+    state.hooks.handler = NULL;
+    state.hooks.context = NULL;
+    state.hooks.vm = (reil_vm_t)this;
+
+    state.taint = NULL;
+
+    memset(cov_bitmap, 0, sizeof(cov_bitmap));
+    cov_prev = 0;
+
+    reg_ip = reg_create(ip_name, U32, false);
+
+    current = VM_LOC(0, 0);
+    executed = 0;
+
+    jit = NULL;
+    shared = false;
+}
+
+CReilVM::~CReilVM()
+{
+    if (jit) delete jit;
+    if (state.taint) delete state.taint;
+}
+
+vm_reg *CReilVM::reg_find(string name)
+{
+    map<string, vm_reg *>::iterator it = regs_map.find(name);
+
+    return it == regs_map.end() ? NULL : it->second;
+}
+
+vm_reg *CReilVM::reg_create(string name, reil_size_t size, bool temp)
+{
+    vm_reg reg;
+
+    vm_mask(size);
+
+    reg.id = (int)regs.size();
+    reg.name = name;
+    reg.size = size;
+    reg.val = 0;
+    reg.temp = temp;
+
+    regs.push_back(reg);
+
+    if (state.taint)
+    {
+        state.taint->reserve((int)regs.size());
+    }
+
+    return regs_map[name] = &regs.back();
+}
+
+void CReilVM::decode_arg(reil_arg_t *arg, reil_const_t **val, reil_const_t *imm, reil_size_t *size, int *id)
+{
+    vm_reg *reg = NULL;
+
+    *val = imm;
+    *imm = 0;
+    *id = -1;
+
+    switch (arg->type)
+    {
+    case A_NONE:
+
+        break;
+
+    case A_REG:
+    case A_TEMP:
+
+        if ((reg = reg_find(arg->name)) != NULL && reg->size != arg->size && arg->type == A_TEMP)
+        {
+            static const int bits[] = { 1, 8, 16, 32, 64 };
+            char name[REIL_MAX_NAME_LEN + 8];
+
+            // other machine instructions may use the same temp name with different size
+            sprintf(name, "%s:%d", arg->name, bits[arg->size]);
+
+            reg = reg_find(name);
+
+            if (reg == NULL)
+            {
+                reg = reg_create(name, arg->size, true);
+            }
+        }
+        else if (reg == NULL)
+        {
+            // register size is determined by the first instruction that uses it
+            reg = reg_create(arg->name, arg->size, arg->type == A_TEMP);
+        }
+
+        *val = &reg->val;
+        *size = reg->size;
+        *id = reg->id;
+        break;
+
+    case A_CONST:
+
+        *imm = arg->val & vm_mask(arg->size);
+        *size = arg->size;
+        break;
+
+    case A_LOC:
+
+        *size = U64;
+        break;
+
+    default:
+
+        throw CReilVMException("Invalid operand type");
+    }
+}
+
+vm_handler_t CReilVM::decode_handler(reil_op_t op, reil_size_t size_a, reil_size_t size_b, reil_size_t size_c)
+{
+    // fast handlers are used when all operands are of the same size
+    bool same_size = size_a == size_b && size_a == size_c;
+
+    switch (op)
+    {
+    case I_STR: return vm_binop_handler<vm_op_str>(same_size, size_a);
+    case I_ADD: return vm_binop_handler<vm_op_add>(same_size, size_a);
+    case I_SUB: return vm_binop_handler<vm_op_sub>(same_size, size_a);
+    case I_NEG: return vm_binop_handler<vm_op_neg>(same_size, size_a);
+    case I_MUL: return vm_binop_handler<vm_op_mul>(same_size, size_a);
+    case I_DIV: return vm_binop_handler<vm_op_div>(same_size, size_a);
+    case I_MOD: return vm_binop_handler<vm_op_mod>(same_size, size_a);
+    case I_SHL: return vm_binop_handler<vm_op_shl>(same_size, size_a);
+    case I_SHR: return vm_binop_handler<vm_op_shr>(same_size, size_a);
+    case I_AND: return vm_binop_handler<vm_op_and>(same_size, size_a);
+    case I_OR:  return vm_binop_handler<vm_op_or>(same_size, size_a);
+    case I_XOR: return vm_binop_handler<vm_op_xor>(same_size, size_a);
+    case I_NOT: return vm_binop_handler<vm_op_not>(same_size, size_a);
+
+    // result of comparison is always 0 or 1, so destination size doesn't matter
+    case I_EQ: return vm_binop_handler<vm_op_eq>(size_a == size_b, size_a);
+    case I_LT: return vm_binop_handler<vm_op_lt>(size_a == size_b, size_a);
+
+    case I_SMUL: return vm_sbinop_handler<vm_op_smul>(same_size, size_a);
+    case I_SDIV: return vm_sbinop_handler<vm_op_sdiv>(same_size, size_a);
+    case I_SMOD: return vm_sbinop_handler<vm_op_smod>(same_size, size_a);
+
+    default: break;
+    }
+
+    return vm_invalid;
+}
+
+void CReilVM::load(reil_inst_t *inst, VM_LOC next)
+{
+    VM_LOC loc(inst->raw_info.addr, inst->inum);
+    vm_insn *insn = NULL;
+
+    map<VM_LOC, vm_insn *>::iterator it = insns_map.find(loc);
+    if (it != insns_map.end())
+    {
+        if (shared)
+        {
+            // batch worker threads are reading loaded instructions without the lock
+            return;
+        }
+
+        // replace previously loaded instruction, it might be a part of compiled code
+        insn = it->second;
+        jit_flush();
+    }
+    else
+    {
+        insns.push_back(vm_insn());
+        insn = insns_map[loc] = &insns.back();
+
+        insn->events = 0;
+        insn->bb_hits = 0;
+    }
+
+    reil_addr_t code_end = inst->raw_info.addr + max(inst->raw_info.size, 1);
+
+    // remember location of the machine code to detect it's modifications
+    for (reil_addr_t page = inst->raw_info.addr / REIL_MEM_PAGE_SIZE;
+         page <= (code_end - 1) / REIL_MEM_PAGE_SIZE; page++)
+    {
+        state.code_pages.insert(page);
+    }
+
+    state.code_start = min(state.code_start, inst->raw_info.addr);
+    state.code_end = max(state.code_end, code_end);
+
+    reil_size_t size_a = U1, size_b = U1, size_c = U1;
+
+    insn->handler = vm_invalid;
+    insn->hits = 0;
+    insn->addr = loc.first;
+    insn->inum = loc.second;
+    insn->op = inst->op;
+    insn->stop = is_stop(loc.first, loc.second);
+    insn->compiled = false;
+    insn->cov_id = vm_cov_id(loc.first, loc.second);
+
+    map<reil_addr_t, vm_rep>::iterator it_rep = reps.find(loc.first);
+    insn->rep = (loc.second == 0 && it_rep != reps.end()) ? &it_rep->second : NULL;
+
+    insn->next = insn->jump = NULL;
+    insn->next_loc = next;
+    insn->jump_loc = VM_LOC(inst->c.val, inst->c.inum);
+
+    decode_arg(&inst->a, &insn->a, &insn->imm_a, &size_a, &insn->reg_a);
+    decode_arg(&inst->b, &insn->b, &insn->imm_b, &size_b, &insn->reg_b);
+    decode_arg(&inst->c, &insn->c, &insn->imm_c, &size_c, &insn->reg_c);
+
+    bool has_b = inst->b.type != A_NONE;
+
+    // unary operations are working with the size of the first operand
+    if (!has_b) size_b = size_a;
+
+    // result has width of the widest operand
+    int width = max(vm_width(size_a), vm_width(size_b));
+
+    insn->mask_a = vm_mask(size_a);
+    insn->mask_b = vm_mask(size_b);
+    insn->mask_c = vm_mask(size_c);
+    insn->mem_size = U1;
+    insn->mem_len = 1;
+
+    insn->sext_a = 64 - vm_width(size_a);
+    insn->sext_b = 64 - vm_width(size_b);
+    insn->sext_r = 64 - width;
+
+    switch (inst->op)
+    {
+    case I_NONE:
+
+        insn->handler = vm_none;
+        break;
+
+    case I_JCC:
+
+        insn->handler = inst->c.type == A_LOC ? vm_jcc_loc : vm_jcc;
+
+        // constant target is known before execution
+        if (inst->c.type == A_CONST) insn->jump_loc = VM_LOC(insn->imm_c & insn->mask_c, 0);
+        break;
+
+    case I_LDM:
+
+        insn->mem_size = inst->c.size;
+        insn->mem_len = vm_width(inst->c.size) / 8;
+        insn->handler = (state.hooks.mask & REIL_VM_HOOK_MEM_READ) ? vm_ldm_hook : vm_ldm;
+        break;
+
+    case I_STM:
+
+        insn->mem_size = inst->a.size;
+        insn->mem_len = vm_width(inst->a.size) / 8;
+        insn->handler = (state.hooks.mask & REIL_VM_HOOK_MEM_WRITE) ? vm_stm_hook : vm_stm;
+        break;
+
+    default:
+
+        if (inst->c.type != A_REG && inst->c.type != A_TEMP)
+        {
+            insn->handler = vm_invalid;
+            break;
+        }
+
+        if (inst->op != I_SMUL && inst->op != I_SDIV && inst->op != I_SMOD)
+        {
+            // result mask for generic handlers, signed results are sign extended instead
+            insn->mask_c &= vm_width_mask(width);
+        }
+
+        if (size_a == U1 && size_b == U1)
+        {
+            // the same hack for one bit operands as in pyopenreil VM.Math
+            insn->mask_c &= 1;
+        }
+
+        insn->handler = decode_handler(inst->op, size_a, size_b, size_c);
+        break;
+    }
+
+    insn->exec = insn->handler;
+    insn->handler = insn_handler(insn);
+
+    // reloaded instruction keeps it's basic block flag and hits
+    insn->events = (insn->events & VM_EVENT_BB) | hook_events(insn);
+}
+
+void CReilVM::flush(void)
+{
+    jit_flush();
+
+    for (deque<vm_insn>::iterator it = insns.begin(); it != insns.end(); ++it)
+    {
+        // keep hit counters of unloaded basic blocks
+        if (it->bb_hits > 0) cov_hits[VM_LOC(it->addr, it->inum)] += it->bb_hits;
+    }
+
+    insns_map.clear();
+    insns.clear();
+    reps.clear();
+
+    state.code_pages.clear();
+    state.code_start = (reil_addr_t)-1;
+    state.code_end = 0;
+}
+
+void CReilVM::rep_add(reil_addr_t addr, reil_vm_rep_t *rep)
+{
+    const char *names[VM_REP_REGS] = { rep->count, rep->src, rep->dst, rep->val, rep->dir };
+    vm_rep *item = &reps[addr];
+
+    if (rep->count == NULL || rep->dst == NULL || rep->dir == NULL || 
+        rep->size <= 0 || rep->size > (int)sizeof(reil_const_t))
+    {
+        throw CReilVMException("Invalid rep instruction information");
+    }
+
+    item->op = rep->op;
+    item->cond = rep->cond;
+    item->size = rep->size;
+
+    for (int i = 0; i < VM_REP_REGS; i++)
+    {
+        item->names[i] = names[i] ? names[i] : "";
+        item->regs[i] = NULL;
+    }
+
+    map<VM_LOC, vm_insn *>::iterator it = insns_map.find(VM_LOC(addr, 0));
+    if (it != insns_map.end())
+    {
+        it->second->rep = item;
+    }
+}
+
+bool CReilVM::rep_range(reil_const_t ptr, reil_const_t mask, bool back, int len, int size, reil_addr_t *addr)
+{
+    if (back)
+    {
+        // pointer points to the last element of the range
+        if (ptr + size < (reil_const_t)len)
+        {
+            return false;
+        }
+
+        *addr = ptr + size - len;
+    }
+    else
+    {
+        if (ptr + len - 1 > mask)
+        {
+            return false;
+        }
+
+        *addr = ptr;
+    }
+
+    return true;
+}
+
+void CReilVM::rep_execute(vm_rep *rep)
+{
+    uint8_t src[VM_REP_CHUNK], dst[VM_REP_CHUNK];
+    vm_reg **regs = rep->regs;
+    CReilMem *mem = state.mem;
+    int size = rep->size;
+
+    for (int i = 0; i < VM_REP_REGS; i++)
+    {
+        if (regs[i] == NULL && !rep->names[i].empty() && (regs[i] = reg_find(rep->names[i])) == NULL)
+        {
+            // register is not used yet, let IR code to execute the instruction
+            return;
+        }
+    }
+
+    vm_reg *count = regs[VM_REP_COUNT], *src_ptr = regs[VM_REP_SRC], *dst_ptr = regs[VM_REP_DST];
+    reil_const_t mask = vm_mask(dst_ptr->size), count_mask = vm_mask(count->size);
+    reil_const_t dir = regs[VM_REP_DIR]->val & vm_mask(regs[VM_REP_DIR]->size);
+    reil_const_t val = regs[VM_REP_VAL] ? regs[VM_REP_VAL]->val : 0;
+
+    if (dir != 1 && dir != vm_mask(regs[VM_REP_DIR]->size))
+    {
+        return;
+    }
+
+    bool back = dir != 1;
+
+    // CMPS and SCAS are stopped by not equal elements unless it's REPNE
+    bool eq = rep->cond != REIL_VM_REP_NE;
+
+    while ((count->val & count_mask) > 0)
+    {
+        reil_const_t num = min(count->val & count_mask, (reil_const_t)(VM_REP_CHUNK / size));
+        reil_addr_t src_addr = 0, dst_addr = 0;
+
+        if (rep->op == REIL_VM_REP_CMPS || rep->op == REIL_VM_REP_SCAS)
+        {
+            // the last iteration is executed by IR code to set the flags
+            num = min(num, (count->val & count_mask) - 1);
+        }
+
+        int len = (int)num * size;
+
+        if (num == 0 || !rep_range(dst_ptr->val & mask, mask, back, len, size, &dst_addr) ||
+            (src_ptr && !rep_range(src_ptr->val & mask, mask, back, len, size, &src_addr)))
+        {
+            return;
+        }
+
+        if (src_ptr == NULL)
+        {
+            // STOS and SCAS are using the value register
+            for (int i = 0; i < len; i += size) mem_put_le(src + i, size, val);
+        }
+        else if (!mem->read(src_addr, src, len))
+        {
+            return;
+        }
+
+        if (rep->op == REIL_VM_REP_MOVS || rep->op == REIL_VM_REP_STOS)
+        {
+            // overlapped copying and writes into the loaded code are left for IR code
+            if ((src_ptr && src_addr < dst_addr + len && dst_addr < src_addr + len) ||
+                (dst_addr < state.code_end && state.code_start < dst_addr + len))
+            {
+                return;
+            }
+
+            if (!mem->write(dst_addr, src, len))
+            {
+                return;
+            }
+        }
+        else
+        {
+            if (!mem->read(dst_addr, dst, len))
+            {
+                return;
+            }
+
+            for (reil_const_t i = 0; i < num; i++)
+            {
+                int offs = (int)(back ? num - 1 - i : i) * size;
+
+                if ((memcmp(src + offs, dst + offs, size) == 0) != eq)
+                {
+                    // this element stops the loop
+                    num = i;
+                    break;
+                }
+            }
+        }
+
+        reil_const_t step = num * size;
+
+        if (src_ptr) src_ptr->val = (back ? src_ptr->val - step : src_ptr->val + step) & mask;
+        dst_ptr->val = (back ? dst_ptr->val - step : dst_ptr->val + step) & mask;
+        count->val = (count->val - num) & count_mask;
+
+        if ((int)step < len)
+        {
+            break;
+        }
+    }
+}
+
+bool CReilVM::reg_get(string name, reil_size_t *size, reil_const_t *val)
+{
+    vm_reg *reg = reg_find(name);
+
+    if (reg == NULL)
+    {
+        return false;
+    }
+
+    if (size) *size = reg->size;
+    if (val) *val = reg->val & vm_mask(reg->size);
+
+    return true;
+}
+
+void CReilVM::reg_set(string name, reil_size_t size, reil_const_t val)
+{
+    vm_reg *reg = reg_find(name);
+
+    if (reg == NULL)
+    {
+        reg = reg_create(name, size, false);
+    }
+
+    reg->val = val & vm_mask(reg->size);
+}
+
+int CReilVM::reg_list(reil_vm_reg_t *regs, int count)
+{
+    int num = 0;
+
+    for (deque<vm_reg>::iterator it = this->regs.begin(); it != this->regs.end(); ++it)
+    {
+        if (regs && num < count)
+        {
+            reil_vm_reg_t *reg = &regs[num];
+
+            strncpy(reg->name, it->name.c_str(), REIL_MAX_NAME_LEN - 1);
+            reg->name[REIL_MAX_NAME_LEN - 1] = '\0';
+
+            reg->size = it->size;
+            reg->val = it->val;
+            reg->temp = it->temp ? 1 : 0;
+        }
+
+        num += 1;
+    }
+
+    return num;
+}
+
+void CReilVM::reset(void)
+{
+    for (deque<vm_reg>::iterator it = regs.begin(); it != regs.end(); ++it)
+    {
+        it->val = 0;
+    }
+}
+
+void CReilVM::reset_temp(void)
+{
+    for (deque<vm_reg>::iterator it = regs.begin(); it != regs.end(); ++it)
+    {
+        if (it->temp) it->val = 0;
+    }
+}
+
+bool CReilVM::is_stop(reil_addr_t addr, reil_inum_t inum)
+{
+    if (stop_addrs.empty() && stop_points.empty())
+    {
+        return false;
+    }
+
+    return stop_addrs.find(addr) != stop_addrs.end() ||
+           stop_points.find(VM_LOC(addr, inum)) != stop_points.end();
+}
+
+void CReilVM::stop_add(reil_addr_t addr, int inum)
+{
+    if (inum == REIL_VM_ANY_INUM)
+    {
+        stop_addrs.insert(addr);
+    }
+    else
+    {
+        stop_points.insert(VM_LOC(addr, (reil_inum_t)inum));
+    }
+
+    // compiled code doesn't check for stop points
+    jit_flush();
+
+    // update already loaded instructions
+    for (deque<vm_insn>::iterator it = insns.begin(); it != insns.end(); ++it)
+    {
+        it->stop = is_stop(it->addr, it->inum);
+    }
+}
+
+void CReilVM::stop_clear(void)
+{
+    stop_addrs.clear();
+    stop_points.clear();
+
+    for (deque<vm_insn>::iterator it = insns.begin(); it != insns.end(); ++it)
+    {
+        it->stop = false;
+    }
+}
+
+vm_snapshot *CReilVM::snapshot(void)
+{
+    vm_snapshot *snap = new vm_snapshot;
+
+    snap->regs.assign(regs.begin(), regs.end());
+
+    return snap;
+}
+
+void CReilVM::restore(vm_snapshot *snap)
+{
+    size_t num = 0;
+
+    // snapshot of the same interpreter has registers in the same order
+    while (num < snap->regs.size() && num < regs.size() && regs[num].name == snap->regs[num].name)
+    {
+        num += 1;
+    }
+
+    if (num < snap->regs.size())
+    {
+        reset();
+
+        // find or create registers by name
+        for (vector<vm_reg>::iterator it = snap->regs.begin(); it != snap->regs.end(); ++it)
+        {
+            vm_reg *reg = reg_find(it->name);
+
+            if (reg == NULL)
+            {
+                reg = reg_create(it->name, it->size, it->temp);
+            }
+
+            reg->val = it->val & vm_mask(reg->size);
+        }
+
+        return;
+    }
+
+    for (num = 0; num < regs.size(); num++)
+    {
+        // registers that were created after snapshot are set to zero
+        regs[num].val = num < snap->regs.size() ? snap->regs[num].val : 0;
+    }
+}
+
+void CReilVM::set_mem(CReilMem *mem)
+{
+    state.mem = mem;
+}
+
+bool CReilVM::jit_enable(bool enable)
+{
+    if (enable && jit == NULL)
+    {
+        jit = new CReilJIT(&reg_ip->val, vm_mask(reg_ip->size), &executed, &state.exit);
+
+        if (!jit->is_available())
+        {
+            // not supported by the host
+            delete jit;
+            jit = NULL;
+
+            return false;
+        }
+    }
+    else if (!enable && jit)
+    {
+        jit_flush();
+
+        delete jit;
+        jit = NULL;
+    }
+
+    return true;
+}
+
+void CReilVM::jit_compile(vm_insn *insn)
+{
+    if (!jit->compile(insn))
+    {
+        // executable memory is full, start from scratch
+        jit_flush();
+        jit->compile(insn);
+    }
+}
+
+void CReilVM::jit_flush(void)
+{
+    if (jit == NULL)
+    {
+        return;
+    }
+
+    jit->flush();
+
+    for (deque<vm_insn>::iterator it = insns.begin(); it != insns.end(); ++it)
+    {
+        it->hits = 0;
+        it->compiled = false;
+    }
+}
+
+vm_handler_t CReilVM::insn_handler(vm_insn *insn)
+{
+    // taint handler calls interpreter handler by itself
+    return state.taint ? vm_taint_handler(insn) : insn->exec;
+}
+
+void CReilVM::taint_enable(bool enable, int options)
+{
+    if (enable && state.taint)
+    {
+        state.taint->set_options(options);
+        return;
+    }
+
+    if (enable)
+    {
+        state.taint = new CReilTaint(options);
+        state.taint->reserve((int)regs.size());
+    }
+    else if (state.taint)
+    {
+        delete state.taint;
+        state.taint = NULL;
+    }
+    else
+    {
+        return;
+    }
+
+    // update handlers and sink events of loaded instructions
+    hook_update();
+}
+
+bool CReilVM::taint_clear(void)
+{
+    if (state.taint == NULL)
+    {
+        return false;
+    }
+
+    state.taint->clear();
+
+    return true;
+}
+
+bool CReilVM::taint_reg_get(string name, reil_const_t *mask)
+{
+    vm_reg *reg = reg_find(name);
+
+    if (state.taint == NULL || reg == NULL)
+    {
+        return false;
+    }
+
+    *mask = state.taint->reg(reg->id) & vm_mask(reg->size);
+
+    return true;
+}
+
+bool CReilVM::taint_reg_set(string name, reil_const_t mask)
+{
+    vm_reg *reg = reg_find(name);
+
+    if (state.taint == NULL || reg == NULL)
+    {
+        return false;
+    }
+
+    state.taint->reg_set(reg->id, mask, vm_mask(reg->size));
+
+    return true;
+}
+
+bool CReilVM::taint_mem_get(reil_addr_t addr, uint8_t *buff, int size)
+{
+    if (state.taint == NULL || size < 0)
+    {
+        return false;
+    }
+
+    state.taint->read(addr, buff, size);
+
+    return true;
+}
+
+bool CReilVM::taint_mem_set(reil_addr_t addr, int size, uint8_t mask)
+{
+    if (state.taint == NULL || size < 0)
+    {
+        return false;
+    }
+
+    state.taint->fill(addr, size, mask);
+
+    return true;
+}
+
+int CReilVM::taint_sink_add(reil_addr_t addr, string name)
+{
+    if (state.taint == NULL)
+    {
+        return REIL_ERROR;
+    }
+
+    int id = state.taint->sink_add(addr, name);
+
+    hook_update();
+
+    return id;
+}
+
+bool CReilVM::taint_sink_clear(void)
+{
+    if (state.taint == NULL)
+    {
+        return false;
+    }
+
+    state.taint->sink_clear();
+
+    hook_update();
+
+    return true;
+}
+
+bool CReilVM::taint_sink(vm_insn *insn)
+{
+    CReilTaint *taint = state.taint;
+
+    if (taint == NULL || !(state.hooks.mask & REIL_VM_HOOK_TAINT_SINK))
+    {
+        return true;
+    }
+
+    for (size_t i = 0; i < taint->sinks.size(); i++)
+    {
+        vm_reg *reg = NULL;
+
+        if (taint->sinks[i].addr != insn->addr || (reg = reg_find(taint->sinks[i].name)) == NULL)
+        {
+            continue;
+        }
+
+        reil_const_t mask = taint->reg(reg->id) & vm_mask(reg->size);
+
+        if (mask != 0 && !vm_hook_queue(&state, REIL_VM_HOOK_TAINT_SINK, insn, i, reg->size, mask))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int CReilVM::hook_events(vm_insn *insn)
+{
+    int events = 0;
+
+    if ((state.hooks.mask & REIL_VM_HOOK_INSN) && insn->inum == 0 && vm_hook_addr(&state.hooks, insn->addr))
+    {
+        events |= VM_EVENT_INSN;
+    }
+
+    if (state.taint && insn->inum == 0 && state.taint->is_sink(insn->addr))
+    {
+        events |= VM_EVENT_SINK;
+    }
+
+    return events;
+}
+
+void CReilVM::hook_update(void)
+{
+    int mask = state.hooks.mask;
+
+    // compiled code calls memory handlers directly and doesn't check for events
+    jit_flush();
+
+    for (deque<vm_insn>::iterator it = insns.begin(); it != insns.end(); ++it)
+    {
+        if (it->op == I_LDM)
+        {
+            it->exec = (mask & REIL_VM_HOOK_MEM_READ) ? vm_ldm_hook : vm_ldm;
+        }
+        else if (it->op == I_STM)
+        {
+            it->exec = (mask & REIL_VM_HOOK_MEM_WRITE) ? vm_stm_hook : vm_stm;
+        }
+
+        it->handler = insn_handler(&*it);
+
+        it->events = (it->events & VM_EVENT_BB) | hook_events(&*it);
+    }
+}
+
+void CReilVM::hook_set(int mask, reil_vm_hook_t handler, void *context)
+{
+    if (mask != 0 && handler == NULL)
+    {
+        throw CReilVMException("Hook handler is not specified");
+    }
+
+    state.hooks.mask = mask;
+    state.hooks.handler = handler;
+    state.hooks.context = context;
+
+    hook_update();
+}
+
+void CReilVM::hook_addr_add(reil_addr_t addr)
+{
+    state.hooks.addrs.insert(addr);
+
+    hook_update();
+}
+
+void CReilVM::hook_mem_add(reil_addr_t addr, int size)
+{
+    if (size <= 0)
+    {
+        throw CReilVMException("Invalid memory range");
+    }
+
+    state.hooks.ranges.push_back(make_pair(addr, addr + size));
+}
+
+void CReilVM::hook_clear(void)
+{
+    state.hooks.mask = 0;
+    state.hooks.handler = NULL;
+    state.hooks.context = NULL;
+
+    state.hooks.addrs.clear();
+    state.hooks.ranges.clear();
+    state.hooks.events.clear();
+
+    hook_update();
+}
+
+int CReilVM::cov_list(reil_vm_cov_t *items, int count)
+{
+    map<VM_LOC, unsigned long long> hits(cov_hits);
+    int num = 0;
+
+    for (deque<vm_insn>::iterator it = insns.begin(); it != insns.end(); ++it)
+    {
+        if (it->bb_hits > 0) hits[VM_LOC(it->addr, it->inum)] += it->bb_hits;
+    }
+
+    for (map<VM_LOC, unsigned long long>::iterator it = hits.begin(); it != hits.end(); ++it)
+    {
+        if (items && num < count)
+        {
+            items[num].addr = it->first.first;
+            items[num].inum = it->first.second;
+            items[num].hits = it->second;
+        }
+
+        num += 1;
+    }
+
+    return num;
+}
+
+void CReilVM::cov_reset(void)
+{
+    memset(cov_bitmap, 0, sizeof(cov_bitmap));
+    cov_prev = 0;
+    cov_hits.clear();
+
+    for (deque<vm_insn>::iterator it = insns.begin(); it != insns.end(); ++it)
+    {
+        it->bb_hits = 0;
+    }
+}
+
+void CReilVM::bb_mark(vm_insn *insn)
+{
+    if (insn->events & VM_EVENT_BB)
+    {
+        return;
+    }
+
+    if (insn->compiled)
+    {
+        // compiled code must return to the interpreter before this instruction
+        jit_flush();
+    }
+
+    insn->events |= VM_EVENT_BB;
+}
+
+bool CReilVM::on_events(vm_insn *insn)
+{
+    vm_hooks *hooks = &state.hooks;
+
+    if (insn->events & VM_EVENT_BB)
+    {
+        insn->bb_hits += 1;
+
+        // the same edge coverage as AFL instrumentation collects
+        cov_bitmap[insn->cov_id ^ cov_prev] += 1;
+        cov_prev = insn->cov_id >> 1;
+
+        if ((hooks->mask & REIL_VM_HOOK_BB) && vm_hook_addr(hooks, insn->addr) &&
+            !vm_hook_queue(&state, REIL_VM_HOOK_BB, insn, 0, U1, 0))
+        {
+            return false;
+        }
+    }
+
+    if ((insn->events & VM_EVENT_INSN) && !vm_hook_queue(&state, REIL_VM_HOOK_INSN, insn, 0, U1, 0))
+    {
+        return false;
+    }
+
+    if ((insn->events & VM_EVENT_SINK) && !taint_sink(insn))
+    {
+        return false;
+    }
+
+    return true;
+}
+
+vm_insn *CReilVM::fetch_insn(VM_LOC loc)
+{
+    map<VM_LOC, vm_insn *>::iterator it = insns_map.find(loc);
+    if (it != insns_map.end())
+    {
+        return it->second;
+    }
+
+    if (fetch == NULL || fetch((reil_vm_t)this, loc.first, loc.second, context) == REIL_ERROR)
+    {
+        return NULL;
+    }
+
+    // callback must load requested instruction
+    it = insns_map.find(loc);
+
+    return it == insns_map.end() ? NULL : it->second;
+}
+
+reil_vm_status_t CReilVM::run(VM_LOC loc)
+{
+    reil_vm_status_t status = execute(loc);
+
+    // deliver the rest of queued events
+    if (!vm_hook_flush(&state) && status == REIL_VM_STOP)
+    {
+        status = REIL_VM_ERR_HOOK;
+    }
+
+    return status;
+}
+
+reil_vm_status_t CReilVM::execute(VM_LOC loc)
+{
+    reil_const_t ip_mask = vm_mask(reg_ip->size);
+    vm_insn *insn = NULL, *next = NULL;
+
+    state.error = false;
+    current = loc;
+
+    // IP register is updated before fetching of each instruction
+    reg_ip->val = loc.first & ip_mask;
+
+    if ((insn = fetch_insn(loc)) == NULL)
+    {
+        return REIL_VM_ERR_FETCH;
+    }
+
+    if (loc.second == 0)
+    {
+        // execution starts from the basic block entry
+        bb_mark(insn);
+    }
+
+    while (true)
+    {
+        reg_ip->val = insn->addr & ip_mask;
+
+        if (insn->stop)
+        {
+            current = VM_LOC(insn->addr, insn->inum);
+            return REIL_VM_STOP;
+        }
+
+        if (insn->events && !on_events(insn))
+        {
+            current = VM_LOC(insn->addr, insn->inum);
+            return REIL_VM_ERR_HOOK;
+        }
+
+        if (insn->rep && state.mem && state.taint == NULL &&
+            !(state.hooks.mask & (REIL_VM_HOOK_MEM_READ | REIL_VM_HOOK_MEM_WRITE)))
+        {
+            // bulk memory operation, IR code executes the rest of iterations
+            rep_execute(insn->rep);
+        }
+
+        if (jit && state.taint == NULL && ++insn->hits == VM_JIT_THRESHOLD)
+        {
+            // compile hot code starting from this instruction
+            jit_compile(insn);
+        }
+
+        executed += 1;
+
+        if ((next = insn->handler(&state, insn)) == NULL)
+        {
+            if (state.exit)
+            {
+                // returned from compiled code
+                insn = state.exit;
+                state.exit = NULL;
+            }
+
+            if (state.error)
+            {
+                current = VM_LOC(insn->addr, insn->inum);
+
+                if (state.status == REIL_VM_ERR_INSN && insn->op == I_UNK && 
+                    (state.hooks.mask & REIL_VM_HOOK_UNK) && vm_hook_addr(&state.hooks, insn->addr))
+                {
+                    // handler gets this event before run() returns
+                    vm_hook_queue(&state, REIL_VM_HOOK_UNK, insn, 0, U1, 0);
+                }
+
+                return state.status;
+            }
+
+            // target of the machine code jump is a basic block entry
+            bool branch = insn->op == I_JCC && state.next.second == 0;
+
+            current = state.next;
+            reg_ip->val = current.first & ip_mask;
+
+            if (state.code_written)
+            {
+                // self-modifying code, all of the instructions must be loaded again
+                state.code_written = false;
+                flush();
+            }
+
+            // find or load next instruction
+            if ((next = fetch_insn(current)) == NULL)
+            {
+                return REIL_VM_ERR_FETCH;
+            }
+
+            // link it with the current one
+            if (state.link) *state.link = next;
+
+            if (branch) bb_mark(next);
+        }
+
+        insn = next;
+    }
+}
+
+void CReilVM::get_state(reil_vm_state_t *state)
+{
+    state->addr = current.first;
+    state->inum = current.second;
+    state->executed = executed;
+}
+
+//======================================================================
+// C API
+//======================================================================
+
+extern "C" reil_vm_t reil_vm_init(reil_arch_t arch, reil_vm_fetch_t fetch,
+                                  reil_vm_mem_read_t mem_read, reil_vm_mem_write_t mem_write, void *context)
+{
+    try
+    {
+        return (reil_vm_t)new CReilVM(arch, fetch, mem_read, mem_write, context);
+    }
+    catch (CReilVMException e)
+    {
+        fprintf(stderr, "reil_vm_init() ERROR: %s\n", e.reason.c_str());
+    }
+
+    return NULL;
+}
+
+extern "C" void reil_vm_close(reil_vm_t vm)
+{
+    delete (CReilVM *)vm;
+}
+
+extern "C" int reil_vm_load_next(reil_vm_t vm, reil_inst_t *inst, reil_addr_t next_addr, reil_inum_t next_inum)
+{
+    try
+    {
+        ((CReilVM *)vm)->load(inst, VM_LOC(next_addr, next_inum));
+        return 0;
+    }
+    catch (CReilVMException e)
+    {
+        fprintf(stderr, "reil_vm_load() ERROR: %s\n", e.reason.c_str());
+    }
+
+    return REIL_ERROR;
+}
+
+extern "C" int reil_vm_load(reil_vm_t vm, reil_inst_t *inst)
+{
+    if (inst->flags & IOPT_ASM_END)
+    {
+        // go to the first IR instruction of the next machine instruction
+        return reil_vm_load_next(vm, inst, inst->raw_info.addr + inst->raw_info.size, 0);
+    }
+
+    return reil_vm_load_next(vm, inst, inst->raw_info.addr, inst->inum + 1);
+}
+
+extern "C" int reil_vm_rep_add(reil_vm_t vm, reil_addr_t addr, reil_vm_rep_t *rep)
+{
+    try
+    {
+        ((CReilVM *)vm)->rep_add(addr, rep);
+        return 0;
+    }
+    catch (CReilVMException e)
+    {
+        fprintf(stderr, "reil_vm_rep_add() ERROR: %s\n", e.reason.c_str());
+    }
+
+    return REIL_ERROR;
+}
+
+extern "C" void reil_vm_flush(reil_vm_t vm)
+{
+    ((CReilVM *)vm)->flush();
+}
+
+extern "C" int reil_vm_reg_get(reil_vm_t vm, const char *name, reil_size_t *size, reil_const_t *val)
+{
+    return ((CReilVM *)vm)->reg_get(name, size, val) ? 0 : REIL_ERROR;
+}
+
+extern "C" int reil_vm_reg_set(reil_vm_t vm, const char *name, reil_size_t size, reil_const_t val)
+{
+    try
+    {
+        ((CReilVM *)vm)->reg_set(name, size, val);
+        return 0;
+    }
+    catch (CReilVMException e)
+    {
+        fprintf(stderr, "reil_vm_reg_set() ERROR: %s\n", e.reason.c_str());
+    }
+
+    return REIL_ERROR;
+}
+
+extern "C" int reil_vm_reg_list(reil_vm_t vm, reil_vm_reg_t *regs, int count)
+{
+    return ((CReilVM *)vm)->reg_list(regs, count);
+}
+
+extern "C" void reil_vm_reset(reil_vm_t vm)
+{
+    ((CReilVM *)vm)->reset();
+}
+
+extern "C" void reil_vm_reset_temp(reil_vm_t vm)
+{
+    ((CReilVM *)vm)->reset_temp();
+}
+
+extern "C" int reil_vm_stop_add(reil_vm_t vm, reil_addr_t addr, int inum)
+{
+    if (inum != REIL_VM_ANY_INUM && (inum < 0 || inum > 0xffff))
+    {
+        return REIL_ERROR;
+    }
+
+    ((CReilVM *)vm)->stop_add(addr, inum);
+
+    return 0;
+}
+
+extern "C" void reil_vm_stop_clear(reil_vm_t vm)
+{
+    ((CReilVM *)vm)->stop_clear();
+}
+
+extern "C" int reil_vm_run(reil_vm_t vm, reil_addr_t addr, reil_inum_t inum)
+{
+    return ((CReilVM *)vm)->run(VM_LOC(addr, inum));
+}
+
+extern "C" void reil_vm_get_state(reil_vm_t vm, reil_vm_state_t *state)
+{
+    ((CReilVM *)vm)->get_state(state);
+}
+
+extern "C" reil_vm_snapshot_t reil_vm_snapshot(reil_vm_t vm)
+{
+    return (reil_vm_snapshot_t)((CReilVM *)vm)->snapshot();
+}
+
+extern "C" void reil_vm_restore(reil_vm_t vm, reil_vm_snapshot_t snap)
+{
+    ((CReilVM *)vm)->restore((vm_snapshot *)snap);
+}
+
+extern "C" void reil_vm_snapshot_close(reil_vm_snapshot_t snap)
+{
+    delete (vm_snapshot *)snap;
+}
+
+extern "C" void reil_vm_set_mem(reil_vm_t vm, reil_mem_t mem)
+{
+    ((CReilVM *)vm)->set_mem((CReilMem *)mem);
+}
+
+extern "C" int reil_vm_jit_enable(reil_vm_t vm, int enable)
+{
+    return ((CReilVM *)vm)->jit_enable(enable != 0) ? 0 : REIL_ERROR;
+}
+
+extern "C" int reil_vm_hook_set(reil_vm_t vm, int mask, reil_vm_hook_t handler, void *context)
+{
+    try
+    {
+        ((CReilVM *)vm)->hook_set(mask, handler, context);
+        return 0;
+    }
+    catch (CReilVMException e)
+    {
+        fprintf(stderr, "reil_vm_hook_set() ERROR: %s\n", e.reason.c_str());
+    }
+
+    return REIL_ERROR;
+}
+
+extern "C" int reil_vm_hook_addr_add(reil_vm_t vm, reil_addr_t addr)
+{
+    ((CReilVM *)vm)->hook_addr_add(addr);
+
+    return 0;
+}
+
+extern "C" int reil_vm_hook_mem_add(reil_vm_t vm, reil_addr_t addr, int size)
+{
+    try
+    {
+        ((CReilVM *)vm)->hook_mem_add(addr, size);
+        return 0;
+    }
+    catch (CReilVMException e)
+    {
+        fprintf(stderr, "reil_vm_hook_mem_add() ERROR: %s\n", e.reason.c_str());
+    }
+
+    return REIL_ERROR;
+}
+
+extern "C" void reil_vm_hook_clear(reil_vm_t vm)
+{
+    ((CReilVM *)vm)->hook_clear();
+}
+
+extern "C" int reil_vm_taint_enable(reil_vm_t vm, int enable, int options)
+{
+    ((CReilVM *)vm)->taint_enable(enable != 0, options);
+
+    return 0;
+}
+
+extern "C" int reil_vm_taint_clear(reil_vm_t vm)
+{
+    return ((CReilVM *)vm)->taint_clear() ? 0 : REIL_ERROR;
+}
+
+extern "C" int reil_vm_taint_reg_get(reil_vm_t vm, const char *name, reil_const_t *mask)
+{
+    return ((CReilVM *)vm)->taint_reg_get(name, mask) ? 0 : REIL_ERROR;
+}
+
+extern "C" int reil_vm_taint_reg_set(reil_vm_t vm, const char *name, reil_const_t mask)
+{
+    return ((CReilVM *)vm)->taint_reg_set(name, mask) ? 0 : REIL_ERROR;
+}
+
+extern "C" int reil_vm_taint_mem_get(reil_vm_t vm, reil_addr_t addr, unsigned char *buff, int size)
+{
+    return ((CReilVM *)vm)->taint_mem_get(addr, buff, size) ? 0 : REIL_ERROR;
+}
+
+extern "C" int reil_vm_taint_mem_set(reil_vm_t vm, reil_addr_t addr, int size, unsigned char mask)
+{
+    return ((CReilVM *)vm)->taint_mem_set(addr, size, mask) ? 0 : REIL_ERROR;
+}
+
+extern "C" int reil_vm_taint_sink_add(reil_vm_t vm, reil_addr_t addr, const char *name)
+{
+    return ((CReilVM *)vm)->taint_sink_add(addr, name);
+}
+
+extern "C" int reil_vm_taint_sink_clear(reil_vm_t vm)
+{
+    return ((CReilVM *)vm)->taint_sink_clear() ? 0 : REIL_ERROR;
+}
+
+extern "C" int reil_vm_cov_list(reil_vm_t vm, reil_vm_cov_t *items, int count)
+{
+    return ((CReilVM *)vm)->cov_list(items, count);
+}
+
+extern "C" unsigned char *reil_vm_cov_map(reil_vm_t vm)
+{
+    return ((CReilVM *)vm)->cov_map();
+}
+
+extern "C" void reil_vm_cov_reset(reil_vm_t vm)
+{
+    ((CReilVM *)vm)->cov_reset();
+}
@@ -0,0 +1,930 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <string>
+#include <deque>
+#include <vector>
+#include <map>
+#include <set>
+#include <algorithm>
+
+using namespace std;
+
+// OpenREIL includes
+#include "libopenreil.h"
+#include "reil_mem.h"
+#include "reil_vm.h"
+#include "reil_vm_ops.h"
+#include "reil_dfg.h"
+#include "reil_ssa.h"
+#include "reil_vsa.h"
+
+/*
+    Value set analysis is sparse conditional constant propagation of Wegman
+    and Zadeck over SSA form where lattice values are bounded sets of constants
+    instead of single constants:
+
+      - blocks are processed in reverse postorder untill nothing changes, only
+        blocks that are reachable by executable edges are evaluated and phi
+        functions are using values from executable edges only;
+
+      - conditional edge refines values of variables that are used to compute
+        the branch condition (I_EQ and I_LT with constant operand, I_AND, I_OR,
+        I_NOT and I_XOR of conditions, I_STR, I_ADD and I_SUB of the compared
+        value), so index of the jump table that was checked by bounds check
+        gets the set of all possible indexes;
+
+      - I_LDM with all of the addresses known reads the values with callback
+        that has to return only constant data (read-only sections of the image);
+
+      - variable that was changed too many times is widened to any value, so
+        loop counters don't need VSA_MAX_VALS passes to converge.
+
+    Targets of indirect jumps are the values of their operand c.
+*/
+
+static void vsa_any(vsa_val &val)
+{
+    val.state = VSA_ANY;
+    val.vals.clear();
+}
+
+static void vsa_set(vsa_val &val, vector<reil_const_t> &vals)
+{
+    sort(vals.begin(), vals.end());
+    vals.erase(unique(vals.begin(), vals.end()), vals.end());
+
+    if (vals.size() > VSA_MAX_VALS)
+    {
+        vsa_any(val);
+        return;
+    }
+
+    // empty set means that variable has no value on this path
+    val.state = vals.empty() ? VSA_TOP : VSA_SET;
+    val.vals.swap(vals);
+}
+
+static bool vsa_equal(vsa_val &a, vsa_val &b)
+{
+    return a.state == b.state && a.vals == b.vals;
+}
+
+static void vsa_join(vsa_val &dst, vsa_val &src)
+{
+    if (src.state == VSA_TOP || dst.state == VSA_ANY)
+    {
+        return;
+    }
+
+    if (src.state == VSA_ANY || dst.state == VSA_TOP)
+    {
+        dst = src;
+        return;
+    }
+
+    vector<reil_const_t> vals;
+
+    set_union(dst.vals.begin(), dst.vals.end(), src.vals.begin(), src.vals.end(), back_inserter(vals));
+    vsa_set(dst, vals);
+}
+
+static bool vsa_range(vector<reil_const_t> &vals, reil_const_t first, reil_const_t last)
+{
+    if (last - first >= VSA_MAX_VALS)
+    {
+        return false;
+    }
+
+    vals.clear();
+
+    for (reil_const_t val = first; ; val++)
+    {
+        vals.push_back(val);
+        if (val == last) break;
+    }
+
+    return true;
+}
+
+// conjunction of constraints, returns false when they are contradictory
+static bool vsa_env_and(vsa_env &dst, vsa_env &src)
+{
+    for (vsa_env::iterator it = src.begin(); it != src.end(); ++it)
+    {
+        vsa_env::iterator found = dst.find(it->first);
+
+        if (found == dst.end())
+        {
+            found = dst.insert(*it).first;
+        }
+        else
+        {
+            vector<reil_const_t> vals;
+
+            set_intersection(found->second.begin(), found->second.end(),
+                             it->second.begin(), it->second.end(), back_inserter(vals));
+
+            found->second.swap(vals);
+        }
+
+        if (found->second.empty())
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// disjunction of constraints, only variables that are constrained by both of them are kept
+static void vsa_env_or(vsa_env &dst, vsa_env &src)
+{
+    for (vsa_env::iterator it = dst.begin(); it != dst.end();)
+    {
+        vsa_env::iterator found = src.find(it->first);
+
+        if (found != src.end())
+        {
+            vector<reil_const_t> vals;
+
+            set_union(it->second.begin(), it->second.end(),
+                      found->second.begin(), found->second.end(), back_inserter(vals));
+
+            if (vals.size() <= VSA_MAX_VALS)
+            {
+                it->second.swap(vals);
+                ++it;
+
+                continue;
+            }
+        }
+
+        dst.erase(it++);
+    }
+}
+
+CReilVSA::CReilVSA(reil_arch_t arch, reil_inst_t *insts, int count, DFG_LOC entry,
+                   reil_reader_t reader, void *context)
+    : CReilSSA(arch, insts, count, entry)
+{
+    this->reader = reader;
+    this->reader_context = context;
+
+    converged = solve();
+}
+
+bool CReilVSA::get(int var, vsa_env &env, vsa_val &val)
+{
+    val = vals[var];
+
+    vsa_env::iterator it = env.find(var);
+
+    if (it != env.end() && val.state != VSA_TOP)
+    {
+        if (val.state == VSA_ANY)
+        {
+            val.state = VSA_SET;
+            val.vals = it->second;
+        }
+        else
+        {
+            vector<reil_const_t> vals;
+
+            set_intersection(val.vals.begin(), val.vals.end(),
+                             it->second.begin(), it->second.end(), back_inserter(vals));
+
+            val.vals.swap(vals);
+        }
+
+        // variable can't have any value on this path
+        if (val.vals.empty()) val.state = VSA_TOP;
+    }
+
+    return val.state != VSA_TOP;
+}
+
+bool CReilVSA::get_arg(reil_arg_t *arg, int var, vsa_env &env, vsa_val &val)
+{
+    if (arg->type == A_REG || arg->type == A_TEMP)
+    {
+        if (var == -1 || !get(var, env, val))
+        {
+            return false;
+        }
+
+        if (val.state == VSA_ANY && vm_width(arg->size) <= 8)
+        {
+            // small operands have known set of all possible values
+            vsa_range(val.vals, 0, vm_mask(arg->size));
+            val.state = VSA_SET;
+        }
+
+        return true;
+    }
+
+    val.state = VSA_SET;
+    val.vals.assign(1, arg->type == A_CONST ? arg->val & vm_mask(arg->size) : 0);
+
+    return true;
+}
+
+bool CReilVSA::get_single(reil_arg_t *arg, int var, vsa_env &env, reil_const_t *ret)
+{
+    vsa_val val;
+
+    if (arg->type == A_NONE || !get_arg(arg, var, env, val) ||
+        val.state != VSA_SET || val.vals.size() != 1)
+    {
+        return false;
+    }
+
+    *ret = val.vals[0];
+
+    return true;
+}
+
+bool CReilVSA::load(reil_addr_t addr, reil_size_t size, reil_const_t *val)
+{
+    int len = max(vm_width(size) / 8, 1);
+
+    map<pair<reil_addr_t, int>, pair<bool, reil_const_t> >::iterator it = loads.find(make_pair(addr, len));
+
+    if (it == loads.end())
+    {
+        unsigned char buff[sizeof(reil_const_t)];
+        reil_const_t ret = 0;
+
+        bool ok = reader != NULL && reader(addr, buff, len, reader_context) == len;
+
+        // little endian value
+        for (int i = len - 1; ok && i >= 0; i--) ret = (ret << 8) | buff[i];
+
+        it = loads.insert(make_pair(make_pair(addr, len), make_pair(ok, ret & vm_mask(size)))).first;
+    }
+
+    *val = it->second.second;
+
+    return it->second.first;
+}
+
+void CReilVSA::eval(reil_inst_t *inst, vsa_val &a, vsa_val &b, vsa_val &ret)
+{
+    vector<reil_const_t> vals;
+
+    if (a.state == VSA_TOP || b.state == VSA_TOP)
+    {
+        ret.state = VSA_TOP;
+        ret.vals.clear();
+
+        return;
+    }
+
+    if (inst->op == I_AND && (a.state == VSA_ANY) != (b.state == VSA_ANY))
+    {
+        vsa_val &other = a.state == VSA_ANY ? b : a;
+
+        if (other.vals.size() == 1)
+        {
+            reil_const_t mask = other.vals[0] & vm_mask(inst->c.size);
+
+            if (__builtin_popcountll(mask) <= 9)
+            {
+                // any value masked with constant gives one of the mask subsets
+                for (reil_const_t val = mask; ; val = (val - 1) & mask)
+                {
+                    vals.push_back(val);
+                    if (val == 0) break;
+                }
+
+                vsa_set(ret, vals);
+                return;
+            }
+        }
+    }
+
+    if (a.state == VSA_ANY || b.state == VSA_ANY ||
+        a.vals.size() * b.vals.size() > VSA_MAX_OPS)
+    {
+        vsa_any(ret);
+        return;
+    }
+
+    for (vector<reil_const_t>::iterator x = a.vals.begin(); x != a.vals.end(); ++x)
+    {
+        for (vector<reil_const_t>::iterator y = b.vals.begin(); y != b.vals.end(); ++y)
+        {
+            reil_const_t val = 0;
+
+            if (!dfg_eval(inst, *x, *y, &val))
+            {
+                vsa_any(ret);
+                return;
+            }
+
+            vals.push_back(val);
+        }
+    }
+
+    vsa_set(ret, vals);
+}
+
+void CReilVSA::update(int var, vsa_val &val)
+{
+    vsa_val old = vals[var];
+
+    vsa_join(vals[var], val);
+
+    if (!vsa_equal(old, vals[var]))
+    {
+        // widen variable that keeps changing
+        if (++changes[var] > VSA_MAX_CHANGES) vsa_any(vals[var]);
+
+        changed = true;
+    }
+}
+
+void CReilVSA::transfer(int n, vsa_env &env)
+{
+    reil_inst_t *inst = insns[n].inst;
+    reil_ssa_insn_t *ssa = &ssa_insns[n];
+
+    vsa_val a, b, ret;
+
+    // variables that are written by other instructions are initialized with any value
+    if (!is_pure(inst) || ssa->c == -1)
+    {
+        return;
+    }
+
+    if (!get_arg(&inst->a, ssa->a, env, a))
+    {
+        return;
+    }
+
+    if (inst->op == I_LDM)
+    {
+        vector<reil_const_t> vals;
+
+        if (a.state == VSA_ANY)
+        {
+            vsa_any(ret);
+        }
+        else
+        {
+            for (vector<reil_const_t>::iterator it = a.vals.begin(); it != a.vals.end(); ++it)
+            {
+                reil_const_t val = 0;
+
+                if (!load(*it, inst->c.size, &val))
+                {
+                    vsa_any(ret);
+                    break;
+                }
+
+                vals.push_back(val);
+            }
+
+            if (ret.state != VSA_ANY) vsa_set(ret, vals);
+        }
+    }
+    else
+    {
+        if (!get_arg(&inst->b, ssa->b, env, b))
+        {
+            return;
+        }
+
+        eval(inst, a, b, ret);
+    }
+
+    update(ssa->c, ret);
+}
+
+//======================================================================
+// Branch conditions
+//======================================================================
+
+bool CReilVSA::refine_bool(int var, reil_const_t bit, vsa_env &env, int depth, vsa_env &ret)
+{
+    vsa_val val;
+
+    ret.clear();
+    ret[var] = vector<reil_const_t>(1, bit);
+
+    if (get(var, env, val) && val.state == VSA_SET &&
+        !binary_search(val.vals.begin(), val.vals.end(), bit))
+    {
+        // condition never has this value
+        return false;
+    }
+
+    int n = ssa_vars[var].insn;
+
+    if (depth >= VSA_MAX_DEPTH || n == -1 || !is_pure(insns[n].inst) || ssa_insns[n].c != var)
+    {
+        return true;
+    }
+
+    reil_inst_t *inst = insns[n].inst;
+    reil_ssa_insn_t *ssa = &ssa_insns[n];
+
+    reil_const_t k = 0;
+    vsa_env cons;
+
+    switch (inst->op)
+    {
+    case I_STR:
+    case I_NOT:
+
+        if (ssa->a == -1 || inst->a.size != U1)
+        {
+            break;
+        }
+
+        if (!refine_bool(ssa->a, inst->op == I_NOT ? bit ^ 1 : bit, env, depth + 1, cons))
+        {
+            return false;
+        }
+
+        return vsa_env_and(ret, cons);
+
+    case I_XOR:
+
+        if (inst->a.size != U1 || inst->b.size != U1)
+        {
+            break;
+        }
+
+        if (ssa->a != -1 && get_single(&inst->b, ssa->b, env, &k))
+        {
+            if (!refine_bool(ssa->a, bit ^ (k & 1), env, depth + 1, cons)) return false;
+        }
+        else if (ssa->b != -1 && get_single(&inst->a, ssa->a, env, &k))
+        {
+            if (!refine_bool(ssa->b, bit ^ (k & 1), env, depth + 1, cons)) return false;
+        }
+        else
+        {
+            break;
+        }
+
+        return vsa_env_and(ret, cons);
+
+    case I_AND:
+    case I_OR:
+        {
+            if (inst->a.size != U1 || inst->b.size != U1)
+            {
+                break;
+            }
+
+            reil_arg_t *args[] = { &inst->a, &inst->b };
+            int vars[] = { ssa->a, ssa->b };
+
+            vsa_env conds[2];
+            bool feasible[2];
+
+            for (int i = 0; i < 2; i++)
+            {
+                if (args[i]->type == A_CONST)
+                {
+                    feasible[i] = (args[i]->val & 1) == bit;
+                }
+                else if (vars[i] != -1)
+                {
+                    feasible[i] = refine_bool(vars[i], bit, env, depth + 1, conds[i]);
+                }
+                else
+                {
+                    feasible[i] = true;
+                }
+            }
+
+            if ((inst->op == I_AND) == (bit == 1))
+            {
+                // both operands have the same value as result
+                if (!feasible[0] || !feasible[1] || !vsa_env_and(conds[0], conds[1]))
+                {
+                    return false;
+                }
+            }
+            else
+            {
+                // at least one of the operands has the same value as result
+                if (!feasible[0] && !feasible[1])
+                {
+                    return false;
+                }
+
+                if (!feasible[0]) conds[0].swap(conds[1]);
+                else if (feasible[1]) vsa_env_or(conds[0], conds[1]);
+            }
+
+            return vsa_env_and(ret, conds[0]);
+        }
+
+    case I_EQ:
+    case I_LT:
+        {
+            reil_arg_t *arg = NULL;
+            int u = -1;
+            bool left = false;
+
+            if (ssa->a != -1 && get_single(&inst->b, ssa->b, env, &k))
+            {
+                // variable is compared with constant
+                arg = &inst->a;
+                u = ssa->a;
+                left = true;
+            }
+            else if (ssa->b != -1 && get_single(&inst->a, ssa->a, env, &k))
+            {
+                // constant is compared with variable
+                arg = &inst->b;
+                u = ssa->b;
+            }
+            else
+            {
+                break;
+            }
+
+            reil_const_t mask = vm_mask(arg->size);
+            vector<reil_const_t> vals;
+
+            k &= mask;
+
+            if (get(u, env, val) && val.state == VSA_SET)
+            {
+                for (vector<reil_const_t>::iterator it = val.vals.begin(); it != val.vals.end(); ++it)
+                {
+                    reil_const_t x = *it & mask;
+                    bool res = inst->op == I_EQ ? x == k : (left ? x < k : k < x);
+
+                    if (res == (bit != 0)) vals.push_back(x);
+                }
+
+                sort(vals.begin(), vals.end());
+                vals.erase(unique(vals.begin(), vals.end()), vals.end());
+            }
+            else if (inst->op == I_EQ)
+            {
+                // inequality of any value gives nothing
+                if (bit == 0) break;
+
+                vals.push_back(k);
+            }
+            else if (left)
+            {
+                // u < k or u >= k
+                if (bit ? k == 0 : false) return false;
+                if (!(bit ? vsa_range(vals, 0, k - 1) : vsa_range(vals, k, mask))) break;
+            }
+            else
+            {
+                // k < u or u <= k
+                if (bit ? k == mask : false) return false;
+                if (!(bit ? vsa_range(vals, k + 1, mask) : vsa_range(vals, 0, k))) break;
+            }
+
+            if (!refine_value(u, vals, env, depth + 1, cons))
+            {
+                return false;
+            }
+
+            return vsa_env_and(ret, cons);
+        }
+
+    default:
+
+        break;
+    }
+
+    return true;
+}
+
+bool CReilVSA::refine_value(int var, vector<reil_const_t> &vals, vsa_env &env, int depth, vsa_env &ret)
+{
+    ret.clear();
+
+    if (vals.empty())
+    {
+        return false;
+    }
+
+    ret[var] = vals;
+
+    int n = ssa_vars[var].insn;
+
+    if (depth >= VSA_MAX_DEPTH || n == -1 || !is_pure(insns[n].inst) || ssa_insns[n].c != var)
+    {
+        return true;
+    }
+
+    reil_inst_t *inst = insns[n].inst;
+    reil_ssa_insn_t *ssa = &ssa_insns[n];
+
+    reil_const_t mask = vm_mask(inst->c.size), k = 0;
+    vector<reil_const_t> src;
+    vsa_env cons;
+    int u = -1;
+
+    switch (inst->op)
+    {
+    case I_STR:
+
+        // value was copied or zero extended
+        if (ssa->a != -1 && vm_width(inst->a.size) <= vm_width(inst->c.size))
+        {
+            u = ssa->a;
+
+            for (vector<reil_const_t>::iterator it = vals.begin(); it != vals.end(); ++it)
+            {
+                if (*it <= vm_mask(inst->a.size)) src.push_back(*it);
+            }
+        }
+
+        break;
+
+    case I_ADD:
+    case I_SUB:
+
+        if (inst->a.size != inst->c.size || inst->b.size != inst->c.size)
+        {
+            break;
+        }
+
+        if (ssa->a != -1 && get_single(&inst->b, ssa->b, env, &k))
+        {
+            u = ssa->a;
+
+            // u + k or u - k
+            for (vector<reil_const_t>::iterator it = vals.begin(); it != vals.end(); ++it)
+            {
+                src.push_back((inst->op == I_ADD ? *it - k : *it + k) & mask);
+            }
+        }
+        else if (ssa->b != -1 && inst->op == I_ADD && get_single(&inst->a, ssa->a, env, &k))
+        {
+            u = ssa->b;
+
+            // k + u
+            for (vector<reil_const_t>::iterator it = vals.begin(); it != vals.end(); ++it)
+            {
+                src.push_back((*it - k) & mask);
+            }
+        }
+
+        break;
+
+    default:
+
+        break;
+    }
+
+    if (u == -1)
+    {
+        return true;
+    }
+
+    sort(src.begin(), src.end());
+    src.erase(unique(src.begin(), src.end()), src.end());
+
+    if (!refine_value(u, src, env, depth + 1, cons))
+    {
+        return false;
+    }
+
+    return vsa_env_and(ret, cons);
+}
+
+void CReilVSA::jump_succ(int n, int *target, int *next)
+{
+    reil_inst_t *inst = insns[n].inst;
+
+    *target = *next = -1;
+
+    if (inst->c.type == A_CONST || inst->c.type == A_LOC)
+    {
+        *target = find(DFG_LOC(inst->c.val, inst->c.type == A_LOC ? inst->c.inum : 0));
+    }
+
+    if (!(inst->flags & IOPT_RET) && !(inst->a.type == A_CONST && inst->a.val != 0))
+    {
+        DFG_LOC loc = (inst->flags & IOPT_ASM_END) ?
+                      DFG_LOC(inst->raw_info.addr + inst->raw_info.size, 0) :
+                      DFG_LOC(inst->raw_info.addr, inst->inum + 1);
+
+        *next = find(loc);
+    }
+}
+
+bool CReilVSA::edge_env(int from, int to, vsa_env &ret)
+{
+    int last = bbs[from].last;
+    reil_inst_t *inst = insns[last].inst;
+
+    ret = envs[from];
+
+    if (inst->op != I_JCC || (inst->flags & IOPT_CALL))
+    {
+        // fall through into the next block
+        return true;
+    }
+
+    int target = -1, next = -1;
+
+    jump_succ(last, &target, &next);
+
+    bool is_target = target != -1 && insns[target].bb == to;
+    bool is_next = next != -1 && insns[next].bb == to;
+
+    if (is_target && is_next)
+    {
+        // both edges are leading to the same block
+        return true;
+    }
+
+    vsa_val cond;
+    reil_const_t bit = is_target ? 1 : 0;
+
+    if (!get_arg(&inst->a, ssa_insns[last].a, envs[from], cond))
+    {
+        // condition value is not known yet
+        return false;
+    }
+
+    if (cond.state == VSA_SET)
+    {
+        bool zero = cond.vals[0] == 0, nonzero = cond.vals.back() != 0;
+
+        if (!(bit ? nonzero : zero)) return false;
+    }
+
+    if (ssa_insns[last].a != -1 && inst->a.size == U1)
+    {
+        vsa_env cons;
+
+        if (!refine_bool(ssa_insns[last].a, bit, envs[from], 0, cons))
+        {
+            return false;
+        }
+
+        return vsa_env_and(ret, cons);
+    }
+
+    return true;
+}
+
+bool CReilVSA::solve()
+{
+    int count = (int)ssa_vars.size();
+
+    vsa_val top;
+    top.state = VSA_TOP;
+
+    vals.assign(count, top);
+    changes.assign(count, 0);
+
+    for (int i = 0; i < count; i++)
+    {
+        reil_ssa_var_t *var = &ssa_vars[i];
+
+        if (var->phi != -1)
+        {
+            continue;
+        }
+
+        // initial values and variables that are changed by calls and unknown instructions
+        if (var->insn == -1 || !is_pure(insns[var->insn].inst) || ssa_insns[var->insn].c != i)
+        {
+            vsa_any(vals[i]);
+        }
+    }
+
+    executable.assign(bbs.size(), false);
+    envs.assign(bbs.size(), vsa_env());
+
+    for (int pass = 0; pass < VSA_MAX_PASSES; pass++)
+    {
+        changed = false;
+
+        for (vector<int>::iterator it = order.begin(); it != order.end(); ++it)
+        {
+            int n = *it;
+
+            // constraints of executable incoming edges
+            vector<pair<int, vsa_env> > edges;
+            vsa_env env;
+
+            for (vector<int>::iterator pred = bbs[n].pred.begin(); pred != bbs[n].pred.end(); ++pred)
+            {
+                vsa_env edge;
+
+                if (!executable[*pred] || !edge_env(*pred, n, edge))
+                {
+                    continue;
+                }
+
+                if (edges.empty()) env = edge;
+                else vsa_env_or(env, edge);
+
+                edges.push_back(make_pair(*pred, edge));
+            }
+
+            if (n == entry)
+            {
+                // nothing is known at the function entry
+                env.clear();
+            }
+            else if (edges.empty())
+            {
+                continue;
+            }
+
+            if (!executable[n] || envs[n] != env)
+            {
+                executable[n] = true;
+                envs[n] = env;
+
+                changed = true;
+            }
+
+            for (int i = 0; i < ssa_bbs[n].phi_count; i++)
+            {
+                reil_ssa_phi_t *phi = &ssa_phis[ssa_bbs[n].phi_first + i];
+
+                vsa_val val;
+                val.state = VSA_TOP;
+
+                for (int j = 0; j < phi->arg_count; j++)
+                {
+                    reil_ssa_phi_arg_t *arg = &ssa_phi_args[phi->arg_first + j];
+
+                    for (size_t e = 0; e < edges.size(); e++)
+                    {
+                        vsa_val arg_val;
+
+                        // value from executable edge
+                        if (edges[e].first == arg->bb && get(arg->var, edges[e].second, arg_val))
+                        {
+                            vsa_join(val, arg_val);
+                        }
+                    }
+
+                    if (arg->bb == -1) vsa_join(val, vals[arg->var]);
+                }
+
+                update(phi->var, val);
+            }
+
+            for (int i = bbs[n].first; i <= bbs[n].last; i++)
+            {
+                transfer(i, envs[n]);
+            }
+        }
+
+        if (!changed)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+int CReilVSA::jump_list(map<DFG_LOC, vector<reil_addr_t> > &jumps)
+{
+    if (!converged)
+    {
+        return 0;
+    }
+
+    for (size_t n = 0; n < bbs.size(); n++)
+    {
+        if (!executable[n])
+        {
+            continue;
+        }
+
+        int last = bbs[n].last;
+        reil_inst_t *inst = insns[last].inst;
+        int var = ssa_insns[last].c;
+
+        vsa_val val;
+
+        if (inst->op != I_JCC || (inst->flags & (IOPT_CALL | IOPT_RET)) || var == -1)
+        {
+            continue;
+        }
+
+        if (get(var, envs[n], val) && val.state == VSA_SET)
+        {
+            // indirect jump with known targets
+            jumps[insns[last].loc] = vector<reil_addr_t>(val.vals.begin(), val.vals.end());
+        }
+    }
+
+    return (int)jumps.size();
+}
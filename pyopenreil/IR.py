@@ -6,6 +6,29 @@ IATTR_FLAGS = 2
 IATTR_NEXT  = 3
 IATTR_SRC   = 4
 IATTR_DST   = 5
+IATTR_REP   = 6
+IATTR_SYSCALL = 7
+IATTR_TARGETS = 8
+
+# IATTR_REP operations of rep-prefixed string instructions
+REP_MOVS = 0
+REP_STOS = 1
+REP_CMPS = 2
+REP_SCAS = 3
+
+# IATTR_REP conditions
+REP_ALWAYS = 0 # rep
+REP_EQ     = 1 # repe, repz
+REP_NE     = 2 # repne, repnz
+
+REP_OP     = 0 # one of REP_* operations
+REP_SIZE   = 1 # element size in bytes
+REP_COND   = 2 # one of REP_* conditions
+REP_COUNT  = 3 # counter register name
+REP_SRC    = 4 # source pointer register name, None for STOS and SCAS
+REP_DST    = 5 # destination pointer register name
+REP_VAL    = 6 # value register name for STOS and SCAS, None for others
+REP_DIR    = 7 # direction register name, it's 1 for incrementing of pointers
 
 # IR instruction flags
 IOPT_CALL       = 0x00000001
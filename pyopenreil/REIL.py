@@ -738,7 +738,8 @@ class InsnJson():
         # make serialized argument from json data
         arg = lambda a: ( Arg_type(a), \
                           Arg_size(a), \
-                          Arg_val(a) if Arg_type(a) == A_CONST else Arg_name(a) ) if len(a) > 0 else ()
+                          Arg_val(a) if Arg_type(a) == A_CONST else Arg_name(a) ) if len(a) > 2 else \
+                        ( Arg_type(a), tuple(Arg_loc(a)) ) if len(a) > 0 else ()
         
         insn = json.loads(data)
         attr = Insn_attr(insn)
@@ -792,9 +793,21 @@ class TestInsnJson(unittest.TestCase):
         # check json parsing
         assert js.from_json(self.json_data) == self.test_data
 
+    def test_loc(self):
+
+        js = InsnJson()
+
+        # jump location argument
+        test_data = ((0, 2), 0, I_JCC, ((A_CONST, U1, 1), (), (A_LOC, (0x1000, 1))), {})
+
+        assert js.from_json(js.to_json(test_data)) == test_data
+
 
 class InsnList(list):
 
+    # use native expression engine of libopenreil for to_symbolic()
+    NATIVE_SYMBOLIC = False
+
     def __str__(self):
 
         return '\n'.join(map(lambda insn: insn.to_str(show_asm = True, show_bin = True), self)) + '\n'
@@ -837,10 +850,24 @@ class InsnList(list):
 
     def to_symbolic(self, in_state = None, temp_regs = True):
 
-        out_state = None if in_state is None else in_state.copy()
+        out_state = None
+
+        # native engine doesn't know about IATTR_NEXT
+        if self.NATIVE_SYMBOLIC and len(self) > 0 and \
+           not any(map(lambda insn: insn.has_attr(IATTR_NEXT), self)):
+
+            import translator
 
-        # update symbolic state with each instruction
-        for insn in self: out_state = insn.to_symbolic(out_state)
+            # input state or instructions are not supported by native engine
+            try: out_state = SymNative().execute(self, in_state)
+            except (ValueError, translator.Error): pass
+
+        if out_state is None:
+
+            out_state = None if in_state is None else in_state.clone()
+
+            # update symbolic state with each instruction
+            for insn in self: out_state = insn.to_symbolic(out_state)
 
         # remove temp registers from output state
         if not temp_regs: out_state.remove_temp_regs()
@@ -999,6 +1026,192 @@ class TestBasicBlock(unittest.TestCase):
         assert rhs == Insn.IRAddr(( 0x09, 0 ))
 
 
+class SymSummaryCache(object):
+    ''' Symbolic summaries of basic blocks: values of registers and memory at the
+        block end as expressions over values that they had at the block entry, 
+        including instruction pointer with the exit condition. Symbolic state of 
+        the path is built by substitution of block summaries, so each block is 
+        executed only once for all of the paths. Summaries are keyed by IR address 
+        of the block and removed when its instructions are changed in storage. '''
+
+    def __init__(self, storage):
+
+        self.storage = storage
+        self.clear()
+
+        self.storage.watch(self._changed)
+
+    def close(self):
+
+        self.storage.unwatch(self._changed)
+        self.clear()
+
+    def clear(self):
+
+        # summaries by IR address of block and blocks by machine instruction address
+        self.items, self.blocks = {}, {}
+
+        # native engine that summaries are belonging to, see SymNative.reset()
+        self.engine = None
+
+    def _changed(self, addr):
+
+        if addr is None: 
+
+            self.clear()
+            return
+
+        for ir_addr in self.blocks.pop(addr, []):
+
+            addr_list, _ = self.items.pop(ir_addr)
+
+            for other in addr_list:
+
+                if other != addr: self.blocks[other].discard(ir_addr)
+
+    def _get(self, ir_addr):
+
+        import translator
+
+        native = SymNative()
+
+        # nodes of summaries are not valid after the engine reset
+        if self.engine is not native.engine: 
+
+            self.clear()
+            self.engine = native.engine
+
+        ir_addr = ir_addr if isinstance(ir_addr, tuple) else ( ir_addr, 0 )
+
+        try: return self.items[ir_addr][1]
+        except KeyError: pass
+
+        bb = CFGraphBuilder(self.storage).get_bb(ir_addr)
+        summary = None
+
+        # native engine doesn't know about IATTR_NEXT, such blocks are executed
+        if InsnList.NATIVE_SYMBOLIC and \
+           not any(map(lambda insn: insn.has_attr(IATTR_NEXT), bb)):
+
+            try: summary = native.summary(bb)
+            except translator.Error: pass
+
+        addr_list = Set(map(lambda insn: insn.addr, bb))
+
+        for addr in addr_list: self.blocks.setdefault(addr, Set()).add(ir_addr)
+
+        self.items[ir_addr] = ( addr_list, summary )
+
+        return summary
+
+    def get(self, ir_addr):
+        ''' Summary of basic block at given IR address as SymState. '''
+
+        summary = self._get(ir_addr)
+
+        if summary is None: return CFGraphBuilder(self.storage).get_bb(ir_addr).to_symbolic()
+
+        return SymNative().get_state(summary)
+
+    def to_symbolic(self, path, in_state = None, temp_regs = True):
+        ''' Symbolic state at the end of path: list of basic blocks or their IR addresses. '''
+
+        import translator
+
+        native, state, items = SymNative(), in_state, None
+
+        # blocks are executed one by one when native engine is disabled
+        if InsnList.NATIVE_SYMBOLIC:
+
+            try: items = native.put_state(in_state)
+            except (ValueError, translator.Error): items = None
+
+        for bb in path:
+
+            ir_addr = bb.ir_addr if isinstance(bb, BasicBlock) else bb
+            summary = None if items is None else self._get(ir_addr)
+
+            if summary is not None:
+
+                out_items = native.apply(summary, items)
+
+                if out_items is not None: 
+
+                    items = out_items
+                    continue
+
+            if items is not None: state = native.get_state(items)
+            if not isinstance(bb, BasicBlock): bb = CFGraphBuilder(self.storage).get_bb(ir_addr)
+
+            # execute instructions of the block
+            state = bb.to_symbolic(state)
+
+            if InsnList.NATIVE_SYMBOLIC:
+
+                try: items = native.put_state(state)
+                except (ValueError, translator.Error): items = None
+
+        if items is not None: state = native.get_state(items)
+        elif state is None: state = SymState()
+        else: state = state.clone()
+
+        # remove temp registers from output state
+        if not temp_regs: state.remove_temp_regs()
+
+        return state
+
+
+class TestSymSummaryCache(unittest.TestCase):
+
+    arch = ARCH_X86
+
+    def test(self):
+
+        code = ( 'cmp eax, ecx', 
+                 'jne _l', 
+                 'inc eax', 
+                 '_l: add eax, edx', 
+                 'ret' )
+
+        # create translator
+        from pyopenreil.utils import asm
+        tr = CodeStorageTranslator(asm.Reader(self.arch, code))
+
+        cache = SymSummaryCache(tr)
+        bb = tr.get_bb(0)
+
+        # summaries are made by native engine
+        InsnList.NATIVE_SYMBOLIC = True
+
+        for ir_addr in bb.get_successors():
+
+            # path state must be the same as state of its instructions
+            state = cache.to_symbolic([ bb, ir_addr ])
+            expected = InsnList(bb + tr.get_bb(ir_addr)).to_symbolic()
+
+            for val, exp in expected: assert state[val] == exp
+
+        # summary has the exit condition of block
+        assert isinstance(cache.get(0)[SymIP()], SymCond)
+        assert cache.items.has_key(( 0, 0 ))
+
+        # update instructions of the block
+        tr.put_insn(tr.get_insn(0))
+
+        assert not cache.items.has_key(( 0, 0 ))
+
+        # summaries are removed after the engine reset
+        cache.get(0)
+        SymNative.reset()
+        cache.get(0)
+
+        assert cache.engine is SymNative.engine
+
+        InsnList.NATIVE_SYMBOLIC = False
+
+        cache.close()
+
+
 class Func(InsnList):
 
     class Chunk(object):
@@ -1028,6 +1241,9 @@ class Func(InsnList):
         self.bb_list, self.chunks = [], []
         self.stack_args = None
 
+        # IR addresses of added basic blocks and instructions
+        self.bb_addrs, self.insn_addrs = Set(), Set()
+
     def __str__(self):
 
         return self.to_str(show_header = True, show_chunks = True)
@@ -1113,7 +1329,7 @@ class Func(InsnList):
 
     def add_bb(self, bb):
 
-        if not bb in self.bb_list:
+        if not bb.ir_addr in self.bb_addrs:
 
             if bb.ir_addr == ( self.addr, 0 ):
 
@@ -1132,11 +1348,15 @@ class Func(InsnList):
             # update code chunks and basic blocks information
             self.add_chunk(bb.first.addr, bb.size)
             self.bb_list.append(bb) 
+            self.bb_addrs.add(bb.ir_addr)
             
             for insn in bb:
 
                 # add bb instruction to func instructions list
-                if not insn in self: self.append(insn)            
+                if not insn.ir_addr() in self.insn_addrs: 
+
+                    self.insn_addrs.add(insn.ir_addr())
+                    self.append(insn)            
 
     def name(self):
 
@@ -1479,22 +1699,20 @@ class CFGraphBuilder(object):
 
     def traverse(self, ir_addr, state = None, context = None):
 
-        stack, nodes, edges = [], [], []
+        stack, nodes, edges = [], Set(), []
         cfg = CFGraph()
 
         ir_addr = ir_addr if isinstance(ir_addr, tuple) else (ir_addr, None)        
         state = {} if state is None else state        
 
-        def _process_node(bb, state, context):
-
-            if bb.ir_addr not in nodes: 
+        def _process_edge(edge):
 
-                nodes.append(bb.ir_addr)
-                self.process_node(bb, state, context)
+            if edge not in edges_set: 
 
-        def _process_edge(edge):
+                edges_set.add(edge)
+                edges.append(edge)
 
-            if edge not in edges: edges.append(edge)
+        edges_set = Set()
 
         # iterative pre-order CFG traversal
         while True:
@@ -1505,7 +1723,8 @@ class CFGraphBuilder(object):
 
             cfg.add_node(bb)
 
-            _process_node(bb, state, context)
+            nodes.add(bb.ir_addr)
+            self.process_node(bb, state, context)
 
             # process immediate postdominators
             lhs, rhs = bb.last.next(), bb.last.jcc_loc()
@@ -1522,9 +1741,23 @@ class CFGraphBuilder(object):
 
                 _process_edge(( bb.ir_addr, lhs ))
                 stack.append(( lhs, state.copy() ))
+
+            if bb.last.has_attr(IATTR_TARGETS):
+
+                # resolved targets of indirect jump
+                for addr in bb.last.get_attr(IATTR_TARGETS):
+
+                    _process_edge(( bb.ir_addr, ( addr, 0 ) ))
+                    stack.append(( ( addr, 0 ), state.copy() ))
             
-            try: ir_addr, state = stack.pop()
-            except IndexError: break
+            while len(stack) > 0:
+
+                ir_addr, state = stack.pop()
+
+                # successors of already processed block were already pushed
+                if not ir_addr in nodes: break
+
+            else: break
 
         # add processed edges to the CFG
         for edge in edges: cfg.add_edge(*edge)
@@ -1642,6 +1875,18 @@ class DFGraph(Graph):
     NODE = DFGraphNode
     EDGE = DFGraphEdge
 
+    # run optimizations of optimize_all() with native DFG optimizer
+    NATIVE_OPTIMIZE = False
+
+    def __init__(self, arch = None, entry = None):
+
+        if isinstance(arch, (int, long)): arch = get_arch(arch)
+
+        # architecture module and IR address of function entry point
+        self.arch, self.entry = arch, entry
+
+        super(DFGraph, self).__init__()
+
     def reset(self):
 
         super(DFGraph, self).reset()
@@ -1740,12 +1985,86 @@ class DFGraph(Graph):
         # update inums and flags
         if relink: storage.fix_inums_and_flags()
 
-    def optimize_all(self, storage = None):
+    def optimize_all(self, storage = None, keep_flags = False):
+
+        if self.NATIVE_OPTIMIZE and self.arch is not None and self.entry is not None:
+
+            self.optimize_native(keep_flags = keep_flags, storage = storage)
+            return
 
         # run all available optimizations                
         self.constant_folding(storage = storage)        
         self.eliminate_subexpressions(storage = storage)
-        self.eliminate_dead_code(storage = storage)  
+        self.eliminate_dead_code(keep_flags = keep_flags, storage = storage)  
+
+    def optimize_native(self, keep_flags = False, storage = None):
+        ''' Run constant folding, common subexpression and dead code elimination
+            with native DFG optimizer. It works with IR code of the function instead 
+            of DFG nodes and edges, so edges are built again from the optimized
+            instructions when it's done. '''
+
+        import translator
+
+        deleted_nodes = []
+
+        print '*** Running native DFG optimizer...'
+
+        nodes = filter(lambda node: node.item is not None, self.nodes.values())
+
+        arch = { x86: translator.ARCH_X86, 
+                 arm: translator.ARCH_ARM }[ self.arch ]
+
+        options = translator.DFG_OPTIMIZE_ALL
+        if keep_flags: options |= translator.DFG_KEEP_FLAGS
+
+        addr, inum = self.entry
+        insn_list = map(lambda node: node.item.serialize(), nodes)
+
+        for node, ( op, args, flags ) in zip(nodes, translator.dfg_optimize(arch, insn_list, 
+                                                                             addr, inum, options)):
+            insn = node.item
+
+            if flags & IOPT_ELIMINATED:
+
+                if not insn.has_flag(IOPT_ELIMINATED):
+
+                    # delete node of eliminated instruction
+                    self.del_node(node)
+                    deleted_nodes.append(node)
+
+                continue
+
+            # update optimized instruction
+            insn.op = op
+            insn.a, insn.b, insn.c = Arg(args[0]), Arg(args[1]), Arg(args[2])
+
+        print '*** %d nodes deleted' % len(deleted_nodes)
+
+        # update global set of deleted DFG nodes
+        self.deleted_nodes = self.deleted_nodes.union(deleted_nodes)
+
+        # operands of instructions were changed
+        self.update_edges()
+
+        if storage is not None: self.store(storage)
+
+    def update_edges(self):
+        ''' Replace DFG edges with the edges of new DFG that was built from 
+            current instructions of the nodes. '''
+
+        storage = CodeStorageMem(self.arch)
+
+        for node in self.nodes.values():
+
+            if node.item is not None: storage.put_insn(node.item.serialize())
+
+        dfg = DFGraphBuilder(storage).traverse(self.entry)
+
+        for edge in list(self.edges): self.del_edge(edge)
+
+        for edge in dfg.edges: 
+
+            self.add_edge(edge.node_from.key(), edge.node_to.key(), edge.name)
         
     def constant_folding(self, storage = None):
 
@@ -2165,7 +2484,7 @@ class DFGraphBuilder(object):
 
         state = {} if state is None else state
 
-        dfg = DFGraph()
+        dfg = DFGraph(self.arch)
         bb = BasicBlock(insn)
 
         self._process_bb(bb, state, dfg, from_insn = True) 
@@ -2183,7 +2502,7 @@ class DFGraphBuilder(object):
         
         ir_addr = ir_addr if isinstance(ir_addr, tuple) else (ir_addr, 0)                
 
-        dfg = DFGraph()
+        dfg = DFGraph(self.arch, ir_addr)
         cfg = CFGraphBuilder(self.storage).traverse(ir_addr)
 
         while True:
@@ -2312,6 +2631,281 @@ class TestDFGraphBuilder(unittest.TestCase):
                                              a = Arg(A_CONST, U1, val = 1), 
                                              c = Arg(A_TEMP, U32, 'V_01')) ]
 
+    def test_optimize_native(self):
+
+        # add test data to the storage
+        self.storage.clear()
+        self.storage.put_insn(self.tr.to_reil(self.asm.compile('mov edx, 1'), addr = 0L))
+        self.storage.put_insn(self.tr.to_reil(self.asm.compile('add ecx, edx'), addr = 5L))
+        self.storage.put_insn(self.tr.to_reil(self.asm.compile('ret'), addr = 7L))
+
+        # construct DFG and run native optimizer
+        dfg = DFGraphBuilder(self.storage).traverse(0)
+        dfg.NATIVE_OPTIMIZE = True
+
+        storage = CodeStorageMem(self.arch)
+        dfg.optimize_all(storage = storage)
+
+        print '\n', storage
+
+        '''
+            Constant value of R_EDX is also propagated into the I_ADD:
+
+            00000000.00     STR             1:32,                 ,         R_EDX:32
+            00000005.00     ADD         R_ECX:32,             1:32,         R_ECX:32
+            00000007.00     LDM         R_ESP:32,                 ,          V_01:32
+            00000007.01     ADD         R_ESP:32,             4:32,         R_ESP:32
+            00000007.02     JCC              1:1,                 ,          V_01:32
+
+        '''
+        assert storage.get_insn(0) == [ Insn(op = I_STR, ir_addr = ( 0, 0 ), 
+                                             a = Arg(A_CONST, U32, val = 1), 
+                                             c = Arg(A_REG, U32, 'R_EDX')) ]
+
+        assert storage.get_insn(5) == [ Insn(op = I_ADD, ir_addr = ( 5, 0 ), 
+                                             a = Arg(A_REG, U32, 'R_ECX'),
+                                             b = Arg(A_CONST, U32, val = 1),
+                                             c = Arg(A_REG, U32, 'R_ECX')) ]
+
+        assert len(storage.get_insn(7)) == 3
+
+        # edges are matching optimized instructions
+        node = dfg.node(( 5, 0 ))
+
+        assert Set(map(lambda edge: edge.name, node.in_edges)) == Set([ 'R_ECX' ])
+        assert dfg.entry_node in map(lambda edge: edge.node_from, node.in_edges)
+
+
+class SSAForm(object):
+    ''' Function in SSA form built by native SSA builder. Variables are
+        identified by indexes of var_list() items, each variable is a version
+        of register or temporary register that has exactly one definition. '''
+
+    def __init__(self, arch, insn_list, ir_addr):
+
+        import translator
+
+        if isinstance(arch, (int, long)): arch = get_arch(arch)
+
+        self.arch, self.ir_addr = arch, ir_addr
+        self.insns = dict(map(lambda insn: ( insn.ir_addr(), insn ), insn_list))
+
+        addr, inum = ir_addr
+        arch = { x86: translator.ARCH_X86, 
+                 arm: translator.ARCH_ARM }[ arch ]
+
+        self.ssa = translator.SSA(arch, map(lambda insn: insn.serialize(), insn_list), addr, inum)
+
+        self.bb_list = self.ssa.bb_list()
+        self.insn_list = self.ssa.insn_list()
+        self.var_list = self.ssa.var_list()
+        self.use_list = self.ssa.use_list()
+        self.phi_list = self.ssa.phi_list()
+        self.phi_arg_list = self.ssa.phi_arg_list()
+
+        # index of instruction by it's IR address
+        self.insn_index = dict(map(lambda n: ( self.insn_list[n][0], n ), 
+                                   range(len(self.insn_list))))
+
+    def var_name(self, var):
+
+        _, name, version, _, _, _, _ = self.var_list[var]
+
+        return '%s_%d' % (name, version)
+
+    def get_insn(self, n):
+
+        return self.insns[self.insn_list[n][0]]
+
+    def get_vars(self, ir_addr):
+        ''' Get SSA variables of instruction operands, -1 for operand that is
+            not a register or temporary register. '''
+
+        _, _, a, b, c = self.insn_list[self.insn_index[ir_addr]]
+
+        return a, b, c
+
+    def get_def(self, var):
+        ''' Get ( insn, phi ) tuple with defining instruction or index of 
+            defining phi function, both are None for initial value of variable. '''
+
+        _, _, _, insn, phi, _, _ = self.var_list[var]
+
+        return None if insn == -1 else self.get_insn(insn), None if phi == -1 else phi
+
+    def get_uses(self, var):
+        ''' Get list of ( insn, phi ) tuples for each use of variable. '''
+
+        _, _, _, _, _, use_first, use_count = self.var_list[var]
+
+        return map(lambda ( insn, phi ): ( None if insn == -1 else self.get_insn(insn), 
+                                          None if phi == -1 else phi ), 
+                   self.use_list[use_first : use_first + use_count])
+
+    def get_phi_args(self, phi):
+        ''' Get list of ( bb, var ) tuples with arguments of phi function, 
+            bb is index of predecessor block or -1 for function entry. '''
+
+        _, _, arg_first, arg_count = self.phi_list[phi]
+
+        return self.phi_arg_list[arg_first : arg_first + arg_count]
+
+    def get_bb(self, ir_addr):
+
+        return self.insn_list[self.insn_index[ir_addr]][1]
+
+    def dominates(self, a, b):
+
+        return self.ssa.dominates(a, b)
+
+    def df_list(self, bb):
+
+        return self.ssa.df_list(bb)
+
+    def slice(self, ir_addr, arg, forward = False, mem = False, local = False):
+        ''' Get list of instructions that value of operand ('a', 'b' or 'c') of 
+            instruction depends on or that depend on it when forward is True. 
+            Memory dependencies are followed only when mem is True, local slice
+            doesn't leave basic block of the instruction. '''
+
+        import translator
+
+        options = (translator.SLICE_FORWARD if forward else 0) | \
+                  (translator.SLICE_MEM if mem else 0) | \
+                  (translator.SLICE_LOCAL if local else 0)
+
+        addr, inum = ir_addr
+        arg = { 'a': translator.SLICE_ARG_A, 
+                'b': translator.SLICE_ARG_B, 
+                'c': translator.SLICE_ARG_C }[ arg ]
+
+        return InsnList(map(lambda n: self.get_insn(n), 
+                            self.ssa.slice(addr, inum, arg, options)))
+
+    def rename(self, n):
+        ''' Get copy of instruction with SSA variables names in operands. '''
+
+        insn = self.get_insn(n).clone()
+        _, _, a, b, c = self.insn_list[n]
+
+        for arg, var in [ ( insn.a, a ), ( insn.b, b ), ( insn.c, c ) ]:
+
+            if var != -1: arg.name = self.var_name(var)
+
+        return insn
+
+    def __str__(self):
+
+        ret = ''
+
+        for bb in range(len(self.bb_list)):
+
+            first, last, idom, phi_first, phi_count, reachable = self.bb_list[bb]
+
+            if not reachable: continue
+
+            ret += 'BB %d (idom = %d):\n' % (bb, idom)
+
+            for phi in range(phi_first, phi_first + phi_count):
+
+                args = map(lambda ( _, var ): self.var_name(var), self.get_phi_args(phi))
+                ret += '%s = PHI(%s)\n' % (self.var_name(self.phi_list[phi][1]), ', '.join(args))
+
+            for n in range(first, last + 1): 
+
+                ret += '%s\n' % self.rename(n)
+
+        return ret
+
+
+class SSABuilder(object):
+
+    def __init__(self, storage):
+
+        self.arch = storage.arch
+        self.storage = storage
+
+    def traverse(self, ir_addr):
+
+        ir_addr = ir_addr if isinstance(ir_addr, tuple) else (ir_addr, 0)
+
+        cfg = CFGraphBuilder(self.storage).traverse(ir_addr)
+
+        # collect instructions of all basic blocks of the function, blocks 
+        # that were found before the jump into the middle of them can overlap
+        insns = {}
+        for node in cfg.nodes.values(): 
+
+            for insn in node.item: insns[insn.ir_addr()] = insn
+
+        return SSAForm(self.arch, insns.values(), ir_addr)
+
+
+class TestSSABuilder(unittest.TestCase):
+
+    arch = ARCH_X86
+
+    def test(self):
+
+        from pyopenreil.utils import asm
+
+        code = ( 'xor ecx, ecx', '_loop:', 'inc ecx', 'cmp ecx, 10', 'jne _loop', 
+                 'mov eax, ecx', 'ret' )
+
+        storage = CodeStorageTranslator(asm.Reader(self.arch, code))
+
+        ssa = SSABuilder(storage).traverse(0)
+
+        print '\n', ssa
+
+        # loop header has phi function for R_ECX
+        phi_list = filter(lambda phi: ssa.var_list[phi[1]][1] == 'R_ECX', ssa.phi_list)
+        assert len(phi_list) == 1
+
+        bb, var, arg_first, arg_count = phi_list[0]
+        assert arg_count == 2 and ssa.get_bb(( 2, 0 )) == bb
+
+        # R_ECX value after the loop is defined by inc ecx
+        a, _, _ = ssa.get_vars(( 8, 0 ))
+        insn, phi = ssa.get_def(a)
+
+        assert ssa.var_list[a][1] == 'R_ECX' and insn.addr == 2 and phi is None        
+        assert ssa.dominates(bb, ssa.get_bb(( 8, 0 )))
+
+        # phi variable is used by inc ecx
+        assert 2 in [ insn.addr for insn, phi in ssa.get_uses(var) if insn is not None ]
+
+    def test_slice(self):
+
+        from pyopenreil.utils import asm
+
+        code = ( 'mov ecx, [esp + 4]', 'mov edx, 1', '_loop:', 'add edx, edx', 
+                 'dec ecx', 'jnz _loop', 'mov [esp + 8], edx', 'mov eax, [esp + 8]', 'ret' )
+
+        storage = CodeStorageTranslator(asm.Reader(self.arch, code))
+
+        ssa = SSABuilder(storage).traverse(0)
+
+        ret = filter(lambda insn: insn.has_flag(IOPT_RET), ssa.insns.values())[0]
+        ldm = filter(lambda insn: insn.op == I_LDM and insn.addr == ret.addr - 4, 
+                     ssa.insns.values())[0]
+
+        # value that was stored by mov [esp + 8], edx is loaded only with memory dependencies
+        addr_list = Set(map(lambda insn: insn.addr, ssa.slice(ldm.ir_addr(), 'c')))
+        assert 0x9 not in addr_list and 0xb not in addr_list
+
+        addr_list = Set(map(lambda insn: insn.addr, ssa.slice(ldm.ir_addr(), 'c', mem = True)))
+        assert 0x4 in addr_list and 0x9 in addr_list and 0xe in addr_list
+
+        # stored value doesn't depend on loop counter
+        stm = filter(lambda insn: insn.op == I_STM, ssa.insns.values())[0]
+        addr_list = Set(map(lambda insn: insn.addr, ssa.slice(stm.ir_addr(), 'a')))
+        assert 0x4 in addr_list and 0x9 in addr_list and 0xb not in addr_list
+
+        # loop counter is used by jnz
+        addr_list = Set(map(lambda insn: insn.addr, ssa.slice(( 0xb, 0 ), 'c', forward = True)))
+        assert 0xc in addr_list and 0x9 not in addr_list
+
 
 class Reader(object):
 
@@ -2323,6 +2917,13 @@ class Reader(object):
     @abstractmethod
     def read_insn(self, addr): pass
 
+    def read_rodata(self, addr, size): 
+        ''' Read constant data (jump tables), it's used by native CFG builder to
+            resolve indirect jumps, readers that can't tell whether memory is 
+            writable or not are raising ReadError. '''
+
+        raise ReadError(addr)
+
 
 class ReaderRaw(Reader):
 
@@ -2348,6 +2949,11 @@ class ReaderRaw(Reader):
 
         return self.read(addr, MAX_INST_LEN)
 
+    def read_rodata(self, addr, size): 
+
+        # raw code buffer is never changed
+        return self.read(addr, size)
+
 
 class CodeStorage(object):
 
@@ -2367,6 +2973,27 @@ class CodeStorage(object):
     @abstractmethod
     def clear(self): pass
 
+    # callbacks of watch()
+    watchers = None
+
+    def watch(self, callback):
+        ''' Call callback(addr) when IR instructions of machine instruction at given
+            address were changed, addr is None when storage was cleared. '''
+
+        if self.watchers is None: self.watchers = []
+
+        self.watchers.append(callback)
+
+    def unwatch(self, callback):
+
+        if self.watchers is not None: self.watchers.remove(callback)
+
+    def changed(self, addr = None):
+
+        if self.watchers is not None:
+
+            for callback in self.watchers: callback(addr)
+
 
 class CodeStorageMem(CodeStorage):    
 
@@ -2400,17 +3027,25 @@ class CodeStorageMem(CodeStorage):
 
     def _del_insn(self, ir_addr):
 
-        try: return self.items.pop(ir_addr)
+        try: insn = self.items.pop(ir_addr)
         except KeyError: raise StorageError(*ir_addr)
 
+        self.changed(ir_addr[0])
+
+        return insn
+
     def _put_insn(self, insn):
 
         self.items[self._get_key(insn)] = insn        
+
+        self.changed(Insn_addr(insn))
     
     def clear(self): 
 
         self.items = {}
 
+        self.changed()
+
     def size(self): 
 
         return len(self.items)
@@ -2607,6 +3242,9 @@ class CodeStorageTranslator(CodeStorage):
     # validate instructions list returned by translator
     DEBUG = True
 
+    # translate code of the function with native CFG builder in get_func()
+    NATIVE_CFG = False
+
     #
     # OpenREIL (as well as VEX) uses the least significant bit of 
     # address to determinate encoding mode for ARM instruction:
@@ -2652,11 +3290,18 @@ class CodeStorageTranslator(CodeStorage):
 
         self.translator_postprocess = [ self._postprocess_cjmp, 
                                         self._postprocess_xchg,
-                                        self._postprocess_unknown ]        
+                                        self._postprocess_unknown,
+                                        self._postprocess_syscall ]        
         self.arch = get_arch(arch)        
         self.storage = CodeStorageMem(arch) if storage is None else storage
         self.reader = reader
 
+        # native CFG builder is created on demand
+        self.cfg = None
+
+        # first instructions of basic blocks that were stored by native CFG builder
+        self.cfg_stored = set()
+
     ''' is_valid_arg(), is_valid_insn() and is_valid_insn_list() methods are
     used to validate IR instructions format. Any exception here indicates 
     that invalid instruction was generated by libopenreil. '''
@@ -2980,10 +3625,45 @@ class CodeStorageTranslator(CodeStorage):
 
         return [ unk_insn.serialize() ]    
 
+    def _postprocess_syscall(self, addr, insn_list):
+        ''' VEX translates Linux system call instruction (int 0x80 on x86 
+            and svc on ARM) into the jump to the next instruction that has no
+            side effects. Here we replace it's IR code with single I_UNK 
+            instruction tagged with IATTR_SYSCALL attribute, so CPU emulator
+            stops on it and system call can be handled by the caller. '''
+
+        attr = Insn_attr(insn_list[0])
+
+        if not attr.has_key(IATTR_ASM):
+
+            return insn_list
+
+        mnem, args = attr[IATTR_ASM]
+
+        if self.arch == x86: syscall = mnem == 'int' and args.strip() == '0x80'
+        elif self.arch == arm: syscall = mnem in [ 'svc', 'swi' ]
+        else: syscall = False
+
+        if not syscall:
+
+            return insn_list
+
+        insn = Insn(I_UNK, ir_addr = ( addr, 0 ), size = Insn_size(insn_list[0]))
+        insn.set_flag(IOPT_ASM_END)
+
+        insn.set_attr(IATTR_ASM, attr[IATTR_ASM])
+        if attr.has_key(IATTR_BIN): insn.set_attr(IATTR_BIN, attr[IATTR_BIN])
+
+        insn.set_attr(IATTR_SYSCALL, True)
+
+        return [ insn.serialize() ]
+
     def translate_insn(self, data, addr):        
 
         # generate IR instructions
-        ret = self.translator.to_reil(data, addr = addr)
+        return self.postprocess_insn(addr, self.translator.to_reil(data, addr = addr))
+
+    def postprocess_insn(self, addr, ret):
         
         # validate instructions returned by libopenreil
         if self.DEBUG: self.is_valid_insn_list(ret)
@@ -3001,6 +3681,7 @@ class CodeStorageTranslator(CodeStorage):
     def clear(self): 
 
         self.storage.clear()
+        self.cfg_stored.clear()
 
     def size(self): 
 
@@ -3058,17 +3739,153 @@ class CodeStorageTranslator(CodeStorage):
 
         self.storage.put_insn(insn_or_insn_list)
 
+    def watch(self, callback):
+
+        self.storage.watch(callback)
+
+    def unwatch(self, callback):
+
+        self.storage.unwatch(callback)
+
     def get_bb(self, ir_addr):
         
         return CFGraphBuilder(self).get_bb(ir_addr)
 
+    def _read_code(self, addr, size):
+
+        try: return self.reader.read(addr, size)
+        except ReadError: return None
+
+    def _read_rodata(self, addr, size):
+
+        try: return self.reader.read_rodata(addr, size)
+        except ReadError: return None
+
+    def _get_cfg(self):
+
+        import translator
+
+        if self.cfg is None:
+
+            self.cfg = translator.CFG(self.reader.arch, self._read_code, 
+                                      read_data = self._read_rodata)
+
+        return self.cfg
+
+    def _store_targets(self, bb_list, edge_list):
+
+        import translator
+
+        targets = {}
+
+        for bb_from, bb_to in edge_list:
+
+            first, last, size, flags = bb_list[bb_from]
+
+            # successors of indirect jump that were resolved by native CFG builder
+            if flags & translator.CFG_BB_INDIRECT: 
+
+                targets.setdefault(last, []).append(bb_list[bb_to][0][0])
+
+        for ir_addr, addr_list in targets.items():
+
+            insn = self.storage.get_insn(ir_addr)
+            insn.set_attr(IATTR_TARGETS, sorted(addr_list))
+
+            self.storage.put_insn(insn)
+
+    def _store_bb_list(self, bb_list):
+
+        import translator
+
+        for first, last, size, flags in bb_list:
+
+            # get_insn() raises appropriate exception for such blocks
+            if flags & translator.CFG_BB_ERROR: continue
+
+            # block is shared with the function that was stored before
+            if first in self.cfg_stored: continue
+
+            addr = first[0]
+
+            while True:
+
+                try: 
+
+                    # check for already translated instruction
+                    insn_size = self.storage.get_insn(( addr, 0 )).size
+
+                except StorageError:
+
+                    insn_list = self.cfg.insn_list(addr)
+                    insn_size = Insn_size(insn_list[0])
+
+                    for insn in self.postprocess_insn(addr, insn_list):
+
+                        self.storage.put_insn(insn)
+
+                if addr == last[0]: break
+
+                addr += insn_size
+
+            self.cfg_stored.add(first)
+
+    def _translate_func(self, ir_addr):
+        ''' Native CFG builder discovers basic blocks of the function and translates
+            their code without calling Python for each machine instruction, here we
+            only post-process translated instructions and put them into the storage, 
+            so CFGraphBuilderFunc will find all of the function code there. '''
+
+        cfg = self._get_cfg()
+
+        addr, inum = ir_addr if isinstance(ir_addr, tuple) else ( ir_addr, 0 )
+        
+        # blocks and edges of the previous traversal are discarded by builder
+        bb_count = cfg.traverse(addr, 0 if inum is None else inum)
+        bb_list = cfg.bb_list()[: bb_count]
+
+        self._store_bb_list(bb_list)
+        self._store_targets(bb_list, cfg.edge_list())
+
     def get_func(self, ir_addr):
 
+        if self.NATIVE_CFG and self.reader is not None: 
+
+            self._translate_func(ir_addr)
+
         cfg = self.CFGraphBuilderFunc(self)
         cfg.traverse(self.arch, ir_addr)
 
         return cfg.func
 
+    def get_funcs(self, addr_list, jobs = 1):
+        ''' Discover all of the functions that are reachable from the specified entry 
+            points by following direct calls, jobs argument is the number of worker 
+            processes that native CFG builder uses for discovery. Functions with 
+            not readable or not translatable code are skipped. '''
+
+        import translator
+
+        cfg = self._get_cfg()
+        cfg.discover(addr_list, jobs = jobs)
+
+        bb_list, edge_list, ret = cfg.bb_list(), cfg.edge_list(), []
+
+        for addr, bb_first, bb_count, edge_first, edge_count in cfg.func_list():
+
+            self._store_bb_list(bb_list[bb_first : bb_first + bb_count])
+            self._store_targets(bb_list[bb_first : bb_first + bb_count], 
+                                edge_list[edge_first : edge_first + edge_count])
+
+            func = self.CFGraphBuilderFunc(self)
+
+            try: func.traverse(self.arch, addr)
+            except (ReadError, translator.TranslationError): continue
+
+            ret.append(func.func)
+
+        return ret
+
 
 class TestCodeStorageTranslator(unittest.TestCase):
 
@@ -3122,6 +3939,105 @@ class TestCodeStorageTranslator(unittest.TestCase):
 
         print '\n', self.tr.get_func(0)    
 
+    def test_get_func_native(self):
+
+        from pyopenreil.utils import asm
+
+        code = ( 'test eax, eax', 'jz _quit', 'inc eax', '_quit:', 'ret' )
+        reader = asm.Reader(self.arch, code)
+
+        tr_native, tr = CodeStorageTranslator(reader), CodeStorageTranslator(reader)
+        tr_native.NATIVE_CFG = True
+
+        # native CFG builder must not change the function code
+        func_native, func = tr_native.get_func(0), tr.get_func(0)
+
+        assert len(func_native.bb_list) == len(func.bb_list) == 3
+        assert str(func_native) == str(func)
+
+    def test_get_func_switch(self):
+
+        from pyopenreil.utils import asm
+
+        code = ( 'cmp eax, 2', 'ja _default',
+                 'jmp dword ptr [_table + eax * 4]',
+                 '_case_0:', 'mov eax, 1', 'ret',
+                 '_case_1:', 'mov eax, 2', 'ret',
+                 '_case_2:', 'mov eax, 3', 'ret',
+                 '_default:', 'xor eax, eax', 'ret',
+                 '_table:', '.long _case_0', '.long _case_1', '.long _case_2' )
+
+        reader = asm.Reader(self.arch, code)
+
+        tr = CodeStorageTranslator(reader)
+        tr.NATIVE_CFG = True
+        func = tr.get_func(0)
+
+        # targets of jump table must be resolved by native CFG builder
+        insn = tr.get_insn(( 5, None ))[-1]
+
+        assert insn.get_attr(IATTR_TARGETS) == [ 0x0c, 0x12, 0x18 ]
+        assert sorted([ bb.ir_addr[0] for bb in func.bb_list ]) == [ 0x00, 0x05, 0x0c, 0x12, 0x18, 0x1e ]
+
+    def test_get_funcs(self):
+
+        from pyopenreil.utils import asm
+
+        code = ( 'call _func', 'ret', '_func:', 'xor eax, eax', 'ret' )
+        reader = asm.Reader(self.arch, code)
+
+        tr = CodeStorageTranslator(reader)
+
+        # caller and called function must be discovered by both of the workers
+        for jobs in [ 1, 2 ]:
+
+            func_list = tr.get_funcs([ 0 ], jobs = jobs)
+
+            assert [ func.addr for func in func_list ] == [ 0, 6 ]
+            assert str(func_list[1]) == str(tr.get_func(6))
+
+    def test_stats(self):
+
+        translator = self.tr.translator
+        translator.reset_stats()
+
+        # xor eax, eax
+        insn_list = translator.to_reil('\x33\xC0', addr = 0L)
+        stats = translator.get_stats()
+
+        print '\n', stats
+
+        # check for valid instructions counters
+        assert stats['insn_translated'] == 1 and stats['insn_failed'] == 0
+        assert stats['reil_emitted'] == len(insn_list)
+        assert stats['handler']['count'] == len(insn_list)
+
+    def test_profile(self):
+
+        translator = self.tr.translator
+        translator.profile_enable()
+
+        # xor eax, eax ; xor eax, eax ; ret
+        for data in [ '\x33\xC0', '\x33\xC0', '\xC3' ]:
+
+            translator.to_reil(data, addr = 0L)
+
+        profile = translator.get_profile()
+
+        print '\n', profile
+
+        translator.profile_enable(False)
+        translator.profile_reset()
+
+        # check for valid profile entries
+        entries = dict([ ( entry['mnem'], entry ) for entry in profile ])
+
+        assert len(profile) == 2
+        assert entries['xor']['count'] == 2 and entries['ret']['count'] == 1
+        assert entries['xor']['reil_emitted'] > 0
+
+        assert len(translator.get_profile()) == 0
+
 
 class TestArchX86(unittest.TestCase):
 
@@ -3263,6 +4179,56 @@ class TestArchX86(unittest.TestCase):
         assert SymPtr(SymVal('R_ESP', U32)) == sym.get(SymVal('R_EDX', U32))
 
 
+    def test_rep(self):
+
+        from pyopenreil.utils import asm
+
+        code = ( 'rep movsd', 
+                 'repne scasb',
+                 'ret' )
+
+        tr = CodeStorageTranslator(asm.Reader(self.arch, code))
+
+        # check for information about rep-prefixed string instructions
+        assert tr.get_insn(0)[0].get_attr(IATTR_REP) == \
+               ( REP_MOVS, 4, REP_ALWAYS, 'R_ECX', 'R_ESI', 'R_EDI', None, 'R_DFLAG' )
+
+        assert tr.get_insn(2)[0].get_attr(IATTR_REP) == \
+               ( REP_SCAS, 1, REP_NE, 'R_ECX', None, 'R_EDI', 'R_EAX', 'R_DFLAG' )
+
+        assert not tr.get_insn(4)[0].has_attr(IATTR_REP)
+
+        # rep movsw, segment override, address size override, rep nop
+        code = '\x66\xf3\xa5' + '\x2e\xf3\xa4' + '\x67\xf3\xa4' + '\xf3\x90'
+
+        tr = CodeStorageTranslator(ReaderRaw(self.arch, code))
+
+        assert tr.get_insn(0)[0].get_attr(IATTR_REP) == \
+               ( REP_MOVS, 2, REP_ALWAYS, 'R_ECX', 'R_ESI', 'R_EDI', None, 'R_DFLAG' )
+
+        for addr in [ 3, 6, 9 ]:
+
+            assert not tr.get_insn(addr)[0].has_attr(IATTR_REP)
+
+    def test_syscall(self):
+
+        from pyopenreil.utils import asm
+
+        code = ( 'int 0x80', 
+                 'nop',
+                 'ret' )
+
+        tr = CodeStorageTranslator(asm.Reader(self.arch, code))
+
+        # system call is represented by single I_UNK instruction
+        insn_list = tr.get_insn(0)
+
+        assert len(insn_list) == 1 and insn_list[0].op == I_UNK and \
+               insn_list[0].has_attr(IATTR_SYSCALL) and insn_list[0].next() == ( 2, 0 )
+
+        assert not tr.get_insn(2)[0].has_attr(IATTR_SYSCALL)
+
+
 class TestArchArm(unittest.TestCase):
 
     arch = ARCH_ARM
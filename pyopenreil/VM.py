@@ -1,4 +1,4 @@
-import sys, os, struct, random
+import sys, os, struct, random, copy
 import numpy
 
 from REIL import *
@@ -99,6 +99,24 @@ class Mem(object):
 
         self.data = {}
 
+    def snapshot(self):
+
+        # save memory contents and allocator state
+        return dict(self.data), self.alloc_last
+
+    def restore(self, snap):
+
+        data, self.alloc_last = snap
+        self.data = dict(data)
+
+    def clone(self):
+
+        # make empty memory instance with the same settings
+        mem = copy.copy(self)
+        mem.clear()
+
+        return mem
+
     def _is_valid_addr(self, addr):
 
         if self.LOWEST_USER_ADDR is not None and \
@@ -235,11 +253,125 @@ class Mem(object):
         self.dump_hex(self.read(addr, size), addr = addr)
 
 
+#
+# Drop-in replacement for Mem that keeps memory contents in libopenreil,
+# it also can be used directly by CpuNative without memory access callbacks.
+#
+class MemNative(Mem):
+
+    def __init__(self, data = None, reader = None, strict = True, native = None):
+
+        from pyopenreil.translator import Memory
+
+        lowest_addr = 0 if self.LOWEST_USER_ADDR is None else self.LOWEST_USER_ADDR
+
+        self.reader, self._strict = reader, strict
+
+        # native memory can be owned by someone else, see CpuBatch
+        self.native = Memory(strict = strict, lowest_addr = lowest_addr, fault = self._fault) \
+                      if native is None else native
+
+    def _get_strict(self):
+
+        return self._strict
+
+    def _set_strict(self, strict):
+
+        self._strict = strict
+        self.native.set_strict(strict)
+
+    strict = property(_get_strict, _set_strict)
+
+    def _fault(self, addr, size):
+
+        #
+        # Invalid address, try to get the data from external memory 
+        # reader if possible, see Mem.read() and Mem.write()
+        #
+        if self.reader is None: return False
+
+        try: data = self.reader.read(addr, size)
+        except ReadError: return False
+
+        if data is None: return False
+
+        # copy data from external storage
+        return self.native.alloc(addr, data)
+
+    def error(self):
+
+        from pyopenreil.translator import MEM_ERR_READ, MEM_ERR_WRITE, MEM_ERR_NULL
+
+        errors = { MEM_ERR_READ: MemReadError, 
+                   MEM_ERR_WRITE: MemWriteError, 
+                   MEM_ERR_NULL: MemNullPointerError }
+
+        code, addr = self.native.get_error()
+
+        return errors[code](addr)
+
+    def clear(self):
+
+        self.native.clear()
+
+    def snapshot(self):
+
+        # memory pages are copied on write, see reil_mem_snapshot()
+        return self.native.snapshot()
+
+    def restore(self, snap):
+
+        self.native.restore(snap)
+
+    def clone(self):
+
+        return self.__class__(reader = self.reader, strict = self.strict)
+
+    def read(self, addr, size):
+
+        data = self.native.read(addr, size)
+        if data is None: raise self.error()
+
+        return data
+
+    def write(self, addr, size, data):
+
+        if not self.native.write(addr, data[: size]): raise self.error()
+
+    def alloc_addr(self, size):
+
+        return self.native.alloc_addr(size)
+
+    def alloc(self, addr = None, size = None, data = None):
+
+        size = len(data) if size is None and not data is None else size
+        addr = self.alloc_addr(size) if addr is None else addr
+
+        if not self.native.alloc(addr, data, size): raise self.error()
+
+        return addr
+
+    def store(self, addr, size, val):
+
+        if not self.native.store(addr, size, val): raise self.error()
+
+    def load(self, addr, size):
+
+        val = self.native.load(addr, size)
+        if val is None: raise self.error()
+
+        return val
+
+
 class TestMem(unittest.TestCase):
 
+    def _mem(self, strict = True):
+
+        return Mem(strict = strict)
+
     def test_access(self):             
 
-        mem = Mem(strict = False)
+        mem = self._mem(strict = False)
 
         val = 0x1111111122224488
         addr = 0x10000000
@@ -249,8 +381,14 @@ class TestMem(unittest.TestCase):
         mem.store(addr, U16, 0x4444)
         mem.store(addr, U8, 0x88)
         
-        assert mem.data == { addr + 0: chr(0x88), addr + 1: chr(0x44), addr + 2: chr(0x22), addr + 3: chr(0x22),
-                             addr + 4: chr(0x11), addr + 5: chr(0x11), addr + 6: chr(0x11), addr + 7: chr(0x11) }
+        if isinstance(mem, MemNative):
+
+            assert mem.read(addr, 8) == '\x88\x44\x22\x22\x11\x11\x11\x11'
+
+        else:
+
+            assert mem.data == { addr + 0: chr(0x88), addr + 1: chr(0x44), addr + 2: chr(0x22), addr + 3: chr(0x22),
+                                 addr + 4: chr(0x11), addr + 5: chr(0x11), addr + 6: chr(0x11), addr + 7: chr(0x11) }
         
         assert mem.load(addr, U64) == val and \
                mem.load(addr, U32) == val & 0xffffffff and \
@@ -259,7 +397,7 @@ class TestMem(unittest.TestCase):
 
     def test_null_ptr(self):       
 
-        mem = Mem(strict = False)
+        mem = self._mem(strict = False)
 
         #
         # try to access memory lower that NULL pointer detection limit
@@ -283,6 +421,56 @@ class TestMem(unittest.TestCase):
         assert mem.load(mem.LOWEST_USER_ADDR, U8) == 0
 
 
+class TestMemNative(TestMem):
+
+    def _mem(self, strict = True):
+
+        try: 
+
+            return MemNative(strict = strict)
+
+        except ImportError, why: 
+
+            # libopenreil python bindings are not available
+            raise unittest.SkipTest(str(why))
+
+    def test_strict(self):
+
+        class Reader(object):
+
+            def read(self, addr, size):
+
+                if addr < 0x1000000: raise ReadError(addr)
+                return '\x41' * size
+
+        mem = self._mem(strict = True)
+        mem.reader = Reader()
+
+        # unmapped memory that is not known by memory reader
+        try: 
+
+            mem.store(0x100000, U32, 0)
+            assert False
+
+        except MemWriteError as e: assert e.addr == 0x100000
+
+        try: 
+
+            mem.load(0x100000, U32)
+            assert False
+
+        except MemReadError as e: assert e.addr == 0x100000
+
+        # memory contents must be copied from memory reader
+        assert mem.load(0x1000ffe, U32) == 0x41414141
+
+        mem.store(0x2000ffe, U32, 0x42424242)
+        assert mem.read(0x2000ffe, 4) == '\x42' * 4
+
+        addr = mem.alloc(size = 0x10, data = 'foo')
+        assert mem.read(addr, 0x10) == 'foo' + '\0' * 0xd
+
+
 class Math(object):
 
     def __init__(self, a = None, b = None):
@@ -401,6 +589,12 @@ class Cpu(object):
 
     DEF_R_DFLAG = 1L
 
+    # execute rep-prefixed string instructions as bulk memory operations
+    REP_FAST = True
+
+    # max. number of bytes that is processed by single bulk memory operation
+    REP_CHUNK = 0x1000
+
     #
     # Debugging options
     #
@@ -419,6 +613,42 @@ class Cpu(object):
 
         self.mem.reader = None if storage is None else storage.reader
 
+    def snapshot(self):
+
+        regs = dict(map(lambda item: ( item[0], copy.copy(item[1]) ), self.regs.items()))
+
+        # save registers and memory state
+        return regs, self.mem.snapshot()
+
+    def restore(self, snap):
+
+        regs, mem = snap
+
+        self.insn = None
+        self.regs = dict(map(lambda item: ( item[0], copy.copy(item[1]) ), regs.items()))
+        self.mem.restore(mem)
+
+    def _clone(self):
+
+        cpu = copy.copy(self)
+        cpu.mem = self.mem.clone()
+
+        return cpu
+
+    def fork(self, snap, count = 1):
+
+        ret = []
+
+        for i in range(count):
+
+            # make independent cpu instance with the state from snapshot
+            cpu = self._clone()
+            cpu.restore(snap)
+
+            ret.append(cpu)
+
+        return ret
+
     def reset(self, regs = None, mem = None):
 
         self.insn, self.regs = None, {}
@@ -445,7 +675,7 @@ class Cpu(object):
 
             if reg.temp: self.regs.pop(name)
 
-    def reg(self, name, val = None, size = None):
+    def reg_info(self, name, size = None):
 
         if isinstance(name, Arg):
 
@@ -465,6 +695,12 @@ class Cpu(object):
             # make canonical register name
             name = '%s_%s' % ( 'V' if temp else 'R', name.upper() )
 
+        return name, size, temp
+
+    def reg(self, name, val = None, size = None):
+
+        name, size, temp = self.reg_info(name, size)
+
         if self.regs.has_key(name): 
 
             reg = self.regs[name]
@@ -535,6 +771,94 @@ class Cpu(object):
         self.reg(insn.c, self.math.eval(insn.op, a, b))
         return None
 
+    def rep(self, info):
+
+        reg = lambda name: None if name is None else self.reg(name)
+
+        op, size, cond = info[REP_OP], info[REP_SIZE], info[REP_COND]
+        count, src, dst = reg(info[REP_COUNT]), reg(info[REP_SRC]), reg(info[REP_DST])
+        val, dir = reg(info[REP_VAL]), reg(info[REP_DIR])
+
+        # register value masks
+        mask, dir_mask = dst.get_val(-1), dir.get_val(-1)
+
+        if dir.get_val() == 1: back = False
+        elif dir.get_val() == dir_mask: back = True
+        else: return
+
+        # CMPS and SCAS are stopped by not equal elements unless it's REPNE
+        eq = cond != REP_NE
+
+        if val is not None:
+
+            # element value for STOS and SCAS
+            elem = self.mem.pack(Mem.map_size[size], val.get_val() & ((1 << (size * 8)) - 1))
+
+        def _range(ptr, length):
+
+            # get the lowest address of accessed memory range
+            if back: return None if ptr + size < length else ptr + size - length
+            else: return None if ptr + length - 1 > mask else ptr
+
+        while count.get_val() > 0:
+
+            num = min(count.get_val(), self.REP_CHUNK / size)
+
+            # the last iteration is executed by IR code to set the flags
+            if op in [ REP_CMPS, REP_SCAS ]: num = min(num, count.get_val() - 1)
+
+            length = num * size
+            dst_addr = _range(dst.get_val(), length)
+            src_addr = None if src is None else _range(src.get_val(), length)
+
+            if num == 0 or dst_addr is None or (src is not None and src_addr is None): 
+
+                return
+
+            try:
+
+                data = elem * num if src is None else self.mem.read(src_addr, length)
+
+                if op in [ REP_MOVS, REP_STOS ]:
+
+                    # overlapped copying is left for IR code
+                    if src is not None and src_addr < dst_addr + length and \
+                                           dst_addr < src_addr + length:
+
+                        return
+
+                    # Mem might write a part of the range before the error
+                    if self.mem.strict: self.mem.read(dst_addr, length)
+
+                    self.mem.write(dst_addr, length, data)
+
+                else:
+
+                    data_dst = self.mem.read(dst_addr, length)
+
+                    for i in range(num):
+
+                        offs = (num - 1 - i if back else i) * size
+
+                        if (data[offs : offs + size] == data_dst[offs : offs + size]) != eq:
+
+                            # this element stops the loop
+                            num = i
+                            break
+
+            except MemError:
+
+                # IR code will report an error for exact element
+                return
+
+            step = num * size
+
+            if src is not None: src.val = (src.get_val() + (-step if back else step)) & mask
+            dst.val = (dst.get_val() + (-step if back else step)) & mask
+            count.val = count.get_val() - num
+
+            if step < length: break
+
     def _log_insn(self, insn):        
 
         if not self.debug & self.DBG_TRACE_INSN:
@@ -574,9 +898,9 @@ class Cpu(object):
         # get arguments values
         a, b, c = self.arg(insn.a), self.arg(insn.b), self.arg(insn.c)
         
-        if not insn.op in REIL_INSN:
+        if not insn.op in REIL_INSN or insn.op == I_UNK:
 
-            # invalid opcode
+            # invalid or unknown opcode
             raise CpuInstructionError(insn.addr, insn.inum)
 
         try:
@@ -633,6 +957,12 @@ class Cpu(object):
 
                 raise CpuStop(*next)
 
+            if inum == 0 and self.REP_FAST and self.insn.has_attr(IATTR_REP) and \
+               not self.debug & self.DBG_TRACE_INSN:
+
+                # IR code executes the rest of iterations
+                self.rep(self.insn.get_attr(IATTR_REP))
+
             # execute single instruction
             next = self.execute(self.insn)            
 
@@ -684,6 +1014,10 @@ class TestCpu(unittest.TestCase):
 
     arch = ARCH_X86
 
+    def _cpu(self, arch):
+
+        return Cpu(arch)
+
     def test(self):     
 
         code = ( 'mov eax, edx',
@@ -696,7 +1030,7 @@ class TestCpu(unittest.TestCase):
         from pyopenreil.utils import asm
         tr = CodeStorageTranslator(asm.Reader(self.arch, code, addr = addr))
         
-        cpu = Cpu(self.arch)
+        cpu = self._cpu(self.arch)
 
         # set up stack pointer and input args
         cpu.reg('esp', stack)
@@ -727,7 +1061,7 @@ class TestCpu(unittest.TestCase):
         from pyopenreil.utils import asm
         tr = CodeStorageTranslator(asm.Reader(self.arch, code, addr = addr))
 
-        cpu = Cpu(ARCH_X86)
+        cpu = self._cpu(ARCH_X86)
 
         # set up stack pointer
         cpu.reg('esp', stack)
@@ -742,6 +1076,623 @@ class TestCpu(unittest.TestCase):
         # check for correct return value
         assert cpu.reg('eax').val == 0x90909090
 
+    def test_rep(self):
+
+        code = ( 'rep movsb',
+                 'mov edi, edx',
+                 'mov ecx, 0x100',
+                 'repne scasb',
+                 'ret' )
+
+        addr, stack, data = 0x41414141, 0x42424242, 'hello\0'
+
+        from pyopenreil.utils import asm
+        tr = CodeStorageTranslator(asm.Reader(self.arch, code, addr = addr))
+
+        # IR code loop and bulk memory operations must give the same results
+        for rep_fast in [ False, True ]:
+
+            cpu = self._cpu(self.arch)
+            cpu.REP_FAST = rep_fast
+
+            src = cpu.mem.alloc(data = data)
+            dst = cpu.mem.alloc(size = 0x100, data = '\xff' * 0x100)
+
+            # copy string and find it's terminating zero
+            cpu.reg('esp', stack)
+            cpu.reg('ecx', len(data))
+            cpu.reg('esi', src)
+            cpu.reg('edi', dst)
+            cpu.reg('edx', dst)
+            cpu.reg('eax', 0)
+            
+            # run untill ret
+            try: cpu.run(tr, addr)
+            except MemReadError as e: 
+
+                # exception on accessing to the stack
+                if e.addr != stack: raise
+
+            assert cpu.mem.read(dst, len(data) + 1) == data + '\xff'
+
+            assert cpu.reg('esi').val == src + len(data)
+            assert cpu.reg('edi').val == dst + len(data)
+            assert cpu.reg('ecx').val == 0x100 - len(data)
+            assert cpu.reg('zf').val == 1
+
+    def test_snapshot(self):
+
+        code = ( 'mov eax, dword ptr [ecx]',
+                 'add eax, edx', 
+                 'mov dword ptr [ecx], eax',
+                 'ret' )
+
+        addr, stack = 0x41414141, 0x42424242
+
+        from pyopenreil.utils import asm
+        tr = CodeStorageTranslator(asm.Reader(self.arch, code, addr = addr))
+
+        def run(cpu):
+
+            try: cpu.run(tr, addr)
+            except MemReadError as e: 
+
+                # exception on accessing to the stack
+                if e.addr != stack: raise
+
+            return cpu.reg('eax').val, cpu.mem.load(buff, U32)
+
+        cpu = self._cpu(self.arch)
+        buff = cpu.mem.alloc(data = '\x01\0\0\0')
+
+        cpu.reg('esp', stack)
+        cpu.reg('ecx', buff)
+        cpu.reg('edx', 1)
+
+        snap = cpu.snapshot()
+
+        for i in range(3):
+
+            # each run must start from the same state
+            cpu.restore(snap)
+            assert run(cpu) == ( 2, 2 )
+
+        # make independent copies of the cpu
+        first, second = cpu.fork(snap, count = 2)
+        first.reg('edx', 5)
+
+        assert run(first) == ( 6, 6 )
+        assert run(second) == ( 2, 2 )
+        assert run(cpu) == ( 3, 3 )
+
+        cpu.restore(snap)
+        assert cpu.reg('eax').val == 0 and cpu.mem.load(buff, U32) == 1
+
+
+class RegNative(Reg):
+
+    def __init__(self, emu, size, name, temp = False):
+
+        self.emu, self.size, self.name, self.temp = emu, size, name, temp
+
+    def _get_val(self):
+
+        return self.emu.reg_get(self.name)[1]
+
+    def _set_val(self, val):
+
+        self.emu.reg_set(self.name, self.size, val)
+
+    # register value is stored by native interpreter
+    val = property(_get_val, _set_val)
+
+
+#
+# Cpu that executes IR instructions with native interpreter from libopenreil,
+# instructions are loaded from the storage by basic blocks only once. Call 
+# flush() when contents of the storage was changed, interpreter also does it
+# when executed code writes into itself. MemNative instance is accessed by
+# the interpreter directly, any other Mem is accessed with callbacks.
+#
+class CpuNative(Cpu):
+
+    # compile frequently executed IR code into the native code
+    JIT = False
+
+    # event types of hook()
+    HOOK_INSN = 0x01        # machine instruction execution
+    HOOK_BB = 0x02          # basic block entry
+    HOOK_MEM_READ = 0x04    # memory read
+    HOOK_MEM_WRITE = 0x08   # memory write
+    HOOK_UNK = 0x10         # unknown instruction
+    HOOK_TAINT_JUMP = 0x20  # jump to tainted address
+    HOOK_TAINT_COND = 0x40  # conditional jump with tainted condition
+    HOOK_TAINT_MEM = 0x80   # memory access at tainted address
+    HOOK_TAINT_SINK = 0x100 # tainted register at sink address
+
+    # options of taint()
+    TAINT_BYTES = 0x01      # track taint of whole bytes instead of bits
+    TAINT_ADDR = 0x02       # memory access at tainted address taints the value
+
+    def __init__(self, arch, mem = None, math = None, debug = 0):
+
+        from pyopenreil.translator import Emulator
+
+        self.storage, self.stop_at, self.arch_id = None, None, arch
+        self.emu = Emulator(arch, self._fetch, self._mem_read, self._mem_write)
+
+        # JIT is silently disabled when host is not supported
+        if self.JIT: self.emu.jit_enable()
+
+        mem = MemNative() if mem is None else mem
+
+        super(CpuNative, self).__init__(arch, mem = mem, math = math, debug = debug)
+
+    def _fetch(self, addr, inum):
+
+        ret, ir_addr = [], ( addr, inum )
+
+        while ir_addr is not None:
+
+            try:
+
+                # query IR instruction from the storage
+                insn = self.storage.get_insn(ir_addr)
+
+            except StorageError:
+
+                # interpreter will report CpuReadError
+                if len(ret) == 0: return []
+                break
+
+            except Exception:
+
+                # report errors only for requested instruction
+                if len(ret) == 0: raise
+                break
+
+            ret.append(( insn.serialize(), insn.next() ))
+
+            # load the rest of basic block at once
+            if insn.has_flag(IOPT_BB_END): break
+
+            ir_addr = insn.next()
+
+        return ret
+
+    def _mem_read(self, addr, size):
+
+        return self.mem.load(addr, size)
+
+    def _mem_write(self, addr, size, val):
+
+        self.mem.store(addr, size, val)
+
+    @property
+    def regs(self):
+
+        regs = {}
+
+        for name, size, val, temp in self.emu.reg_list():
+
+            regs[name] = RegNative(self.emu, size, name, temp = temp)
+
+        return regs
+
+    def reset(self, regs = None, mem = None):
+
+        self.insn = None
+        self.emu.reset()
+        self.set_ip(0)
+
+        if self.arch == x86:
+
+            # see Cpu.reset()
+            self.reg('R_DFLAG', self.DEF_R_DFLAG)
+
+        if regs is not None:
+
+            # set up caller specified registers set
+            for name, val in regs.items(): self.reg(name, val)        
+
+        if mem is not None:
+
+            self.mem = mem
+
+    def reset_temp(self):
+
+        self.emu.reset_temp()
+
+    def snapshot(self):
+
+        return self.emu.snapshot(), self.mem.snapshot()
+
+    def restore(self, snap):
+
+        regs, mem = snap
+
+        self.insn = None
+        self.emu.restore(regs)
+        self.mem.restore(mem)
+
+    def _clone(self):
+
+        return self.__class__(self.arch_id, mem = self.mem.clone(), math = self.math, debug = self.debug)
+
+    def reg(self, name, val = None, size = None):
+
+        name, size, temp = self.reg_info(name, size)
+        info = self.emu.reg_get(name)
+
+        if info is None:
+
+            # create register with specified or default value
+            val = self.DEF_REG_VAL if val is None else val
+            self.emu.reg_set(name, size, val)
+
+        else:
+
+            # use size of existing register
+            size = info[0]
+            if val is not None: self.emu.reg_set(name, size, val)
+
+        return RegNative(self.emu, size, name, temp = temp)
+
+    def flush(self):
+
+        # unload all of the instructions from the interpreter
+        self.emu.flush()
+
+    def _prepare(self, storage, stop_at):
+
+        if storage is not self.storage:
+
+            self.storage = storage
+            self.flush()
+
+        # use specified storage instance
+        self.set_storage(storage)
+
+        stop_at = None if stop_at is None else list(stop_at)
+        if stop_at != self.stop_at:
+
+            self.stop_at = stop_at
+            self.emu.stop_clear()
+
+            for item in [] if stop_at is None else stop_at:
+
+                # stop point can be IR or machine instruction address
+                if isinstance(item, tuple): self.emu.stop_add(*item)
+                else: self.emu.stop_add(item)
+
+        native = isinstance(self.mem, MemNative)
+        self.emu.set_mem(self.mem.native if native else None)
+
+        if self.REP_FAST != self.emu.rep_fast:
+
+            # loaded code must be fetched again with or without IATTR_REP information
+            self.emu.rep_fast = self.REP_FAST
+            self.flush()
+
+    def _error(self, ret, state, mem):
+
+        from pyopenreil.translator import VM_STOP, VM_ERR_FETCH, VM_ERR_INSN, VM_ERR_MEM
+
+        addr, inum = state['addr'], state['inum']
+
+        if ret == VM_STOP: return CpuStop(addr, inum)
+        elif ret == VM_ERR_FETCH: return CpuReadError(addr, inum)
+        elif ret == VM_ERR_INSN: return CpuInstructionError(addr, inum)
+        elif ret == VM_ERR_MEM and isinstance(mem, MemNative): return mem.error()
+        
+        return CpuError(addr, inum)
+
+    def run(self, storage, addr = 0L, stop_at = None):
+
+        self._prepare(storage, stop_at)
+
+        # execute instructions untill error or stop point
+        ret = self.emu.run(addr)
+
+        raise self._error(ret, self.emu.get_state(), self.mem)
+
+    def hook(self, mask, callback, addrs = None, mem = None):
+
+        # callback gets lists of ( type, addr, inum, mem_addr, mem_size, val ) tuples,
+        # events can be filtered by instruction addresses and ( addr, size ) memory ranges
+        self.emu.hook_clear()
+
+        for addr in [] if addrs is None else addrs: self.emu.hook_addr_add(addr)
+        for addr, size in [] if mem is None else mem: self.emu.hook_mem_add(addr, size)
+
+        self.emu.hook_set(mask, callback)
+
+    def unhook(self):
+
+        self.emu.hook_clear()
+
+    def coverage(self):
+
+        # hits of executed basic blocks by ( addr, inum )
+        return self.emu.cov_list()
+
+    def coverage_map(self):
+
+        # AFL-style edge coverage bitmap
+        return self.emu.cov_map()
+
+    def coverage_reset(self):
+
+        self.emu.cov_reset()
+
+    def taint(self, options = 0):
+
+        # enable taint tracking of the interpreter, it keeps the current shadow state
+        self.emu.taint_enable(True, options)
+
+    def untaint(self):
+
+        self.emu.taint_enable(False)
+
+    def taint_clear(self):
+
+        self.emu.taint_clear()
+
+    def taint_reg(self, name, mask = None):
+
+        # get or set taint bits of the register
+        name = self.reg(name).name
+
+        if mask is not None: self.emu.taint_reg_set(name, mask)
+
+        return self.emu.taint_reg_get(name)
+
+    def taint_mem(self, addr, size, mask = None):
+
+        # get string with taint bits of each byte or set them
+        if mask is not None: self.emu.taint_mem_set(addr, size, mask)
+
+        return self.emu.taint_mem_get(addr, size)
+
+    def taint_sink(self, addr, name):
+
+        # HOOK_TAINT_SINK event has returned sink ID in mem_addr field
+        return self.emu.taint_sink_add(addr, self.reg(name).name)
+
+
+class TestCpuNative(TestCpu):
+
+    def _cpu(self, arch):
+
+        try: 
+
+            return CpuNative(arch)
+
+        except ImportError, why: 
+
+            # libopenreil python bindings are not available
+            raise unittest.SkipTest(str(why))
+
+    def test_stop(self):
+
+        code = ( 'mov eax, 1',
+                 'mov eax, 2', 
+                 'ret' )
+
+        addr = 0x41414141
+
+        from pyopenreil.utils import asm
+        tr = CodeStorageTranslator(asm.Reader(self.arch, code, addr = addr))
+
+        cpu = self._cpu(self.arch)
+
+        # stop at the second machine instruction
+        try: cpu.run(tr, addr, stop_at = [ addr + 5 ])
+        except CpuStop as e: 
+
+            assert e.addr == addr + 5 and e.inum == 0
+
+        assert cpu.reg('eax').val == 1
+        assert cpu.get_ip() == addr + 5
+
+    def test_abi(self):
+
+        code = ( 'pop ecx', 
+                 'pop eax', 
+                 'jmp ecx'  )   
+
+        addr, arg = 0x41414141, 0x42424242
+
+        from pyopenreil.utils import asm
+        tr = CodeStorageTranslator(asm.Reader(self.arch, code, addr = addr))
+
+        abi = Abi(self._cpu(self.arch), tr)
+
+        # check for correct return value
+        assert abi.stdcall(addr, arg) == arg
+
+    def test_batch(self):
+
+        code = ( 'mov eax, [esp + 4]',
+                 'test eax, 1',
+                 'jz _even',
+                 'lea eax, [eax * 2 + eax + 1]',
+                 'ret',
+                 '_even:',
+                 'shr eax, 1',
+                 'ret' )
+
+        addr, args = 0x41414141, range(0, 100)
+
+        from pyopenreil.utils import asm
+        tr = CodeStorageTranslator(asm.Reader(self.arch, code, addr = addr))
+
+        abi = Abi(self._cpu(self.arch), tr)
+
+        # lanes are diverging at jz and returning from different instructions
+        ret = abi.cdecl_batch(addr, [ ( arg, ) for arg in args ])
+
+        assert ret == [ arg * 3 + 1 if arg & 1 else arg / 2 for arg in args ]
+
+        # the same lanes distributed between worker threads
+        ret = abi.cdecl_batch(addr, [ ( arg, ) for arg in args ], threads = 4)
+
+        assert ret == [ arg * 3 + 1 if arg & 1 else arg / 2 for arg in args ]
+
+    def test_hook(self):
+
+        code = ( 'mov ecx, 3',
+                 '_loop:',
+                 'mov [esp - 4], ecx',
+                 'dec ecx',
+                 'jnz _loop',
+                 'ret' )
+
+        addr, events = 0x41414141, []
+
+        from pyopenreil.utils import asm
+        tr = CodeStorageTranslator(asm.Reader(self.arch, code, addr = addr))
+
+        cpu = self._cpu(self.arch)
+        cpu.hook(cpu.HOOK_BB | cpu.HOOK_MEM_WRITE, events.extend)
+
+        Abi(cpu, tr).cdecl(addr)
+
+        # loop head and return are reached by jnz
+        assert [ e[1] for e in events if e[0] == cpu.HOOK_BB ] == \
+               [ addr, addr + 5, addr + 5, addr + 12 ]
+
+        assert [ e[5] for e in events if e[0] == cpu.HOOK_MEM_WRITE ] == [ 3, 2, 1 ]
+
+        # counters are updated without hooks as well
+        cpu.unhook()
+        cpu.coverage_reset()
+
+        Abi(cpu, tr).cdecl(addr)
+
+        assert cpu.coverage() == { ( addr, 0 ): 1, ( addr + 5, 0 ): 2, ( addr + 12, 0 ): 1 }
+        assert len(filter(lambda c: c != '\x00', cpu.coverage_map())) == 4
+
+    def test_taint(self):
+
+        code = ( 'mov eax, [esp + 4]',
+                 'mov ecx, [eax]',
+                 'mov edx, [eax + 4]',
+                 'and ecx, 0xff00',
+                 'shr ecx, 8',
+                 'test ecx, ecx',
+                 'jz _zero',
+                 'mov eax, ecx',
+                 'ret',
+                 '_zero:',
+                 'xor eax, eax',
+                 'ret' )
+
+        addr, events = 0x41414141, []
+
+        from pyopenreil.utils import asm
+        tr = CodeStorageTranslator(asm.Reader(self.arch, code, addr = addr))
+
+        cpu = self._cpu(self.arch)
+        abi = Abi(cpu, tr)
+
+        buff = abi.buff('\x11\x22\x33\x44\x55\x66\x77\x88')
+
+        # the first 4 bytes of the buffer are taint source
+        cpu.taint()
+        cpu.taint_mem(buff, 4, 0xff)
+        cpu.hook(cpu.HOOK_TAINT_COND, events.extend)
+
+        assert abi.cdecl(addr, buff) == 0x22
+
+        # only the second byte of the source goes to the return value
+        assert cpu.taint_reg('eax') == 0xff
+        assert cpu.taint_reg('edx') == 0
+        assert cpu.taint_mem(buff, 8) == '\xff' * 4 + '\x00' * 4
+
+        assert len(events) > 0 and all([ e[5] != 0 for e in events ])
+
+        cpu.untaint()
+        assert cpu.taint_reg('eax') is None
+
+
+#
+# Executes the same IR code over many states of CpuNative at once. Lanes are 
+# starting from the current state of the CPU, each lane has it's own registers
+# and copy-on-write clone of MemNative memory. Lanes that are going through
+# the same path are executed together, see reil_vm_batch_run(). With multiple
+# threads lanes are distributed between workers that are running in parallel 
+# without GIL and sharing instructions that were loaded by CpuNative.
+#
+class CpuBatch(object):
+
+    def __init__(self, cpu, lanes, threads = 1):
+
+        # lanes memory is cloned from native guest memory only
+        assert isinstance(cpu.mem, MemNative)
+
+        cpu.emu.set_mem(cpu.mem.native)
+
+        self.cpu, self.lanes = cpu, lanes
+        self.batch = cpu.emu.batch(lanes, threads)
+
+        self.mem = [ MemNative(reader = cpu.mem.reader, strict = cpu.mem.strict, 
+                               native = self.batch.mem(lane)) for lane in range(lanes) ]
+
+    def reg(self, lane, name, val = None):
+
+        name, size, temp = self.cpu.reg_info(name)
+        info = self.batch.reg_get(lane, name)
+
+        if info is not None: size = info[0]
+
+        if val is not None: 
+
+            self.batch.reg_set(lane, name, size, val)
+            return val
+
+        return self.cpu.DEF_REG_VAL if info is None else info[1]
+
+    def run(self, storage, addr = 0L, stop_at = None):
+
+        self.cpu._prepare(storage, stop_at)
+
+        # execute all of the lanes untill error or stop point
+        self.batch.run(addr)
+
+        ret = []
+
+        for lane in range(self.lanes):
+
+            state = self.batch.get_state(lane)
+
+            # return the same exceptions as CpuNative.run() raises
+            ret.append(self.cpu._error(state['status'], state, self.mem[lane]))
+
+        return ret
+
+
+#
+# CpuNative with JIT compiler enabled.
+#
+class CpuNativeJIT(CpuNative):
+
+    JIT = True
+
+
+class TestCpuNativeJIT(TestCpuNative):
+
+    def _cpu(self, arch):
+
+        try: 
+
+            return CpuNativeJIT(arch)
+
+        except ImportError, why: 
+
+            # libopenreil python bindings are not available
+            raise unittest.SkipTest(str(why))
+
 
 class Stack(object):
 
@@ -936,6 +1887,59 @@ class Abi(object):
         # we never need to care about stack cleanup
         return self.stdcall(addr, *args)
 
+    def call_batch(self, addr, args_list, threads = 1):
+
+        args_list = [ list(args) for args in args_list ]
+        count = 0 if len(args_list) == 0 else len(args_list[0])
+
+        # reserve the same stack space for arguments of each lane
+        stack = self.pushargs([ 0 ] * count)
+        args_addr = stack.top
+
+        if self.cpu.arch == x86: stack.push(self.DUMMY_RET_ADDR)
+        elif self.cpu.arch == arm: self.reg(arm.Registers.lr, self.DUMMY_RET_ADDR)
+        else: assert False
+
+        self.reg(self.arch.Registers.sp, stack.top)
+
+        # lanes are cloned from the current state
+        batch = CpuBatch(self.cpu, len(args_list), threads)
+
+        for lane, args in enumerate(args_list):
+
+            mem = batch.mem[lane]
+
+            for i in range(count):
+
+                arg = args[i]
+
+                if isinstance(arg, basestring):
+
+                    # copy buffer into the memory of the lane
+                    arg = mem.alloc(size = self.align(len(arg) + 4), data = arg + '\0\0\0\0')
+
+                mem.store(args_addr + i * self.arch.ptr_len, Mem.map_size[self.arch.ptr_len], arg)
+
+        for e in batch.run(self.storage, addr):
+
+            # each lane must stop on DUMMY_RET_ADDR
+            if not isinstance(e, CpuError) or e.addr != self.DUMMY_RET_ADDR: raise e
+
+        return batch
+
+    def stdcall_batch(self, addr, args_list, threads = 1):
+
+        # init cpu and call target function for each list of arguments
+        self.reg(self.arch.Registers.accum, 0)
+        batch = self.call_batch(addr, args_list, threads)
+
+        # return accumulator values
+        return [ batch.reg(lane, self.arch.Registers.accum) for lane in range(batch.lanes) ]
+
+    def cdecl_batch(self, addr, args_list, threads = 1):
+
+        return self.stdcall_batch(addr, args_list, threads)
+
     def ms_fastcall(self, addr, *args):
 
         if len(args) > 0:
@@ -1,5 +1,6 @@
 
 DEF REIL_MAX_NAME_LEN = 15
+DEF REIL_MAX_MNEM_LEN = 32
 DEF REIL_ERROR = -1
 
 cdef extern from "libopenreil.h":    
@@ -80,9 +81,373 @@ cdef extern from "libopenreil.h":
     ctypedef _reil_inst_t reil_inst_t
     ctypedef _reil_arch_t reil_arch_t
 
+    cdef struct _reil_stats_stage_t:
+
+        unsigned long long time     # cumulative time in nanoseconds
+        unsigned long long count    # number of calls
+
+    ctypedef _reil_stats_stage_t reil_stats_stage_t
+
+    cdef struct _reil_stats_t:
+
+        reil_stats_stage_t disasm   # capstone instruction decoding
+        reil_stats_stage_t vex      # LibVEX_Translate()
+        reil_stats_stage_t irbb     # translate_irbb()
+        reil_stats_stage_t bap      # generate_bap_ir() post-passes
+        reil_stats_stage_t bil      # process_bil() excluding handler time
+        reil_stats_stage_t handler  # instruction handler
+
+        unsigned long long insn_translated
+        unsigned long long insn_unknown
+        unsigned long long insn_failed
+        unsigned long long reil_emitted
+        unsigned long long temp_allocated
+        unsigned long long vex_mem_max
+
+    ctypedef _reil_stats_t reil_stats_t
+
+    cdef struct _reil_profile_entry_t:
+
+        unsigned int id                     # capstone instruction ID
+        char mnem[REIL_MAX_MNEM_LEN]        # instruction mnemonic
+        unsigned long long count
+        unsigned long long reil_emitted
+        unsigned long long temp_allocated
+        unsigned long long time             # translation time in nanoseconds
+
+    ctypedef _reil_profile_entry_t reil_profile_entry_t
+
+    cdef enum _reil_profile_format_t:
+
+        REIL_PROFILE_CSV,
+        REIL_PROFILE_JSON
+
+    ctypedef _reil_profile_format_t reil_profile_format_t
+
     int reil_log_init(int mask, char *path)
     void reil_log_close()
 
     int reil_translate_insn(reil_t reil, reil_addr_t addr, unsigned char *buff, int len)
     reil_t reil_init(reil_arch_t arch, reil_inst_handler_t handler, void *context)
     void reil_close(reil_t reil) 
+
+    int reil_get_stats(reil_t reil, reil_stats_t *stats)
+    void reil_reset_stats(reil_t reil)
+
+    void reil_profile_enable(reil_t reil, int enable)
+    int reil_profile_get(reil_t reil, reil_profile_entry_t *entries, int count)
+    int reil_profile_dump(reil_t reil, char *path, reil_profile_format_t format)
+    void reil_profile_reset(reil_t reil)
+
+    ctypedef void* reil_cfg_t
+    ctypedef void* reil_reader_t
+
+    cdef struct _reil_cfg_bb_t:
+
+        reil_addr_t addr        # IR address of the first instruction
+        reil_inum_t inum
+        reil_addr_t last_addr   # IR address of the last instruction
+        reil_inum_t last_inum
+        int size                # size of machine code
+        int flags
+
+    ctypedef _reil_cfg_bb_t reil_cfg_bb_t
+
+    cdef struct _reil_cfg_edge_t:
+
+        int from_bb "from"      # indexes of basic blocks
+        int to_bb "to"
+
+    ctypedef _reil_cfg_edge_t reil_cfg_edge_t
+
+    cdef struct _reil_cfg_func_t:
+
+        reil_addr_t addr        # function address
+        int bb_first            # range of basic blocks
+        int bb_count
+        int edge_first          # range of edges
+        int edge_count
+
+    ctypedef _reil_cfg_func_t reil_cfg_func_t
+
+    reil_cfg_t reil_cfg_init(reil_arch_t arch, reil_reader_t reader, void *context)
+    void reil_cfg_close(reil_cfg_t cfg)
+    void reil_cfg_set_data_reader(reil_cfg_t cfg, reil_reader_t reader, void *context)
+    int reil_cfg_traverse(reil_cfg_t cfg, reil_addr_t addr, reil_inum_t inum)
+    int reil_cfg_discover(reil_cfg_t cfg, reil_addr_t *entries, int count, int jobs)
+    int reil_cfg_func_list(reil_cfg_t cfg, reil_cfg_func_t *funcs, int count)
+    int reil_cfg_bb_list(reil_cfg_t cfg, reil_cfg_bb_t *bbs, int count)
+    int reil_cfg_edge_list(reil_cfg_t cfg, reil_cfg_edge_t *edges, int count)
+    int reil_cfg_insn_list(reil_cfg_t cfg, reil_addr_t addr, reil_inst_t *insts, int count)
+
+    int reil_dfg_optimize(reil_arch_t arch, reil_inst_t *insts, int count, 
+                          reil_addr_t addr, reil_inum_t inum, int options)
+
+    ctypedef void* reil_ssa_t
+
+    cdef struct _reil_ssa_bb_t:
+
+        int first, last         # range of instructions
+        int idom                # immediate dominator or -1 for entry point
+        int phi_first, phi_count
+        int reachable
+
+    ctypedef _reil_ssa_bb_t reil_ssa_bb_t
+
+    cdef struct _reil_ssa_insn_t:
+
+        reil_addr_t addr
+        reil_inum_t inum
+        int bb
+        int a, b, c             # SSA variables of the operands or -1
+
+    ctypedef _reil_ssa_insn_t reil_ssa_insn_t
+
+    cdef struct _reil_ssa_var_t:
+
+        _reil_type_t type
+        char name[REIL_MAX_NAME_LEN]
+        int version
+        int insn                # defining instruction or -1
+        int phi                 # defining phi function or -1
+        int use_first, use_count
+
+    ctypedef _reil_ssa_var_t reil_ssa_var_t
+
+    cdef struct _reil_ssa_use_t:
+
+        int insn, phi
+
+    ctypedef _reil_ssa_use_t reil_ssa_use_t
+
+    cdef struct _reil_ssa_phi_t:
+
+        int bb, var
+        int arg_first, arg_count
+
+    ctypedef _reil_ssa_phi_t reil_ssa_phi_t
+
+    cdef struct _reil_ssa_phi_arg_t:
+
+        int bb                  # predecessor block or -1 for function entry
+        int var
+
+    ctypedef _reil_ssa_phi_arg_t reil_ssa_phi_arg_t
+
+    reil_ssa_t reil_ssa_init(reil_arch_t arch, reil_inst_t *insts, int count, 
+                             reil_addr_t addr, reil_inum_t inum)
+    void reil_ssa_close(reil_ssa_t ssa)
+    int reil_ssa_bb_list(reil_ssa_t ssa, reil_ssa_bb_t *bbs, int count)
+    int reil_ssa_insn_list(reil_ssa_t ssa, reil_ssa_insn_t *insns, int count)
+    int reil_ssa_var_list(reil_ssa_t ssa, reil_ssa_var_t *vars, int count)
+    int reil_ssa_use_list(reil_ssa_t ssa, reil_ssa_use_t *uses, int count)
+    int reil_ssa_phi_list(reil_ssa_t ssa, reil_ssa_phi_t *phis, int count)
+    int reil_ssa_phi_arg_list(reil_ssa_t ssa, reil_ssa_phi_arg_t *args, int count)
+    int reil_ssa_df_list(reil_ssa_t ssa, int bb, int *bbs, int count)
+    int reil_ssa_dominates(reil_ssa_t ssa, int a, int b)
+    int reil_ssa_slice(reil_ssa_t ssa, reil_addr_t addr, reil_inum_t inum, int arg, int options,
+                       unsigned long long *bitmap, int count)
+
+    ctypedef void* reil_sym_t
+
+    cdef struct _reil_sym_node_t:
+
+        int kind
+        _reil_op_t op
+        _reil_size_t size
+        int a, b, c             # operand nodes or -1
+        reil_const_t val        # constant value or IR address
+        reil_inum_t inum
+        _reil_type_t type
+        char name[REIL_MAX_NAME_LEN]
+
+    ctypedef _reil_sym_node_t reil_sym_node_t
+
+    cdef struct _reil_sym_item_t:
+
+        int val, exp
+
+    ctypedef _reil_sym_item_t reil_sym_item_t
+
+    reil_sym_t reil_sym_init()
+    void reil_sym_close(reil_sym_t sym)
+    int reil_sym_const(reil_sym_t sym, reil_const_t val, _reil_size_t size)
+    int reil_sym_val(reil_sym_t sym, char *name, _reil_type_t type, _reil_size_t size, reil_addr_t addr)
+    int reil_sym_ptr(reil_sym_t sym, int addr, _reil_size_t size)
+    int reil_sym_exp(reil_sym_t sym, _reil_op_t op, int a, int b, _reil_size_t size)
+    int reil_sym_cond(reil_sym_t sym, int cond, int a, int b)
+    int reil_sym_loc(reil_sym_t sym, reil_addr_t addr, reil_inum_t inum)
+    int reil_sym_ip(reil_sym_t sym)
+    int reil_sym_node(reil_sym_t sym, int node, reil_sym_node_t *info)
+    int reil_sym_count(reil_sym_t sym)
+    int reil_sym_exec(reil_sym_t sym, reil_inst_t *insts, int count, 
+                      reil_sym_item_t *state, int state_count, reil_sym_item_t *out, int out_count)
+    int reil_sym_apply(reil_sym_t sym, reil_sym_item_t *summary, int summary_count, 
+                       reil_sym_item_t *state, int state_count, reil_sym_item_t *out, int out_count)
+    int reil_sym_smt2(reil_sym_t sym, int *nodes, int count, int options, char *buff, int size)
+
+    ctypedef void* reil_vm_t
+    ctypedef void* reil_mem_t
+    ctypedef void* reil_mem_fault_t
+    ctypedef void* reil_vm_snapshot_t
+    ctypedef void* reil_mem_snapshot_t
+    ctypedef void* reil_vm_batch_t
+    ctypedef void* reil_vm_fetch_t
+    ctypedef void* reil_vm_mem_read_t
+    ctypedef void* reil_vm_mem_write_t
+
+    cdef enum _reil_vm_status_t:
+
+        REIL_VM_STOP,       # stop point was reached
+        REIL_VM_ERR_FETCH,  # instruction to execute is not available
+        REIL_VM_ERR_INSN,   # invalid or unknown instruction
+        REIL_VM_ERR_MEM,    # memory access error
+        REIL_VM_ERR_HOOK    # hook handler returned error
+
+    cdef enum _reil_mem_error_t:
+
+        REIL_MEM_OK,
+        REIL_MEM_ERR_READ,      # memory at given address is not accessible
+        REIL_MEM_ERR_WRITE,
+        REIL_MEM_ERR_NULL       # NULL pointer access
+
+    cdef struct _reil_vm_state_t:
+
+        reil_addr_t addr
+        reil_inum_t inum
+        unsigned long long executed
+
+    ctypedef _reil_vm_state_t reil_vm_state_t
+
+    cdef struct _reil_vm_reg_t:
+
+        char name[REIL_MAX_NAME_LEN]
+        _reil_size_t size
+        reil_const_t val
+        int temp
+
+    ctypedef _reil_vm_reg_t reil_vm_reg_t
+
+    cdef enum _reil_vm_rep_op_t:
+
+        REIL_VM_REP_MOVS,
+        REIL_VM_REP_STOS,
+        REIL_VM_REP_CMPS,
+        REIL_VM_REP_SCAS
+
+    cdef enum _reil_vm_rep_cond_t:
+
+        REIL_VM_REP_ALWAYS, # rep
+        REIL_VM_REP_EQ,     # repe, repz
+        REIL_VM_REP_NE      # repne, repnz
+
+    cdef struct _reil_vm_rep_t:
+
+        _reil_vm_rep_op_t op
+        _reil_vm_rep_cond_t cond
+        int size
+        const char *count
+        const char *src
+        const char *dst
+        const char *val
+        const char *dir
+
+    ctypedef _reil_vm_rep_t reil_vm_rep_t
+
+    cdef struct _reil_vm_event_t:
+
+        int type
+        reil_addr_t addr
+        reil_inum_t inum
+        reil_addr_t mem_addr
+        _reil_size_t mem_size
+        reil_const_t val
+
+    ctypedef _reil_vm_event_t reil_vm_event_t
+
+    ctypedef int (* reil_vm_hook_t)(reil_vm_t vm, reil_vm_event_t *events, int count, void *context)
+
+    cdef struct _reil_vm_cov_t:
+
+        reil_addr_t addr
+        reil_inum_t inum
+        unsigned long long hits
+
+    ctypedef _reil_vm_cov_t reil_vm_cov_t
+
+    reil_vm_t reil_vm_init(reil_arch_t arch, reil_vm_fetch_t fetch, 
+                           reil_vm_mem_read_t mem_read, reil_vm_mem_write_t mem_write, void *context)
+    void reil_vm_close(reil_vm_t vm)
+
+    int reil_vm_load(reil_vm_t vm, reil_inst_t *inst)
+    int reil_vm_load_next(reil_vm_t vm, reil_inst_t *inst, reil_addr_t next_addr, reil_inum_t next_inum)
+    int reil_vm_rep_add(reil_vm_t vm, reil_addr_t addr, reil_vm_rep_t *rep)
+    int reil_rep_info(reil_arch_t arch, unsigned long long flags, reil_vm_rep_t *rep)
+    void reil_vm_flush(reil_vm_t vm)
+
+    int reil_vm_reg_get(reil_vm_t vm, char *name, _reil_size_t *size, reil_const_t *val)
+    int reil_vm_reg_set(reil_vm_t vm, char *name, _reil_size_t size, reil_const_t val)
+    int reil_vm_reg_list(reil_vm_t vm, reil_vm_reg_t *regs, int count)
+
+    void reil_vm_reset(reil_vm_t vm)
+    void reil_vm_reset_temp(reil_vm_t vm)
+
+    int reil_vm_stop_add(reil_vm_t vm, reil_addr_t addr, int inum)
+    void reil_vm_stop_clear(reil_vm_t vm)
+
+    int reil_vm_run(reil_vm_t vm, reil_addr_t addr, reil_inum_t inum)
+    void reil_vm_get_state(reil_vm_t vm, reil_vm_state_t *state)
+    reil_vm_snapshot_t reil_vm_snapshot(reil_vm_t vm)
+    void reil_vm_restore(reil_vm_t vm, reil_vm_snapshot_t snap)
+    void reil_vm_snapshot_close(reil_vm_snapshot_t snap)
+
+    void reil_vm_set_mem(reil_vm_t vm, reil_mem_t mem)
+
+    int reil_vm_jit_enable(reil_vm_t vm, int enable)
+
+    int reil_vm_hook_set(reil_vm_t vm, int mask, reil_vm_hook_t handler, void *context)
+    int reil_vm_hook_addr_add(reil_vm_t vm, reil_addr_t addr)
+    int reil_vm_hook_mem_add(reil_vm_t vm, reil_addr_t addr, int size)
+    void reil_vm_hook_clear(reil_vm_t vm)
+
+    int reil_vm_cov_list(reil_vm_t vm, reil_vm_cov_t *items, int count)
+    unsigned char *reil_vm_cov_map(reil_vm_t vm)
+    void reil_vm_cov_reset(reil_vm_t vm)
+
+    int reil_vm_taint_enable(reil_vm_t vm, int enable, int options)
+    int reil_vm_taint_clear(reil_vm_t vm)
+    int reil_vm_taint_reg_get(reil_vm_t vm, const char *name, reil_const_t *mask)
+    int reil_vm_taint_reg_set(reil_vm_t vm, const char *name, reil_const_t mask)
+    int reil_vm_taint_mem_get(reil_vm_t vm, reil_addr_t addr, unsigned char *buff, int size)
+    int reil_vm_taint_mem_set(reil_vm_t vm, reil_addr_t addr, int size, unsigned char mask)
+    int reil_vm_taint_sink_add(reil_vm_t vm, reil_addr_t addr, const char *name)
+    int reil_vm_taint_sink_clear(reil_vm_t vm)
+
+    reil_vm_batch_t reil_vm_batch_init(reil_vm_t vm, int lanes)
+    reil_vm_batch_t reil_vm_batch_init_mt(reil_vm_t vm, int lanes, int threads)
+    int reil_vm_batch_simd(int level)
+    void reil_vm_batch_close(reil_vm_batch_t batch)
+    int reil_vm_batch_reg_get(reil_vm_batch_t batch, int lane, char *name, _reil_size_t *size, reil_const_t *val)
+    int reil_vm_batch_reg_set(reil_vm_batch_t batch, int lane, char *name, _reil_size_t size, reil_const_t val)
+    reil_mem_t reil_vm_batch_mem(reil_vm_batch_t batch, int lane)
+    void reil_vm_batch_run(reil_vm_batch_t batch, reil_addr_t addr, reil_inum_t inum) nogil
+    int reil_vm_batch_get_state(reil_vm_batch_t batch, int lane, reil_vm_state_t *state)
+
+    reil_mem_t reil_mem_init(int strict, reil_addr_t lowest_addr, reil_mem_fault_t fault, void *context)
+    void reil_mem_close(reil_mem_t mem)
+    void reil_mem_set_strict(reil_mem_t mem, int strict)
+
+    int reil_mem_read(reil_mem_t mem, reil_addr_t addr, unsigned char *buff, int size)
+    int reil_mem_write(reil_mem_t mem, reil_addr_t addr, unsigned char *buff, int size)
+    int reil_mem_load(reil_mem_t mem, reil_addr_t addr, _reil_size_t size, reil_const_t *val)
+    int reil_mem_store(reil_mem_t mem, reil_addr_t addr, _reil_size_t size, reil_const_t val)
+
+    int reil_mem_alloc(reil_mem_t mem, reil_addr_t addr, unsigned char *data, int data_size, int size)
+    reil_addr_t reil_mem_alloc_addr(reil_mem_t mem, int size)
+    void reil_mem_clear(reil_mem_t mem)
+
+    reil_mem_snapshot_t reil_mem_snapshot(reil_mem_t mem)
+    void reil_mem_restore(reil_mem_t mem, reil_mem_snapshot_t snap)
+    void reil_mem_snapshot_close(reil_mem_snapshot_t snap)
+
+    int reil_mem_get_error(reil_mem_t mem, reil_addr_t *addr)
@@ -1,3 +1,6 @@
+from libc.stdlib cimport malloc, free
+from libc.string cimport memset, memcpy, strcpy
+
 cimport libopenreil
 
 ARCH_X86 = 0
@@ -7,6 +10,7 @@ ARCH_ARM = 1
 IATTR_ASM = 0
 IATTR_BIN = 1
 IATTR_FLAGS = 2
+IATTR_REP = 6
 
 # log_init() mask constants
 LOG_INFO = 0x00000001 # regular message
@@ -26,6 +30,89 @@ LOG_NONE = 0
 # default log messages mask
 LOG_MASK_DEFAULT = LOG_INFO | LOG_WARN | LOG_ERR
 
+# profile_dump() format constants
+PROFILE_CSV = 0
+PROFILE_JSON = 1
+
+# Emulator.run() status codes
+VM_STOP = 0         # stop point was reached
+VM_ERR_FETCH = 1    # instruction to execute is not available
+VM_ERR_INSN = 2     # invalid or unknown instruction
+VM_ERR_MEM = 3      # memory access error
+VM_ERR_HOOK = 4     # hook callback raised an exception
+
+# Emulator.stop_add() inum value to stop at any IR instruction of given address
+VM_ANY_INUM = -1
+
+# Emulator.hook_set() event types
+VM_HOOK_INSN = 0x01         # machine instruction execution
+VM_HOOK_BB = 0x02           # basic block entry
+VM_HOOK_MEM_READ = 0x04     # memory read
+VM_HOOK_MEM_WRITE = 0x08    # memory write
+VM_HOOK_UNK = 0x10          # unknown instruction
+VM_HOOK_TAINT_JUMP = 0x20   # jump to tainted address
+VM_HOOK_TAINT_COND = 0x40   # conditional jump with tainted condition
+VM_HOOK_TAINT_MEM = 0x80    # memory access at tainted address
+VM_HOOK_TAINT_SINK = 0x100  # tainted register at sink address
+
+# Emulator.taint_enable() options
+VM_TAINT_BYTES = 0x01       # track taint of whole bytes instead of bits
+VM_TAINT_ADDR = 0x02        # memory access at tainted address taints the value
+
+# size of Emulator.cov_map() edge coverage bitmap
+VM_COV_MAP_SIZE = 0x10000
+
+# Memory.get_error() error codes
+MEM_ERR_READ = 1    # memory at given address is not accessible
+MEM_ERR_WRITE = 2
+MEM_ERR_NULL = 3    # NULL pointer access
+
+# default lowest accessible address of Memory
+MEM_LOWEST_ADDR = 0x1000
+
+# CFG.bb_list() flags
+CFG_BB_RET = 0x01       # basic block ends with return from function
+CFG_BB_ERROR = 0x02     # code at block address can't be read or translated
+CFG_BB_INDIRECT = 0x04  # basic block ends with indirect jump that was resolved
+
+# dfg_optimize() options
+DFG_FOLD_CONST = 0x01   # constant folding and propagation
+DFG_ELIM_SUBEXP = 0x02  # common subexpression elimination and copy propagation
+DFG_ELIM_DEAD = 0x04    # dead code elimination
+DFG_KEEP_FLAGS = 0x08   # flags are live at the end of the function
+
+DFG_OPTIMIZE_ALL = DFG_FOLD_CONST | DFG_ELIM_SUBEXP | DFG_ELIM_DEAD
+
+# SSA.slice() options
+SLICE_FORWARD = 0x01    # forward slice instead of backward one
+SLICE_MEM = 0x02        # follow memory dependencies of I_LDM and I_STM
+SLICE_LOCAL = 0x04      # don't leave basic block of the instruction
+
+# SSA.slice() operands
+SLICE_ARG_A = 0
+SLICE_ARG_B = 1
+SLICE_ARG_C = 2
+
+# kinds of Sym.node() items
+SYM_CONST = 0
+SYM_VAL = 1
+SYM_PTR = 2
+SYM_EXP = 3
+SYM_COND = 4
+SYM_LOC = 5
+SYM_IP = 6
+
+# Sym.smt2() options
+SMT_ASSERT = 0x00000001
+SMT_MEM_BYTES = 0x00000002
+
+# flags of instructions that were eliminated by dfg_optimize()
+IOPT_ELIMINATED = 0x00000010
+
+# rep-prefixed string instruction information, see IOPT_REP_* in reil_ir.h
+IOPT_REP = 0x00000020
+IOPT_REP_MASK = IOPT_REP | 0x7f00
+
 cdef process_arg(libopenreil._reil_arg_t arg):
 
     # convert reil_arg_t to the python tuple
@@ -49,6 +136,28 @@ cdef process_arg(libopenreil._reil_arg_t arg):
 
         return ( arg.type, ( arg.val, arg.inum ))
 
+cdef process_stats_stage(libopenreil.reil_stats_stage_t stage):
+
+    # convert reil_stats_stage_t to the python dict
+    return { 'time': stage.time, 'count': stage.count }
+
+cdef process_rep_reg(const char *name):
+
+    return None if name == NULL else str(name)
+
+cdef process_rep(libopenreil.reil_arch_t arch, unsigned long long flags):
+
+    cdef libopenreil.reil_vm_rep_t rep
+
+    # get IOPT_REP_* fields and registers of the architecture
+    if libopenreil.reil_rep_info(arch, flags, &rep) == -1:
+
+        return None
+
+    # convert reil_vm_rep_t to the IATTR_REP tuple
+    return ( rep.op, rep.size, rep.cond, process_rep_reg(rep.count), process_rep_reg(rep.src), 
+             process_rep_reg(rep.dst), process_rep_reg(rep.val), process_rep_reg(rep.dir) )
+
 cdef int process_insn(libopenreil.reil_inst_t* inst, object context):
 
     attr = {}    
@@ -56,10 +165,21 @@ cdef int process_insn(libopenreil.reil_inst_t* inst, object context):
     cdef unsigned char* data
     cdef char* str_mnem
     cdef char* str_op
-    
-    if inst.flags != 0: 
 
-        attr[IATTR_FLAGS] = inst.flags
+    # context is a tuple of instructions list and reil_arch_t value
+    translated, arch = context
+
+    if inst.flags & IOPT_REP:
+
+        # rep-prefixed string instruction that was tagged by libopenreil
+        rep = process_rep(arch, inst.flags)
+        if rep is not None: attr[IATTR_REP] = rep
+
+    flags = inst.flags & ~IOPT_REP_MASK
+
+    if flags != 0: 
+
+        attr[IATTR_FLAGS] = flags
 
     if inst.inum == 0:
 
@@ -82,7 +202,7 @@ cdef int process_insn(libopenreil.reil_inst_t* inst, object context):
     args = ( process_arg(inst.a), process_arg(inst.b), process_arg(inst.c) )
     
     # put instruction into the list
-    context.insert(0, ( raw_info, inst.inum, inst.op, args, attr ))
+    translated.insert(0, ( raw_info, inst.inum, inst.op, args, attr ))
 
     return 1
     
@@ -119,6 +239,7 @@ cdef class Translator:
     cdef libopenreil.reil_t reil
     cdef libopenreil.reil_arch_t reil_arch 
     cdef char* log_path   
+    cdef object context
     translated = []
 
     def __init__(self, arch, log_path = None, log_mask = LOG_MASK_DEFAULT):
@@ -136,9 +257,12 @@ cdef class Translator:
         # initialize logging
         libopenreil.reil_log_init(log_mask, self.log_path)
 
+        # process_insn() needs architecture for IATTR_REP information
+        self.context = ( self.translated, self.reil_arch )
+
         # initialize translator
         self.reil = libopenreil.reil_init(self.reil_arch, 
-            <libopenreil.reil_inst_handler_t>process_insn, <void*>self.translated)
+            <libopenreil.reil_inst_handler_t>process_insn, <void*>self.context)
 
         if self.reil == NULL:
 
@@ -176,3 +300,1596 @@ cdef class Translator:
         while len(self.translated) > 0: ret.append(self.translated.pop())
         return ret
 
+    def get_stats(self):
+
+        cdef libopenreil.reil_stats_t stats
+
+        if libopenreil.reil_get_stats(self.reil, &stats) == -1:
+
+            raise Error('Error while querying translator statistics')
+
+        # time values are in nanoseconds
+        return { 'disasm': process_stats_stage(stats.disasm), 
+                    'vex': process_stats_stage(stats.vex), 
+                   'irbb': process_stats_stage(stats.irbb),
+                    'bap': process_stats_stage(stats.bap), 
+                    'bil': process_stats_stage(stats.bil),
+                'handler': process_stats_stage(stats.handler),
+
+                'insn_translated': stats.insn_translated,
+                   'insn_unknown': stats.insn_unknown,
+                    'insn_failed': stats.insn_failed,
+                   'reil_emitted': stats.reil_emitted,
+                 'temp_allocated': stats.temp_allocated,
+                    'vex_mem_max': stats.vex_mem_max }
+
+    def reset_stats(self):
+
+        libopenreil.reil_reset_stats(self.reil)
+
+    def profile_enable(self, enable = True):
+
+        libopenreil.reil_profile_enable(self.reil, 1 if enable else 0)
+
+    def get_profile(self):
+
+        ret = []
+        cdef int count = libopenreil.reil_profile_get(self.reil, NULL, 0)
+        if count <= 0: 
+
+            return ret
+
+        cdef libopenreil.reil_profile_entry_t *entries = \
+            <libopenreil.reil_profile_entry_t *>malloc(sizeof(libopenreil.reil_profile_entry_t) * count)
+
+        if entries == NULL:
+
+            raise MemoryError()
+
+        try:
+
+            libopenreil.reil_profile_get(self.reil, entries, count)
+
+            # most expensive instructions goes first, time values are in nanoseconds
+            for i in range(count):
+
+                ret.append({ 'id': entries[i].id, 
+                           'mnem': entries[i].mnem, 
+                          'count': entries[i].count, 
+                   'reil_emitted': entries[i].reil_emitted, 
+                 'temp_allocated': entries[i].temp_allocated, 
+                           'time': entries[i].time })
+
+        finally:
+
+            free(entries)
+
+        return ret
+
+    def profile_dump(self, path = None, format = PROFILE_CSV):
+
+        cdef char* c_path = NULL
+        cdef libopenreil.reil_profile_format_t c_format = libopenreil.REIL_PROFILE_CSV
+
+        if path is not None: c_path = path
+        if format == PROFILE_JSON: c_format = libopenreil.REIL_PROFILE_JSON
+
+        if libopenreil.reil_profile_dump(self.reil, c_path, c_format) == -1:
+
+            raise Error('Error while saving translation profile')
+
+    def profile_reset(self):
+
+        libopenreil.reil_profile_reset(self.reil)
+
+
+
+cdef int cfg_read(libopenreil.reil_addr_t addr, unsigned char *buff, int size, void *context):
+
+    cfg = <object>context
+
+    try:
+
+        # callback returns code at given address or None when it's not accessible
+        data = cfg.read(addr, size)
+        if data is None: return -1
+
+        size = min(size, len(data))
+        memcpy(buff, <char *>data, size)
+
+        return size
+
+    except Exception as e:
+
+        cfg.error = e
+        return -1
+
+
+cdef int cfg_read_data(libopenreil.reil_addr_t addr, unsigned char *buff, int size, void *context):
+
+    cfg = <object>context
+
+    try:
+
+        # callback returns constant data at given address or None when it's not available
+        data = cfg.read_data(addr, size)
+        if data is None: return -1
+
+        size = min(size, len(data))
+        memcpy(buff, <char *>data, size)
+
+        return size
+
+    except Exception:
+
+        # not constant memory is not an error, jump target just stays unresolved
+        return -1
+
+
+cdef class CFG:
+
+    cdef libopenreil.reil_cfg_t cfg
+    cdef libopenreil.reil_arch_t reil_arch
+    cdef public object read, read_data, error
+
+    def __init__(self, arch, read, read_data = None):
+
+        try: 
+
+            self.reil_arch = { ARCH_X86: libopenreil.ARCH_X86, 
+                               ARCH_ARM: libopenreil.ARCH_ARM }[ arch ]
+
+        except KeyError: 
+
+            raise InitError('Unknown architecture')
+
+        self.read, self.read_data, self.error = read, read_data, None
+
+        # initialize CFG builder
+        self.cfg = libopenreil.reil_cfg_init(self.reil_arch, 
+            <libopenreil.reil_reader_t>cfg_read, <void*>self)
+
+        if self.cfg == NULL:
+
+            raise InitError('Error while initializing CFG builder')
+
+        if read_data is not None:
+
+            # resolve indirect jumps using constant data of the image
+            libopenreil.reil_cfg_set_data_reader(self.cfg, 
+                <libopenreil.reil_reader_t>cfg_read_data, <void*>self)
+
+    def __dealloc__(self):
+
+        if self.cfg != NULL: libopenreil.reil_cfg_close(self.cfg)
+
+    def traverse(self, addr, inum = 0):
+
+        self.error = None
+
+        ret = libopenreil.reil_cfg_traverse(self.cfg, addr, inum)
+
+        if self.error is not None:
+
+            # re-raise exception from read callback
+            error, self.error = self.error, None
+            raise error
+
+        if ret == -1:
+
+            raise Error('Error while traversing basic blocks')
+
+        return ret
+
+    def discover(self, addr_list, jobs = 1):
+
+        cdef int count = len(addr_list)
+        cdef libopenreil.reil_addr_t *entries = \
+            <libopenreil.reil_addr_t *>malloc(sizeof(libopenreil.reil_addr_t) * max(count, 1))
+
+        if entries == NULL:
+
+            raise MemoryError()
+
+        try:
+
+            for i in range(count): entries[i] = addr_list[i]
+
+            self.error = None
+
+            # read callback exceptions are visible here only for single worker
+            ret = libopenreil.reil_cfg_discover(self.cfg, entries, count, jobs)
+
+        finally:
+
+            free(entries)
+
+        if self.error is not None:
+
+            # re-raise exception from read callback
+            error, self.error = self.error, None
+            raise error
+
+        if ret == -1:
+
+            raise Error('Error while discovering functions')
+
+        return ret
+
+    def func_list(self):
+
+        ret = []
+        cdef int count = libopenreil.reil_cfg_func_list(self.cfg, NULL, 0)
+        if count <= 0: 
+
+            return ret
+
+        cdef libopenreil.reil_cfg_func_t *funcs = \
+            <libopenreil.reil_cfg_func_t *>malloc(sizeof(libopenreil.reil_cfg_func_t) * count)
+
+        if funcs == NULL:
+
+            raise MemoryError()
+
+        try:
+
+            libopenreil.reil_cfg_func_list(self.cfg, funcs, count)
+
+            # list of ( addr, bb_first, bb_count, edge_first, edge_count ) tuples
+            for i in range(count):
+
+                ret.append(( funcs[i].addr, funcs[i].bb_first, funcs[i].bb_count, 
+                             funcs[i].edge_first, funcs[i].edge_count ))
+
+        finally:
+
+            free(funcs)
+
+        return ret
+
+    def bb_list(self):
+
+        ret = []
+        cdef int count = libopenreil.reil_cfg_bb_list(self.cfg, NULL, 0)
+        if count <= 0: 
+
+            return ret
+
+        cdef libopenreil.reil_cfg_bb_t *bbs = \
+            <libopenreil.reil_cfg_bb_t *>malloc(sizeof(libopenreil.reil_cfg_bb_t) * count)
+
+        if bbs == NULL:
+
+            raise MemoryError()
+
+        try:
+
+            libopenreil.reil_cfg_bb_list(self.cfg, bbs, count)
+
+            # list of ( first_ir_addr, last_ir_addr, size, flags ) tuples
+            for i in range(count):
+
+                ret.append(( ( bbs[i].addr, bbs[i].inum ), 
+                             ( bbs[i].last_addr, bbs[i].last_inum ), bbs[i].size, bbs[i].flags ))
+
+        finally:
+
+            free(bbs)
+
+        return ret
+
+    def edge_list(self):
+
+        ret = []
+        cdef int count = libopenreil.reil_cfg_edge_list(self.cfg, NULL, 0)
+        if count <= 0: 
+
+            return ret
+
+        cdef libopenreil.reil_cfg_edge_t *edges = \
+            <libopenreil.reil_cfg_edge_t *>malloc(sizeof(libopenreil.reil_cfg_edge_t) * count)
+
+        if edges == NULL:
+
+            raise MemoryError()
+
+        try:
+
+            libopenreil.reil_cfg_edge_list(self.cfg, edges, count)
+
+            # list of ( from, to ) tuples with indexes of bb_list() items
+            for i in range(count):
+
+                ret.append(( edges[i].from_bb, edges[i].to_bb ))
+
+        finally:
+
+            free(edges)
+
+        return ret
+
+    def insn_list(self, addr):
+
+        ret = []
+        cdef int count = libopenreil.reil_cfg_insn_list(self.cfg, addr, NULL, 0)
+        if count <= 0: 
+
+            raise TranslationError(addr)
+
+        cdef libopenreil.reil_inst_t *insts = \
+            <libopenreil.reil_inst_t *>malloc(sizeof(libopenreil.reil_inst_t) * count)
+
+        if insts == NULL:
+
+            raise MemoryError()
+
+        try:
+
+            libopenreil.reil_cfg_insn_list(self.cfg, addr, insts, count)
+
+            # process_insn() inserts instructions at the beginning of the list
+            for i in range(count - 1, -1, -1):
+
+                process_insn(&insts[i], ( ret, self.reil_arch ))
+
+        finally:
+
+            free(insts)
+
+        # the same format as Translator.to_reil() returns
+        return ret
+
+
+cdef load_arg(libopenreil.reil_arg_t *arg, object data):
+
+    # convert python tuple to the reil_arg_t
+    if len(data) == 0:
+
+        arg.type = libopenreil.A_NONE
+
+    elif data[0] == libopenreil.A_LOC:
+
+        arg.type = libopenreil.A_LOC
+        arg.val, arg.inum = data[1]
+
+    else:
+
+        arg.type = <libopenreil._reil_type_t>data[0]
+        arg.size = <libopenreil._reil_size_t>data[1]
+
+        if arg.type == libopenreil.A_CONST:
+
+            arg.val = data[2] & 0xffffffffffffffff
+
+        else:
+
+            name = data[2]
+            if len(name) >= sizeof(arg.name):
+
+                raise Error('Invalid register name %s' % name)
+
+            strcpy(arg.name, name)
+
+cdef int vm_fetch(libopenreil.reil_vm_t vm, libopenreil.reil_addr_t addr, 
+                  libopenreil.reil_inum_t inum, void *context) with gil:
+
+    emu = <object>context
+
+    try:
+
+        # callback returns list of ( insn, next ) tuples
+        for insn, next in emu.fetch(addr, inum): emu.load(insn, next)
+        return 0
+
+    except Exception as e:
+
+        # exception will be raised by Emulator.run()
+        emu.error = e
+        return -1
+
+cdef int vm_mem_read(libopenreil.reil_addr_t addr, libopenreil._reil_size_t size, 
+                     libopenreil.reil_const_t *val, void *context):
+
+    emu = <object>context
+
+    try:
+
+        val[0] = emu.mem_read(addr, size) & 0xffffffffffffffff
+        return 0
+
+    except Exception as e:
+
+        emu.error = e
+        return -1
+
+cdef int vm_mem_write(libopenreil.reil_addr_t addr, libopenreil._reil_size_t size, 
+                      libopenreil.reil_const_t val, void *context):
+
+    emu = <object>context
+
+    try:
+
+        emu.mem_write(addr, size, val)
+        return 0
+
+    except Exception as e:
+
+        emu.error = e
+        return -1
+
+cdef int vm_hook(libopenreil.reil_vm_t vm, libopenreil.reil_vm_event_t *events, 
+                 int count, void *context):
+
+    emu = <object>context
+
+    try:
+
+        # callback gets list of ( type, addr, inum, mem_addr, mem_size, val ) tuples
+        emu.hook([ ( events[i].type, events[i].addr, events[i].inum, 
+                     events[i].mem_addr, events[i].mem_size, events[i].val ) for i in range(count) ])
+        return 0
+
+    except Exception as e:
+
+        emu.error = e
+        return -1
+
+cdef int mem_fault(libopenreil.reil_mem_t mem, libopenreil.reil_addr_t addr, int size, void *context) with gil:
+
+    obj = <object>context
+
+    try:
+
+        # callback must allocate requested memory range or return False
+        return 0 if obj.fault(addr, size) else -1
+
+    except Exception as e:
+
+        obj.error = e
+        return -1
+
+
+cdef class MemorySnapshot:
+
+    cdef libopenreil.reil_mem_snapshot_t snap
+
+    def __dealloc__(self):
+
+        if self.snap != NULL: libopenreil.reil_mem_snapshot_close(self.snap)
+
+
+cdef class Memory:
+
+    cdef libopenreil.reil_mem_t mem
+    cdef public object fault, error
+
+    # object that owns borrowed memory
+    cdef object owner
+
+    def __init__(self, strict = True, lowest_addr = MEM_LOWEST_ADDR, fault = None):
+
+        cdef libopenreil.reil_mem_fault_t c_fault = NULL
+
+        self.fault, self.error = fault, None
+
+        # fault callback is optional
+        if fault is not None: c_fault = <libopenreil.reil_mem_fault_t>mem_fault
+
+        self.mem = libopenreil.reil_mem_init(1 if strict else 0, lowest_addr, c_fault, <void*>self)
+
+    def __dealloc__(self):
+
+        if self.mem != NULL and self.owner is None: libopenreil.reil_mem_close(self.mem)
+
+    def check_error(self):
+
+        if self.error is not None:
+
+            # re-raise exception from fault callback
+            error, self.error = self.error, None
+            raise error
+
+    def set_strict(self, strict):
+
+        libopenreil.reil_mem_set_strict(self.mem, 1 if strict else 0)
+
+    def get_error(self):
+
+        cdef libopenreil.reil_addr_t addr = 0
+
+        # returns MEM_ERR_* code and address
+        ret = libopenreil.reil_mem_get_error(self.mem, &addr)
+        return ret, addr
+
+    def read(self, addr, size):
+
+        cdef unsigned char *buff = <unsigned char *>malloc(max(size, 1))
+        if buff == NULL:
+
+            raise MemoryError()
+
+        try:
+
+            ret = libopenreil.reil_mem_read(self.mem, addr, buff, size)
+            self.check_error()
+
+            # returns None on error, see get_error()
+            return None if ret == -1 else (<char *>buff)[:size]
+
+        finally:
+
+            free(buff)
+
+    def write(self, addr, data):
+
+        ret = libopenreil.reil_mem_write(self.mem, addr, data, len(data))
+        self.check_error()
+
+        return ret != -1
+
+    def load(self, addr, size):
+
+        cdef libopenreil.reil_const_t val = 0
+
+        ret = libopenreil.reil_mem_load(self.mem, addr, <libopenreil._reil_size_t>size, &val)
+        self.check_error()
+
+        return None if ret == -1 else val
+
+    def store(self, addr, size, val):
+
+        ret = libopenreil.reil_mem_store(self.mem, addr, <libopenreil._reil_size_t>size, 
+                                         val & 0xffffffffffffffff)
+        self.check_error()
+
+        return ret != -1
+
+    def alloc(self, addr, data = None, size = None):
+
+        cdef unsigned char *c_data = NULL
+        cdef int data_size = 0
+
+        if data is not None:
+
+            c_data, data_size = data, len(data)
+
+        size = data_size if size is None else size
+
+        return libopenreil.reil_mem_alloc(self.mem, addr, c_data, data_size, size) != -1
+
+    def alloc_addr(self, size):
+
+        return libopenreil.reil_mem_alloc_addr(self.mem, size)
+
+    def clear(self):
+
+        libopenreil.reil_mem_clear(self.mem)
+
+    def snapshot(self):
+
+        cdef MemorySnapshot snap = MemorySnapshot()
+
+        snap.snap = libopenreil.reil_mem_snapshot(self.mem)
+        return snap
+
+    def restore(self, MemorySnapshot snap not None):
+
+        libopenreil.reil_mem_restore(self.mem, snap.snap)
+
+
+cdef class EmulatorSnapshot:
+
+    cdef libopenreil.reil_vm_snapshot_t snap
+
+    def __dealloc__(self):
+
+        if self.snap != NULL: libopenreil.reil_vm_snapshot_close(self.snap)
+
+
+cdef class Emulator:
+
+    cdef libopenreil.reil_vm_t vm
+    cdef public object fetch, mem_read, mem_write, hook, error
+    cdef public bint rep_fast
+    cdef Memory mem
+
+    def __init__(self, arch, fetch, mem_read = None, mem_write = None):
+
+        cdef libopenreil.reil_arch_t reil_arch
+        cdef libopenreil.reil_vm_mem_read_t c_mem_read = NULL
+        cdef libopenreil.reil_vm_mem_write_t c_mem_write = NULL
+
+        try: 
+
+            reil_arch = { ARCH_X86: libopenreil.ARCH_X86, 
+                          ARCH_ARM: libopenreil.ARCH_ARM }[ arch ]
+
+        except KeyError: 
+
+            raise InitError('Unknown architecture')
+
+        self.fetch, self.mem_read, self.mem_write = fetch, mem_read, mem_write
+        self.error, self.mem, self.hook = None, None, None
+
+        # IATTR_REP information is used unless rep_fast was cleared
+        self.rep_fast = True
+
+        # memory access callbacks are optional
+        if mem_read is not None: c_mem_read = <libopenreil.reil_vm_mem_read_t>vm_mem_read
+        if mem_write is not None: c_mem_write = <libopenreil.reil_vm_mem_write_t>vm_mem_write
+
+        # initialize interpreter
+        self.vm = libopenreil.reil_vm_init(reil_arch, 
+            <libopenreil.reil_vm_fetch_t>vm_fetch, c_mem_read, c_mem_write, <void*>self)
+
+        if self.vm == NULL:
+
+            raise InitError('Error while initializing REIL interpreter')
+
+    def __dealloc__(self):
+
+        if self.vm != NULL: libopenreil.reil_vm_close(self.vm)
+
+    def load(self, insn, next = None):
+
+        cdef libopenreil.reil_inst_t inst
+        cdef int ret
+
+        memset(&inst, 0, sizeof(inst))
+
+        # convert python tuple to the reil_inst_t
+        raw_info, inum, op, args, attr = insn
+
+        inst.raw_info.addr, inst.raw_info.size = raw_info
+        inst.inum, inst.op = inum, <libopenreil._reil_op_t>op
+        inst.flags = attr.get(IATTR_FLAGS, 0)
+
+        if inum == 0 and self.rep_fast and attr.has_key(IATTR_REP):
+
+            # rep-prefixed string instruction information must be known before loading
+            self.rep_add(inst.raw_info.addr, attr[IATTR_REP])
+
+        load_arg(&inst.a, args[0])
+        load_arg(&inst.b, args[1])
+        load_arg(&inst.c, args[2])
+
+        if next is None:
+
+            # next instruction address is determined by IOPT_ASM_END flag
+            ret = libopenreil.reil_vm_load(self.vm, &inst)
+
+        else:
+
+            ret = libopenreil.reil_vm_load_next(self.vm, &inst, next[0], next[1])
+
+        if ret == -1:
+
+            raise Error('Error while loading instruction %s' % hex(inst.raw_info.addr))
+
+    def rep_add(self, addr, info):
+
+        cdef libopenreil.reil_vm_rep_t rep
+
+        op, size, cond = info[: 3]
+
+        # register names may be unicode after JSON, they must be alive during the call
+        names = map(lambda name: None if name is None else str(name), info[3 :])
+        count, src, dst, val, dir = names
+
+        rep.op, rep.cond = <libopenreil._reil_vm_rep_op_t>op, <libopenreil._reil_vm_rep_cond_t>cond
+        rep.size = size
+
+        rep.count = <char *>NULL if count is None else <char *>count
+        rep.src = <char *>NULL if src is None else <char *>src
+        rep.dst = <char *>NULL if dst is None else <char *>dst
+        rep.val = <char *>NULL if val is None else <char *>val
+        rep.dir = <char *>NULL if dir is None else <char *>dir
+
+        if libopenreil.reil_vm_rep_add(self.vm, addr, &rep) == -1:
+
+            raise Error('Error while adding rep instruction %s' % hex(addr))
+
+    def flush(self):
+
+        libopenreil.reil_vm_flush(self.vm)
+
+    def reg_get(self, name):
+
+        cdef libopenreil._reil_size_t size
+        cdef libopenreil.reil_const_t val
+
+        if libopenreil.reil_vm_reg_get(self.vm, name, &size, &val) == -1:
+
+            return None
+
+        return size, val
+
+    def reg_set(self, name, size, val):
+
+        if libopenreil.reil_vm_reg_set(self.vm, name, <libopenreil._reil_size_t>size, 
+                                       val & 0xffffffffffffffff) == -1:
+
+            raise Error('Error while setting register %s' % name)
+
+    def reg_list(self):
+
+        ret = []
+        cdef int count = libopenreil.reil_vm_reg_list(self.vm, NULL, 0)
+        if count <= 0: 
+
+            return ret
+
+        cdef libopenreil.reil_vm_reg_t *regs = \
+            <libopenreil.reil_vm_reg_t *>malloc(sizeof(libopenreil.reil_vm_reg_t) * count)
+
+        if regs == NULL:
+
+            raise MemoryError()
+
+        try:
+
+            libopenreil.reil_vm_reg_list(self.vm, regs, count)
+
+            for i in range(count):
+
+                ret.append(( regs[i].name, regs[i].size, regs[i].val, regs[i].temp != 0 ))
+
+        finally:
+
+            free(regs)
+
+        return ret
+
+    def reset(self):
+
+        libopenreil.reil_vm_reset(self.vm)
+
+    def reset_temp(self):
+
+        libopenreil.reil_vm_reset_temp(self.vm)
+
+    def stop_add(self, addr, inum = VM_ANY_INUM):
+
+        if libopenreil.reil_vm_stop_add(self.vm, addr, inum) == -1:
+
+            raise Error('Invalid stop point')
+
+    def stop_clear(self):
+
+        libopenreil.reil_vm_stop_clear(self.vm)
+
+    def snapshot(self):
+
+        cdef EmulatorSnapshot snap = EmulatorSnapshot()
+
+        # save registers state
+        snap.snap = libopenreil.reil_vm_snapshot(self.vm)
+        return snap
+
+    def restore(self, EmulatorSnapshot snap not None):
+
+        libopenreil.reil_vm_restore(self.vm, snap.snap)
+
+    def set_mem(self, Memory mem = None):
+
+        # use native guest memory instead of memory access callbacks
+        libopenreil.reil_vm_set_mem(self.vm, NULL if mem is None else mem.mem)
+        self.mem = mem
+
+    def jit_enable(self, enable = True):
+
+        # returns False when JIT compiler is not supported by the host
+        return libopenreil.reil_vm_jit_enable(self.vm, 1 if enable else 0) == 0
+
+    def hook_set(self, mask, hook):
+
+        cdef libopenreil.reil_vm_hook_t c_hook = <libopenreil.reil_vm_hook_t>NULL
+
+        # callback gets queued events in batches
+        self.hook = hook if mask != 0 else None
+
+        if self.hook is not None: c_hook = <libopenreil.reil_vm_hook_t>vm_hook
+
+        if libopenreil.reil_vm_hook_set(self.vm, mask, c_hook, <void*>self) == -1:
+
+            raise Error('Error while setting hook')
+
+    def hook_addr_add(self, addr):
+
+        libopenreil.reil_vm_hook_addr_add(self.vm, addr)
+
+    def hook_mem_add(self, addr, size):
+
+        if libopenreil.reil_vm_hook_mem_add(self.vm, addr, size) == -1:
+
+            raise Error('Invalid memory range')
+
+    def hook_clear(self):
+
+        libopenreil.reil_vm_hook_clear(self.vm)
+        self.hook = None
+
+    def cov_list(self):
+
+        ret = {}
+        cdef int count = libopenreil.reil_vm_cov_list(self.vm, NULL, 0)
+        if count <= 0: 
+
+            return ret
+
+        cdef libopenreil.reil_vm_cov_t *items = \
+            <libopenreil.reil_vm_cov_t *>malloc(sizeof(libopenreil.reil_vm_cov_t) * count)
+
+        if items == NULL:
+
+            raise MemoryError()
+
+        try:
+
+            libopenreil.reil_vm_cov_list(self.vm, items, count)
+
+            for i in range(count):
+
+                ret[( items[i].addr, items[i].inum )] = items[i].hits
+
+        finally:
+
+            free(items)
+
+        return ret
+
+    def cov_map(self):
+
+        # copy of the edge coverage bitmap
+        return (<char *>libopenreil.reil_vm_cov_map(self.vm))[: VM_COV_MAP_SIZE]
+
+    def cov_reset(self):
+
+        libopenreil.reil_vm_cov_reset(self.vm)
+
+    def taint_enable(self, enable = True, options = 0):
+
+        libopenreil.reil_vm_taint_enable(self.vm, 1 if enable else 0, options)
+
+    def taint_clear(self):
+
+        if libopenreil.reil_vm_taint_clear(self.vm) == -1:
+
+            raise Error('Taint tracking is not enabled')
+
+    def taint_reg_get(self, name):
+
+        cdef libopenreil.reil_const_t mask
+
+        if libopenreil.reil_vm_taint_reg_get(self.vm, name, &mask) == -1:
+
+            return None
+
+        return mask
+
+    def taint_reg_set(self, name, mask):
+
+        if libopenreil.reil_vm_taint_reg_set(self.vm, name, mask & 0xffffffffffffffff) == -1:
+
+            raise Error('Error while setting taint of register %s' % name)
+
+    def taint_mem_get(self, addr, size):
+
+        # string with taint bits of each byte
+        cdef unsigned char *buff = <unsigned char *>malloc(max(size, 1))
+
+        if buff == NULL:
+
+            raise MemoryError()
+
+        try:
+
+            if libopenreil.reil_vm_taint_mem_get(self.vm, addr, buff, size) == -1:
+
+                raise Error('Error while reading taint of memory %s' % hex(addr))
+
+            return (<char *>buff)[: size]
+
+        finally:
+
+            free(buff)
+
+    def taint_mem_set(self, addr, size, mask = 0xff):
+
+        if libopenreil.reil_vm_taint_mem_set(self.vm, addr, size, mask) == -1:
+
+            raise Error('Error while setting taint of memory %s' % hex(addr))
+
+    def taint_sink_add(self, addr, name):
+
+        cdef int ret = libopenreil.reil_vm_taint_sink_add(self.vm, addr, name)
+
+        if ret == -1:
+
+            raise Error('Taint tracking is not enabled')
+
+        return ret
+
+    def taint_sink_clear(self):
+
+        libopenreil.reil_vm_taint_sink_clear(self.vm)
+
+    def batch(self, lanes, threads = 1):
+
+        return EmulatorBatch(self, lanes, threads)
+
+    def run(self, addr, inum = 0):
+
+        self.error = None
+
+        ret = libopenreil.reil_vm_run(self.vm, addr, inum)
+
+        if self.error is not None:
+
+            # re-raise exception from fetch or memory access callback
+            error, self.error = self.error, None
+            raise error
+
+        if self.mem is not None: 
+
+            self.mem.check_error()
+
+        return ret
+
+    def get_state(self):
+
+        cdef libopenreil.reil_vm_state_t state
+
+        libopenreil.reil_vm_get_state(self.vm, &state)
+
+        return { 'addr': state.addr, 'inum': state.inum, 'executed': state.executed }
+
+
+cdef class EmulatorBatch:
+
+    cdef libopenreil.reil_vm_batch_t batch
+    cdef Emulator emu
+    cdef public int lanes
+
+    def __init__(self, Emulator emu not None, lanes, threads = 1):
+
+        if emu.mem is None:
+
+            raise InitError('Batch execution requires native memory')
+
+        self.emu, self.lanes = emu, lanes
+
+        # lanes are starting from the current state of the emulator
+        self.batch = libopenreil.reil_vm_batch_init_mt(emu.vm, lanes, threads)
+
+        if self.batch == NULL:
+
+            raise InitError('Error while initializing batch executor')
+
+    def __dealloc__(self):
+
+        if self.batch != NULL: libopenreil.reil_vm_batch_close(self.batch)
+
+    def check_lane(self, lane):
+
+        if lane < 0 or lane >= self.lanes:
+
+            raise IndexError('Invalid lane %d' % lane)
+
+    def reg_get(self, lane, name):
+
+        cdef libopenreil._reil_size_t size
+        cdef libopenreil.reil_const_t val
+
+        self.check_lane(lane)
+
+        if libopenreil.reil_vm_batch_reg_get(self.batch, lane, name, &size, &val) == -1:
+
+            return None
+
+        return size, val
+
+    def reg_set(self, lane, name, size, val):
+
+        self.check_lane(lane)
+
+        if libopenreil.reil_vm_batch_reg_set(self.batch, lane, name, <libopenreil._reil_size_t>size, 
+                                             val & 0xffffffffffffffff) == -1:
+
+            raise Error('Error while setting register %s' % name)
+
+    def mem(self, lane):
+
+        cdef Memory mem = Memory.__new__(Memory)
+
+        self.check_lane(lane)
+
+        # memory of the lane is owned by the batch
+        mem.mem, mem.owner = libopenreil.reil_vm_batch_mem(self.batch, lane), self
+        return mem
+
+    def run(self, addr, inum = 0):
+
+        cdef libopenreil.reil_addr_t c_addr = addr
+        cdef libopenreil.reil_inum_t c_inum = inum
+
+        self.emu.error = None
+
+        # worker threads are taking GIL only to call fetch and memory fault callbacks
+        with nogil: libopenreil.reil_vm_batch_run(self.batch, c_addr, c_inum)
+
+        if self.emu.error is not None:
+
+            # re-raise exception from fetch callback
+            error, self.emu.error = self.emu.error, None
+            raise error
+
+        # lanes are reading missing memory contents from the emulator memory
+        self.emu.mem.check_error()
+
+    def get_state(self, lane):
+
+        cdef libopenreil.reil_vm_state_t state
+
+        self.check_lane(lane)
+
+        ret = libopenreil.reil_vm_batch_get_state(self.batch, lane, &state)
+
+        return { 'addr': state.addr, 'inum': state.inum, 'executed': state.executed, 'status': ret }
+
+
+cdef load_insn_list(libopenreil.reil_inst_t *insts, object insn_list):
+
+    memset(insts, 0, sizeof(libopenreil.reil_inst_t) * len(insn_list))
+
+    for i in range(len(insn_list)):
+
+        # convert python tuple to the reil_inst_t
+        raw_info, insn_inum, op, args, attr = insn_list[i]
+
+        insts[i].raw_info.addr, insts[i].raw_info.size = raw_info
+        insts[i].inum, insts[i].op = insn_inum, <libopenreil._reil_op_t>op
+        insts[i].flags = attr.get(IATTR_FLAGS, 0)
+
+        load_arg(&insts[i].a, args[0])
+        load_arg(&insts[i].b, args[1])
+        load_arg(&insts[i].c, args[2])
+
+
+def dfg_optimize(arch, insn_list, addr, inum = 0, options = DFG_OPTIMIZE_ALL):
+
+    cdef libopenreil.reil_arch_t reil_arch
+
+    try: 
+
+        reil_arch = { ARCH_X86: libopenreil.ARCH_X86, 
+                      ARCH_ARM: libopenreil.ARCH_ARM }[ arch ]
+
+    except KeyError: 
+
+        raise Error('Unknown architecture')
+
+    ret = []
+    cdef int count = len(insn_list)
+    if count == 0: 
+
+        return ret
+
+    cdef libopenreil.reil_inst_t *insts = \
+        <libopenreil.reil_inst_t *>malloc(sizeof(libopenreil.reil_inst_t) * count)
+
+    if insts == NULL:
+
+        raise MemoryError()
+
+    try:
+
+        load_insn_list(insts, insn_list)
+
+        if libopenreil.reil_dfg_optimize(reil_arch, insts, count, 
+                                         addr, inum, options) == -1:
+
+            raise Error('Error while optimizing function %s' % hex(addr))
+
+        # optimized operation, operands and flags of each instruction
+        for i in range(count):
+
+            args = ( process_arg(insts[i].a), process_arg(insts[i].b), process_arg(insts[i].c) )
+            ret.append(( insts[i].op, args, insts[i].flags ))
+
+    finally:
+
+        free(insts)
+
+    return ret
+
+
+cdef class SSA:
+
+    cdef libopenreil.reil_ssa_t ssa
+
+    def __init__(self, arch, insn_list, addr, inum = 0):
+
+        cdef libopenreil.reil_arch_t reil_arch
+
+        try: 
+
+            reil_arch = { ARCH_X86: libopenreil.ARCH_X86, 
+                          ARCH_ARM: libopenreil.ARCH_ARM }[ arch ]
+
+        except KeyError: 
+
+            raise InitError('Unknown architecture')
+
+        cdef int count = len(insn_list)
+        cdef libopenreil.reil_inst_t *insts = \
+            <libopenreil.reil_inst_t *>malloc(sizeof(libopenreil.reil_inst_t) * max(count, 1))
+
+        if insts == NULL:
+
+            raise MemoryError()
+
+        try:
+
+            load_insn_list(insts, insn_list)
+
+            # instructions are copied, so they can be freed right after
+            self.ssa = libopenreil.reil_ssa_init(reil_arch, insts, count, addr, inum)
+
+        finally:
+
+            free(insts)
+
+        if self.ssa == NULL:
+
+            raise InitError('Error while building SSA form of function %s' % hex(addr))
+
+    def __dealloc__(self):
+
+        if self.ssa != NULL: libopenreil.reil_ssa_close(self.ssa)
+
+    def bb_list(self):
+
+        ret = []
+        cdef int count = libopenreil.reil_ssa_bb_list(self.ssa, NULL, 0)
+        if count <= 0: 
+
+            return ret
+
+        cdef libopenreil.reil_ssa_bb_t *bbs = \
+            <libopenreil.reil_ssa_bb_t *>malloc(sizeof(libopenreil.reil_ssa_bb_t) * count)
+
+        if bbs == NULL:
+
+            raise MemoryError()
+
+        try:
+
+            libopenreil.reil_ssa_bb_list(self.ssa, bbs, count)
+
+            # list of ( first, last, idom, phi_first, phi_count, reachable ) tuples
+            for i in range(count):
+
+                ret.append(( bbs[i].first, bbs[i].last, bbs[i].idom, 
+                             bbs[i].phi_first, bbs[i].phi_count, bool(bbs[i].reachable) ))
+
+        finally:
+
+            free(bbs)
+
+        return ret
+
+    def insn_list(self):
+
+        ret = []
+        cdef int count = libopenreil.reil_ssa_insn_list(self.ssa, NULL, 0)
+        if count <= 0: 
+
+            return ret
+
+        cdef libopenreil.reil_ssa_insn_t *insns = \
+            <libopenreil.reil_ssa_insn_t *>malloc(sizeof(libopenreil.reil_ssa_insn_t) * count)
+
+        if insns == NULL:
+
+            raise MemoryError()
+
+        try:
+
+            libopenreil.reil_ssa_insn_list(self.ssa, insns, count)
+
+            # list of ( ir_addr, bb, a, b, c ) tuples
+            for i in range(count):
+
+                ret.append(( ( insns[i].addr, insns[i].inum ), insns[i].bb, 
+                             insns[i].a, insns[i].b, insns[i].c ))
+
+        finally:
+
+            free(insns)
+
+        return ret
+
+    def var_list(self):
+
+        ret = []
+        cdef int count = libopenreil.reil_ssa_var_list(self.ssa, NULL, 0)
+        if count <= 0: 
+
+            return ret
+
+        cdef libopenreil.reil_ssa_var_t *vars = \
+            <libopenreil.reil_ssa_var_t *>malloc(sizeof(libopenreil.reil_ssa_var_t) * count)
+
+        if vars == NULL:
+
+            raise MemoryError()
+
+        try:
+
+            libopenreil.reil_ssa_var_list(self.ssa, vars, count)
+
+            # list of ( type, name, version, insn, phi, use_first, use_count ) tuples
+            for i in range(count):
+
+                ret.append(( vars[i].type, vars[i].name, vars[i].version, vars[i].insn, 
+                             vars[i].phi, vars[i].use_first, vars[i].use_count ))
+
+        finally:
+
+            free(vars)
+
+        return ret
+
+    def use_list(self):
+
+        ret = []
+        cdef int count = libopenreil.reil_ssa_use_list(self.ssa, NULL, 0)
+        if count <= 0: 
+
+            return ret
+
+        cdef libopenreil.reil_ssa_use_t *uses = \
+            <libopenreil.reil_ssa_use_t *>malloc(sizeof(libopenreil.reil_ssa_use_t) * count)
+
+        if uses == NULL:
+
+            raise MemoryError()
+
+        try:
+
+            libopenreil.reil_ssa_use_list(self.ssa, uses, count)
+
+            # list of ( insn, phi ) tuples
+            for i in range(count):
+
+                ret.append(( uses[i].insn, uses[i].phi ))
+
+        finally:
+
+            free(uses)
+
+        return ret
+
+    def phi_list(self):
+
+        ret = []
+        cdef int count = libopenreil.reil_ssa_phi_list(self.ssa, NULL, 0)
+        if count <= 0: 
+
+            return ret
+
+        cdef libopenreil.reil_ssa_phi_t *phis = \
+            <libopenreil.reil_ssa_phi_t *>malloc(sizeof(libopenreil.reil_ssa_phi_t) * count)
+
+        if phis == NULL:
+
+            raise MemoryError()
+
+        try:
+
+            libopenreil.reil_ssa_phi_list(self.ssa, phis, count)
+
+            # list of ( bb, var, arg_first, arg_count ) tuples
+            for i in range(count):
+
+                ret.append(( phis[i].bb, phis[i].var, phis[i].arg_first, phis[i].arg_count ))
+
+        finally:
+
+            free(phis)
+
+        return ret
+
+    def phi_arg_list(self):
+
+        ret = []
+        cdef int count = libopenreil.reil_ssa_phi_arg_list(self.ssa, NULL, 0)
+        if count <= 0: 
+
+            return ret
+
+        cdef libopenreil.reil_ssa_phi_arg_t *args = \
+            <libopenreil.reil_ssa_phi_arg_t *>malloc(sizeof(libopenreil.reil_ssa_phi_arg_t) * count)
+
+        if args == NULL:
+
+            raise MemoryError()
+
+        try:
+
+            libopenreil.reil_ssa_phi_arg_list(self.ssa, args, count)
+
+            # list of ( bb, var ) tuples, bb is -1 for function entry
+            for i in range(count):
+
+                ret.append(( args[i].bb, args[i].var ))
+
+        finally:
+
+            free(args)
+
+        return ret
+
+    def df_list(self, bb):
+
+        ret = []
+        cdef int count = libopenreil.reil_ssa_df_list(self.ssa, bb, NULL, 0)
+        if count == -1:
+
+            raise IndexError('Invalid basic block %d' % bb)
+
+        if count == 0:
+
+            return ret
+
+        cdef int *bbs = <int *>malloc(sizeof(int) * count)
+
+        if bbs == NULL:
+
+            raise MemoryError()
+
+        try:
+
+            libopenreil.reil_ssa_df_list(self.ssa, bb, bbs, count)
+
+            # dominance frontier of the basic block
+            for i in range(count): ret.append(bbs[i])
+
+        finally:
+
+            free(bbs)
+
+        return ret
+
+    def dominates(self, a, b):
+
+        return libopenreil.reil_ssa_dominates(self.ssa, a, b) != 0
+
+    def slice(self, addr, inum, arg, options = 0):
+
+        ret = []
+        cdef int count = libopenreil.reil_ssa_insn_list(self.ssa, NULL, 0)
+        cdef int words = (count + 63) / 64
+
+        cdef unsigned long long *bitmap = \
+            <unsigned long long *>malloc(sizeof(unsigned long long) * max(words, 1))
+
+        if bitmap == NULL:
+
+            raise MemoryError()
+
+        try:
+
+            if libopenreil.reil_ssa_slice(self.ssa, addr, inum, arg, options, 
+                                          bitmap, words) == -1:
+
+                raise IndexError('Invalid instruction or operand')
+
+            # indexes of insn_list() items that are in the slice
+            for i in range(count): 
+
+                if (bitmap[i / 64] >> (i % 64)) & 1: ret.append(i)
+
+        finally:
+
+            free(bitmap)
+
+        return ret
+
+
+cdef class Sym:
+
+    cdef libopenreil.reil_sym_t sym
+
+    def __init__(self):
+
+        self.sym = libopenreil.reil_sym_init()
+
+    def __dealloc__(self):
+
+        if self.sym != NULL: libopenreil.reil_sym_close(self.sym)
+
+    def check(self, n):
+
+        if n == -1:
+
+            raise Error('Invalid expression')
+
+        return n
+
+    def constant(self, val, size):
+
+        return self.check(libopenreil.reil_sym_const(self.sym, val & 0xffffffffffffffff, 
+                                                     <libopenreil._reil_size_t>size))
+
+    def val(self, name, arg_type, size, addr = 0):
+
+        return self.check(libopenreil.reil_sym_val(self.sym, name, <libopenreil._reil_type_t>arg_type, 
+                                                   <libopenreil._reil_size_t>size, addr))
+
+    def ptr(self, addr, size):
+
+        return self.check(libopenreil.reil_sym_ptr(self.sym, addr, <libopenreil._reil_size_t>size))
+
+    def exp(self, op, a, b, size):
+
+        return self.check(libopenreil.reil_sym_exp(self.sym, <libopenreil._reil_op_t>op, a, 
+                                                   -1 if b is None else b, 
+                                                   <libopenreil._reil_size_t>size))
+
+    def cond(self, cond, a, b):
+
+        return self.check(libopenreil.reil_sym_cond(self.sym, cond, a, b))
+
+    def loc(self, addr, inum = 0):
+
+        return self.check(libopenreil.reil_sym_loc(self.sym, addr, inum))
+
+    def ip(self):
+
+        return self.check(libopenreil.reil_sym_ip(self.sym))
+
+    def node(self, n):
+
+        cdef libopenreil.reil_sym_node_t info
+
+        if libopenreil.reil_sym_node(self.sym, n, &info) == -1:
+
+            raise IndexError(n)
+
+        return ( info.kind, info.op, info.size, info.a, info.b, info.c, 
+                 info.val, info.inum, info.type, info.name )
+
+    def count(self):
+
+        return libopenreil.reil_sym_count(self.sym)
+
+    def execute(self, insn_list, state = None):
+
+        state = [] if state is None else state
+
+        ret = []
+        cdef int count = len(insn_list), state_count = len(state)
+        cdef int out_count = state_count + count
+
+        cdef libopenreil.reil_inst_t *insts = \
+            <libopenreil.reil_inst_t *>malloc(sizeof(libopenreil.reil_inst_t) * max(count, 1))
+
+        cdef libopenreil.reil_sym_item_t *items = \
+            <libopenreil.reil_sym_item_t *>malloc(sizeof(libopenreil.reil_sym_item_t) * max(out_count, 1))
+
+        if insts == NULL or items == NULL:
+
+            free(insts)
+            free(items)
+            raise MemoryError()
+
+        try:
+
+            load_insn_list(insts, insn_list)
+
+            for i in range(state_count):
+
+                items[i].val, items[i].exp = state[i]
+
+            # input and output state can share the same array
+            out_count = libopenreil.reil_sym_exec(self.sym, insts, count, 
+                                                  items, state_count, items, out_count)
+            if out_count == -1:
+
+                raise Error('Error while executing instructions')
+
+            for i in range(out_count):
+
+                ret.append(( items[i].val, items[i].exp ))
+
+        finally:
+
+            free(insts)
+            free(items)
+
+        return ret
+
+    def apply(self, summary, state = None):
+
+        state = [] if state is None else state
+
+        ret = []
+        cdef int summary_count = len(summary), state_count = len(state)
+        cdef int out_count = state_count + summary_count
+
+        cdef libopenreil.reil_sym_item_t *updates = \
+            <libopenreil.reil_sym_item_t *>malloc(sizeof(libopenreil.reil_sym_item_t) * max(summary_count, 1))
+
+        cdef libopenreil.reil_sym_item_t *items = \
+            <libopenreil.reil_sym_item_t *>malloc(sizeof(libopenreil.reil_sym_item_t) * max(out_count, 1))
+
+        if updates == NULL or items == NULL:
+
+            free(updates)
+            free(items)
+            raise MemoryError()
+
+        try:
+
+            for i in range(summary_count):
+
+                updates[i].val, updates[i].exp = summary[i]
+
+            for i in range(state_count):
+
+                items[i].val, items[i].exp = state[i]
+
+            out_count = libopenreil.reil_sym_apply(self.sym, updates, summary_count, 
+                                                   items, state_count, items, out_count)
+            if out_count == -1:
+
+                # summary can't be applied to this state
+                return None
+
+            for i in range(out_count):
+
+                ret.append(( items[i].val, items[i].exp ))
+
+        finally:
+
+            free(updates)
+            free(items)
+
+        return ret
+
+    def smt2(self, nodes, options = 0):
+
+        cdef int count = len(nodes), size = 0
+        cdef int *items = <int *>malloc(sizeof(int) * max(count, 1))
+        cdef char *buff = NULL
+
+        if items == NULL:
+
+            raise MemoryError()
+
+        try:
+
+            for i in range(count):
+
+                items[i] = nodes[i]
+
+            size = libopenreil.reil_sym_smt2(self.sym, items, count, options, NULL, 0)
+            if size == -1:
+
+                raise Error('Unable to export expression')
+
+            buff = <char *>malloc(size + 1)
+            if buff == NULL:
+
+                raise MemoryError()
+
+            libopenreil.reil_sym_smt2(self.sym, items, count, options, buff, size + 1)
+
+            return buff[: size]
+
+        finally:
+
+            free(items)
+            free(buff)
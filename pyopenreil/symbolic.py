@@ -1,7 +1,23 @@
+import copy
+
 from REIL import *
 
 class Sym(object):
 
+    # node of native expression engine and the engine itself, see SymNative
+    node, engine = None, None
+
+    # identifier of expression structure that is used for comparison, see SymNative.key()
+    node_key = None
+
+    # cached hash of expression with native node
+    node_hash = None
+
+    def same_engine(self, other):
+
+        return self.node_key is not None and other.node_key is not None and \
+               self.engine is other.engine
+
     def __init__(self):
 
         pass    
@@ -142,6 +158,9 @@ class SymVal(Sym):
         if type(other) == SymAny: return True
         if type(other) != SymVal: return False
 
+        # expressions with native nodes are hash-consed
+        if self.same_engine(other): return self.node_key == other.node_key
+
         return self.name == other.name
 
     def __hash__(self):
@@ -164,15 +183,26 @@ class SymPtr(Sym):
         if type(other) == SymAny: return True
         if type(other) != SymPtr: return False
 
+        if self.same_engine(other): return self.node_key == other.node_key
+
         return self.val == other.val
 
     def __hash__(self):
 
-        return ~hash(self.val)
+        if self.node is None: return ~hash(self.val)
+
+        if self.node_hash is None: self.node_hash = ~hash(self.val)
+
+        return self.node_hash
 
     def parse(self, visitor):
 
-        self.val = self.val.parse(visitor)
+        val = self.val.parse(visitor)
+
+        # expression was changed by visitor, it's not a native node anymore
+        if val is not self.val: 
+
+            self.val, self.node, self.node_key, self.node_hash = val, None, None, None
 
         return visitor(self)
 
@@ -192,6 +222,8 @@ class SymConst(Sym):
         if type(other) == SymAny: return True
         if type(other) != SymConst: return False
 
+        if self.same_engine(other): return self.node_key == other.node_key
+
         return self.val == other.val
 
     def __hash__(self):
@@ -252,19 +284,32 @@ class SymCond(Sym):
         if type(other) == SymAny: return True
         if type(other) != SymCond: return False
 
+        if self.same_engine(other): return self.node_key == other.node_key
+
         return self.cond == other.cond and \
                self.true == other.true and \
                self.false == other.false
 
     def __hash__(self):
 
-        return hash(self.cond) ^ hash(self.true) ^ hash(self.false)
+        if self.node is None: return hash(self.cond) ^ hash(self.true) ^ hash(self.false)
+
+        if self.node_hash is None: 
+
+            self.node_hash = hash(self.cond) ^ hash(self.true) ^ hash(self.false)
+
+        return self.node_hash
 
     def parse(self, visitor):        
         
-        self.cond = self.cond.parse(visitor)
-        self.true = self.true.parse(visitor)
-        self.false = self.false.parse(visitor)
+        cond = self.cond.parse(visitor)
+        true = self.true.parse(visitor)
+        false = self.false.parse(visitor)
+
+        if cond is not self.cond or true is not self.true or false is not self.false:
+
+            self.cond, self.true, self.false = cond, true, false
+            self.node, self.node_key, self.node_hash = None, None, None
 
         return visitor(self)
 
@@ -273,9 +318,10 @@ class SymExp(Sym):
 
     commutative = ( I_ADD, I_SUB, I_AND, I_XOR, I_OR )
 
-    def __init__(self, op, a, b = None):
+    def __init__(self, op, a, b = None, size = None):
         
         self.op, self.a, self.b = op, a, b
+        self.size = size
 
     def __str__(self):
 
@@ -299,6 +345,8 @@ class SymExp(Sym):
         if type(other) == SymAny: return True
         if type(other) != SymExp: return False
 
+        if self.same_engine(other): return self.node_key == other.node_key
+
         if self.op == other.op and self.op in self.commutative:
 
             # equation for commutative operations
@@ -310,12 +358,21 @@ class SymExp(Sym):
 
     def __hash__(self):
 
-        return hash(self.op) ^ hash(self.a) ^ hash(self.b)
+        if self.node is None: return hash(self.op) ^ hash(self.a) ^ hash(self.b)
+
+        if self.node_hash is None: self.node_hash = hash(self.op) ^ hash(self.a) ^ hash(self.b)
+
+        return self.node_hash
 
     def parse(self, visitor):        
         
-        if self.a is not None: self.a = self.a.parse(visitor)
-        if self.b is not None: self.b = self.b.parse(visitor)
+        a = None if self.a is None else self.a.parse(visitor)
+        b = None if self.b is None else self.b.parse(visitor)
+
+        if a is not self.a or b is not self.b:
+
+            self.a, self.b = a, b
+            self.node, self.node_key, self.node_hash = None, None, None
 
         return visitor(self)
 
@@ -501,6 +558,281 @@ class SymState(object):
 
                 except ValueFound: pass                
 
+
+class SymNative(object):
+    ''' Symbolic execution with native expression engine of libopenreil: expressions 
+        are hash-consed and simplified DAG nodes, so executing large code takes much 
+        less time and memory. Expressions are converted into Sym objects that are 
+        sharing common subexpressions and comparing native nodes is O(1). '''
+
+    # engine is shared, so nodes of different states can be compared
+    engine = None
+
+    def __init__(self):
+
+        import translator
+
+        # native engine and identifiers of expressions structure, see key()
+        if SymNative.engine is None: SymNative.engine = ( translator.Sym(), {} )
+
+        self.tr, self.engine = translator, SymNative.engine
+        self.sym, self.keys = self.engine
+
+        # Sym objects of converted nodes
+        self.nodes = {}
+
+    @classmethod
+    def reset(cls):
+        ''' Release shared engine with all of it's nodes, new instances are using new one. 
+            Sym objects that were converted before are keeping old engine until they're 
+            deleted, they are converted into new nodes just like other expressions. '''
+
+        cls.engine = None
+
+    def get(self, n):
+        ''' Convert native node into Sym object. '''
+
+        stack, info = [ n ], {}
+
+        # nodes might be very deep, so conversion is not recursive
+        while len(stack) > 0:
+
+            node = stack[-1]
+
+            if self.nodes.has_key(node): 
+
+                stack.pop()
+                continue
+
+            if not info.has_key(node): info[node] = self.sym.node(node)
+
+            args = filter(lambda arg: arg != -1 and not self.nodes.has_key(arg), info[node][3 : 6])
+
+            if len(args) > 0: 
+
+                stack.extend(args)
+                continue
+
+            self.nodes[node] = self.make(node, info[node])
+            stack.pop()
+
+        return self.nodes[n]
+
+    def make(self, node, info):
+
+        kind, op, size, a, b, c, val, inum, arg_type, name = info
+        arg = lambda n: None if n == -1 else self.nodes[n]
+
+        if kind == self.tr.SYM_CONST: ret = SymConst(val, size)
+        elif kind == self.tr.SYM_PTR: ret = SymPtr(arg(a), size)
+
+        elif kind == self.tr.SYM_EXP and op == I_STR:
+
+            bits, bits_a = int(REIL_NAMES_SIZE[size]), int(REIL_NAMES_SIZE[arg(a).size])
+
+            # Insn.to_symbolic() copies value of I_STR and truncates it with I_AND
+            if bits < bits_a: ret = SymExp(I_AND, arg(a), SymConst((1 << bits) - 1, size), size)
+            else: ret = copy.copy(arg(a))
+
+        elif kind == self.tr.SYM_EXP: ret = SymExp(op, arg(a), arg(b), size)
+        elif kind == self.tr.SYM_COND: ret = SymCond(arg(a), arg(b), arg(c))
+        elif kind == self.tr.SYM_LOC: ret = SymIRAddr(val, inum)
+        elif kind == self.tr.SYM_IP: ret = SymIP()
+
+        elif kind == self.tr.SYM_VAL:
+
+            # the same names of temp registers as Arg.to_symbolic() uses
+            if arg_type == A_TEMP: name += '_%x' % val
+
+            ret = SymVal(name, size, is_temp = arg_type == A_TEMP)
+
+        ret.node, ret.engine, ret.node_hash = node, self.engine, None
+        ret.node_key = self.key(ret)
+
+        return ret
+
+    def key(self, exp):
+        ''' Identifier of expression that is equal for expressions which are equal
+            by __eq__() of Sym classes, so comparing converted nodes is O(1). '''
+
+        if exp.node_key is not None and exp.engine is self.engine: return exp.node_key
+
+        args = lambda *items: tuple(map(lambda arg: None if arg is None else self.key(arg), items))
+
+        if isinstance(exp, SymConst): key = ( SymConst, exp.val )
+        elif isinstance(exp, SymVal): key = ( SymVal, exp.name )
+        elif isinstance(exp, SymPtr): key = ( SymPtr, ) + args(exp.val)
+        elif isinstance(exp, SymCond): key = ( SymCond, ) + args(exp.cond, exp.true, exp.false)
+        elif isinstance(exp, SymIRAddr): key = ( SymIRAddr, exp.addr, exp.inum )
+        elif isinstance(exp, SymIP): key = ( SymIP, )
+
+        elif isinstance(exp, SymExp):
+
+            a, b = args(exp.a, exp.b)
+
+            # the same order of operands for commutative operations
+            if exp.op in SymExp.commutative and a > b: a, b = b, a
+
+            key = ( SymExp, exp.op, a, b )
+
+        else: self.error(exp)
+
+        return self.keys.setdefault(key, len(self.keys))
+
+    def put(self, exp):
+        ''' Convert Sym object into native node, raises ValueError when expression 
+            has no size information or it's SymAny. '''
+
+        if exp.node is not None and exp.engine is self.engine: return exp.node
+
+        check = lambda val: val if val is not None else self.error(exp)
+
+        if isinstance(exp, SymConst): return self.sym.constant(exp.val, check(exp.size))
+        elif isinstance(exp, SymPtr): return self.sym.ptr(self.put(exp.val), check(exp.size))
+        elif isinstance(exp, SymIRAddr): return self.sym.loc(exp.addr, exp.inum)
+        elif isinstance(exp, SymIP): return self.sym.ip()
+
+        elif isinstance(exp, SymVal):
+
+            if exp.is_temp:
+
+                name, addr = exp.name.rsplit('_', 1)
+                return self.sym.val(name, A_TEMP, check(exp.size), int(addr, 16))
+
+            return self.sym.val(exp.name, A_REG, check(exp.size))
+
+        elif isinstance(exp, SymCond):
+
+            return self.sym.cond(self.put(exp.cond), self.put(exp.true), self.put(exp.false))
+
+        elif isinstance(exp, SymExp):
+
+            a = self.put(exp.a)
+            b = None if exp.b is None else self.put(exp.b)
+
+            size = exp.size
+            if size is None: size = U1 if exp.op in [ I_EQ, I_LT ] else self.sym.node(a)[2]
+
+            return self.sym.exp(exp.op, a, b, size)
+
+        self.error(exp)
+
+    def error(self, exp):
+
+        raise ValueError('Unable to convert %s into native expression' % str(exp))
+
+    def put_state(self, state):
+        ''' Convert SymState into list of native ( val, exp ) nodes. '''
+
+        return [] if state is None else [ ( self.put(val), self.put(exp) ) for val, exp in state ]
+
+    def get_state(self, items):
+        ''' Convert list of native ( val, exp ) nodes into SymState. '''
+
+        state = SymState()
+
+        for val, exp in items: state.state.append(( self.get(val), self.get(exp) ))
+
+        return state
+
+    def execute(self, insn_list, in_state = None):
+        ''' Symbolic execution of instructions just like InsnList.to_symbolic() does. '''
+
+        return self.get_state(self.sym.execute(map(lambda insn: insn.serialize(), insn_list), 
+                                               self.put_state(in_state)))
+
+    def summary(self, insn_list):
+        ''' Native state of instructions executed from the empty state: expressions are 
+            using values that registers had before the first instruction. '''
+
+        return self.sym.execute(map(lambda insn: insn.serialize(), insn_list))
+
+    def apply(self, summary, items):
+        ''' Update native state with summary(), returns None when instructions must be 
+            executed instead because their memory writes are aliased in this state. '''
+
+        return self.sym.apply(summary, items)
+
+    def to_smt2(self, exps, options = 0):
+        ''' SMT-LIB2 script with declarations of registers and memory and (define-fun E_n ...)
+            for n-th expression, common subexpressions are shared with let. '''
+
+        return self.sym.smt2(map(self.put, exps), options)
+
+    def to_z3(self, exps, ctx = None):
+        ''' Z3 expressions that are parsed from to_smt2() script, so expression
+            trees are never walked in Python. '''
+
+        import z3
+
+        nodes = map(self.put, exps)
+        text = self.sym.smt2(nodes)
+
+        for i in range(len(nodes)):
+
+            node = self.sym.node(nodes[i])
+
+            # condition might select instruction address
+            while node[0] == self.tr.SYM_COND: node = self.sym.node(node[4])
+
+            bits = 64 if node[0] == self.tr.SYM_LOC else int(REIL_NAMES_SIZE[node[2]])
+
+            # get expression from the assertion, define-fun is expanded by parser
+            text += '(declare-fun |E_%d.val| () (_ BitVec %d))\n' % (i, bits)
+            text += '(assert (= |E_%d.val| E_%d))\n' % (i, i)
+
+        ret = z3.parse_smt2_string(text, ctx = ctx)
+
+        # older versions of Z3 are returning conjunction of assertions
+        if not isinstance(ret, z3.AstVector): ret = ret.children() if len(nodes) > 1 else [ ret ]
+
+        return [ ret[i].arg(1) for i in range(len(nodes)) ]
+
+
+class TestSymNative(unittest.TestCase):
+
+    def test(self):
+
+        native = SymNative()
+        a, b = SymVal('R_EAX', U32), SymVal('R_ECX', U32)
+
+        # equal expressions are the same node
+        assert native.put(a + b) == native.put(b + a)
+        assert native.get(native.put(a + b)) == native.get(native.put(b + a))
+
+        # simplified expressions
+        assert native.put((a ^ b) ^ b) == native.put(a)
+        assert native.put(a & SymConst(0xffffffff, U32)) == native.put(a)
+        assert native.put((a + SymConst(1, U32)) + SymConst(2, U32)) == \
+               native.put(a + SymConst(3, U32))
+
+        # expressions with SymAny are not supported
+        self.assertRaises(ValueError, native.put, a + SymAny())
+
+        # shared subexpression is bound once
+        text = native.to_smt2([ (a + b) * (a + b) ])
+
+        assert '(declare-fun R_EAX () (_ BitVec 32))' in text
+        assert text.count('bvadd') == 1 and '(let ((?x' in text
+
+        # size conversions are printed and compared like Insn.to_symbolic() results
+        exp = SymExp(I_AND, a, SymConst(0xff, U32), U8)
+        val = native.get(native.put(exp))
+
+        assert str(val) == '(R_EAX & 0xff)' and val == exp
+
+        exp = SymExp(I_OR, SymVal('R_AL', U8), SymConst(0, U8), U32)
+        val = native.get(native.put(exp))
+
+        assert str(val) == 'R_AL' and val == SymVal('R_AL', U8)
+
+        # nodes of the old engine are converted into the new one
+        SymNative.reset()
+        other = SymNative()
+
+        assert other.engine is not native.engine
+        assert other.get(other.put(val)) == val
+
 #
 # EoF
 #
@@ -0,0 +1,262 @@
+import sys, os, struct, unittest
+
+file_dir = os.path.abspath(os.path.dirname(__file__))
+test_dir = os.path.abspath(os.path.join(file_dir, '..', '..', 'tests'))
+
+from pyopenreil import REIL
+
+# ELF machine types
+EM_386 = 3
+EM_ARM = 40
+
+# program header types
+PT_LOAD = 1
+PT_DYNAMIC = 2
+PT_INTERP = 3
+PT_PHDR = 6
+
+# program header flags
+PF_X = 1
+PF_W = 2
+PF_R = 4
+
+# dynamic section tags
+DT_NULL = 0
+DT_PLTRELSZ = 2
+DT_STRTAB = 5
+DT_SYMTAB = 6
+DT_REL = 17
+DT_RELSZ = 18
+DT_JMPREL = 23
+
+# section header types
+SHT_SYMTAB = 2
+SHT_DYNSYM = 11
+
+# symbol types
+STT_FUNC = 2
+
+# relocation types
+R_386_GLOB_DAT = 6
+R_386_JMP_SLOT = 7
+R_ARM_GLOB_DAT = 21
+R_ARM_JUMP_SLOT = 22
+
+EHDR_LEN = 0x34
+SHDR_LEN = 0x28
+SYM_LEN = 0x10
+REL_LEN = 0x08
+
+class Segment(object):
+
+    def __init__(self, addr, size, data, flags):
+
+        # file data is shorter than memory size for segments with BSS
+        self.addr, self.size, self.data, self.flags = addr, size, data, flags
+
+    def __str__(self):
+
+        return '0x%.8x - 0x%.8x %s%s%s' % (self.addr, self.addr + self.size,
+                                           'R' if self.flags & PF_R else '-',
+                                           'W' if self.flags & PF_W else '-',
+                                           'X' if self.flags & PF_X else '-')
+
+
+class Reader(REIL.Reader):
+
+    def __init__(self, path):
+
+        with open(path, 'rb') as fd: data = fd.read()
+
+        if data[: 4] != '\x7fELF': raise Exception('Invalid ELF file')
+
+        # only 32-bit little endian images are supported
+        if len(data) < EHDR_LEN or data[4] != '\x01' or data[5] != '\x01':
+
+            raise Exception('Unsupported ELF class or byte order')
+
+        machine, self.entry, phoff, shoff, phentsize, phnum, shentsize, shnum = \
+            [ struct.unpack('<' + f, data[offs : offs + struct.calcsize(f)])[0] \
+              for f, offs in ( ( 'H', 0x12 ), ( 'I', 0x18 ), ( 'I', 0x1c ), ( 'I', 0x20 ), 
+                               ( 'H', 0x2a ), ( 'H', 0x2c ), ( 'H', 0x2e ), ( 'H', 0x30 ) ) ]
+
+        try:
+
+            # get REIL arch by file arch
+            self.arch = { EM_386: REIL.ARCH_X86, EM_ARM: REIL.ARCH_ARM }[ machine ]
+
+        except KeyError:
+
+            raise Exception('Unsupported architecture')
+
+        self.segments, self.dynamic, self.interp = [], {}, None
+        self.phdr, self.phent, self.phnum = None, phentsize, phnum
+
+        dynamic = None
+
+        for i in range(phnum):
+
+            offs = phoff + i * phentsize
+            p_type, p_offset, p_vaddr, _, p_filesz, p_memsz, p_flags, _ = \
+                struct.unpack('<IIIIIIII', data[offs : offs + 0x20])
+
+            if p_type == PT_LOAD:
+
+                if p_offset == 0 and self.phdr is None:
+
+                    # program headers are mapped with the first segment
+                    self.phdr = p_vaddr + phoff
+
+                self.segments.append(Segment(p_vaddr, p_memsz,
+                                             data[p_offset : p_offset + p_filesz], p_flags))
+
+            elif p_type == PT_PHDR: self.phdr = p_vaddr
+            elif p_type == PT_DYNAMIC: dynamic = ( p_offset, p_filesz )
+            elif p_type == PT_INTERP: self.interp = data[p_offset : p_offset + p_filesz].rstrip('\0')
+
+        if dynamic is not None:
+
+            offs, size = dynamic
+
+            for offs in range(offs, offs + size, 8):
+
+                tag, val = struct.unpack('<II', data[offs : offs + 8])
+                if tag == DT_NULL: break
+
+                # keep the first value of each tag
+                if not self.dynamic.has_key(tag): self.dynamic[tag] = val
+
+        # addresses of defined functions from static and dynamic symbol tables
+        self.func_syms = set()
+
+        for i in range(shnum if shentsize == SHDR_LEN else 0):
+
+            offs = shoff + i * shentsize
+            _, sh_type, _, _, sh_offset, sh_size, _, _, _, sh_entsize = \
+                struct.unpack('<IIIIIIIIII', data[offs : offs + SHDR_LEN])
+
+            if sh_type not in ( SHT_SYMTAB, SHT_DYNSYM ) or sh_entsize != SYM_LEN: continue
+
+            for offs in range(sh_offset, sh_offset + sh_size - SYM_LEN + 1, SYM_LEN):
+
+                _, st_value, _, st_info, _, _ = struct.unpack('<IIIBBH', data[offs : offs + SYM_LEN])
+
+                if st_info & 0xf == STT_FUNC and st_value != 0: self.func_syms.add(st_value)
+
+        super(REIL.Reader, self).__init__()
+
+    def read(self, addr, size):
+
+        for seg in self.segments:
+
+            if addr >= seg.addr and addr < seg.addr + seg.size:
+
+                offs = addr - seg.addr
+                size = min(size, seg.size - offs)
+                data = seg.data[offs : offs + size]
+
+                # the rest of the segment after file data is filled with zeros
+                return data + '\0' * (size - len(data))
+
+        raise REIL.ReadError(addr)
+
+    def read_rodata(self, addr, size):
+
+        for seg in self.segments:
+
+            # jump tables are never stored in writable segments
+            if addr >= seg.addr and addr < seg.addr + seg.size and not seg.flags & PF_W:
+
+                return self.read(addr, size)
+
+        raise REIL.ReadError(addr)
+
+    def read_insn(self, addr):
+
+        return self.read(addr, REIL.MAX_INST_LEN)
+
+    def read_str(self, addr):
+
+        data = ''
+
+        while True:
+
+            byte = self.read(addr + len(data), 1)
+            if byte == '\0': return data
+
+            data += byte
+
+    def symbol(self, num):
+
+        # get name and value of the dynamic symbol
+        st_name, st_value = struct.unpack('<II', self.read(self.dynamic[DT_SYMTAB] + num * SYM_LEN, 8))
+
+        return self.read_str(self.dynamic[DT_STRTAB] + st_name), st_value
+
+    def funcs(self):
+        ''' Returns sorted list of the entry point and function symbol addresses, 
+            it can be passed to CodeStorageTranslator.get_funcs(). '''
+
+        return sorted(self.func_syms.union([ self.entry ]))
+
+    def relocs(self):
+        ''' Returns list of ( addr, type, symbol name ) tuples of dynamic relocations. '''
+
+        ret = []
+
+        for addr_tag, size_tag in ( ( DT_REL, DT_RELSZ ), ( DT_JMPREL, DT_PLTRELSZ ) ):
+
+            if not self.dynamic.has_key(addr_tag): continue
+
+            addr = self.dynamic[addr_tag]
+
+            for offs in range(0, self.dynamic[size_tag], REL_LEN):
+
+                r_offset, r_info = struct.unpack('<II', self.read(addr + offs, REL_LEN))
+                name = self.symbol(r_info >> 8)[0] if r_info >> 8 != 0 else None
+
+                ret.append(( r_offset, r_info & 0xff, name ))
+
+        return ret
+
+
+class TestELF(unittest.TestCase):
+
+    BIN_PATH = os.path.join(test_dir, 'fib_x86.elf')
+    PROC_ADDR = 0x08048414
+
+    def test_reader(self):
+
+        if os.path.isfile(self.BIN_PATH):
+
+            reader = Reader(self.BIN_PATH)
+
+            assert reader.arch == REIL.ARCH_X86
+            assert 'printf' in [ name for addr, type, name in reader.relocs() ]
+
+            # BSS must be readable as well
+            seg = reader.segments[-1]
+            assert reader.read(seg.addr + seg.size - 1, 0x10) == '\0'
+
+            tr = REIL.CodeStorageTranslator(reader)
+
+            print tr.get_func(self.PROC_ADDR)
+
+    def test_funcs(self):
+
+        if os.path.isfile(self.BIN_PATH):
+
+            reader = Reader(self.BIN_PATH)
+
+            assert reader.entry in reader.funcs()
+
+            tr = REIL.CodeStorageTranslator(reader)
+
+            # functions called by the entry point code must be discovered as well
+            func_list = tr.get_funcs([ reader.entry ])
+
+            assert reader.entry in [ func.addr for func in func_list ]
+
+#
+# EoF
+#
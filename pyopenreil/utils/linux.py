@@ -0,0 +1,535 @@
+import sys, os, re, unittest
+
+file_dir = os.path.abspath(os.path.dirname(__file__))
+test_dir = os.path.abspath(os.path.join(file_dir, '..', '..', 'tests'))
+
+from pyopenreil.REIL import *
+from pyopenreil.VM import *
+from pyopenreil.utils import bin_ELF
+
+PAGE_SIZE = 0x1000
+
+page_align = lambda addr: (addr + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1)
+
+# auxiliary vector types
+AT_NULL = 0
+AT_PHDR = 3
+AT_PHENT = 4
+AT_PHNUM = 5
+AT_PAGESZ = 6
+AT_BASE = 7
+AT_FLAGS = 8
+AT_ENTRY = 9
+AT_UID = 11
+AT_EUID = 12
+AT_GID = 13
+AT_EGID = 14
+AT_HWCAP = 16
+AT_CLKTCK = 17
+AT_SECURE = 23
+AT_RANDOM = 25
+
+# errno values
+EBADF = 9
+ENOMEM = 12
+EFAULT = 14
+EINVAL = 22
+ENOSYS = 38
+
+# mmap() flags
+MAP_FIXED = 0x10
+MAP_ANONYMOUS = 0x20
+
+# system call numbers
+SYS_EXIT = 'exit'
+SYS_READ = 'read'
+SYS_WRITE = 'write'
+SYS_BRK = 'brk'
+SYS_MMAP = 'mmap'
+SYS_MMAP2 = 'mmap2'
+SYS_MUNMAP = 'munmap'
+SYS_EXIT_GROUP = 'exit_group'
+
+syscalls = { 'x86': { 1: SYS_EXIT, 3: SYS_READ, 4: SYS_WRITE, 45: SYS_BRK, 90: SYS_MMAP,
+                      91: SYS_MUNMAP, 192: SYS_MMAP2, 252: SYS_EXIT_GROUP },
+
+             'arm': { 1: SYS_EXIT, 3: SYS_READ, 4: SYS_WRITE, 45: SYS_BRK,
+                      91: SYS_MUNMAP, 192: SYS_MMAP2, 248: SYS_EXIT_GROUP } }
+
+# registers of system call number, arguments and return value
+syscall_regs = { 'x86': ( 'R_EAX', ( 'R_EBX', 'R_ECX', 'R_EDX', 'R_ESI', 'R_EDI', 'R_EBP' ), 'R_EAX' ),
+                 'arm': ( 'R_R7',  ( 'R_R0', 'R_R1', 'R_R2', 'R_R3', 'R_R4', 'R_R5' ), 'R_R0' ) }
+
+
+class ProcessError(Error):
+
+    pass
+
+
+#
+# Runs statically or dynamically linked i386/ARM Linux executable in user mode.
+# PT_LOAD segments are mapped into the guest memory, system calls instructions
+# are marked by translator with IATTR_SYSCALL and handled here. Imports of dynamically
+# linked executables are resolved to the stubs addresses that are handled by Python
+# code, it supports only a few libc functions that test programs are using.
+#
+class Process(object):
+
+    # initial stack location
+    STACK_TOP = 0xbf000000
+    STACK_SIZE = 0x20000
+
+    # start address of anonymous mmap() allocations
+    MMAP_BASE = 0x40000000
+
+    # address of imported functions stubs
+    STUBS_BASE = 0xfffe0000
+
+    def __init__(self, path, argv = None, envp = None, stdin = '', cpu_type = Cpu):
+
+        self.reader = bin_ELF.Reader(path)
+        self.storage = CodeStorageTranslator(self.reader)
+
+        self.cpu = cpu_type(self.reader.arch)
+        self.mem, self.arch = self.cpu.mem, self.cpu.arch
+
+        self.argv = [ path ] if argv is None else argv
+        self.envp = [] if envp is None else envp
+
+        self.stdin, self.stdout, self.stderr = stdin, '', ''
+        self.exit_code = None
+
+        self.stubs, self.stubs_names = {}, {}
+
+        self.sys_handlers = { SYS_EXIT: self.sys_exit, SYS_EXIT_GROUP: self.sys_exit,
+                              SYS_READ: self.sys_read, SYS_WRITE: self.sys_write,
+                              SYS_BRK: self.sys_brk, SYS_MMAP: self.sys_mmap,
+                              SYS_MMAP2: self.sys_mmap2, SYS_MUNMAP: self.sys_munmap }
+
+        self.cpu.reset(dict(map(lambda name: ( name, 0L ), self.arch.Registers.general + \
+                                                           self.arch.Registers.flags)))
+        self.load()
+
+    def reg(self, name, val = None):
+
+        # get/set register value
+        if val is None: return self.cpu.reg(name).val
+        else: self.cpu.reg(name).val = val
+
+    def load_ptr(self, addr):
+
+        return self.mem.load(addr, Mem.map_size[self.arch.ptr_len])
+
+    def store_ptr(self, addr, val):
+
+        self.mem.store(addr, Mem.map_size[self.arch.ptr_len], val)
+
+    def read_str(self, addr):
+
+        data = ''
+
+        while True:
+
+            byte = self.mem.read(addr + len(data), 1)
+            if byte == '\0': return data
+
+            data += byte
+
+    def load(self):
+
+        end = 0
+
+        for seg in self.reader.segments:
+
+            # copy whole segment into the memory, the rest after file data is zeros
+            self.mem.alloc(addr = seg.addr, size = seg.size, data = seg.data)
+            end = max(end, seg.addr + seg.size)
+
+        # program break starts after the last segment
+        self.brk = page_align(end)
+        self.mmap_next = self.MMAP_BASE
+
+        self.load_imports()
+        self.load_stack()
+
+        self.reg(self.arch.Registers.ip, self.reader.entry)
+
+    def load_imports(self):
+
+        for addr, type, name in self.reader.relocs():
+
+            if type in [ bin_ELF.R_386_JMP_SLOT, bin_ELF.R_ARM_JUMP_SLOT ] or \
+               (type in [ bin_ELF.R_386_GLOB_DAT, bin_ELF.R_ARM_GLOB_DAT ] and \
+                self.stub_handler(name) is not None):
+
+                if not self.stubs_names.has_key(name):
+
+                    # allocate new stub address for imported function
+                    stub = self.STUBS_BASE + len(self.stubs) * self.arch.ptr_len
+
+                    self.stubs[stub], self.stubs_names[name] = name, stub
+
+                self.store_ptr(addr, self.stubs_names[name])
+
+            elif type in [ bin_ELF.R_386_GLOB_DAT, bin_ELF.R_ARM_GLOB_DAT ]:
+
+                # unknown data import, like __gmon_start__
+                self.store_ptr(addr, 0)
+
+    def load_stack(self):
+
+        ptr_len = self.arch.ptr_len
+        random = os.urandom(16)
+
+        self.mem.alloc(addr = self.STACK_TOP - self.STACK_SIZE, size = self.STACK_SIZE)
+
+        # arguments and environment strings with AT_RANDOM bytes are at the top of the stack
+        strings = ''.join(map(lambda s: s + '\0', self.argv + self.envp)) + random
+        addr = (self.STACK_TOP - len(strings)) & ~0xf
+
+        self.mem.write(addr, len(strings), strings)
+
+        ptrs, offs = [], 0
+
+        for s in self.argv + self.envp:
+
+            ptrs.append(addr + offs)
+            offs += len(s) + 1
+
+        auxv = ( ( AT_PHDR, self.reader.phdr ), ( AT_PHENT, self.reader.phent ),
+                 ( AT_PHNUM, self.reader.phnum ), ( AT_PAGESZ, PAGE_SIZE ),
+                 ( AT_BASE, 0 ), ( AT_FLAGS, 0 ), ( AT_ENTRY, self.reader.entry ),
+                 ( AT_UID, 0 ), ( AT_EUID, 0 ), ( AT_GID, 0 ), ( AT_EGID, 0 ),
+                 ( AT_HWCAP, 0 ), ( AT_CLKTCK, 100 ), ( AT_SECURE, 0 ),
+                 ( AT_RANDOM, addr + offs ), ( AT_NULL, 0 ) )
+
+        # argc, argv pointers, envp pointers and auxiliary vector
+        items = [ len(self.argv) ] + ptrs[: len(self.argv)] + [ 0 ] + \
+                                     ptrs[len(self.argv) :] + [ 0 ]
+
+        for item in auxv: items += list(item)
+
+        sp = (addr - len(items) * ptr_len) & ~0xf
+
+        for i in range(len(items)): self.store_ptr(sp + i * ptr_len, items[i])
+
+        self.argv_addr = sp + ptr_len
+        self.envp_addr = self.argv_addr + (len(self.argv) + 1) * ptr_len
+
+        self.reg(self.arch.Registers.sp, sp)
+
+    def run(self):
+
+        addr = self.reader.entry
+
+        while self.exit_code is None:
+
+            try:
+
+                # execute instructions untill system call or imported function call
+                self.cpu.run(self.storage, addr)
+
+            except CpuInstructionError as e:
+
+                insn = self.storage.get_insn(( e.addr, e.inum ))
+                if not insn.has_attr(IATTR_SYSCALL): raise
+
+                self.syscall()
+
+                # continue from the next machine instruction
+                addr = insn.next()[0]
+
+            except CpuError as e:
+
+                if not self.stubs.has_key(e.addr): raise
+
+                addr = self.stub(self.stubs[e.addr])
+
+        return self.exit_code
+
+    def syscall(self):
+
+        num_reg, arg_regs, ret_reg = syscall_regs[self.arch.name]
+
+        num = self.reg(num_reg)
+        args = map(lambda name: self.reg(name), arg_regs)
+
+        try: handler = self.sys_handlers[syscalls[self.arch.name][num]]
+        except KeyError: ret = -ENOSYS
+        else: ret = handler(*args)
+
+        self.reg(ret_reg, ret & 0xffffffff)
+
+    def sys_exit(self, code, *args):
+
+        self.exit_code = code & 0xff
+        return 0
+
+    def sys_read(self, fd, buff, size, *args):
+
+        if fd != 0: return -EBADF
+
+        # read from stdin buffer
+        data, self.stdin = self.stdin[: size], self.stdin[size :]
+
+        try: self.mem.write(buff, len(data), data)
+        except MemError: return -EFAULT
+
+        return len(data)
+
+    def sys_write(self, fd, buff, size, *args):
+
+        if not fd in [ 1, 2 ]: return -EBADF
+
+        try: data = self.mem.read(buff, size)
+        except MemError: return -EFAULT
+
+        if fd == 1: self.stdout += data
+        else: self.stderr += data
+
+        return size
+
+    def sys_brk(self, addr, *args):
+
+        if addr > self.brk:
+
+            if addr >= self.MMAP_BASE: return self.brk
+
+            # extend program break memory
+            self.mem.alloc(addr = self.brk, size = addr - self.brk)
+            self.brk = addr
+
+        return self.brk
+
+    def sys_mmap2(self, addr, size, prot, flags, fd, pgoff):
+
+        # only anonymous mappings are supported
+        if not flags & MAP_ANONYMOUS: return -EINVAL
+        if size == 0: return -EINVAL
+
+        size = page_align(size)
+
+        if not flags & MAP_FIXED:
+
+            addr = self.mmap_next
+            self.mmap_next += size
+
+            if self.mmap_next > self.STACK_TOP - self.STACK_SIZE: return -ENOMEM
+
+        self.mem.alloc(addr = addr, size = size)
+
+        return addr
+
+    def sys_mmap(self, args, *unused):
+
+        # old i386 mmap() that takes arguments structure
+        try: args = map(lambda i: self.load_ptr(args + i * 4), range(6))
+        except MemError: return -EFAULT
+
+        return self.sys_mmap2(*(args[: 5] + [ args[5] / PAGE_SIZE ]))
+
+    def sys_munmap(self, addr, size, *args):
+
+        # memory is never released
+        return 0
+
+    def stub_arg(self, num):
+
+        if self.arch.name == 'x86':
+
+            # arguments are passed over the stack after return address
+            return self.load_ptr(self.reg('esp') + (num + 1) * 4)
+
+        elif self.arch.name == 'arm':
+
+            # first four arguments are passed in registers
+            if num < 4: return self.reg('r%d' % num)
+
+            return self.load_ptr(self.reg(self.arch.Registers.sp) + (num - 4) * 4)
+
+        else: assert False
+
+    def stub_ret(self, val):
+
+        if self.arch.name == 'x86':
+
+            ret = self.load_ptr(self.reg('esp'))
+
+            self.reg('esp', self.reg('esp') + 4)
+            self.reg('eax', val & 0xffffffff)
+
+        elif self.arch.name == 'arm':
+
+            ret = self.reg(self.arch.Registers.lr)
+
+            self.reg('r0', val & 0xffffffff)
+
+        else: assert False
+
+        return ret
+
+    def stub_handler(self, name):
+
+        return getattr(self, 'stub_' + name, None) if name is not None else None
+
+    def stub(self, name):
+
+        handler = self.stub_handler(name)
+        if handler is None: raise ProcessError('Unsupported import %s()' % name)
+
+        return handler()
+
+    def stub_exit_main(self):
+
+        # main() returned
+        self.exit_code = self.reg(self.arch.Registers.accum) & 0xff
+
+    def stub___libc_start_main(self):
+
+        main = self.stub_arg(0)
+
+        if not self.stubs_names.has_key('exit_main'):
+
+            stub = self.STUBS_BASE + len(self.stubs) * self.arch.ptr_len
+            self.stubs[stub], self.stubs_names['exit_main'] = 'exit_main', stub
+
+        ret = self.stubs_names['exit_main']
+
+        if self.arch.name == 'x86':
+
+            sp = self.reg('esp')
+
+            # int main(int argc, char **argv, char **envp)
+            for val in [ self.envp_addr, self.argv_addr, len(self.argv), ret ]:
+
+                sp -= 4
+                self.store_ptr(sp, val)
+
+            self.reg('esp', sp)
+
+        elif self.arch.name == 'arm':
+
+            self.reg('r0', len(self.argv))
+            self.reg('r1', self.argv_addr)
+            self.reg('r2', self.envp_addr)
+            self.reg(self.arch.Registers.lr, ret)
+
+        else: assert False
+
+        return main
+
+    def stub_exit(self):
+
+        self.exit_code = self.stub_arg(0) & 0xff
+
+    def stub_abort(self):
+
+        # the same as killed by SIGABRT
+        self.exit_code = 134
+
+    def stub___stack_chk_fail(self):
+
+        self.stub_abort()
+
+    def stub_strlen(self):
+
+        return self.stub_ret(len(self.read_str(self.stub_arg(0))))
+
+    def stub_memcpy(self):
+
+        dst, src, size = self.stub_arg(0), self.stub_arg(1), self.stub_arg(2)
+
+        if size > 0: self.mem.write(dst, size, self.mem.read(src, size))
+
+        return self.stub_ret(dst)
+
+    def stub_atoi(self):
+
+        m = re.match(r'\s*([+-]?\d+)', self.read_str(self.stub_arg(0)))
+
+        return self.stub_ret(int(m.group(1)) if m else 0)
+
+    def stub_puts(self):
+
+        data = self.read_str(self.stub_arg(0)) + '\n'
+        self.stdout += data
+
+        return self.stub_ret(len(data))
+
+    def stub_printf(self):
+
+        data = self.format(self.read_str(self.stub_arg(0)), 1)
+        self.stdout += data
+
+        return self.stub_ret(len(data))
+
+    def format(self, fmt, num):
+
+        ret = ''
+        pos = 0
+
+        for m in re.finditer(r'%([-+ #0]*)(\*|\d+)?(?:\.(\*|\d+))?(hh|h|ll|l|z|j|t)?([diouxXcsp%])', fmt):
+
+            ret += fmt[pos : m.start()]
+            pos = m.end()
+
+            flags, width, prec, length, conv = m.groups()
+
+            if conv == '%':
+
+                ret += '%'
+                continue
+
+            if width == '*': width, num = str(self.stub_arg(num)), num + 1
+            if prec == '*': prec, num = str(self.stub_arg(num)), num + 1
+
+            spec = flags + ('' if width is None else width) + ('' if prec is None else '.' + prec)
+
+            if length == 'll':
+
+                # 64-bit value that takes two arguments
+                val = self.stub_arg(num) | (self.stub_arg(num + 1) << 32)
+                num += 2
+                bits = 64
+
+            else:
+
+                val = self.stub_arg(num)
+                num += 1
+                bits = { 'hh': 8, 'h': 16 }.get(length, 32)
+
+            val &= (1 << bits) - 1
+
+            if conv in 'di':
+
+                if val >> (bits - 1): val -= 1 << bits
+                conv = 'd'
+
+            elif conv == 'u': conv = 'd'
+            elif conv == 'c': val, conv = chr(val & 0xff), 's'
+            elif conv == 's': val = self.read_str(val) if val != 0 else '(null)'
+            elif conv == 'p': val, conv = '0x%x' % val, 's'
+
+            ret += ('%' + spec + conv) % val
+
+        return ret + fmt[pos :]
+
+
+class TestProcess(unittest.TestCase):
+
+    CPU = Cpu
+
+    BIN_PATH = os.path.join(test_dir, 'fib_x86.elf')
+
+    def test(self):
+
+        if os.path.isfile(self.BIN_PATH):
+
+            proc = Process(self.BIN_PATH, argv = [ self.BIN_PATH, '11' ], cpu_type = self.CPU)
+
+            assert proc.run() == 0
+            assert proc.stdout == '11 number in Fibonacci sequence is 144\n'
+
+#
+# EoF
+#
@@ -153,6 +153,8 @@ class CodeStorageMongo(REIL.CodeStorageMem):
             try: del self.cache[ir_addr]
             except KeyError: pass
 
+            self.changed(ir_addr[0])
+
         else:
 
             raise REIL.StorageError(*ir_addr)
@@ -174,6 +176,8 @@ class CodeStorageMongo(REIL.CodeStorageMem):
         # update cache
         self.cache[ir_addr] = insn
 
+        self.changed(ir_addr[0])
+
     def size(self): 
 
         return self.collection.find().count()
@@ -183,7 +187,11 @@ class CodeStorageMongo(REIL.CodeStorageMem):
         self.cache.clear()
 
         # remove all items of collection
-        return self.collection.remove()
+        ret = self.collection.remove()
+
+        self.changed()
+
+        return ret
 
 
 #
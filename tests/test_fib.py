@@ -5,6 +5,7 @@ from pyopenreil.VM import *
 
 class TestFib(unittest.TestCase):    
     
+    CPU = Cpu
     CPU_DEBUG = 0
     FILE_DIR = os.path.abspath(os.path.dirname(__file__))
 
@@ -30,7 +31,7 @@ class TestFib(unittest.TestCase):
               (insn_before, insn_after)
 
         # create CPU and ABI
-        cpu = Cpu(arch, debug = self.CPU_DEBUG)
+        cpu = self.CPU(arch, debug = self.CPU_DEBUG)
         abi = Abi(cpu, tr)
 
         testval = 11
@@ -43,6 +44,18 @@ class TestFib(unittest.TestCase):
 
         assert ret == 144
 
+    def _run_process(self):
+
+        from pyopenreil.utils import linux
+
+        path = self.file_path(self.ELF_NAME)
+
+        # run the whole test program with emulated system calls and libc imports
+        proc = linux.Process(path, argv = [ path, '11' ], cpu_type = self.CPU)
+
+        assert proc.run() == 0
+        assert proc.stdout == '11 number in Fibonacci sequence is 144\n'
+
 
 class TestFib_X86(TestFib):    
 
@@ -78,6 +91,10 @@ class TestFib_X86(TestFib):
         
         except ImportError, why: print '[!]', str(why)    
 
+    def test_process(self):
+
+        self._run_process()
+
 
 class TestFib_ARM(TestFib):
 
@@ -100,6 +117,32 @@ class TestFib_ARM(TestFib):
 
         except ImportError, why: print '[!]', str(why)
 
+    def test_process(self):
+
+        self._run_process()
+
+
+class TestFibNative_X86(TestFib_X86):
+
+    # the same tests using native interpreter
+    CPU = CpuNative
+
+
+class TestFibNative_ARM(TestFib_ARM):
+
+    CPU = CpuNative
+
+
+class TestFibNativeJIT_X86(TestFib_X86):
+
+    # native interpreter with JIT compiler
+    CPU = CpuNativeJIT
+
+
+class TestFibNativeJIT_ARM(TestFib_ARM):
+
+    CPU = CpuNativeJIT
+
 #
 # EoF
 #
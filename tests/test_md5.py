@@ -6,6 +6,7 @@ from pyopenreil.VM import *
 
 class TestMD5(unittest.TestCase):    
     
+    CPU = Cpu
     CPU_DEBUG = 0
     FILE_DIR = os.path.abspath(os.path.dirname(__file__))
 
@@ -29,7 +30,7 @@ class TestMD5(unittest.TestCase):
         print tr.storage
 
         # create CPU and ABI
-        cpu = Cpu(arch, debug = self.CPU_DEBUG)
+        cpu = self.CPU(arch, debug = self.CPU_DEBUG)
         abi = Abi(cpu, tr)
 
         ctx = abi.buff(6 * 4 + 8 + 64)
@@ -52,6 +53,19 @@ class TestMD5(unittest.TestCase):
         # check for correct result
         assert digest == md5.new(test_val).digest()        
 
+    def _run_process(self):
+
+        from pyopenreil.utils import linux
+
+        path, test_val = self.file_path(self.ELF_NAME), 'foobar'
+
+        # run the whole test program with emulated system calls and libc imports
+        proc = linux.Process(path, argv = [ path, test_val ], cpu_type = self.CPU)
+
+        assert proc.run() == 0
+        assert proc.stdout == '\nData: %s \n\nHash: %s\n\n' % \
+               (' '.join(map(lambda b: '%.2x' % ord(b), test_val)), md5.new(test_val).hexdigest())
+
 
 class TestMD5_X86(TestMD5):
 
@@ -87,6 +101,10 @@ class TestMD5_X86(TestMD5):
         
         except ImportError, why: print '[!]', str(why)
 
+    def test_process(self):
+
+        self._run_process()
+
 
 class TestMD5_ARM(TestMD5):
 
@@ -109,6 +127,32 @@ class TestMD5_ARM(TestMD5):
 
         except ImportError, why: print '[!]', str(why)
 
+    def test_process(self):
+
+        self._run_process()
+
+
+class TestMD5Native_X86(TestMD5_X86):
+
+    # the same tests using native interpreter
+    CPU = CpuNative
+
+
+class TestMD5Native_ARM(TestMD5_ARM):
+
+    CPU = CpuNative
+
+
+class TestMD5NativeJIT_X86(TestMD5_X86):
+
+    # native interpreter with JIT compiler
+    CPU = CpuNativeJIT
+
+
+class TestMD5NativeJIT_ARM(TestMD5_ARM):
+
+    CPU = CpuNativeJIT
+
 #
 # EoF
 #
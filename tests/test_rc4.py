@@ -5,6 +5,7 @@ from pyopenreil.VM import *
 
 class TestRC4(unittest.TestCase):            
     
+    CPU = Cpu
     CPU_DEBUG = 0
     FILE_DIR = os.path.abspath(os.path.dirname(__file__))
 
@@ -25,7 +26,7 @@ class TestRC4(unittest.TestCase):
         tr.optimize(addr_list)
 
         # create CPU and ABI
-        cpu = Cpu(arch, debug = self.CPU_DEBUG)
+        cpu = self.CPU(arch, debug = self.CPU_DEBUG)
         abi = Abi(cpu, tr)
 
         # allocate buffers for arguments of emulated functions
@@ -45,6 +46,19 @@ class TestRC4(unittest.TestCase):
         # check for correct result
         assert val == '\x38\x88\xBC'
 
+    def _run_process(self):
+
+        from pyopenreil.utils import linux
+
+        path = self.file_path(self.ELF_NAME)
+
+        # run the whole test program with emulated system calls and libc imports
+        proc = linux.Process(path, argv = [ path, 'somekey', 'bar' ], cpu_type = self.CPU)
+
+        assert proc.run() == 0
+        assert proc.stdout == '\nKey: 73 6f 6d 65 6b 65 79 \n\nPlaintext: 62 61 72 ' + \
+                              '\n\nEncrypted: 38 88 bc \n\nDecrypted: 62 61 72 \n\n'
+
 
 class TestRC4_X86(TestRC4):        
 
@@ -80,6 +94,10 @@ class TestRC4_X86(TestRC4):
         
         except ImportError, why: print '[!]', str(why)
 
+    def test_process(self):
+
+        self._run_process()
+
 
 class TestRC4_ARM(TestRC4):  
 
@@ -102,6 +120,32 @@ class TestRC4_ARM(TestRC4):
 
         except ImportError, why: print '[!]', str(why)
 
+    def test_process(self):
+
+        self._run_process()
+
+
+class TestRC4Native_X86(TestRC4_X86):
+
+    # the same tests using native interpreter
+    CPU = CpuNative
+
+
+class TestRC4Native_ARM(TestRC4_ARM):
+
+    CPU = CpuNative
+
+
+class TestRC4NativeJIT_X86(TestRC4_X86):
+
+    # native interpreter with JIT compiler
+    CPU = CpuNativeJIT
+
+
+class TestRC4NativeJIT_ARM(TestRC4_ARM):
+
+    CPU = CpuNativeJIT
+
 #
 # EoF
 #